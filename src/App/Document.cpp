@@ -42,6 +42,21 @@ The FreeCAD document handles the dependencies of its DocumentObjects with
 an adjacence list. This gives the opportunity to calculate the shortest
 recompute path. Also enables more complicated dependencies beyond trees.
 
+The back links of the graph are kept in an index that the link properties
+update whenever they change. So, getting the objects that link to a given
+object doesn't need to scan the whole document and a recompute only sorts
+the objects that are touched and the objects depending on them.
+
+If the parameter ParallelRecompute of the document preferences is set, the
+objects of the recompute are grouped by their level in the graph. Objects of
+the same level don't depend on each other and the ones whose type declares its
+execute() as thread-safe (see DocumentObject::isExecuteThreadSafe()) get
+recomputed concurrently. Before, each of them can prepare the libraries it
+uses for multi-threading, e.g. the Part features make OCC reentrant. All
+other objects, e.g. Python features, are still recomputed in the main thread,
+and the change notifications of the objects recomputed in worker threads are
+emitted in the main thread afterwards.
+
 
 @see App::Application
 @see App::DocumentObject
@@ -65,9 +80,15 @@ recompute path. Also enables more complicated dependencies beyond trees.
 #include <boost/bind.hpp>
 #include <boost/regex.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrentMap>
 
 
 #include "Document.h"
@@ -137,15 +158,27 @@ struct DocumentP
     int iTransactionMode;
     int iTransactionCount;
     std::map<int,Transaction*> mTransactions;
-    std::map<Vertex,DocumentObject*> vertexMap;
+    // the objects of a running recompute in execution order
+    std::vector<DocumentObject*> recomputeList;
+    // back-link index: for each object the objects linking to it (once per link)
+    boost::unordered_map<const DocumentObject*, std::vector<DocumentObject*> > inLists;
+    // the objects whose links are registered in the back-link index
+    boost::unordered_set<const DocumentObject*> linkedObjects;
+    // the candidates of the next recompute, i.e. the touched and the new objects,
+    // the list keeps the order in which they were touched
+    boost::unordered_set<const DocumentObject*> touchedObjects;
+    std::vector<DocumentObject*> touchedList;
+    // set while objects are recomputed in worker threads
+    bool parallelRecompute;
+    QMutex recomputeMutex;
+    // property changes to be notified after the parallel recompute
+    std::vector<std::pair<const DocumentObject*, const Property*> > pendingChanges;
     bool rollback;
     bool closable;
     bool keepTrailingDigits;
     int iUndoMode;
     unsigned int UndoMemSize;
     unsigned int UndoMaxStackSize;
-    DependencyList DepList;
-    std::map<DocumentObject*,Vertex> VertexObjectList;
 
     DocumentP() {
         activeObject = 0;
@@ -153,6 +186,7 @@ struct DocumentP
         activeTransaction = 0;
         iTransactionMode = 0;
         iTransactionCount = 0;
+        parallelRecompute = false;
         rollback = false;
         closable = true;
         keepTrailingDigits = true;
@@ -509,12 +543,22 @@ void Document::onChanged(const Property* prop)
 
 void Document::onBeforeChangeProperty(const DocumentObject *Who, const Property *What)
 {
+    // during a parallel recompute the objects are changed from several threads
+    QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
     if (d->activeUndoTransaction && !d->rollback)
         d->activeUndoTransaction->addObjectChange(Who,What);
 }
 
 void Document::onChangedProperty(const DocumentObject *Who, const Property *What)
 {
+    if (d->parallelRecompute) {
+        // the observers get notified in the main thread when the recompute is done
+        QMutexLocker locker(&d->recomputeMutex);
+        if (d->activeTransaction && !d->rollback)
+            d->activeTransaction->addObjectChange(Who,What);
+        d->pendingChanges.push_back(std::make_pair(Who, What));
+        return;
+    }
     if (d->activeTransaction && !d->rollback)
         d->activeTransaction->addObjectChange(Who,What);
     signalChangedObject(*Who, *What);
@@ -634,6 +678,10 @@ Document::~Document()
 #endif
 
     d->objectArray.clear();
+    d->inLists.clear();
+    d->linkedObjects.clear();
+    d->touchedObjects.clear();
+    d->touchedList.clear();
     for (it = d->objectMap.begin(); it != d->objectMap.end(); ++it) {
         delete(it->second);
     }
@@ -1047,6 +1095,10 @@ void Document::restore (void)
     // clean up if the document is not empty
     // !TODO mind exeptions while restoring!
     clearUndos();
+    d->inLists.clear();
+    d->linkedObjects.clear();
+    d->touchedObjects.clear();
+    d->touchedList.clear();
     for (std::vector<DocumentObject*>::iterator obj = d->objectArray.begin(); obj != d->objectArray.end(); ++obj) {
         signalDeletedObject(*(*obj));
         delete *obj;
@@ -1161,18 +1213,77 @@ int Document::countObjects(void) const
 
 std::vector<App::DocumentObject*> Document::getInList(const DocumentObject* me) const
 {
-    // result list
-    std::vector<App::DocumentObject*> result;
-    // go through all objects
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // get the outList and search if me is in that list
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2)
-            if (*It2 && *It2 == me)
-                // add the parent object
-                result.push_back(It->second);
+    boost::unordered_map<const DocumentObject*, std::vector<DocumentObject*> >::const_iterator it;
+    it = d->inLists.find(me);
+    if (it != d->inLists.end())
+        return it->second;
+    return std::vector<App::DocumentObject*>();
+}
+
+void Document::_addBackLink(DocumentObject* from, DocumentObject* to)
+{
+    // only links between objects of this document are registered
+    if (!to || to->getDocument() != this || d->linkedObjects.find(from) == d->linkedObjects.end())
+        return;
+    d->inLists[to].push_back(from);
+}
+
+void Document::_removeBackLink(DocumentObject* from, DocumentObject* to)
+{
+    if (!to || d->linkedObjects.find(from) == d->linkedObjects.end())
+        return;
+    boost::unordered_map<const DocumentObject*, std::vector<DocumentObject*> >::iterator it;
+    it = d->inLists.find(to);
+    if (it != d->inLists.end()) {
+        std::vector<DocumentObject*>::iterator jt = std::find(it->second.begin(), it->second.end(), from);
+        if (jt != it->second.end())
+            it->second.erase(jt);
+    }
+}
+
+void Document::_attachLinks(DocumentObject* pcObject)
+{
+    if (!d->linkedObjects.insert(pcObject).second)
+        return; // already registered
+    std::vector<DocumentObject*> OutList = pcObject->getOutList();
+    for (std::vector<DocumentObject*>::iterator it = OutList.begin(); it != OutList.end(); ++it)
+        _addBackLink(pcObject, *it);
+}
+
+bool Document::_detachLinks(DocumentObject* pcObject)
+{
+    if (d->linkedObjects.find(pcObject) == d->linkedObjects.end())
+        return false; // not registered
+    std::vector<DocumentObject*> OutList = pcObject->getOutList();
+    for (std::vector<DocumentObject*>::iterator it = OutList.begin(); it != OutList.end(); ++it)
+        _removeBackLink(pcObject, *it);
+    d->linkedObjects.erase(pcObject);
+    return true;
+}
+
+void Document::_setTouched(DocumentObject* pcObject, bool on)
+{
+    // during a parallel recompute the objects are touched from several threads
+    QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
+    if (on) {
+        // objects kept by the undo/redo transactions are not part of the document
+        if (d->linkedObjects.find(pcObject) == d->linkedObjects.end())
+            return;
+        if (d->touchedObjects.insert(pcObject).second)
+            d->touchedList.push_back(pcObject);
+    }
+    else if (d->touchedObjects.erase(pcObject) > 0 &&
+             d->touchedList.size() > 2 * d->touchedObjects.size() + 16) {
+        // drop the purged objects from the list once they dominate it
+        std::vector<DocumentObject*> list;
+        list.reserve(d->touchedObjects.size());
+        boost::unordered_set<const DocumentObject*> seen;
+        for (std::vector<DocumentObject*>::iterator it = d->touchedList.begin(); it != d->touchedList.end(); ++it) {
+            if (d->touchedObjects.find(*it) != d->touchedObjects.end() && seen.insert(*it).second)
+                list.push_back(*it);
+        }
+        d->touchedList.swap(list);
     }
-    return result;
 }
 
 std::vector<App::DocumentObject*>
@@ -1227,23 +1338,35 @@ Document::getDependencyList(const std::vector<App::DocumentObject*>& objs) const
     return ary;
 }
 
-void Document::_rebuildDependencyList(void)
+// checks whether the object or one of its dependencies has changed
+static bool mustRecompute(DocumentObject* Cur)
 {
-    d->VertexObjectList.clear();
-    d->DepList.clear();
-    // Filling up the adjacency List
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // add the object as Vertex and remember the index
-        d->VertexObjectList[It->second] = add_vertex(d->DepList);
-    }
-    // add the edges
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2) {
-            if (*It2)
-                add_edge(d->VertexObjectList[It->second],d->VertexObjectList[*It2],d->DepList);
+#ifdef FC_LOGFEATUREUPDATE
+    std::clog << Cur->getNameInDocument() << " dep on: " ;
+#endif
+    bool NeedUpdate = false;
+
+    // ask the object if it should be recomputed
+    if (Cur->mustExecute() == 1)
+        NeedUpdate = true;
+    else {// if (Cur->mustExecute() == -1)
+        // update if one of the dependencies is touched
+        std::vector<DocumentObject*> OutList = Cur->getOutList();
+        for (std::vector<DocumentObject*>::iterator j = OutList.begin(); j != OutList.end(); ++j) {
+            DocumentObject* Test = *j;
+#ifdef FC_LOGFEATUREUPDATE
+            std::clog << Test->getNameInDocument() << ", " ;
+#endif
+            if (Test->isTouched()) {
+                NeedUpdate = true;
+                break;
+            }
         }
+#ifdef FC_LOGFEATUREUPDATE
+        std::clog << std::endl;
+#endif
     }
+    return NeedUpdate;
 }
 
 void Document::recompute()
@@ -1253,76 +1376,153 @@ void Document::recompute()
         delete *it;
     _RecomputeLog.clear();
 
-    // updates the dependency graph
-    _rebuildDependencyList();
+    // Only the objects that are touched or want to be executed and the objects
+    // depending on them can be affected by the recompute. So, only this part of
+    // the dependency graph is taken into account. The candidates are taken over
+    // from the touched set, the ones that don't want to be executed are dropped.
+    std::vector<DocumentObject*> candidates;
+    candidates.swap(d->touchedList);
+    boost::unordered_set<const DocumentObject*> touched;
+    touched.swap(d->touchedObjects);
+    std::vector<DocumentObject*> affected;
+    boost::unordered_set<DocumentObject*> affectedSet;
+    for (std::vector<DocumentObject*>::const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
+        if (touched.find(*it) == touched.end() || affectedSet.find(*it) != affectedSet.end())
+            continue; // purged or removed in the meantime, or a duplicate
+        if ((*it)->isTouched() || (*it)->mustExecute() == 1) {
+            affected.push_back(*it);
+            affectedSet.insert(*it);
+        }
+    }
 
-    std::list<Vertex> make_order;
-    DependencyList::out_edge_iterator j, jend;
+    for (std::size_t i = 0; i < affected.size(); i++) {
+        const std::vector<DocumentObject*>& inList = d->inLists[affected[i]];
+        for (std::vector<DocumentObject*>::const_iterator it = inList.begin(); it != inList.end(); ++it) {
+            if (affectedSet.insert(*it).second)
+                affected.push_back(*it);
+        }
+    }
 
-    try {
-        // this sort gives the execute
-        boost::topological_sort(d->DepList, std::front_inserter(make_order));
+    // sort the objects topologically, i.e. an object comes after all objects it depends on
+    std::vector<DocumentObject*> make_order;
+    make_order.reserve(affected.size());
+    boost::unordered_map<DocumentObject*, int> pending;
+    for (std::vector<DocumentObject*>::iterator it = affected.begin(); it != affected.end(); ++it) {
+        int count = 0;
+        std::vector<DocumentObject*> OutList = (*it)->getOutList();
+        for (std::vector<DocumentObject*>::iterator jt = OutList.begin(); jt != OutList.end(); ++jt) {
+            if (affectedSet.find(*jt) != affectedSet.end())
+                count++;
+        }
+        pending[*it] = count;
+        if (count == 0)
+            make_order.push_back(*it);
     }
-    catch (const std::exception& e) {
-        std::cerr << "Document::recompute: " << e.what() << std::endl;
-        return;
+
+    for (std::size_t i = 0; i < make_order.size(); i++) {
+        const std::vector<DocumentObject*>& inList = d->inLists[make_order[i]];
+        for (std::vector<DocumentObject*>::const_iterator it = inList.begin(); it != inList.end(); ++it) {
+            if (affectedSet.find(*it) != affectedSet.end() && --pending[*it] == 0)
+                make_order.push_back(*it);
+        }
     }
 
-    // caching vertex to DocObject
-    for (std::map<DocumentObject*,Vertex>::const_iterator It1= d->VertexObjectList.begin();It1 != d->VertexObjectList.end(); ++It1)
-        d->vertexMap[It1->second] = It1->first;
+    if (make_order.size() != affected.size()) {
+        std::cerr << "Document::recompute: The graph must be a DAG." << std::endl;
+        // nothing was recomputed, keep the candidates for the next try
+        for (std::vector<DocumentObject*>::iterator it = affected.begin(); it != affected.end(); ++it)
+            _setTouched(*it, true);
+        return;
+    }
 
 #ifdef FC_LOGFEATUREUPDATE
     std::clog << "make ordering: " << std::endl;
 #endif
 
-    for (std::list<Vertex>::reverse_iterator i = make_order.rbegin();i != make_order.rend(); ++i) {
-        DocumentObject* Cur = d->vertexMap[*i];
-        if (!Cur) continue;
-#ifdef FC_LOGFEATUREUPDATE
-        std::clog << Cur->getNameInDocument() << " dep on: " ;
-#endif
-        bool NeedUpdate = false;
-
-        // ask the object if it should be recomputed
-        if (Cur->mustExecute() == 1)
-            NeedUpdate = true;
-        else {// if (Cur->mustExecute() == -1)
-            // update if one of the dependencies is touched
-            for (boost::tie(j, jend) = out_edges(*i, d->DepList); j != jend; ++j) {
-                DocumentObject* Test = d->vertexMap[target(*j, d->DepList)];
-                if (!Test) continue;
-#ifdef FC_LOGFEATUREUPDATE
-                std::clog << Test->getNameInDocument() << ", " ;
-#endif
-                if (Test->isTouched()) {
-                    NeedUpdate = true;
-                    break;
-                }
+    // Split the objects into groups that are recomputed one after another. Without
+    // parallel recompute each object is a group of its own. Otherwise, a group is a
+    // level of the graph, i.e. its objects only depend on objects of former groups.
+    bool parallel = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRecompute",false);
+    std::vector<std::size_t> groups; // index of the first object of each group
+    if (parallel) {
+        boost::unordered_map<DocumentObject*, std::size_t> levelOf;
+        std::vector< std::vector<DocumentObject*> > levels;
+        for (std::vector<DocumentObject*>::iterator it = make_order.begin(); it != make_order.end(); ++it) {
+            std::size_t level = 0;
+            std::vector<DocumentObject*> OutList = (*it)->getOutList();
+            for (std::vector<DocumentObject*>::iterator jt = OutList.begin(); jt != OutList.end(); ++jt) {
+                boost::unordered_map<DocumentObject*, std::size_t>::iterator kt = levelOf.find(*jt);
+                if (kt != levelOf.end())
+                    level = std::max<std::size_t>(level, kt->second + 1);
             }
-#ifdef FC_LOGFEATUREUPDATE
-            std::clog << std::endl;
-#endif
+            levelOf[*it] = level;
+            if (levels.size() <= level)
+                levels.resize(level + 1);
+            levels[level].push_back(*it);
         }
-        // if one touched recompute
-        if (NeedUpdate) {
+
+        make_order.clear();
+        for (std::vector< std::vector<DocumentObject*> >::iterator it = levels.begin(); it != levels.end(); ++it) {
+            groups.push_back(make_order.size());
+            make_order.insert(make_order.end(), it->begin(), it->end());
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < make_order.size(); i++)
+            groups.push_back(i);
+    }
+    groups.push_back(make_order.size());
+
+    // objects removed while recomputing are nullified in this list
+    d->recomputeList.swap(make_order);
+
+    for (std::size_t g = 0; g + 1 < groups.size(); g++) {
+        std::vector<DocumentObject*> threaded;
+        std::vector<std::size_t> serial;
+        for (std::size_t i = groups[g]; i < groups[g+1]; i++) {
+            DocumentObject* Cur = d->recomputeList[i];
+            // if one touched recompute
+            if (!Cur || !mustRecompute(Cur))
+                continue;
 #ifdef FC_LOGFEATUREUPDATE
             std::clog << "Recompute" << std::endl;
 #endif
-            if (_recomputeFeature(Cur)) {
-                // if somthing happen break execution of recompute
-                d->vertexMap.clear();
-                return;
+            if (parallel && Cur->isExecuteThreadSafe())
+                threaded.push_back(Cur);
+            else
+                serial.push_back(i);
+        }
+
+        bool abort = false;
+        if (threaded.size() > 1)
+            abort = _recomputeFeatures(threaded);
+        else if (threaded.size() == 1)
+            abort = _recomputeFeature(threaded.front());
+        for (std::vector<std::size_t>::iterator it = serial.begin(); it != serial.end() && !abort; ++it) {
+            // the object may have been removed by one recomputed before
+            DocumentObject* Cur = d->recomputeList[*it];
+            if (Cur)
+                abort = _recomputeFeature(Cur);
+        }
+
+        if (abort) {
+            // if somthing happen break execution of recompute
+            for (std::vector<DocumentObject*>::iterator it = d->recomputeList.begin(); it != d->recomputeList.end(); ++it) {
+                if (*it)
+                    _setTouched(*it, true);
             }
+            d->recomputeList.clear();
+            return;
         }
     }
 
     // reset all touched
-    for (std::map<Vertex,DocumentObject*>::iterator it = d->vertexMap.begin(); it != d->vertexMap.end(); ++it) {
-        if (it->second)
-            it->second->purgeTouched();
+    for (std::vector<DocumentObject*>::iterator it = d->recomputeList.begin(); it != d->recomputeList.end(); ++it) {
+        if (*it)
+            (*it)->purgeTouched();
     }
-    d->vertexMap.clear();
+    d->recomputeList.clear();
 }
 
 const char * Document::getErrorDescription(const App::DocumentObject*Obj) const
@@ -1345,24 +1545,28 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
         returnCode = Feat->recompute();
     }
     catch(Base::AbortException &e){
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         e.ReportException();
         _RecomputeLog.push_back(new DocumentObjectExecReturn("User abort",Feat));
         Feat->setError();
         return true;
     }
     catch (const Base::MemoryException& e) {
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         Base::Console().Error("Memory exception in feature '%s' thrown: %s\n",Feat->getNameInDocument(),e.what());
         _RecomputeLog.push_back(new DocumentObjectExecReturn("Out of memory exception",Feat));
         Feat->setError();
         return true;
     }
     catch (Base::Exception &e) {
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         e.ReportException();
         _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
         Feat->setError();
         return false;
     }
     catch (std::exception &e) {
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         Base::Console().Warning("exception in Feature \"%s\" thrown: %s\n",Feat->getNameInDocument(),e.what());
         _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
         Feat->setError();
@@ -1370,6 +1574,7 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     }
 #ifndef FC_DEBUG
     catch (...) {
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         Base::Console().Error("App::Document::_RecomputeFeature(): Unknown exception in Feature \"%s\" thrown\n",Feat->getNameInDocument());
         _RecomputeLog.push_back(new DocumentObjectExecReturn("Unknown exeption!"));
         Feat->setError();
@@ -1382,6 +1587,7 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
         Feat->resetError();
     }
     else {
+        QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
         returnCode->Which = Feat;
         _RecomputeLog.push_back(returnCode);
 #ifdef FC_DEBUG
@@ -1392,6 +1598,31 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     return false;
 }
 
+// recompute objects that don't depend on each other in worker threads
+bool Document::_recomputeFeatures(const std::vector<DocumentObject*>& Feats)
+{
+    for (std::vector<DocumentObject*>::const_iterator it = Feats.begin(); it != Feats.end(); ++it)
+        (*it)->onBeforeExecuteThreaded();
+    d->parallelRecompute = true;
+    QFuture<bool> future = QtConcurrent::mapped
+        (Feats, boost::bind(&Document::_recomputeFeature, this, _1));
+    QFutureWatcher<bool> watcher;
+    watcher.setFuture(future);
+    watcher.waitForFinished();
+    d->parallelRecompute = false;
+
+    // notify the observers in the main thread
+    std::vector<std::pair<const DocumentObject*, const Property*> > changes;
+    changes.swap(d->pendingChanges);
+    for (std::vector<std::pair<const DocumentObject*, const Property*> >::iterator it = changes.begin(); it != changes.end(); ++it)
+        signalChangedObject(*it->first, *it->second);
+
+    bool abort = false;
+    for (QFuture<bool>::const_iterator it = future.begin(); it != future.end(); ++it)
+        abort = abort || *it;
+    return abort;
+}
+
 void Document::recomputeFeature(DocumentObject* Feat)
 {
      // delete recompute log
@@ -1444,8 +1675,10 @@ DocumentObject * Document::addObject(const char* sType, const char* pObjectName)
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
-    // insert in the adjacence list and referenc through the ConectionMap
-    //_DepConMap[pcObject] = add_vertex(_DepList);
+    // register the links of the object in the back-link index
+    _attachLinks(pcObject);
+    // a new object is a candidate of the next recompute
+    _setTouched(pcObject, true);
 
     pcObject->Label.setValue( ObjectName );
 
@@ -1464,6 +1697,10 @@ void Document::_addObject(DocumentObject* pcObject, const char* pObjectName)
     d->objectArray.push_back(pcObject);
     // cache the pointer to the name string in the Object (for performance of DocumentObject::getNameInDocument())
     pcObject->pcNameInDocument = &(d->objectMap.find(pObjectName)->first);
+    // the object may come back with its links, e.g. by an undo
+    _attachLinks(pcObject);
+    // a new object is a candidate of the next recompute
+    _setTouched(pcObject, true);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1493,16 +1730,18 @@ void Document::remObject(const char* sName)
         d->activeObject = 0;
 
     signalDeletedObject(*(pos->second));
-    if (!d->vertexMap.empty()) {
+    if (!d->recomputeList.empty()) {
         // recompute of document is running
-        for (std::map<Vertex,DocumentObject*>::iterator it = d->vertexMap.begin(); it != d->vertexMap.end(); ++it) {
-            if (it->second == pos->second) {
-                it->second = 0; // just nullify the pointer
-                break;
-            }
-        }
+        std::vector<DocumentObject*>::iterator it = std::find
+            (d->recomputeList.begin(), d->recomputeList.end(), pos->second);
+        if (it != d->recomputeList.end())
+            *it = 0; // just nullify the pointer
     }
 
+    // the links of the object are not part of the document any more
+    _detachLinks(pos->second);
+    _setTouched(pos->second, false);
+
     // Before deleting we must nullify all dependant objects
     breakDependency(pos->second, true);
 
@@ -1520,9 +1759,11 @@ void Document::remObject(const char* sName)
             // set name cache false
             //pos->second->pcNameInDocument = 0;
         }
-        else
+        else {
             // if not saved in undo -> delete object
+            d->inLists.erase(pos->second);
             delete pos->second;
+        }
     }
 
     for (std::vector<DocumentObject*>::iterator obj = d->objectArray.begin(); obj != d->objectArray.end(); ++obj) {
@@ -1549,6 +1790,10 @@ void Document::_remObject(DocumentObject* pcObject)
 
     signalDeletedObject(*pcObject);
 
+    // the links of the object are not part of the document any more
+    _detachLinks(pcObject);
+    _setTouched(pcObject, false);
+
     // do no transactions if we do a rollback!
     if(!d->rollback){
         // Transaction stuff
@@ -1574,10 +1819,22 @@ void Document::_remObject(DocumentObject* pcObject)
 
 void Document::breakDependency(DocumentObject* pcObject, bool clear)
 {
+    // Only the objects linking to the object and, if clear is set, the object itself
+    // can hold a link that must be nullified
+    std::vector<DocumentObject*> objs;
+    boost::unordered_set<DocumentObject*> visited;
+    std::vector<DocumentObject*> inList = getInList(pcObject);
+    if (clear)
+        inList.push_back(pcObject);
+    for (std::vector<DocumentObject*>::iterator it = inList.begin(); it != inList.end(); ++it) {
+        if (visited.insert(*it).second)
+            objs.push_back(*it);
+    }
+
     // Nullify all dependant objects
-    for (std::map<std::string,DocumentObject*>::iterator it = d->objectMap.begin(); it != d->objectMap.end(); ++it) {
+    for (std::vector<DocumentObject*>::iterator it = objs.begin(); it != objs.end(); ++it) {
         std::map<std::string,App::Property*> Map;
-        it->second->getPropertyMap(Map);
+        (*it)->getPropertyMap(Map);
         // search for all properties that could have a link to the object
         for (std::map<std::string,App::Property*>::iterator pt = Map.begin(); pt != Map.end(); ++pt) {
             if (pt->second->getTypeId().isDerivedFrom(PropertyLink::getClassTypeId())) {
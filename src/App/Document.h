@@ -269,6 +269,16 @@ public:
     bool checkOnCycle(void);
     /// get a list of all objects linking to the given object
     std::vector<App::DocumentObject*> getInList(const DocumentObject* me) const;
+    /// Internal: the link properties call this when \a from starts linking to \a to
+    void _addBackLink(DocumentObject* from, DocumentObject* to);
+    /// Internal: the link properties call this when \a from stops linking to \a to
+    void _removeBackLink(DocumentObject* from, DocumentObject* to);
+    /// Internal: register the links of an object in the back-link index
+    void _attachLinks(DocumentObject* pcObject);
+    /// Internal: remove the links of an object from the back-link index, returns false if they weren't registered
+    bool _detachLinks(DocumentObject* pcObject);
+    /// Internal: the objects call this when they get touched or purged
+    void _setTouched(DocumentObject* pcObject, bool on);
     /// Get a complete list of all objects the given objects depend on. The list
     /// also contains the given objects!
     std::vector<App::DocumentObject*> getDependencyList
@@ -309,9 +319,9 @@ protected:
     void onChangedProperty(const DocumentObject *Who, const Property *What);
     /// helper which Recompute only this feature
     bool _recomputeFeature(DocumentObject* Feat);
+    /// helper which Recompute independent features in parallel
+    bool _recomputeFeatures(const std::vector<DocumentObject*>& Feats);
     void _clearRedos();
-    /// refresh the internal dependency graph
-    void _rebuildDependencyList(void);
     std::string getTransientDirectoryName(const std::string& uuid, const std::string& filename) const;
 
 
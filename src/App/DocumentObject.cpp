@@ -96,6 +96,11 @@ short DocumentObject::mustExecute(void) const
     return (isTouched() ? 1 : 0);
 }
 
+bool DocumentObject::isExecuteThreadSafe(void) const
+{
+    return false;
+}
+
 const char* DocumentObject::getStatusString(void) const
 {
     if (isError()) {
@@ -195,6 +200,8 @@ void DocumentObject::onChanged(const Property* prop)
         return;
     // set object touched
     StatusBits.set(0);
+    if (_pDoc)
+        _pDoc->_setTouched(this, true);
 }
 
 PyObject *DocumentObject::getPyObject(void)
@@ -215,6 +222,16 @@ std::vector<PyObject *> DocumentObject::getPySubObjects(const std::vector<std::s
 void DocumentObject::touch(void)
 {
     StatusBits.set(0);
+    if (_pDoc)
+        _pDoc->_setTouched(this, true);
+}
+
+void DocumentObject::purgeTouched(void)
+{
+    StatusBits.reset(0);
+    setPropertyStatus(0,false);
+    if (_pDoc)
+        _pDoc->_setTouched(this, false);
 }
 
 void DocumentObject::Save (Base::Writer &writer) const
@@ -101,7 +101,7 @@ public:
     /// test if this feature is touched
     bool isTouched(void) const {return StatusBits.test(0);}
     /// reset this feature touched
-    void purgeTouched(void){StatusBits.reset(0);setPropertyStatus(0,false);}
+    void purgeTouched(void);
     /// set this feature to error
     bool isError(void) const {return  StatusBits.test(1);}
     bool isValid(void) const {return !StatusBits.test(1);}
@@ -137,6 +137,13 @@ public:
      * -1: the document examine all links of this object and if one is touched -> recompute
      */
     virtual short mustExecute(void) const;
+    /** isExecuteThreadSafe
+     *  Returns true if execute() may run in a worker thread while other objects
+     *  are recomputed. It must then only read its own properties and the ones of
+     *  the linked objects and only change its own properties. Python features and
+     *  everything that touches the GUI must return false (the default).
+     */
+    virtual bool isExecuteThreadSafe(void) const;
 
     /// get the status Message
     const char *getStatusString(void) const;
@@ -200,6 +207,9 @@ protected:
     virtual void onFinishDuplicating() {}
     /// get called after setting the document
     virtual void onSettingDocument() {}
+    /// get called in the main thread before execute() runs in a worker thread,
+    /// e.g. to switch the used libraries into their thread-safe mode
+    virtual void onBeforeExecuteThreaded() {}
 
      /// python object of this class and all descendend
 protected: // attributes
@@ -29,6 +29,8 @@
 #include "DynamicProperty.h"
 #include "Property.h"
 #include "PropertyContainer.h"
+#include "Document.h"
+#include "DocumentObject.h"
 #include <Base/Reader.h>
 #include <Base/Writer.h>
 #include <Base/Console.h>
@@ -249,8 +251,16 @@ bool DynamicProperty::removeDynamicProperty(const char* name)
 {
     std::map<std::string,PropData>::iterator it = props.find(name);
     if (it != props.end()) {
+        // the back-link index of the document must not keep the links of a removed
+        // link property, so the links of the owner are registered anew without it
+        DocumentObject* owner = pc->isDerivedFrom(DocumentObject::getClassTypeId())
+            ? static_cast<DocumentObject*>(pc) : 0;
+        Document* doc = owner ? owner->getDocument() : 0;
+        bool linked = doc && doc->_detachLinks(owner);
         delete it->second.property;
         props.erase(it);
+        if (linked)
+            doc->_attachLinks(owner);
         return true;
     }
 
@@ -276,7 +276,7 @@ void PropertyVectorList::setPyObject(PyObject *value)
 void PropertyVectorList::Save (Base::Writer &writer) const
 {
     if (!writer.isForceXML()) {
-        writer.Stream() << writer.ind() << "<VectorList file=\"" << writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.Stream() << writer.ind() << "<VectorList file=\"" << writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -297,9 +297,8 @@ void PropertyVectorList::SaveDocFile (Base::Writer &writer) const
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
     if (writer.getFileVersion() > 0) {
-        for (std::vector<Base::Vector3d>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-            str << it->x << it->y << it->z;
-        }
+        if (uCt > 0)
+            str.writeArray(&(_lValueList[0].x), 3 * uCt);
     }
     else {
         for (std::vector<Base::Vector3d>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
@@ -318,9 +317,8 @@ void PropertyVectorList::RestoreDocFile(Base::Reader &reader)
     str >> uCt;
     std::vector<Base::Vector3d> values(uCt);
     if (reader.getFileVersion() > 0) {
-        for (std::vector<Base::Vector3d>::iterator it = values.begin(); it != values.end(); ++it) {
-            str >> it->x >> it->y >> it->z;
-        }
+        if (uCt > 0)
+            str.readArray(&(values[0].x), 3 * uCt);
     }
     else {
         float x,y,z;
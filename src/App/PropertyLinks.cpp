@@ -45,6 +45,33 @@ using namespace Base;
 using namespace std;
 
 
+namespace {
+
+// Keeps the back-link index of the owning document in sync when a link
+// property changes from \a oldLinks to \a newLinks.
+void updateBackLinks(const Property* prop,
+                     const std::vector<DocumentObject*>& oldLinks,
+                     const std::vector<DocumentObject*>& newLinks)
+{
+    DocumentObject* owner = dynamic_cast<DocumentObject*>(prop->getContainer());
+    Document* doc = owner ? owner->getDocument() : 0;
+    if (!doc)
+        return;
+    for (std::vector<DocumentObject*>::const_iterator it = oldLinks.begin(); it != oldLinks.end(); ++it)
+        doc->_removeBackLink(owner, *it);
+    for (std::vector<DocumentObject*>::const_iterator it = newLinks.begin(); it != newLinks.end(); ++it)
+        doc->_addBackLink(owner, *it);
+}
+
+void updateBackLink(const Property* prop, DocumentObject* oldLink, DocumentObject* newLink)
+{
+    if (oldLink == newLink)
+        return;
+    updateBackLinks(prop, std::vector<DocumentObject*>(1, oldLink),
+                          std::vector<DocumentObject*>(1, newLink));
+}
+
+}
 
 
 //**************************************************************************
@@ -76,6 +103,7 @@ PropertyLink::~PropertyLink()
 void PropertyLink::setValue(App::DocumentObject * lValue)
 {
     aboutToSetValue();
+    updateBackLink(this, _pcLink, lValue);
     _pcLink=lValue;
     hasSetValue();
 }
@@ -159,7 +187,9 @@ Property *PropertyLink::Copy(void) const
 void PropertyLink::Paste(const Property &from)
 {
     aboutToSetValue();
-    _pcLink = dynamic_cast<const PropertyLink&>(from)._pcLink;
+    DocumentObject* link = dynamic_cast<const PropertyLink&>(from)._pcLink;
+    updateBackLink(this, _pcLink, link);
+    _pcLink = link;
     hasSetValue();
 }
 
@@ -191,6 +221,7 @@ PropertyLinkSub::~PropertyLinkSub()
 void PropertyLinkSub::setValue(App::DocumentObject * lValue, const std::vector<std::string> &SubList)
 {
     aboutToSetValue();
+    updateBackLink(this, _pcLinkSub, lValue);
     _pcLinkSub=lValue;
     _cSubList = SubList;
     hasSetValue();
@@ -340,7 +371,9 @@ Property *PropertyLinkSub::Copy(void) const
 void PropertyLinkSub::Paste(const Property &from)
 {
     aboutToSetValue();
-    _pcLinkSub = dynamic_cast<const PropertyLinkSub&>(from)._pcLinkSub;
+    DocumentObject* link = dynamic_cast<const PropertyLinkSub&>(from)._pcLinkSub;
+    updateBackLink(this, _pcLinkSub, link);
+    _pcLinkSub = link;
     _cSubList = dynamic_cast<const PropertyLinkSub&>(from)._cSubList;
     hasSetValue();
 }
@@ -367,6 +400,10 @@ PropertyLinkList::~PropertyLinkList()
 
 void PropertyLinkList::setSize(int newSize)
 {
+    if (newSize < getSize()) {
+        std::vector<DocumentObject*> removed(_lValueList.begin() + newSize, _lValueList.end());
+        updateBackLinks(this, removed, std::vector<DocumentObject*>());
+    }
     _lValueList.resize(newSize);
 }
 
@@ -379,15 +416,23 @@ void PropertyLinkList::setValue(DocumentObject* lValue)
 {
     if (lValue){
         aboutToSetValue();
+        updateBackLinks(this, _lValueList, std::vector<DocumentObject*>(1, lValue));
         _lValueList.resize(1);
         _lValueList[0]=lValue;
         hasSetValue();
     }
 }
 
+void PropertyLinkList::set1Value(const int idx, DocumentObject* value)
+{
+    updateBackLink(this, _lValueList[idx], value);
+    _lValueList[idx] = value;
+}
+
 void PropertyLinkList::setValues(const std::vector<DocumentObject*>& lValue)
 {
     aboutToSetValue();
+    updateBackLinks(this, _lValueList, lValue);
     _lValueList=lValue;
     hasSetValue();
 }
@@ -492,7 +537,9 @@ Property *PropertyLinkList::Copy(void) const
 void PropertyLinkList::Paste(const Property &from)
 {
     aboutToSetValue();
-    _lValueList = dynamic_cast<const PropertyLinkList&>(from)._lValueList;
+    const std::vector<DocumentObject*>& links = dynamic_cast<const PropertyLinkList&>(from)._lValueList;
+    updateBackLinks(this, _lValueList, links);
+    _lValueList = links;
     hasSetValue();
 }
 
@@ -522,6 +569,10 @@ PropertyLinkSubList::~PropertyLinkSubList()
 
 void PropertyLinkSubList::setSize(int newSize)
 {
+    if (newSize < getSize()) {
+        std::vector<DocumentObject*> removed(_lValueList.begin() + newSize, _lValueList.end());
+        updateBackLinks(this, removed, std::vector<DocumentObject*>());
+    }
     _lValueList.resize(newSize);
     _lSubList  .resize(newSize);
 }
@@ -535,6 +586,7 @@ void PropertyLinkSubList::setValue(DocumentObject* lValue,const char* SubName)
 {
     if (lValue){
         aboutToSetValue();
+        updateBackLinks(this, _lValueList, std::vector<DocumentObject*>(1, lValue));
         _lValueList.resize(1);
         _lValueList[0]=lValue;
         _lSubList.resize(1);
@@ -546,6 +598,7 @@ void PropertyLinkSubList::setValue(DocumentObject* lValue,const char* SubName)
 void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,const std::vector<const char*>& lSubNames)
 {
     aboutToSetValue();
+    updateBackLinks(this, _lValueList, lValue);
     _lValueList = lValue;
     _lSubList.resize(lSubNames.size());
     int i = 0;
@@ -557,6 +610,7 @@ void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,c
 void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,const std::vector<std::string>& lSubNames)
 {
     aboutToSetValue();
+    updateBackLinks(this, _lValueList, lValue);
     _lValueList = lValue;
     _lSubList   = lSubNames;
     hasSetValue();
@@ -687,7 +741,9 @@ Property *PropertyLinkSubList::Copy(void) const
 void PropertyLinkSubList::Paste(const Property &from)
 {
     aboutToSetValue();
-    _lValueList = dynamic_cast<const PropertyLinkSubList&>(from)._lValueList;
+    const std::vector<DocumentObject*>& links = dynamic_cast<const PropertyLinkSubList&>(from)._lValueList;
+    updateBackLinks(this, _lValueList, links);
+    _lValueList = links;
     _lSubList   = dynamic_cast<const PropertyLinkSubList&>(from)._lSubList;
     hasSetValue();
 }
@@ -197,9 +197,7 @@ public:
     }
 
 
-    void  set1Value (const int idx, DocumentObject* value) {
-        _lValueList.operator[] (idx) = value;
-    }
+    void  set1Value (const int idx, DocumentObject* value);
 
     const std::vector<DocumentObject*> &getValues(void) const {
         return _lValueList;
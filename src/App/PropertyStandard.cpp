@@ -1193,7 +1193,7 @@ void PropertyFloatList::Save (Base::Writer &writer) const
     }
     else {
         writer.Stream() << writer.ind() << "<FloatList file=\"" << 
-        writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -1214,9 +1214,8 @@ void PropertyFloatList::SaveDocFile (Base::Writer &writer) const
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
     if (writer.getFileVersion() > 0) {
-        for (std::vector<double>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-            str << *it;
-        }
+        if (uCt > 0)
+            str.writeArray(&(_lValueList[0]), uCt);
     }
     else {
         for (std::vector<double>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
@@ -1233,9 +1232,8 @@ void PropertyFloatList::RestoreDocFile(Base::Reader &reader)
     str >> uCt;
     std::vector<double> values(uCt);
     if (reader.getFileVersion() > 0) {
-        for (std::vector<double>::iterator it = values.begin(); it != values.end(); ++it) {
-            str >> *it;
-        }
+        if (uCt > 0)
+            str.readArray(&(values[0]), uCt);
     }
     else {
         for (std::vector<double>::iterator it = values.begin(); it != values.end(); ++it) {
@@ -2325,7 +2323,7 @@ void PropertyColorList::setPyObject(PyObject *value)
 void PropertyColorList::Save (Base::Writer &writer) const
 {
     if (!writer.isForceXML()) {
-        writer.Stream() << writer.ind() << "<ColorList file=\"" << writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.Stream() << writer.ind() << "<ColorList file=\"" << writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -2347,9 +2345,13 @@ void PropertyColorList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
+    std::vector<uint32_t> packed;
+    packed.reserve(uCt);
     for (std::vector<App::Color>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << it->getPackedValue();
+        packed.push_back(it->getPackedValue());
     }
+    if (uCt > 0)
+        str.writeArray(&(packed[0]), uCt);
 }
 
 void PropertyColorList::RestoreDocFile(Base::Reader &reader)
@@ -2358,10 +2360,11 @@ void PropertyColorList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<Color> values(uCt);
-    uint32_t value; // must be 32 bit long
-    for (std::vector<App::Color>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> value;
-        it->setPackedValue(value);
+    std::vector<uint32_t> packed(uCt); // must be 32 bit long
+    if (uCt > 0)
+        str.readArray(&(packed[0]), uCt);
+    for (uint32_t i = 0; i < uCt; i++) {
+        values[i].setPackedValue(packed[i]);
     }
     setValues(values);
 }
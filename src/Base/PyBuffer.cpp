@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <cstring>
+# include <string>
+#endif
+
+#include "PyBuffer.h"
+#include "Exception.h"
+
+using namespace Base;
+
+namespace {
+
+std::size_t itemSize(char format)
+{
+    switch (format) {
+    case 'f':
+    case 'I':
+        return 4;
+    case 'd':
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/// Returns the format of \a fmt if it is one of \a formats, or 0
+char checkFormat(const char* fmt, std::size_t itemsize, const char* formats)
+{
+    // only native byte order is supported
+    if (*fmt == '@' || *fmt == '=')
+        fmt++;
+    if (fmt[0] == '\0' || fmt[1] != '\0')
+        return 0;
+    char format = fmt[0];
+    // 'L' is a 4 byte integer on some platforms
+    if (format == 'L' && itemsize == 4)
+        format = 'I';
+    if (!std::strchr(formats, format) || itemSize(format) != itemsize)
+        return 0;
+    return format;
+}
+
+}
+
+PyBuffer::PyBuffer(PyObject* obj, const char* formats)
+  : _release(false), _data(0), _count(0), _format(formats[0])
+{
+    std::size_t bytes = 0;
+    if (PyObject_CheckBuffer(obj)) {
+        if (PyObject_GetBuffer(obj, &_view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+            PyErr_Clear();
+            throw Base::TypeError("Buffer must be C-contiguous");
+        }
+        _release = true;
+        _data = _view.buf;
+        bytes = _view.len;
+
+        const char* fmt = _view.format ? _view.format : "B";
+        if (std::strcmp(fmt, "B") != 0 && std::strcmp(fmt, "b") != 0 && std::strcmp(fmt, "c") != 0) {
+            _format = checkFormat(fmt, _view.itemsize, formats);
+            if (_format == 0) {
+                std::string error = "Buffer has unsupported item format '";
+                error += fmt;
+                error += "'";
+                PyBuffer_Release(&_view);
+                throw Base::TypeError(error);
+            }
+        }
+    }
+#if PY_MAJOR_VERSION < 3
+    else {
+        // old-style buffer, e.g. array.array or str
+        Py_ssize_t len;
+        if (PyObject_AsReadBuffer(obj, &_data, &len) != 0) {
+            PyErr_Clear();
+            throw Base::TypeError("Object does not support the buffer protocol");
+        }
+        bytes = len;
+    }
+#else
+    else {
+        throw Base::TypeError("Object does not support the buffer protocol");
+    }
+#endif
+
+    std::size_t size = itemSize(_format);
+    if (bytes % size != 0) {
+        if (_release)
+            PyBuffer_Release(&_view);
+        throw Base::TypeError("Buffer size is not a multiple of the item size");
+    }
+    _count = bytes / size;
+}
+
+PyBuffer::~PyBuffer()
+{
+    if (_release)
+        PyBuffer_Release(&_view);
+}
+
+PyObject* PyBuffer::toByteArray(const void* data, std::size_t size)
+{
+    PyObject* array = PyByteArray_FromStringAndSize(0, (Py_ssize_t)size);
+    if (array && size > 0)
+        std::memcpy(PyByteArray_AsString(array), data, size);
+    return array;
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef BASE_PYBUFFER_H
+#define BASE_PYBUFFER_H
+
+// (re-)defined in pyconfig.h
+#if defined (_POSIX_C_SOURCE)
+#   undef    _POSIX_C_SOURCE
+#endif
+#if defined (_XOPEN_SOURCE)
+#   undef    _XOPEN_SOURCE
+#endif
+
+#include <Python.h>
+#include <cstddef>
+
+namespace Base
+{
+
+/**
+ * The PyBuffer class gives read access to the memory of a Python object that
+ * supports the buffer protocol, e.g. a bytearray or a numpy array. This way bulk
+ * data like point coordinates or facet indices can be passed from Python without
+ * creating a Python object for each value.
+ *
+ * The buffer must be C-contiguous. Its items must have one of the given struct
+ * format characters ('f' for float32, 'd' for float64, 'I' for uint32). Buffers
+ * without a format or with a byte format are taken as raw memory of the first
+ * format in the list.
+ */
+class BaseExport PyBuffer
+{
+public:
+    /** Gets the buffer of \a obj. Throws a TypeError if the object doesn't support
+     * the buffer protocol or has an unsupported layout.
+     */
+    PyBuffer(PyObject* obj, const char* formats);
+    ~PyBuffer();
+
+    /// Returns the format character of the items
+    char format() const
+    { return _format; }
+    /// Returns the number of items
+    std::size_t count() const
+    { return _count; }
+    const void* data() const
+    { return _data; }
+
+    /** Returns a new bytearray object with a copy of \a size bytes at \a data.
+     * A bytearray supports the buffer protocol and can be wrapped without
+     * copying, e.g. with numpy.frombuffer(data, numpy.float32).
+     */
+    static PyObject* toByteArray(const void* data, std::size_t size);
+
+private:
+    PyBuffer(const PyBuffer&);
+    PyBuffer& operator=(const PyBuffer&);
+
+private:
+    Py_buffer _view;
+    bool _release;
+    const void* _data;
+    std::size_t _count;
+    char _format;
+};
+
+} // namespace Base
+
+#endif // BASE_PYBUFFER_H
@@ -36,6 +36,8 @@
 #include <string>
 #include <vector>
 
+#include "Swap.h"
+
 class QByteArray;
 class QIODevice;
 class QBuffer;
@@ -80,6 +82,26 @@ public:
     OutputStream& operator << (float f);
     OutputStream& operator << (double d);
 
+    /** Writes \a count elements of \a data as one block of raw data.
+     * If no byte swapping is needed the whole block is passed to the
+     * underlying stream with a single write.
+     */
+    template <typename T>
+    OutputStream& writeArray(const T* data, std::size_t count)
+    {
+        if (!_swap) {
+            _out.write((const char*)data, count * sizeof(T));
+        }
+        else {
+            for (std::size_t i = 0; i < count; i++) {
+                T v = data[i];
+                SwapEndian<T>(v);
+                _out.write((const char*)&v, sizeof(T));
+            }
+        }
+        return *this;
+    }
+
 private:
     OutputStream (const OutputStream&);
     void operator = (const OutputStream&);
@@ -110,6 +132,20 @@ public:
     InputStream& operator >> (float& f);
     InputStream& operator >> (double& d);
 
+    /** Reads \a count elements into \a data with a single read of the
+     * underlying stream. The counterpart of OutputStream::writeArray().
+     */
+    template <typename T>
+    InputStream& readArray(T* data, std::size_t count)
+    {
+        _in.read((char*)data, count * sizeof(T));
+        if (_swap) {
+            for (std::size_t i = 0; i < count; i++)
+                SwapEndian<T>(data[i]);
+        }
+        return *this;
+    }
+
     operator bool() const
     {
         // test if _Ipfx succeeded
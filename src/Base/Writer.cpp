@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <locale>
+#include <zlib.h>
 
 using namespace Base;
 using namespace std;
@@ -108,7 +109,8 @@ int Writer::getFileVersion() const
     return fileVersion;
 }
 
-std::string Writer::addFile(const char* Name,const Base::Persistence *Object)
+std::string Writer::addFile(const char* Name,const Base::Persistence *Object,
+                            FileCompression Compression)
 {
     // always check isForceXML() before requesting a file!
     assert(isForceXML()==false);
@@ -116,6 +118,7 @@ std::string Writer::addFile(const char* Name,const Base::Persistence *Object)
     FileEntry temp;
     temp.FileName = getUniqueFileName(Name);
     temp.Object = Object;
+    temp.Compression = Compression;
   
     FileList.push_back(temp);
 
@@ -185,7 +188,7 @@ void Writer::decInd(void)
 }
 
 ZipWriter::ZipWriter(const char* FileName) 
-  : ZipStream(FileName)
+  : ZipStream(FileName), Level(Z_DEFAULT_COMPRESSION)
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -198,7 +201,7 @@ ZipWriter::ZipWriter(const char* FileName)
 }
 
 ZipWriter::ZipWriter(std::ostream& os) 
-  : ZipStream(os)
+  : ZipStream(os), Level(Z_DEFAULT_COMPRESSION)
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -217,6 +220,17 @@ void ZipWriter::writeFiles(void)
     size_t index = 0;
     while (index < FileList.size()) {
         FileEntry entry = FileList.begin()[index];
+        // a level of zero means no compression at all
+        if (entry.Compression == NoCompression || Level == Z_NO_COMPRESSION) {
+            ZipStream.setMethod(zipios::STORED);
+        }
+        else {
+            ZipStream.setMethod(zipios::DEFLATED);
+            if (entry.Compression == FastCompression)
+                ZipStream.setLevel(Z_BEST_SPEED);
+            else
+                ZipStream.setLevel(Level);
+        }
         ZipStream.putNextEntry(entry.FileName);
         entry.Object->SaveDocFile(*this);
         index++;
@@ -70,10 +70,18 @@ public:
     /// insert a binary file BASE64 coded as CDATA section in the XML file
     void insertBinFile(const char* FileName);
 
+    /// compression hint for an additional file
+    enum FileCompression {
+        DefaultCompression, /**< compress with the level of the writer */
+        FastCompression,    /**< fastest compression, for large binary arrays */
+        NoCompression       /**< store as is, e.g. for already compressed data */
+    };
+
     /** @name additional file writing */
     //@{
     /// add a write request of a persistent object
-    std::string addFile(const char* Name, const Base::Persistence *Object);
+    std::string addFile(const char* Name, const Base::Persistence *Object,
+                        FileCompression Compression = DefaultCompression);
     /// process the requested file storing
     virtual void writeFiles(void)=0;
     /// get all registered file names
@@ -100,6 +108,7 @@ protected:
     struct FileEntry {
         std::string FileName;
         const Base::Persistence *Object;
+        FileCompression Compression;
     };
     std::vector<FileEntry> FileList;
     std::vector<std::string> FileNames;
@@ -131,11 +140,12 @@ public:
     virtual std::ostream &Stream(void){return ZipStream;}
 
     void setComment(const char* str){ZipStream.setComment(str);}
-    void setLevel(int level){ZipStream.setLevel( level );}
+    void setLevel(int level){Level = level; ZipStream.setLevel( level );}
     void putNextEntry(const char* str){ZipStream.putNextEntry(str);}
 
 private:
     zipios::ZipOutputStream ZipStream;
+    int Level;
 };
 
 /** The StringWriter class 
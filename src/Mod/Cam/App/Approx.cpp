@@ -542,8 +542,12 @@ void Approximate::ParameterInnerPoints()
             std::vector<Base::Vector3f> NeiPnts;
             std::vector<unsigned long> nei;
             std::vector<unsigned int>::iterator nei_it;
-            PntNei = vv_it[v_it.Position()];
-            FacetNei = vf_it[v_it.Position()];
+            MeshCore::MeshIndexRange PntRange = vv_it[v_it.Position()];
+            MeshCore::MeshIndexRange FacetRange = vf_it[v_it.Position()];
+            PntNei.clear();
+            PntNei.insert(PntRange.begin(), PntRange.end());
+            FacetNei.clear();
+            FacetNei.insert(FacetRange.begin(), FacetRange.end());
             ReorderNeighbourList(PntNei,FacetNei,nei,v_it.Position());
             std::vector<double> Angle;
             std::vector<double> Magnitude;
@@ -36,6 +36,7 @@
 #include <Mod/Mesh/App/Core/Grid.h>
 #include <Mod/Mesh/App/Core/Builder.h>
 #include <Mod/Mesh/App/Core/TopoAlgorithm.h>
+#include <Mod/Mesh/App/Core/Registration.h>
 
 #include <Base/Builder3D.h>
 
@@ -57,8 +58,6 @@
 #include <Handle_Poly_Triangulation.hxx>
 #include <Poly_Triangulation.hxx>
 
-#include <ANN/ANN.h> // ANN declarations
-
 #include <SMESH_Gen.hxx>
 
 
@@ -80,90 +79,6 @@ void best_fit::Load(const MeshCore::MeshKernel &mesh, const TopoDS_Shape &cad)
 
 }
 
-double best_fit::ANN()
-{
-    ANNpointArray   dataPts;                // data points
-    ANNpoint        queryPt;                // query point
-    ANNidxArray     nnIdx;                    // near neighbor indices
-    ANNdistArray    dists;                    // near neighbor distances
-    ANNkd_tree*     kdTree;                    // search structure
-
-	Base::Builder3D log_error;
-
-    //MeshCore::MeshPointArray meshPnts = m_MeshWork.GetPoints();
-	m_pntCloud_2;
-    Base::Vector3f projPoint;
-
-    double error = 0.0;
-
-    int a_dim = 3;
-    int a_nbPnts =(int) m_pntCloud_2.size();        // Size vom eingescanntem Netz
-    int a_nbNear = 1;                               // anzahl der rckgabewerte
-    queryPt = annAllocPt(a_dim);                    // allocate query point storage
-    dataPts = annAllocPts(a_nbPnts, a_dim);         // allocate data points storage
-    nnIdx = new ANNidx[a_nbNear];                   // allocate near neigh indices
-    dists = new ANNdist[a_nbNear];                  // allocatenear neighbor dists
-
-    m_LSPnts[0].clear();
-    m_LSPnts[1].clear();
-
-    for (int i=0; i<a_nbPnts; ++i)
-    {
-        dataPts[i][0] = m_pntCloud_2[i].x;
-        dataPts[i][1] = m_pntCloud_2[i].y;
-        dataPts[i][2] = m_pntCloud_2[i].z;
-    }
-
-    kdTree = new ANNkd_tree(        // build search structure
-        dataPts,                    // the data points
-        a_nbPnts,            // number of points
-        a_dim);                     // dimension of space
-
-
-    for (unsigned int i = 0 ; i < m_pntCloud_1.size() ; i++ )
-    {
-        queryPt[0] = m_pntCloud_1[i].x;
-        queryPt[1] = m_pntCloud_1[i].y;
-        queryPt[2] = m_pntCloud_1[i].z;
-
-        kdTree->annkSearch(                        // search
-            queryPt,							   // query point
-            a_nbNear,						       // number of near neighbors
-            nnIdx,                                 // nearest neighbors (returned)
-            dists                                  // distance (returned)
-        );                                         // error bound
-
-        m_LSPnts[1].push_back(m_pntCloud_1[i]);
-        m_LSPnts[0].push_back(m_pntCloud_2[nnIdx[0]]);
-
-		if(m_pntCloud_1[i].z <= m_pntCloud_2[nnIdx[0]].z)
-		{
-			log_error.addSingleLine(m_pntCloud_1[i],m_pntCloud_2[nnIdx[0]],8,1,0,0);
-		}
-		else
-		{
-			log_error.addSingleLine(m_pntCloud_1[i],m_pntCloud_2[nnIdx[0]],8,0,1,0);
-		}
-
-		//if(dists[0] > error)
-			error += dists[0];
-
-    }
-
-	log_error.saveToFile("c:/errorVec_fit.iv");
-
-    error /= double(m_pntCloud_1.size());
-    m_weights_loc = m_weights;
-
-
-    delete [] nnIdx; // clean things up
-    delete [] dists;
-    delete kdTree;
-    annClose(); // done with ANN
-
-    return error;
-}
-
 bool best_fit::Perform()
 {
     Base::Matrix4D M;
@@ -232,15 +147,18 @@ bool best_fit::Perform()
 
 	}
 
-    Runtime_BestFit << "- Error: " << ANN() << endl;
+    // The scan stays in place and the CAD points are moved onto it instead,
+    // so the search tree over the scan is built once for the whole fit.
+    MeshCore::PointRegistration registration(m_pntCloud_2);
+    Base::Matrix4D cadToScan;
 
-    Coarse_correction();
+    Coarse_correction(registration, cadToScan);
 
 	sec2 = time(NULL);
 	Runtime_BestFit << "Coarse Correction: " << sec2-sec1 << " sec" << endl;
 
     sec1 = time(NULL);
-	LSM();
+	LSM(registration, cadToScan);
 	sec2 = time(NULL);
     Runtime_BestFit << "Least-Square-Matching: " << sec2-sec1 << " sec" << endl;
 	Runtime_BestFit.close();
@@ -285,9 +203,11 @@ bool best_fit::Perform_PointCloud()
 	PointTransform(m_pntCloud_1,M);
 	PointTransform(m_pntCloud_2,M);
 
-	//Runtime_BestFit << "- Error: " << ANN() << endl;
+	MeshCore::PointRegistration registration(m_pntCloud_2);
+	Base::Matrix4D cadToScan;
+
     sec1 = time(NULL);
-	Coarse_correction();
+	Coarse_correction(registration, cadToScan);
 	sec2 = time(NULL);
 	Runtime_BestFit << "Coarse Correction: " << sec2-sec1 << " sec" << endl;
 
@@ -299,7 +219,7 @@ bool best_fit::Perform_PointCloud()
 	//PointTransform(m_pntCloud_2,M);
 
 	sec1 = time(NULL);
-	LSM();
+	LSM(registration, cadToScan);
 	sec2 = time(NULL);
 	Runtime_BestFit << "Least-Square-Matching: " << sec2-sec1 << " sec" << endl;
 	Runtime_BestFit.close();
@@ -393,357 +313,48 @@ int best_fit::intersect_RayTriangle(const Base::Vector3f &normal,const MeshCore:
 }
 */
 
-bool best_fit::Coarse_correction()
+bool best_fit::Coarse_correction(const MeshCore::PointRegistration &registration, Base::Matrix4D &cadToScan)
 {
-    double error, error_tmp, rot = 0.0;
-    Base::Matrix4D M,T;
-	ofstream CoarseCorr;
-
-	CoarseCorr.open("c:/CoarseCorr.txt");
+    std::vector<unsigned long> targets;
+    Base::Matrix4D M, T;
+    double error, error_tmp;
 
-    std::vector<Base::Vector3f> m_pntCloud_Work = m_pntCloud_2;
-
-    T.setToUnity();
-    best_fit befi; 
-    
-	//error = CompError_GetPnts(m_pnts, m_normals)[0];  // startfehler    int n=360/rstep_corr;
-    
-	error = ANN();
+    error = registration.FindCorrespondences(m_pntCloud_1, cadToScan, targets);
 
     for (int i=1; i<4; ++i)
     {
+        // turning the scan by 180 degree is the same as turning the CAD points
         RotMat(M, 180, i);
-        PointTransform(m_pntCloud_2, M);
-		//m_MeshWork.Transform(M);
 
-        error_tmp = ANN();
-		
-		//error_tmp = CompError_GetPnts(m_pnts, m_normals)[0];
-        //error_tmp = befi.CompTotalError(m_MeshWork);
-		
-		CoarseCorr << i << ", " << error_tmp << endl;
+        error_tmp = registration.FindCorrespondences(m_pntCloud_1, M * cadToScan, targets);
 
         if (error_tmp < error)
         {
             T = M;
             error = error_tmp;
         }
-
-        m_pntCloud_2 = m_pntCloud_Work;
     }
 
-	CoarseCorr << "BEST CHOICE: " << error << endl;
-	CoarseCorr.close();
-    PointTransform(m_pntCloud_2, T);
-	m_MeshWork.Transform(T);
-
-
+    cadToScan = T * cadToScan;
     return true;
 }
 
 
-bool best_fit::LSM()
-{
-    double TOL  = 0.05;          // Abbruchkriterium des Newton-Verfahren
-    int maxIter = 100;            // maximale Anzahl von Iterationen fr den Fall,
-							     // dass das Abbruchkriterium nicht erfllt wird
-
-   int mult = 2;                 // zur Halbierung der Schrittweite bei Misserfolg des Newton Verfahrens
-
-    double val, tmp = 1e+10, delta, delta_tmp = 0.0;
-    Base::Matrix4D Tx,Ty,Tz,Rx,Ry,Rz,M;   // Transformaitonsmatrizen
-
-	ofstream anOutputFile;
-	anOutputFile.open("c:/outputBestFit.txt");
-    anOutputFile.precision(7);
-
-      int c=0; // Laufvariable
-    
-
-
-    std::vector<double> del_x(3,0.0);
-    std::vector<double>     x(3,0.0); // Startparameter entspricht Nullvektor
-
-    Base::Vector3f centr_l,centr_r, cent;  // Schwerpunkte der Punktestze
-
-    // Newton Verfahren: 1. Lse  H*del_x = -J
-    //                   2. Setze x = x + del_x
-
-    std::vector<double> Jac(3);           // 1.Ableitung der Fehlerfunktion (Jacobi-Matrix)
-    std::vector< std::vector<double> > H; // 2.Ableitung der Fehlerfunktion (Hesse-Matrix)
-
-    time_t seconds1, seconds2, sec1, sec2;
-    seconds1 = time(NULL);
-
-    while (true)
-    {
-
-        seconds1 = time(NULL);
-        //m_Mesh = m_MeshWork;
-        
-		// Fehlerberechnung vom CAD -> Mesh
-        //tmp = CompError_GetPnts(m_pnts, m_normals);      // hier: - Berechnung der LS-Punktestze
-        //      CompTotalError()                           //       - Berechnung der zugehrigen Gewichtungen
-
-		delta = delta_tmp;
-        delta_tmp = ANN();          // gibt durchschnittlichen absoluten Fehler aus
-		delta = delta - delta_tmp ; // hier wird die Fehlerverbesserung zum vorigen Iterationsschritt gespeichert
-
-		if (c==maxIter || delta < ERR_TOL && c>1) break; // Abbruchkriterium (falls maximale Iterationsschrite erreicht
-										                 //                   oder falls Fehlernderung unsignifikant gering)
-
-        seconds2 = time(NULL);
-		anOutputFile << c << ", " << delta_tmp << ", " << delta << "    -    Time: " << seconds2 - seconds1 << " sec" << endl;
-		seconds1 = time(NULL);
-
-		sec1 = time(NULL);
-        for (unsigned int i=0; i<x.size(); ++i) x[i] = 0.0; // setzt startwerte fr newton auf null
-
-
-        // Berechne gewichtete Schwerpunkte und verschiebe die Punktestze entsprechend:
-        centr_l.Scale(0.0,0.0,0.0);
-        centr_r.Scale(0.0,0.0,0.0);
-
-        Base::Vector3f p,q;
-		double Sum = 0.0;
-        for (unsigned int i=0; i<m_LSPnts[0].size(); ++i)
-        {
-            p = m_LSPnts[0][i];
-            q = m_LSPnts[1][i];
-
-            p.Scale((float) m_weights_loc[i],(float) m_weights_loc[i],(float) m_weights_loc[i]);
-            q.Scale((float) m_weights_loc[i],(float) m_weights_loc[i],(float) m_weights_loc[i]);
-
-			Sum += m_weights_loc[i];
-			centr_l += p;
-            centr_r += q;
-        }
-
-		centr_l.Scale( -1.0f/float(Sum), -1.0f/float(Sum), -1.0f/float(Sum));
-		centr_r.Scale( -1.0f/(float)Sum, -1.0f/(float)Sum, -1.0f/(float)Sum);
-
-       /* float s = (float) m_LSPnts[0].size();
-        s = float(-1.0/s);
-
-        centr_l.Scale(s,s,s);
-        centr_r.Scale(s,s,s);*/
-
-
-
-        // Verschiebung der Schwerpunkte zum Ursprung
-        TransMat(Tx,centr_l.x,1);
-        TransMat(Ty,centr_l.y,2);
-        TransMat(Tz,centr_l.z,3);
-
-        M = Tx*Ty*Tz;
-        PointTransform(m_LSPnts[0],M);
-		PointTransform(m_pntCloud_1,M);
-		PointTransform(m_pntCloud_2,M);
-        m_MeshWork.Transform(M);
-
-        TransMat(Tx,centr_r.x,1); // Berechnung der Translationsmatrix in x-Richtung
-        TransMat(Ty,centr_r.y,2); // Berechnung der Translationsmatrix in y-Richtung
-        TransMat(Tz,centr_r.z,3); // Berechnung der Translationsmatrix in z-Richtung
-
-        M = Tx*Ty*Tz;                  // Zusammenfgen zu einer Gesamttranslationsmatrix
-        PointTransform(m_LSPnts[1],M); // Anwendung der Translation auf m_LSPnts
-        PointTransform(m_pntCloud_1,M);
-		//PointNormalTransform(m_pnts, m_normals, M); // Anwendung der Translation auf m_pnts
-        m_CadMesh.Transform(M);                       // Anwendung der Translation auf das CadMesh
-
-        sec2 = time(NULL);
-		anOutputFile << c+1 << " - Initialisierung und Transformation um gewichtete Schwerpunkte: " << sec2 - sec1 << " sec" << endl;
-
-		sec1 = time(NULL);
-        // Newton-Verfahren zur Berechnung der Rotationsmatrix:
-        while (true)
-        {
-
-            Jac = Comp_Jacobi(x);  // berechne 1.Ableitung
-            H   = Comp_Hess(x);    // berechne 2.Ableitung
-
-            val = 0.0;
-            for (unsigned int i=0; i<Jac.size(); ++i)
-            {
-                val += Jac[i]*Jac[i];
-            }
-            val = sqrt(val);
-
-            if (val < TOL) break; // Abbruchkriterium des Newton-Verfahren
-
-            if (val>tmp && mult < 1e+4)
-            {
-                for (unsigned int i=0; i<del_x.size(); ++i)
-                {
-                    x[i] -= del_x[i]/double(mult);  // Halbiere Schrittweite falls keine Verbesserung
-                }
-                mult *= 2;
-                continue;
-            }
-            else
-            {
-                mult = 2;
-            }
-
-            tmp = val;
-
-            del_x = Routines::NewtonStep(Jac,H);      // lst Gl.system:          H*del_x = -J
-            for (unsigned int i=0; i<x.size(); ++i)   // nchster Iterationswert: x = x + del_x
-            {
-                x[i] += del_x[i];
-            }
-        }
-
-		sec2 = time(NULL);
-		anOutputFile << c+1 << " - Newton: " << seconds2 - seconds1 << " sec" << endl;
-        sec1 = time(NULL);
-        // Rotiere und verschiebe zurck zum Ursprung der !!! CAD-Geometrie !!!
-        RotMat  (Rx,(x[0]*180.0/PI),1);
-        RotMat  (Ry,(x[1]*180.0/PI),2);
-        RotMat  (Rz,(x[2]*180.0/PI),3);
-
-		Base::Matrix4D R = Rx*Ry*Rz;
-		centr_l.Scale(-1.0, -1.0, -1.0);
-
-		cent.x =(float)  (R[0][0]*centr_l.x + R[0][1]*centr_l.y + R[0][2]*centr_l.z);
-		cent.y =(float)  (R[1][0]*centr_l.x + R[1][1]*centr_l.y + R[1][2]*centr_l.z);
-		cent.z =(float)  (R[2][0]*centr_l.x + R[2][1]*centr_l.y + R[2][2]*centr_l.z);
-			 
-		TransMat(Tx, -centr_r.x - cent.x + centr_l.x, 1);
-        TransMat(Ty, -centr_r.y - cent.y + centr_l.y, 2);
-		TransMat(Tz, -centr_r.z - cent.z + centr_l.z, 3);
-
-        M = Tx*Ty*Tz*Rx*Ry*Rz; // Rotiere zuerst !!! (Rotationen stets um den Nullpunkt...)
-        
-		PointTransform(m_pntCloud_2,M);
-		m_MeshWork.Transform(M);
-
-		TransMat(Tx, -centr_r.x, 1);
-		TransMat(Ty, -centr_r.y, 2);
-		TransMat(Tz, -centr_r.z, 3);
-
-        M = Tx*Ty*Tz;
-		PointTransform(m_pntCloud_1,M);
-        m_CadMesh.Transform(M);
-        //PointNormalTransform(m_pnts, m_normals, M);
-
-   		sec2 = time(NULL);
-		
-		anOutputFile << c+1 << " - Trafo: " << seconds2 - seconds1 << " sec" << endl;
-        ++c;  //Erhhe Laufvariable 
-    }
-
-	anOutputFile.close();
-return true;
-
-    /*TransMat(Tx,-centr_l.x,1);
-       TransMat(Ty,-centr_l.y,2);
-    TransMat(Tz,-centr_l.z,3);
-
-    M = Tx*Ty*Tz;
-    PointTransform(m_LSPnts[0],M);
-
-    TransMat(Tx,-centr_r.x,1);
-       TransMat(Ty,-centr_r.y,2);
-    TransMat(Tz,-centr_r.z,3);
-
-    M = Tx*Ty*Tz;
-    PointTransform(m_LSPnts[1],M);
-
-    Base::Builder3D log;
-
-    for(unsigned int i=0; i<m_LSPnts[0].size(); ++i)
-     log.addSingleArrow(m_LSPnts[0][i],m_LSPnts[1][i]);
-
-    log.saveToFile("c:/newton_pnts.iv");*/
-
-  
-}
-
-
-std::vector<double> best_fit::Comp_Jacobi(const std::vector<double> &x)
-{
-    std::vector<double> F(3,0.0);
-    double s1 = sin(x[0]), c1 = cos(x[0]);
-    double s2 = sin(x[1]), c2 = cos(x[1]);
-    double s3 = sin(x[2]), c3 = cos(x[2]);
-
-    Base::Vector3f p,q;
-
-    for (unsigned int i=0; i<m_LSPnts[0].size(); ++i)
-    {
-        p = m_LSPnts[0][i];
-        q = m_LSPnts[1][i];
-
-        F[0] += ( q.y * ( (-c1*s2*c3-s1*s3) * p.x +  (c1*s2*s3-s1*c3) * p.y + (-c1*c2) * p.z ) +
-                  q.z * ( (-s1*s2*c3+c1*s3) * p.x +  (s1*s2*s3+c1*c3) * p.y + (-s1*c2) * p.z ) )*m_weights_loc[i];
-
-        F[1] += ( q.x * (          (-s2*c3) * p.x +           (s2*s3) * p.y +    (-c2) * p.z ) +
-                  q.y * (       (-s1*c2*c3) * p.x +        (s1*c2*s3) * p.y +  (s1*s2) * p.z ) +
-                  q.z * (        (c1*c2*c3) * p.x +       (-c1*c2*s3) * p.y + (-c1*s2) * p.z ) )*m_weights_loc[i];
-
-        F[2] += ( q.x * (          (-c2*s3) * p.x +          (-c2*c3) * p.y) +
-                  q.y * (  (s1*s2*s3+c1*c3) * p.x +  (s1*s2*c3-c1*s3) * p.y) +
-                  q.z * ( (-c1*s2*s3+s1*c3) * p.x + (-c1*s2*c3-s1*s3) * p.y) )*m_weights_loc[i];
-    }
-
-    return F;
-}
-
-std::vector<std::vector<double> > best_fit::Comp_Hess(const std::vector<double> &x)
+bool best_fit::LSM(MeshCore::PointRegistration &registration, Base::Matrix4D &cadToScan)
 {
-    std::vector<std::vector<double> > DF(3);
-    for (unsigned int i=0; i<DF.size(); ++i)
-    {
-        DF[i].resize(3,0.0);
-    }
-
-    double s1 = sin(x[0]), c1 = cos(x[0]);
-    double s2 = sin(x[1]), c2 = cos(x[1]);
-    double s3 = sin(x[2]), c3 = cos(x[2]);
+    std::vector<float> weights(m_weights.begin(), m_weights.end());
 
-    double sum1 = 0.0, sum2 = 0.0, sum3 = 0.0, sum4 = 0.0, sum5 = 0.0, sum6 = 0.0;
+    registration.SetMaxIterations(100);
+    registration.SetTolerance((float) ERR_TOL);
+    registration.Perform(m_pntCloud_1, cadToScan, &weights);
 
-    Base::Vector3f p,q;
+    // move the scan onto the CAD geometry
+    Base::Matrix4D scanToCad = cadToScan;
+    scanToCad.inverseOrthogonal();
+    PointTransform(m_pntCloud_2, scanToCad);
+    m_MeshWork.Transform(scanToCad);
 
-    for (unsigned int i=0; i<m_LSPnts[0].size(); ++i)
-    {
-        p = m_LSPnts[0][i];
-        q = m_LSPnts[1][i];
-
-        sum1      = q.y * (  (s1*s2*c3-c1*s3) * p.x + (-s1*s2*s3-c1*c3) * p.y +  (s1*c2) * p.z ) +
-                    q.z * ( (-c1*s2*c3-s1*s3) * p.x +  (c1*s2*s3-s1*c3) * p.y + (-c1*c2) * p.z );
-
-        sum2      = q.x * (          (-c2*c3) * p.x +           (c2*s3) * p.y +     (s2) * p.z ) +
-                    q.y * (        (s1*s2*c3) * p.x +       (-s1*s2*s3) * p.y +  (s1*c2) * p.z ) +
-                    q.z * (       (-c1*s2*c3) * p.x +        (c1*s2*s3) * p.y + (-c1*c2) * p.z );
-
-        sum3      = q.x * (          (-c2*c3) * p.x +           (c2*s3) * p.y) +
-                    q.y * (  (s1*s2*c3-c1*s3) * p.x + (-s1*s2*s3-c1*c3) * p.y) +
-                    q.z * ( (-c1*s2*c3-s1*s3) * p.x +  (c1*s2*s3-s1*c3) * p.y);
-
-        sum4      = q.y * (       (-c1*c2*c3) * p.x +        (c1*c2*s3) * p.y +  (c1*s2) * p.z ) +
-                    q.z * (       (-s1*c2*c3) * p.x +        (s1*c2*s3) * p.y +  (s1*s2) * p.z );
-
-        sum5      = q.y * (  (c1*s2*s3-s1*c3) * p.x +  (c1*s2*c3+s1*s3) * p.y) +
-                    q.z * (  (s1*s2*s3+c1*c3) * p.x +  (s1*s2*c3-c1*s3) * p.y);
-
-        sum6      = q.x * (           (s2*s3) * p.x +           (s2*c3) * p.y) +
-                    q.y * (        (s1*c2*s3) * p.x +        (s1*c2*c3) * p.y) +
-                    q.z * (       (-c1*c2*s3) * p.x +       (-c1*c2*c3) * p.y);
-
-        DF[0][0] += sum1*m_weights_loc[i];
-        DF[1][1] += sum2*m_weights_loc[i];
-        DF[2][2] += sum3*m_weights_loc[i];
-        DF[0][1] += sum4*m_weights_loc[i];
-        DF[1][0] += sum4*m_weights_loc[i];
-        DF[0][2] += sum5*m_weights_loc[i];
-        DF[2][0] += sum5*m_weights_loc[i];
-        DF[1][2] += sum6*m_weights_loc[i];
-        DF[2][1] += sum6*m_weights_loc[i];
-    }
-
-    return DF;
+    return true;
 }
 
 bool best_fit::Comp_Weights()
@@ -1518,12 +1129,12 @@ std::vector<Base::Vector3f> best_fit::Comp_Normals(MeshCore::MeshKernel &M)
         origPoint.y = mPnt.y;
         origPoint.z = mPnt.z;
 
-        const std::set<unsigned long>& faceSet = rf2pt[i];
+        MeshCore::MeshIndexRange faceSet = rf2pt[i];
         fArea = 0.0;
         normal.Set(0.0,0.0,0.0);
 
         // Iteriere ber die Dreiecke zu jedem Punkt
-        for (std::set<unsigned long>::const_iterator it = faceSet.begin(); it != faceSet.end(); ++it)
+        for (MeshCore::MeshIndexRange::const_iterator it = faceSet.begin(); it != faceSet.end(); ++it)
         {
             // Zweimal derefernzieren, um an das MeshFacet zu kommen und dem Kernel uebergeben, dass er ein MeshGeomFacet liefert
             t_face = M.GetFacet(*it);
@@ -1852,10 +1463,10 @@ double best_fit::CompTotalError()
     MeshCore::MeshRefPointToPoints vv_it(m_CadMesh);
     MeshCore::MeshPointArray::_TConstIterator v_beg = m_CadMesh.GetPoints().begin();
 
-    std::set<unsigned long>::const_iterator v_it;
+    MeshCore::MeshIndexRange::const_iterator v_it;
     for (unsigned int i=0; i<FailProj.size(); ++i)
     {
-        const std::set<unsigned long>& PntNei = vv_it[FailProj[i]];
+        MeshCore::MeshIndexRange PntNei = vv_it[FailProj[i]];
         m_error[FailProj[i]] = 0.0;
 
         for (v_it = PntNei.begin(); v_it !=PntNei.end(); ++v_it)
@@ -1941,10 +1552,10 @@ double best_fit::CompTotalError(MeshCore::MeshKernel &mesh)
     MeshCore::MeshPointArray::_TConstIterator v_beg = m_CadMesh.GetPoints().begin();
 
 	double error;
-	std::set<unsigned long>::const_iterator v_it;
+	MeshCore::MeshIndexRange::const_iterator v_it;
     for (unsigned int i=0; i<FailProj.size(); ++i)
     {
-        const std::set<unsigned long>& PntNei = vv_it[FailProj[i]];
+        MeshCore::MeshIndexRange PntNei = vv_it[FailProj[i]];
 		error = 0.0;
 
 
@@ -36,6 +36,9 @@
 #include <SMESH_Mesh.hxx>
 #include <SMDS_VolumeTool.hxx>
 
+namespace MeshCore {
+class PointRegistration;
+}
 
 #define SMALL_NUM  1e-6
 #define ERR_TOL    0.001       // Abbruchkriterium fr Least-Square-Matching (Fehlernderung zweier aufeinanderfolgenden Iterationsschritten)
@@ -133,13 +136,12 @@ public:
 	
     /*! \brief Check and corrects mesh-position by rotating around all
                coordinate-axes with 180 degree
-    */
-    bool Coarse_correction();
 
-    /*! \brief Determines two corresponding point-sets for the ICP-Method
-               using the Nearest-Neighbour-Algorithm
+        \param registration search structure over the scanned points m_pntCloud_2
+        \param cadToScan    transformation of the CAD-points onto the scan,
+                            the best rotation is added to it
     */
-    double ANN();
+    bool Coarse_correction(const MeshCore::PointRegistration &registration, Base::Matrix4D &cadToScan);
 
     /*! \brief Input-shape from the function Load */
     TopoDS_Shape m_Cad;              // CAD-Geometrie
@@ -167,7 +169,7 @@ public:
     /*! \brief Stores the error-values of m_CadMesh in relative order */
     std::vector<double>         m_error;
 
-    /*! \brief Stores the point-sets computed with the function ANN() */
+    /*! \brief Stores the point-sets computed with the function CompError_GetPnts() */
     std::vector<std::vector<Base::Vector3f> > m_LSPnts;  // zu fittende Punktestze fr den Least-Square
 
     /*! \brief Stores the weights computed with the function Comp_Weights() */
@@ -222,25 +224,15 @@ private:
     /*! \brief Sets the weights for the ICP-Algorithm */
     bool Comp_Weights();
 
-    /*! \brief Performing the ICP-Algorithm */
-    bool LSM();
-
-    /*! \brief Returns the first derivative of the rotation-matrix at the
-               position x
-
-        \param params is a three-dimensional-vector specifying the rotation
-                      angle along the x-,y- and z-axis
-     */
-    std::vector<double> Comp_Jacobi(const std::vector<double> &params);
+    /*! \brief Performing the ICP-Algorithm
 
-    /*! \brief Returns the second derivative (Hessian matrix) of the rotation
-               matrix at the position x in form of a two-dimensional vector
-               of type double
+        Moves the weighted CAD-points m_pntCloud_1 onto the scan starting
+        with \p cadToScan and applies the inverse of the result to the scan
 
-        \param params is a three-dimensional-vector specifying the rotation
-                      angle along the x-,y- and z-axis
+        \param registration search structure over the scanned points m_pntCloud_2
+        \param cadToScan    start and resulting transformation of the CAD-points
     */
-    std::vector<std::vector<double> > Comp_Hess (const std::vector<double> &params);
+    bool LSM(MeshCore::PointRegistration &registration, Base::Matrix4D &cadToScan);
 
     SMESH_Mesh *m_referencemesh;
     SMESH_Mesh *m_meshtobefit;
@@ -16,7 +16,10 @@
 
 #include <Base/Console.h>
 #include <Base/Interpreter.h>
+#include <App/Application.h>
+#include <boost/bind.hpp>
  
+#include "ProjectionAlgos.h"
 #include "FeaturePage.h"
 #include "FeatureView.h"
 #include "FeatureViewPart.h"
@@ -63,6 +66,9 @@ void DrawingExport initDrawing()
     Drawing::FeatureViewAnnotation  ::init();
     Drawing::FeatureViewSymbol      ::init();
     Drawing::FeatureClip            ::init();
+
+    // the cached projections hold the shapes of the document
+    App::GetApplication().signalDeleteDocument.connect(boost::bind(&Drawing::ProjectionAlgos::clearCache));
 }
 
 } // extern "C"
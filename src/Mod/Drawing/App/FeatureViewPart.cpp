@@ -56,6 +56,7 @@
 
 #include <Base/Exception.h>
 #include <Base/FileInfo.h>
+#include <App/DocumentObjectGroup.h>
 #include <Mod/Part/App/PartFeature.h>
 
 #include "FeatureViewPart.h"
@@ -87,12 +88,52 @@ FeatureViewPart::FeatureViewPart(void)
     ADD_PROPERTY_TYPE(HiddenWidth,(0.15),vgroup,App::Prop_None,"The thickness of the hidden lines, if enabled");
     ADD_PROPERTY_TYPE(Tolerance,(0.05),vgroup,App::Prop_None,"The tessellation tolerance");
     Tolerance.setConstraints(&floatRange);
+    ADD_PROPERTY_TYPE(PolygonalHLR ,(false),group,App::Prop_None,"Remove hidden lines on the tessellated shape, faster but only of preview quality");
 }
 
 FeatureViewPart::~FeatureViewPart()
 {
 }
 
+bool FeatureViewPart::getProjectionRequest(ProjectionAlgos::Request& request) const
+{
+    App::DocumentObject* link = Source.getValue();
+    if (!link || !link->getTypeId().isDerivedFrom(Part::Feature::getClassTypeId()))
+        return false;
+    request.Shape = static_cast<Part::Feature*>(link)->Shape.getShape()._Shape;
+    request.Direction = Direction.getValue();
+    request.Mode = PolygonalHLR.getValue() ? ProjectionAlgos::PolygonalHLR : ProjectionAlgos::ExactHLR;
+    request.Deflection = Tolerance.getValue();
+    return !request.Shape.IsNull();
+}
+
+void FeatureViewPart::prefetchPageViews() const
+{
+    // The views of a page are recomputed one after the other. Compute the
+    // projections of all views of the page that are going to be recomputed
+    // at once, so that they run in parallel and are found in the cache.
+    App::DocumentObjectGroup* page = getGroup();
+    if (!page)
+        return;
+
+    std::vector<ProjectionAlgos::Request> requests;
+    const std::vector<App::DocumentObject*> &Grp = page->Group.getValues();
+    for (std::vector<App::DocumentObject*>::const_iterator It= Grp.begin();It!=Grp.end();++It) {
+        if (!(*It)->getTypeId().isDerivedFrom(FeatureViewPart::getClassTypeId()))
+            continue;
+        const FeatureViewPart* view = static_cast<const FeatureViewPart*>(*It);
+        App::DocumentObject* link = view->Source.getValue();
+        if (view != this && !view->isTouched() && !view->mustExecute() && !(link && link->isTouched()))
+            continue;
+        ProjectionAlgos::Request request;
+        if (view->getProjectionRequest(request))
+            requests.push_back(request);
+    }
+
+    if (requests.size() > 1)
+        ProjectionAlgos::prefetch(requests);
+}
+
 App::DocumentObjectExecReturn *FeatureViewPart::execute(void)
 {
     std::stringstream result;
@@ -109,9 +150,14 @@ App::DocumentObjectExecReturn *FeatureViewPart::execute(void)
     Base::Vector3d Dir = Direction.getValue();
     bool hidden = ShowHiddenLines.getValue();
     bool smooth = ShowSmoothLines.getValue();
+    ProjectionAlgos::HLRMode mode = PolygonalHLR.getValue() ? ProjectionAlgos::PolygonalHLR : ProjectionAlgos::ExactHLR;
 
     try {
-        ProjectionAlgos Alg(shape,Dir);
+        // The first view of the page that executes computes the projections
+        // of the other views too. When they execute, they find them in the
+        // cache and prefetchPageViews() has nothing left to do.
+        prefetchPageViews();
+        ProjectionAlgos Alg(shape,Dir,mode,this->Tolerance.getValue());
         result  << "<g" 
                 << " id=\"" << ViewName << "\"" << endl
                 << "   transform=\"rotate("<< Rotation.getValue() << ","<< X.getValue()<<","<<Y.getValue()<<") translate("<< X.getValue()<<","<<Y.getValue()<<") scale("<< Scale.getValue()<<","<<Scale.getValue()<<")\"" << endl
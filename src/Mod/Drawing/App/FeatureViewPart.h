@@ -30,6 +30,7 @@
 #include <App/DocumentObject.h>
 #include <App/PropertyLinks.h>
 #include "FeatureView.h"
+#include "ProjectionAlgos.h"
 #include <App/FeaturePython.h>
 
 
@@ -55,6 +56,7 @@ public:
     App::PropertyFloat  LineWidth;
     App::PropertyFloat  HiddenWidth;
     App::PropertyFloatConstraint  Tolerance;
+    App::PropertyBool   PolygonalHLR;
 
 
     /** @name methods overide Feature */
@@ -68,6 +70,10 @@ public:
         return "DrawingGui::ViewProviderDrawingView";
     }
 
+private:
+    bool getProjectionRequest(ProjectionAlgos::Request&) const;
+    void prefetchPageViews() const;
+
 private:
     static App::PropertyFloatConstraint::Constraints floatRange;
 };
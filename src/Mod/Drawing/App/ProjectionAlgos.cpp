@@ -35,6 +35,9 @@
 #include <BRepBndLib.hxx>
 #include <BRepBuilderAPI_Transform.hxx>
 #include <HLRBRep_Algo.hxx>
+#include <HLRBRep_PolyAlgo.hxx>
+#include <HLRBRep_PolyHLRToShape.hxx>
+#include <Standard.hxx>
 #include <TopoDS_Shape.hxx>
 #include <HLRTopoBRep_OutLiner.hxx>
 //#include <BRepAPI_MakeOutLine.hxx>
@@ -81,17 +84,102 @@
 #include "ProjectionAlgos.h"
 #include "DrawingExport.h"
 
+#include <list>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrentMap>
+
 using namespace Drawing;
 using namespace std;
 
+namespace {
+
+/// the result sets of a projection
+struct ProjectionResult
+{
+    TopoDS_Shape V, V1, VN, VO, VI;
+    TopoDS_Shape H, H1, HN, HO, HI;
+};
+
+struct ProjectionKey
+{
+    TopoDS_Shape shape;
+    Base::Vector3d direction;
+    ProjectionAlgos::HLRMode mode;
+    double deflection;
+
+    bool operator == (const ProjectionKey& key) const
+    {
+        // the deflection only matters for the tessellated shape
+        return shape.IsEqual(key.shape) && direction == key.direction && mode == key.mode &&
+              (mode == ProjectionAlgos::ExactHLR || deflection == key.deflection);
+    }
+};
+
+/** Keeps the most recently used projections. A shape is only found again
+ *  if it is the very same shape, so a recomputed feature never gets
+ *  the projection of its former shape.
+ */
+class ProjectionCache
+{
+public:
+    bool find(const ProjectionKey& key, ProjectionResult& result)
+    {
+        QMutexLocker locker(&mutex);
+        for (std::list<Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+            if (it->first == key) {
+                result = it->second;
+                entries.splice(entries.begin(), entries, it);
+                return true;
+            }
+        }
+        return false;
+    }
+    void insert(const ProjectionKey& key, const ProjectionResult& result)
+    {
+        QMutexLocker locker(&mutex);
+        entries.push_front(Entry(key, result));
+        if (entries.size() > MaxEntries)
+            entries.pop_back();
+    }
+    void clear()
+    {
+        QMutexLocker locker(&mutex);
+        entries.clear();
+    }
+
+private:
+    typedef std::pair<ProjectionKey, ProjectionResult> Entry;
+    static const std::size_t MaxEntries = 32;
+    std::list<Entry> entries;
+    QMutex mutex;
+};
+
+ProjectionCache& projectionCache()
+{
+    static ProjectionCache cache;
+    return cache;
+}
+
+/// a projection computed by prefetch
+struct ProjectionJob
+{
+    ProjectionKey key;
+    ProjectionResult result;
+    bool done;
+};
+
+}
+
 //===========================================================================
 // ProjectionAlgos
 //===========================================================================
 
 
 
-ProjectionAlgos::ProjectionAlgos(const TopoDS_Shape &Input, const Base::Vector3d &Dir)
-  : Input(Input), Direction(Dir)
+ProjectionAlgos::ProjectionAlgos(const TopoDS_Shape &Input, const Base::Vector3d &Dir,
+                                 HLRMode mode, double deflection)
+  : Input(Input), Direction(Dir), Mode(mode), Deflection(deflection)
 {
     execute();
 }
@@ -134,31 +222,140 @@ static const TopoDS_Shape& build3dCurves(const TopoDS_Shape &shape)
   return shape;
 }
 
-void ProjectionAlgos::execute(void)
+// runs the hidden line removal, the polygonal algorithm expects the shape to be tessellated
+static void project(const ProjectionKey& key, ProjectionResult& result)
 {
-    Handle( HLRBRep_Algo ) brep_hlr = new HLRBRep_Algo;
-    brep_hlr->Add(Input);
-
+    const Base::Vector3d& Direction = key.direction;
     gp_Ax2 transform(gp_Pnt(0,0,0),gp_Dir(Direction.x,Direction.y,Direction.z));
     HLRAlgo_Projector projector( transform );
+
+    if (key.mode == ProjectionAlgos::PolygonalHLR) {
+        Handle( HLRBRep_PolyAlgo ) poly_hlr = new HLRBRep_PolyAlgo;
+        poly_hlr->Load(key.shape);
+        poly_hlr->Projector(projector);
+        poly_hlr->Update();
+
+        // extracting the result sets, there are no isolines:
+        HLRBRep_PolyHLRToShape shapes;
+        shapes.Update(poly_hlr);
+
+        result.V  = build3dCurves(shapes.VCompound       ());
+        result.V1 = build3dCurves(shapes.Rg1LineVCompound());
+        result.VN = build3dCurves(shapes.RgNLineVCompound());
+        result.VO = build3dCurves(shapes.OutLineVCompound());
+        result.H  = build3dCurves(shapes.HCompound       ());
+        result.H1 = build3dCurves(shapes.Rg1LineHCompound());
+        result.HN = build3dCurves(shapes.RgNLineHCompound());
+        result.HO = build3dCurves(shapes.OutLineHCompound());
+        return;
+    }
+
+    Handle( HLRBRep_Algo ) brep_hlr = new HLRBRep_Algo;
+    brep_hlr->Add(key.shape);
     brep_hlr->Projector(projector);
     brep_hlr->Update();
     brep_hlr->Hide();
 
     // extracting the result sets:
-    HLRBRep_HLRToShape shapes( brep_hlr );
-
-    V  = build3dCurves(shapes.VCompound       ());// hard edge visibly
-    V1 = build3dCurves(shapes.Rg1LineVCompound());// Smoth edges visibly
-    VN = build3dCurves(shapes.RgNLineVCompound());// contour edges visibly
-    VO = build3dCurves(shapes.OutLineVCompound());// contours apparents visibly
-    VI = build3dCurves(shapes.IsoLineVCompound());// isoparamtriques   visibly
-    H  = build3dCurves(shapes.HCompound       ());// hard edge       invisibly
-    H1 = build3dCurves(shapes.Rg1LineHCompound());// Smoth edges  invisibly
-    HN = build3dCurves(shapes.RgNLineHCompound());// contour edges invisibly
-    HO = build3dCurves(shapes.OutLineHCompound());// contours apparents invisibly
-    HI = build3dCurves(shapes.IsoLineHCompound());// isoparamtriques   invisibly
-}
+    HLRBRep_HLRToShape shapes( brep_hlr );
+
+    result.V  = build3dCurves(shapes.VCompound       ());// hard edge visibly
+    result.V1 = build3dCurves(shapes.Rg1LineVCompound());// Smoth edges visibly
+    result.VN = build3dCurves(shapes.RgNLineVCompound());// contour edges visibly
+    result.VO = build3dCurves(shapes.OutLineVCompound());// contours apparents visibly
+    result.VI = build3dCurves(shapes.IsoLineVCompound());// isoparamtriques   visibly
+    result.H  = build3dCurves(shapes.HCompound       ());// hard edge       invisibly
+    result.H1 = build3dCurves(shapes.Rg1LineHCompound());// Smoth edges  invisibly
+    result.HN = build3dCurves(shapes.RgNLineHCompound());// contour edges invisibly
+    result.HO = build3dCurves(shapes.OutLineHCompound());// contours apparents invisibly
+    result.HI = build3dCurves(shapes.IsoLineHCompound());// isoparamtriques   invisibly
+}
+
+static void projectJob(ProjectionJob& job)
+{
+    try {
+        project(job.key, job.result);
+        job.done = true;
+    }
+    catch (Standard_Failure) {
+        // the view reports the error when it projects the shape itself
+        job.done = false;
+    }
+}
+
+void ProjectionAlgos::execute(void)
+{
+    ProjectionKey key;
+    key.shape = Input;
+    key.direction = Direction;
+    key.mode = Mode;
+    key.deflection = Deflection;
+
+    ProjectionResult result;
+    if (!projectionCache().find(key, result)) {
+        if (Mode == PolygonalHLR)
+            BRepMesh_IncrementalMesh(Input, Deflection);
+        project(key, result);
+        projectionCache().insert(key, result);
+    }
+
+    V  = result.V;
+    V1 = result.V1;
+    VN = result.VN;
+    VO = result.VO;
+    VI = result.VI;
+    H  = result.H;
+    H1 = result.H1;
+    HN = result.HN;
+    HO = result.HO;
+    HI = result.HI;
+}
+
+void ProjectionAlgos::prefetch(const std::vector<Request>& requests)
+{
+    std::vector<ProjectionJob> jobs;
+    for (std::vector<Request>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+        ProjectionJob job;
+        job.key.shape = it->Shape;
+        job.key.direction = it->Direction;
+        job.key.mode = it->Mode;
+        job.key.deflection = it->Deflection;
+        job.done = false;
+
+        ProjectionResult result;
+        if (job.key.shape.IsNull() || projectionCache().find(job.key, result))
+            continue;
+        bool duplicate = false;
+        for (std::vector<ProjectionJob>::iterator jt = jobs.begin(); jt != jobs.end(); ++jt)
+            duplicate = duplicate || jt->key == job.key;
+        if (!duplicate)
+            jobs.push_back(job);
+    }
+
+    // several views may share a shape, so tessellate it before going parallel
+    for (std::vector<ProjectionJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->key.mode == PolygonalHLR)
+            BRepMesh_IncrementalMesh(it->key.shape, it->key.deflection);
+    }
+
+    if (jobs.size() > 1) {
+        Standard::SetReentrant(Standard_True);
+        QtConcurrent::blockingMap(jobs, projectJob);
+    }
+    else if (jobs.size() == 1) {
+        projectJob(jobs.front());
+    }
+
+    for (std::vector<ProjectionJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->done)
+            projectionCache().insert(it->key, it->result);
+    }
+}
+
+void ProjectionAlgos::clearCache()
+{
+    projectionCache().clear();
+}
 
 std::string ProjectionAlgos::getSVG(ExtractionType type, double scale, double tolerance, double hiddenscale)
 {
@@ -27,6 +27,7 @@
 #include <TopoDS_Shape.hxx>
 #include <Base/Vector3D.h>
 #include <string>
+#include <vector>
 
 class BRepAdaptor_Curve;
 
@@ -34,17 +35,39 @@ namespace Drawing
 {
 
 /** Algo class for projecting shapes and creating SVG output of it
+ *  The results of the hidden line removal are kept in a cache, so
+ *  projecting an unchanged shape in the same direction again is cheap.
  */
 class DrawingExport ProjectionAlgos
 {
 public:
+    enum HLRMode {
+        /// exact hidden line removal on the BRep
+        ExactHLR = 0,
+        /// polygonal hidden line removal on the tessellated shape (preview quality)
+        PolygonalHLR = 1
+    };
+
     /// Constructor
-    ProjectionAlgos(const TopoDS_Shape &Input,const Base::Vector3d &Dir);
+    ProjectionAlgos(const TopoDS_Shape &Input,const Base::Vector3d &Dir,
+                    HLRMode mode=ExactHLR, double deflection=0.05);
     virtual ~ProjectionAlgos();
 
     void execute(void);
 //    static TopoDS_Shape invertY(const TopoDS_Shape&);
 
+    /// a projection to compute with prefetch()
+    struct Request {
+        TopoDS_Shape Shape;
+        Base::Vector3d Direction;
+        HLRMode Mode;
+        double Deflection;
+    };
+    /// computes the projections that are not cached yet in parallel
+    static void prefetch(const std::vector<Request>&);
+    /// removes all cached projections, called when a document is deleted
+    static void clearCache();
+
     enum ExtractionType {
         Plain = 0,
         WithHidden = 1,
@@ -57,6 +80,8 @@ public:
 
     const TopoDS_Shape &Input;
     const Base::Vector3d &Direction;
+    HLRMode Mode;
+    double Deflection;
 
     TopoDS_Shape V ;// hard edge visibly
     TopoDS_Shape V1;// Smoth edges visibly
@@ -0,0 +1,113 @@
+#***************************************************************************
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, os, sys, time, unittest, Part, Drawing
+App = FreeCAD
+
+
+def addView(doc, page, source, direction):
+	view = doc.addObject('Drawing::FeatureViewPart','View')
+	view.Source = source
+	view.Direction = direction
+	view.ShowHiddenLines = True
+	page.addObject(view)
+	return view
+
+def viewResult(view):
+	# the SVG group without the line with the name of the view
+	return view.ViewResult.split("\n",1)[1]
+
+#---------------------------------------------------------------------------
+# define the test cases to test the FreeCAD Drawing module
+#---------------------------------------------------------------------------
+
+
+class DrawingProjectionTestCases(unittest.TestCase):
+	def setUp(self):
+		self.Doc = FreeCAD.newDocument("DrawingTest")
+		self.Directions = [(0,0,1),(0,1,0),(1,0,0),(1,1,1)]
+
+	def createPart(self, doc):
+		box = doc.addObject("Part::Box","Box")
+		box.Length = 20
+		cyl = doc.addObject("Part::Cylinder","Cylinder")
+		cyl.Radius = 3
+		cyl.Placement.Base = App.Vector(10,5,-1)
+		cyl.Height = 12
+		cut = doc.addObject("Part::Cut","Cut")
+		cut.Base = box
+		cut.Tool = cyl
+		return cut
+
+	def testPageViews(self):
+		# the views of a page are computed in parallel when the page is
+		# recomputed, each view on a page of its own is computed alone
+		part = self.createPart(self.Doc)
+		page = self.Doc.addObject('Drawing::FeaturePage','Page')
+		views = [addView(self.Doc, page, part, d) for d in self.Directions]
+		self.Doc.recompute()
+		results = [viewResult(v) for v in views]
+
+		doc = FreeCAD.newDocument("DrawingSerialTest")
+		part = self.createPart(doc)
+		for i, d in enumerate(self.Directions):
+			page = doc.addObject('Drawing::FeaturePage','Page')
+			view = addView(doc, page, part, d)
+			doc.recompute()
+			self.failUnless(viewResult(view) == results[i])
+		FreeCAD.closeDocument("DrawingSerialTest")
+
+	def testModifiedSource(self):
+		# a recomputed part must not get the cached projection of its former shape
+		part = self.createPart(self.Doc)
+		page = self.Doc.addObject('Drawing::FeaturePage','Page')
+		view = addView(self.Doc, page, part, (0,0,1))
+		self.Doc.recompute()
+		before = viewResult(view)
+		part.Base.Length = 30
+		self.Doc.recompute()
+		self.failIf(viewResult(view) == before)
+
+		other = self.createPart(self.Doc)
+		other.Base.Length = 30
+		page = self.Doc.addObject('Drawing::FeaturePage','Page')
+		reference = addView(self.Doc, page, other, (0,0,1))
+		self.Doc.recompute()
+		self.failUnless(viewResult(view) == viewResult(reference))
+
+	def testPageTime(self):
+		# a plate with 100 holes in eight views
+		plate = Part.makeBox(200,200,5)
+		for i in range(10):
+			for j in range(10):
+				plate = plate.cut(Part.makeCylinder(4,7,App.Vector(10+20*i,10+20*j,-1)))
+		part = self.Doc.addObject("Part::Feature","Plate")
+		part.Shape = plate
+		page = self.Doc.addObject('Drawing::FeaturePage','Page')
+		for d in self.Directions + [(-1,1,1),(1,-1,1),(1,1,-1),(0,1,1)]:
+			addView(self.Doc, page, part, d)
+		start=time.time()
+		self.Doc.recompute()
+		FreeCAD.Console.PrintMessage("Computing 8 views: %.3f s\n" % (time.time()-start))
+
+	def tearDown(self):
+		#closing doc
+		FreeCAD.closeDocument("DrawingTest")
@@ -24,6 +24,7 @@
 #include "PreCompiled.h"
 
 #ifndef _PreComp_
+# include <cstdio>
 # include <cstdlib>
 # include <memory>
 # include <strstream>
@@ -32,7 +33,18 @@
 # include <BRepExtrema_DistShapeShape.hxx>
 # include <TopoDS_Vertex.hxx>
 # include <BRepBuilderAPI_MakeVertex.hxx>
+# include <BRepAdaptor_Curve.hxx>
+# include <BRepClass_FaceClassifier.hxx>
+# include <BRep_Tool.hxx>
+# include <Geom_Surface.hxx>
+# include <ShapeAnalysis_Curve.hxx>
+# include <ShapeAnalysis_Surface.hxx>
+# include <Precision.hxx>
+# include <Standard.hxx>
+# include <TopoDS_Edge.hxx>
 # include <gp_Pnt.hxx>
+# include <gp_Pnt2d.hxx>
+# include <algorithm>
 #endif
 
 #include <Base/Writer.h>
@@ -66,8 +78,10 @@
 
 # include <TopoDS_Face.hxx>
 
-//to simplify parsing input files we use the boost lib
-#include <boost/tokenizer.hpp>
+#include <boost/bind.hpp>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
 
 
 using namespace Fem;
@@ -76,6 +90,272 @@ using namespace boost;
 
 static int StatCount = 0;
 
+namespace Fem {
+
+/** A bounding volume hierarchy over the mesh nodes in absolute space
+ *  (i.e. with the placement of the mesh applied). The nodes are sorted
+ *  in-place so that every tree node covers a contiguous range of them.
+ */
+class FemNodeIndex
+{
+public:
+    FemNodeIndex(const SMESHDS_Mesh* data, const Base::Matrix4D& mat);
+
+    /// appends the positions of all nodes inside \a box to \a result
+    void search(const Bnd_Box& box, std::vector<std::size_t>& result) const;
+    const gp_Pnt& getPoint(std::size_t index) const
+    { return points[index]; }
+    long getId(std::size_t index) const
+    { return ids[index]; }
+    int countNodes() const
+    { return static_cast<int>(points.size()); }
+
+private:
+    struct TreeNode {
+        Bnd_Box box;
+        std::size_t begin, end;
+        int left, right;
+    };
+
+    int build(std::size_t begin, std::size_t end);
+    void search(int node, const Bnd_Box& box, std::vector<std::size_t>& result) const;
+
+private:
+    std::vector<gp_Pnt> points;
+    std::vector<long> ids;
+    std::vector<TreeNode> tree;
+};
+
+} // namespace Fem
+
+namespace {
+
+const std::size_t LeafSize = 32;
+
+struct NodeOrder
+{
+    NodeOrder(const std::vector<gp_Pnt>& p, int a) : points(p), axis(a) {}
+    bool operator()(std::size_t i, std::size_t j) const
+    { return points[i].Coord(axis) < points[j].Coord(axis); }
+    const std::vector<gp_Pnt>& points;
+    int axis;
+};
+
+bool isInside(const Bnd_Box& outer, const Bnd_Box& inner)
+{
+    Standard_Real ox1, oy1, oz1, ox2, oy2, oz2;
+    Standard_Real ix1, iy1, iz1, ix2, iy2, iz2;
+    outer.Get(ox1, oy1, oz1, ox2, oy2, oz2);
+    inner.Get(ix1, iy1, iz1, ix2, iy2, iz2);
+    return ox1 <= ix1 && oy1 <= iy1 && oz1 <= iz1 &&
+           ix2 <= ox2 && iy2 <= oy2 && iz2 <= oz2;
+}
+
+/// a slice of the candidate nodes of a query, handled by one thread
+struct NodeChunk
+{
+    std::size_t begin, end;
+    std::vector<long> nodes;
+};
+
+std::vector<NodeChunk> makeChunks(std::size_t count)
+{
+    const std::size_t ChunkSize = 256;
+    std::vector<NodeChunk> chunks;
+    for (std::size_t i = 0; i < count; i += ChunkSize) {
+        NodeChunk chunk;
+        chunk.begin = i;
+        chunk.end = std::min(i + ChunkSize, count);
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+void collectChunks(const std::vector<NodeChunk>& chunks, std::set<long>& result)
+{
+    for (std::vector<NodeChunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+        result.insert(it->nodes.begin(), it->nodes.end());
+}
+
+/** Checks the candidate nodes against a face. The node is projected onto the
+ *  underlying surface and the parameter is classified against the face
+ *  boundary. The projection may miss the closest point of the surface, so
+ *  all nodes that are not accepted this way get the exact distance
+ *  computation of the original implementation.
+ */
+class FaceNodeProjector
+{
+public:
+    FaceNodeProjector(const TopoDS_Face& f, double l, const Fem::FemNodeIndex& i,
+                      const std::vector<std::size_t>& c)
+        : face(f), limit(l), index(i), candidates(c)
+    {
+        surface = BRep_Tool::Surface(face);
+    }
+
+    void project(NodeChunk& chunk) const
+    {
+        // the projector caches data and thus cannot be shared between threads
+        Handle_ShapeAnalysis_Surface sas = new ShapeAnalysis_Surface(surface);
+        Standard_Real tol = BRep_Tool::Tolerance(face);
+        for (std::size_t i = chunk.begin; i < chunk.end; i++) {
+            const gp_Pnt& pnt = index.getPoint(candidates[i]);
+            gp_Pnt2d uv = sas->ValueOfUV(pnt, Precision::Confusion());
+            if (sas->Gap() < limit) {
+                BRepClass_FaceClassifier classifier(face, uv, tol);
+                TopAbs_State state = classifier.State();
+                if (state == TopAbs_IN || state == TopAbs_ON) {
+                    chunk.nodes.push_back(index.getId(candidates[i]));
+                    continue;
+                }
+            }
+
+            // the node may still be close to the face boundary or the
+            // projection didn't find the closest point
+            BRepBuilderAPI_MakeVertex aBuilder(pnt);
+            BRepExtrema_DistShapeShape measure(face, aBuilder.Vertex());
+            measure.Perform();
+            if (measure.IsDone() && measure.NbSolution() > 0 && measure.Value() < limit)
+                chunk.nodes.push_back(index.getId(candidates[i]));
+        }
+    }
+
+private:
+    const TopoDS_Face& face;
+    double limit;
+    const Fem::FemNodeIndex& index;
+    const std::vector<std::size_t>& candidates;
+    Handle_Geom_Surface surface;
+};
+
+/** Checks the candidate nodes against an edge by projecting them onto the
+ *  bounded curve.
+ */
+class EdgeNodeProjector
+{
+public:
+    EdgeNodeProjector(const TopoDS_Edge& e, double l, const Fem::FemNodeIndex& i,
+                      const std::vector<std::size_t>& c)
+        : edge(e), limit(l), index(i), candidates(c)
+    {
+    }
+
+    void project(NodeChunk& chunk) const
+    {
+        BRepAdaptor_Curve curve(edge);
+        ShapeAnalysis_Curve sac;
+        gp_Pnt proj;
+        Standard_Real param;
+        for (std::size_t i = chunk.begin; i < chunk.end; i++) {
+            const gp_Pnt& pnt = index.getPoint(candidates[i]);
+            Standard_Real dist = sac.Project(curve, pnt, Precision::Confusion(), proj, param);
+            if (dist < limit)
+                chunk.nodes.push_back(index.getId(candidates[i]));
+        }
+    }
+
+private:
+    const TopoDS_Edge& edge;
+    double limit;
+    const Fem::FemNodeIndex& index;
+    const std::vector<std::size_t>& candidates;
+};
+
+}
+
+FemNodeIndex::FemNodeIndex(const SMESHDS_Mesh* data, const Base::Matrix4D& mat)
+{
+    int count = data->NbNodes();
+    points.reserve(count);
+    ids.reserve(count);
+
+    SMDS_NodeIteratorPtr aNodeIter = data->nodesIterator();
+    while (aNodeIter->more()) {
+        const SMDS_MeshNode* aNode = aNodeIter->next();
+        Base::Vector3d vec(aNode->X(),aNode->Y(),aNode->Z());
+        vec = mat * vec;
+        points.push_back(gp_Pnt(vec.x,vec.y,vec.z));
+        ids.push_back(aNode->GetID());
+    }
+
+    if (!points.empty())
+        build(0, points.size());
+}
+
+int FemNodeIndex::build(std::size_t begin, std::size_t end)
+{
+    int node = static_cast<int>(tree.size());
+    tree.push_back(TreeNode());
+    TreeNode& item = tree.back();
+    item.begin = begin;
+    item.end = end;
+    item.left = -1;
+    item.right = -1;
+    for (std::size_t i = begin; i < end; i++)
+        item.box.Add(points[i]);
+
+    if (end - begin <= LeafSize)
+        return node;
+
+    // split at the median of the longest side
+    Standard_Real x1, y1, z1, x2, y2, z2;
+    item.box.Get(x1, y1, z1, x2, y2, z2);
+    int axis = 1;
+    if (y2 - y1 > x2 - x1)
+        axis = 2;
+    if (z2 - z1 > std::max(x2 - x1, y2 - y1))
+        axis = 3;
+
+    std::vector<std::size_t> order(end - begin);
+    for (std::size_t i = begin; i < end; i++)
+        order[i - begin] = i;
+    std::size_t mid = order.size() / 2;
+    std::nth_element(order.begin(), order.begin() + mid, order.end(), NodeOrder(points, axis));
+
+    std::vector<gp_Pnt> p(order.size());
+    std::vector<long> n(order.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        p[i] = points[order[i]];
+        n[i] = ids[order[i]];
+    }
+    std::copy(p.begin(), p.end(), points.begin() + begin);
+    std::copy(n.begin(), n.end(), ids.begin() + begin);
+
+    // 'item' may be invalidated by the recursion
+    int left = build(begin, begin + mid);
+    int right = build(begin + mid, end);
+    tree[node].left = left;
+    tree[node].right = right;
+    return node;
+}
+
+void FemNodeIndex::search(const Bnd_Box& box, std::vector<std::size_t>& result) const
+{
+    if (!tree.empty() && !box.IsVoid())
+        search(0, box, result);
+}
+
+void FemNodeIndex::search(int node, const Bnd_Box& box, std::vector<std::size_t>& result) const
+{
+    const TreeNode& item = tree[node];
+    if (box.IsOut(item.box))
+        return;
+    if (isInside(box, item.box)) {
+        for (std::size_t i = item.begin; i < item.end; i++)
+            result.push_back(i);
+    }
+    else if (item.left < 0) {
+        for (std::size_t i = item.begin; i < item.end; i++) {
+            if (!box.IsOut(points[i]))
+                result.push_back(i);
+        }
+    }
+    else {
+        search(item.left, box, result);
+        search(item.right, box, result);
+    }
+}
+
 TYPESYSTEM_SOURCE(Fem::FemMesh , Base::Persistence);
 
 FemMesh::FemMesh()
@@ -129,6 +409,7 @@ void FemMesh::copyMeshData(const FemMesh& mesh)
     //int numHedr = info.NbPolyhedrons();
 
     _Mtrx = mesh._Mtrx;
+    invalidateNodeIndex();
 
     SMESHDS_Mesh* meshds = this->myMesh->GetMeshDS();
     meshds->ClearMesh();
@@ -387,9 +668,24 @@ void FemMesh::setStanardHypotheses()
 
 void FemMesh::compute()
 {
+    invalidateNodeIndex();
     myGen->Compute(*myMesh, myMesh->GetShapeToMesh());
 }
 
+const FemNodeIndex& FemMesh::getNodeIndex() const
+{
+    // also catch nodes added or removed directly on the SMESH data structure
+    const SMESHDS_Mesh* data = myMesh->GetMeshDS();
+    if (!nodeIndex || nodeIndex->countNodes() != data->NbNodes())
+        nodeIndex.reset(new FemNodeIndex(data, _Mtrx));
+    return *nodeIndex;
+}
+
+void FemMesh::invalidateNodeIndex() const
+{
+    nodeIndex.reset();
+}
+
 std::set<long> FemMesh::getSurfaceNodes(long ElemId,short FaceId, float Angle) const
 {
     std::set<long> result;
@@ -409,34 +705,70 @@ std::set<long> FemMesh::getSurfaceNodes(const TopoDS_Face &face)const
 
     Bnd_Box box;
     BRepBndLib::Add(face, box);
+    if (box.IsVoid())
+        return result;
     // limit where the mesh node belongs to the face:
     double limit = box.SquareExtent()/10000.0;
     box.Enlarge(limit);
 
-    // get the actuall transform of the FemMesh
-    const Base::Matrix4D Mtrx(getTransform());
+    // the index holds the nodes in absolute space
+    const FemNodeIndex& index = getNodeIndex();
+    std::vector<std::size_t> candidates;
+    index.search(box, candidates);
 
-    SMDS_NodeIteratorPtr aNodeIter = myMesh->GetMeshDS()->nodesIterator();
-    while (aNodeIter->more()) {
-        const SMDS_MeshNode* aNode = aNodeIter->next();
-        Base::Vector3d vec(aNode->X(),aNode->Y(),aNode->Z());
-        // Apply the matrix to hold the BoundBox in absolute space. 
-        vec = Mtrx * vec;
-
-        if(!box.IsOut(gp_Pnt(vec.x,vec.y,vec.z))){
-            // create a Vertex
-            BRepBuilderAPI_MakeVertex aBuilder(gp_Pnt(vec.x,vec.y,vec.z));
-            TopoDS_Shape s = aBuilder.Vertex();
-            // measure distance
-            BRepExtrema_DistShapeShape measure(face,s);
-            measure.Perform();
-            if (!measure.IsDone() || measure.NbSolution() < 1)
-                continue;
-            
-            if(measure.Value() < limit)         
-                result.insert(aNode->GetID());
+    Standard::SetReentrant(Standard_True);
+    std::vector<NodeChunk> chunks = makeChunks(candidates.size());
+    FaceNodeProjector projector(face, limit, index, candidates);
+    QtConcurrent::blockingMap(chunks, boost::bind(&FaceNodeProjector::project, &projector, _1));
+    collectChunks(chunks, result);
 
-        }
+    return result;
+}
+
+std::set<long> FemMesh::getEdgeNodes(const TopoDS_Edge &edge)const
+{
+    std::set<long> result;
+    if (BRep_Tool::Degenerated(edge))
+        return result;
+
+    Bnd_Box box;
+    BRepBndLib::Add(edge, box);
+    if (box.IsVoid())
+        return result;
+    // limit where the mesh node belongs to the edge:
+    double limit = box.SquareExtent()/10000.0;
+    box.Enlarge(limit);
+
+    const FemNodeIndex& index = getNodeIndex();
+    std::vector<std::size_t> candidates;
+    index.search(box, candidates);
+
+    Standard::SetReentrant(Standard_True);
+    std::vector<NodeChunk> chunks = makeChunks(candidates.size());
+    EdgeNodeProjector projector(edge, limit, index, candidates);
+    QtConcurrent::blockingMap(chunks, boost::bind(&EdgeNodeProjector::project, &projector, _1));
+    collectChunks(chunks, result);
+
+    return result;
+}
+
+std::set<long> FemMesh::getVertexNodes(const TopoDS_Vertex &vertex)const
+{
+    std::set<long> result;
+
+    gp_Pnt pnt = BRep_Tool::Pnt(vertex);
+    double limit = std::max(BRep_Tool::Tolerance(vertex), Precision::Confusion());
+    Bnd_Box box;
+    box.Add(pnt);
+    box.Enlarge(limit);
+
+    const FemNodeIndex& index = getNodeIndex();
+    std::vector<std::size_t> candidates;
+    index.search(box, candidates);
+
+    for (std::vector<std::size_t>::iterator it = candidates.begin(); it != candidates.end(); ++it) {
+        if (index.getPoint(*it).Distance(pnt) <= limit)
+            result.insert(index.getId(*it));
     }
 
     return result;
@@ -444,6 +776,481 @@ std::set<long> FemMesh::getSurfaceNodes(const TopoDS_Face &face)const
 
 
 
+namespace {
+
+// ==== Nastran bulk data ====================================================
+
+/// a field of a bulk data card, pointing into the file content
+struct NastranField
+{
+    const char* begin;
+    const char* end;
+};
+
+/// an element card and how its nodes map onto the SMESH node order
+struct NastranElementType
+{
+    const char* name;
+    int firstNode;      // field of the first node, the element id is field 0
+    int dimension;
+    int numLinear;
+    int numQuadratic;   // 0 if there is no quadratic variant
+    const int* linearOrder;
+    const int* quadraticOrder;
+};
+
+const int NastranTetra4[]  = {1,0,2,3};
+const int NastranTetra10[] = {1,0,2,3,4,6,5,8,7,9};
+const int NastranPyra5[]   = {0,3,2,1,4};
+const int NastranPyra13[]  = {0,3,2,1,4,8,7,6,5,9,12,11,10};
+const int NastranPenta6[]  = {0,2,1,3,5,4};
+const int NastranPenta15[] = {0,2,1,3,5,4,8,7,6,14,13,12,9,11,10};
+const int NastranHexa8[]   = {0,3,2,1,4,7,6,5};
+const int NastranHexa20[]  = {0,3,2,1,4,7,6,5,11,10,9,8,19,18,17,16,12,15,14,13};
+
+const NastranElementType NastranElements[] = {
+    {"CTETRA", 2, 3, 4, 10, NastranTetra4, NastranTetra10},
+    {"CPYRAM", 2, 3, 5, 13, NastranPyra5,  NastranPyra13 },
+    {"CPENTA", 2, 3, 6, 15, NastranPenta6, NastranPenta15},
+    {"CHEXA",  2, 3, 8, 20, NastranHexa8,  NastranHexa20 },
+    {"CTRIA3", 2, 2, 3, 0,  0, 0},
+    {"CTRIA6", 2, 2, 3, 6,  0, 0},
+    {"CQUAD4", 2, 2, 4, 0,  0, 0},
+    {"CQUAD8", 2, 2, 4, 8,  0, 0},
+    {"CROD",   2, 1, 2, 0,  0, 0},
+    {"CBAR",   2, 1, 2, 0,  0, 0},
+    {"CBEAM",  2, 1, 2, 0,  0, 0},
+    {"CONROD", 1, 1, 2, 0,  0, 0}
+};
+
+const int NumNastranElements = sizeof(NastranElements) / sizeof(NastranElementType);
+
+struct NastranElement
+{
+    int id;
+    int dimension;
+    int numNodes;
+    std::size_t offset; // into the node ids of the chunk, in SMESH order
+};
+
+/// a part of the file that consists of complete cards
+struct NastranChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<int> gridIds;
+    std::vector<Base::Vector3d> grids;
+    std::vector<NastranElement> elements;
+    std::vector<int> nodes;
+};
+
+inline bool isCardStart(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+/// returns the start of the next card at or after the line start \a p
+const char* nextCard(const char* p, const char* end)
+{
+    while (p < end && !isCardStart(*p)) {
+        p = std::find(p, end, '\n');
+        if (p != end)
+            ++p;
+    }
+    return p;
+}
+
+/// returns the start of the next card after the position \a p
+const char* nextCardAfter(const char* p, const char* end)
+{
+    p = std::find(p, end, '\n');
+    if (p != end)
+        ++p;
+    return nextCard(p, end);
+}
+
+inline void trimField(NastranField& f)
+{
+    while (f.begin < f.end && (*f.begin == ' ' || *f.begin == '\t'))
+        ++f.begin;
+    while (f.end > f.begin && (f.end[-1] == ' ' || f.end[-1] == '\t'))
+        --f.end;
+}
+
+int toInt(const NastranField& f)
+{
+    const char* p = f.begin;
+    bool neg = false;
+    if (p < f.end && (*p == '-' || *p == '+'))
+        neg = (*p++ == '-');
+    int value = 0;
+    for (; p < f.end && *p >= '0' && *p <= '9'; ++p)
+        value = value * 10 + (*p - '0');
+    return neg ? -value : value;
+}
+
+/// Nastran allows to omit the 'E' of the exponent, e.g. 1.5-3
+double toReal(const NastranField& f)
+{
+    char buf[64];
+    std::size_t len = 0;
+    for (const char* p = f.begin; p < f.end && len < sizeof(buf) - 2; ++p) {
+        char c = *p;
+        if (c == 'D' || c == 'd')
+            c = 'E';
+        if ((c == '+' || c == '-') && len > 0 && buf[len-1] != 'E' && buf[len-1] != 'e')
+            buf[len++] = 'E';
+        buf[len++] = c;
+    }
+    buf[len] = '\0';
+    return atof(buf);
+}
+
+class NastranReader
+{
+public:
+    void parse(NastranChunk& chunk) const;
+
+private:
+    void splitCard(const char* begin, const char* end, std::string& name,
+                   std::vector<NastranField>& fields) const;
+    void addCard(const std::string& name, const std::vector<NastranField>& fields,
+                 NastranChunk& chunk) const;
+};
+
+/** Splits a card into its data fields, the continuation fields are skipped.
+ *  Fixed small-field, large-field and free-format lines may be mixed.
+ */
+void NastranReader::splitCard(const char* begin, const char* end, std::string& name,
+                              std::vector<NastranField>& fields) const
+{
+    fields.clear();
+    bool first = true;
+    bool large = false;
+    for (const char* line = begin; line < end;) {
+        const char* eol = std::find(line, end, '\n');
+        const char* stop = eol;
+        if (stop > line && stop[-1] == '\r')
+            --stop;
+
+        if (line < stop && *line != '$') {
+            NastranField head;
+            head.begin = line;
+            head.end = std::min<const char*>(line + 8, stop);
+            const char* comma = std::find(line, stop, ',');
+            if (comma != stop)
+                head.end = comma;
+            trimField(head);
+            if (first) {
+                if (head.end > head.begin && head.end[-1] == '*') {
+                    large = true;
+                    --head.end;
+                }
+                // card names are case-insensitive
+                name.clear();
+                for (const char* c = head.begin; c < head.end; ++c)
+                    name += (*c >= 'a' && *c <= 'z') ? static_cast<char>(*c - 'a' + 'A') : *c;
+            }
+            bool lineLarge = first ? large : (*line == '*');
+            std::size_t perLine = lineLarge ? 4 : 8;
+
+            if (comma != stop) {
+                // free format, the first token is the name or the continuation
+                std::size_t start = fields.size();
+                for (const char* p = comma + 1;;) {
+                    NastranField f;
+                    f.begin = p;
+                    f.end = std::find(p, stop, ',');
+                    p = f.end;
+                    trimField(f);
+                    fields.push_back(f);
+                    if (p == stop)
+                        break;
+                    ++p;
+                }
+                // one token more than the line can hold is the continuation,
+                // anything beyond is a long line without continuation
+                std::size_t count = fields.size() - start;
+                if (count == perLine + 1)
+                    fields.pop_back();
+                for (; count < perLine; count++) {
+                    NastranField f;
+                    f.begin = f.end = stop;
+                    fields.push_back(f);
+                }
+            }
+            else {
+                std::size_t width = lineLarge ? 16 : 8;
+                for (std::size_t i = 0; i < perLine; i++) {
+                    NastranField f;
+                    f.begin = std::min<const char*>(line + 8 + i * width, stop);
+                    f.end = std::min<const char*>(f.begin + width, stop);
+                    trimField(f);
+                    fields.push_back(f);
+                }
+            }
+            first = false;
+        }
+
+        line = (eol == end) ? end : eol + 1;
+    }
+}
+
+void NastranReader::addCard(const std::string& name, const std::vector<NastranField>& fields,
+                            NastranChunk& chunk) const
+{
+    if (name == "GRID") {
+        if (fields.size() < 5)
+            return; // line does not include nodal coordinates
+        chunk.gridIds.push_back(toInt(fields[0]));
+        chunk.grids.push_back(Base::Vector3d(toReal(fields[2]), toReal(fields[3]), toReal(fields[4])));
+        return;
+    }
+
+    for (int i = 0; i < NumNastranElements; i++) {
+        const NastranElementType& type = NastranElements[i];
+        if (name != type.name)
+            continue;
+
+        int node[20];
+        int numNodes = 0;
+        int available = static_cast<int>(fields.size()) - type.firstNode;
+        for (; numNodes < std::min<int>(available, 20); numNodes++) {
+            node[numNodes] = toInt(fields[type.firstNode + numNodes]);
+            if (node[numNodes] <= 0)
+                break;
+        }
+
+        // incomplete quadratic elements are read as linear elements
+        const int* order;
+        if (type.numQuadratic > 0 && numNodes >= type.numQuadratic) {
+            numNodes = type.numQuadratic;
+            order = type.quadraticOrder;
+        }
+        else if (numNodes >= type.numLinear) {
+            numNodes = type.numLinear;
+            order = type.linearOrder;
+        }
+        else {
+            return; // card does not include enough nodal IDs
+        }
+
+        NastranElement element;
+        element.id = toInt(fields[0]);
+        element.dimension = type.dimension;
+        element.numNodes = numNodes;
+        element.offset = chunk.nodes.size();
+        for (int j = 0; j < numNodes; j++)
+            chunk.nodes.push_back(node[order ? order[j] : j]);
+        chunk.elements.push_back(element);
+        return;
+    }
+}
+
+void NastranReader::parse(NastranChunk& chunk) const
+{
+    std::string name;
+    std::vector<NastranField> fields;
+    const char* p = nextCard(chunk.begin, chunk.end);
+    while (p < chunk.end) {
+        const char* next = nextCardAfter(p, chunk.end);
+        splitCard(p, next, name, fields);
+        addCard(name, fields, chunk);
+        p = next;
+    }
+}
+
+/// adds the element to the mesh, returns false if a node is missing
+bool addNastranElement(SMESHDS_Mesh* meshds, const NastranElement& element, const int* ids)
+{
+    const SMDS_MeshNode* n[20];
+    for (int i = 0; i < element.numNodes; i++) {
+        n[i] = meshds->FindNode(ids[i]);
+        if (!n[i])
+            return false;
+    }
+
+    int id = element.id;
+    switch (element.dimension * 100 + element.numNodes) {
+    case 102:
+        meshds->AddEdgeWithID(n[0], n[1], id);
+        break;
+    case 203:
+        meshds->AddFaceWithID(n[0], n[1], n[2], id);
+        break;
+    case 204:
+        meshds->AddFaceWithID(n[0], n[1], n[2], n[3], id);
+        break;
+    case 206:
+        meshds->AddFaceWithID(n[0], n[1], n[2], n[3], n[4], n[5], id);
+        break;
+    case 208:
+        meshds->AddFaceWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], id);
+        break;
+    case 304:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], id);
+        break;
+    case 305:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], id);
+        break;
+    case 306:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], id);
+        break;
+    case 308:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], id);
+        break;
+    case 310:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], n[9], id);
+        break;
+    case 313:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], n[9],
+                                n[10], n[11], n[12], id);
+        break;
+    case 315:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], n[9],
+                                n[10], n[11], n[12], n[13], n[14], id);
+        break;
+    case 320:
+        meshds->AddVolumeWithID(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], n[9],
+                                n[10], n[11], n[12], n[13], n[14], n[15], n[16], n[17], n[18], n[19], id);
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+// ==== ABAQUS input =========================================================
+
+/// an element type and the SMESH node for each ABAQUS node
+struct AbaqusElementType
+{
+    SMDSAbs_ElementType type;
+    int numNodes;
+    const char* name;
+    const int* order;
+};
+
+const int AbaqusTetra4[]  = {1,0,2,3};
+const int AbaqusTetra10[] = {1,0,2,3,4,6,5,8,7,9};
+const int AbaqusPenta6[]  = {0,2,1,3,5,4};
+const int AbaqusPenta15[] = {0,2,1,3,5,4,8,7,6,11,10,9,12,14,13};
+const int AbaqusHexa8[]   = {0,3,2,1,4,7,6,5};
+const int AbaqusHexa20[]  = {0,3,2,1,4,7,6,5,11,10,9,8,15,14,13,12,16,19,18,17};
+const int AbaqusBeam3[]   = {0,2,1};
+
+const AbaqusElementType AbaqusElements[] = {
+    {SMDSAbs_Volume, 4,  "C3D4",  AbaqusTetra4 },
+    {SMDSAbs_Volume, 10, "C3D10", AbaqusTetra10},
+    {SMDSAbs_Volume, 6,  "C3D6",  AbaqusPenta6 },
+    {SMDSAbs_Volume, 15, "C3D15", AbaqusPenta15},
+    {SMDSAbs_Volume, 8,  "C3D8",  AbaqusHexa8  },
+    {SMDSAbs_Volume, 20, "C3D20", AbaqusHexa20 },
+    {SMDSAbs_Face,   3,  "S3",    0},
+    {SMDSAbs_Face,   6,  "S6",    0},
+    {SMDSAbs_Face,   4,  "S4",    0},
+    {SMDSAbs_Face,   8,  "S8R",   0},
+    {SMDSAbs_Edge,   2,  "B31",   0},
+    {SMDSAbs_Edge,   3,  "B32",   AbaqusBeam3}
+};
+
+const int NumAbaqusElements = sizeof(AbaqusElements) / sizeof(AbaqusElementType);
+
+struct ElementIdOrder
+{
+    bool operator()(const SMDS_MeshElement* a, const SMDS_MeshElement* b) const
+    { return a->GetID() < b->GetID(); }
+};
+
+/// a range of nodes or elements, formatted by one thread
+struct AbaqusChunk
+{
+    std::size_t begin, end;
+    std::string text;
+};
+
+inline void appendInt(std::string& str, int value)
+{
+    char buf[16];
+    char* p = buf + sizeof(buf);
+    unsigned int v = value < 0 ? -value : value;
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *--p = '-';
+    str.append(p, buf + sizeof(buf));
+}
+
+class AbaqusWriter
+{
+public:
+    AbaqusWriter(const Base::Matrix4D& m) : type(0), mat(m) {}
+
+    void formatNodes(AbaqusChunk& chunk) const
+    {
+        char buf[32];
+        chunk.text.reserve((chunk.end - chunk.begin) * 64);
+        for (std::size_t i = chunk.begin; i < chunk.end; i++) {
+            const SMDS_MeshNode* aNode = nodes[i];
+            Base::Vector3d current_node(aNode->X(),aNode->Y(),aNode->Z());
+            current_node = mat * current_node;
+            appendInt(chunk.text, aNode->GetID());
+            for (int j = 0; j < 3; j++) {
+                sprintf(buf, ",%.15g", current_node[j]);
+                chunk.text += buf;
+            }
+            chunk.text += '\n';
+        }
+    }
+
+    void formatElements(AbaqusChunk& chunk) const
+    {
+        chunk.text.reserve((chunk.end - chunk.begin) * (type->numNodes + 1) * 8);
+        for (std::size_t i = chunk.begin; i < chunk.end; i++) {
+            const SMDS_MeshElement* aElem = elements[i];
+            appendInt(chunk.text, aElem->GetID());
+            for (int j = 0; j < type->numNodes; j++) {
+                // at most 16 entries per data line
+                chunk.text += (j == 15) ? ",\n" : ",";
+                int index = type->order ? type->order[j] : j;
+                appendInt(chunk.text, aElem->GetNode(index)->GetID());
+            }
+            chunk.text += '\n';
+        }
+    }
+
+    std::vector<const SMDS_MeshNode*> nodes;
+    std::vector<const SMDS_MeshElement*> elements;
+    const AbaqusElementType* type;
+
+private:
+    Base::Matrix4D mat;
+};
+
+std::vector<AbaqusChunk> makeAbaqusChunks(std::size_t count)
+{
+    const std::size_t ChunkSize = 10000;
+    std::vector<AbaqusChunk> chunks;
+    for (std::size_t i = 0; i < count; i += ChunkSize) {
+        AbaqusChunk chunk;
+        chunk.begin = i;
+        chunk.end = std::min(i + ChunkSize, count);
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+void writeAbaqusChunks(std::ostream& str, const std::vector<AbaqusChunk>& chunks)
+{
+    for (std::vector<AbaqusChunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+        str.write(it->text.c_str(), it->text.size());
+}
+
+}
+
 void FemMesh::readNastran(const std::string &Filename)
 {
     Base::TimeInfo Start;
@@ -451,171 +1258,81 @@ void FemMesh::readNastran(const std::string &Filename)
 
     _Mtrx = Base::Matrix4D();
 
-	std::ifstream inputfile;
-	inputfile.open(Filename.c_str());
-	inputfile.seekg(std::ifstream::beg);
-	std::string line1,line2,temp;
-	std::vector<string> token_results;
-	token_results.clear();
-	Base::Vector3d current_node;
-	std::vector<Base::Vector3d> vertices;
-	vertices.clear();
-	std::vector<unsigned int> nodal_id;
-	nodal_id.clear();
-	std::vector<unsigned int> tetra_element;
-	std::vector<std::vector<unsigned int> > all_elements;
-	std::vector<unsigned int> element_id;
-	element_id.clear();
-	bool nastran_free_format = false;
-	do
-	{
-		std::getline(inputfile,line1);
-		if (line1.size() == 0) continue;
-		if (!nastran_free_format && line1.find(",")!= std::string::npos)
-			nastran_free_format = true;
-		if (!nastran_free_format && line1.find("GRID*")!= std::string::npos ) //We found a Grid line
-		{
-			//Now lets extract the GRID Points = Nodes
-			//As each GRID Line consists of two subsequent lines we have to
-			//take care of that as well
-			std::getline(inputfile,line2);
-			//Get the Nodal ID
-			nodal_id.push_back(atoi(line1.substr(8,24).c_str()));
-			//Extract X Value
-			current_node.x = atof(line1.substr(40,56).c_str());
-			//Extract Y Value
-			current_node.y = atof(line1.substr(56,72).c_str());
-			//Extract Z Value
-			current_node.z = atof(line2.substr(8,24).c_str());
-
-			vertices.push_back(current_node);
-		}
-		else if (!nastran_free_format && line1.find("CTETRA")!= std::string::npos)
-		{
-			tetra_element.clear();
-			//Lets extract the elements
-			//As each Element Line consists of two subsequent lines as well 
-			//we have to take care of that
-			//At a first step we only extract Quadratic Tetrahedral Elements
-			std::getline(inputfile,line2);
-            unsigned int id = atoi(line1.substr(8,16).c_str());
-            int offset = 0;
-
-            if(id < 1000000)
-                offset = 0;
-            else if (id < 10000000)
-                offset = 1;
-            else if (id < 100000000)
-                offset = 2;
-            
-
-			element_id.push_back(id);
-			tetra_element.push_back(atoi(line1.substr(24,32).c_str()));
-			tetra_element.push_back(atoi(line1.substr(32,40).c_str()));
-			tetra_element.push_back(atoi(line1.substr(40,48).c_str()));
-			tetra_element.push_back(atoi(line1.substr(48,56).c_str()));
-			tetra_element.push_back(atoi(line1.substr(56,64).c_str()));
-			tetra_element.push_back(atoi(line1.substr(64,72).c_str()));
-			tetra_element.push_back(atoi(line2.substr(8+offset,16+offset).c_str()));
-			tetra_element.push_back(atoi(line2.substr(16+offset,24+offset).c_str()));
-			tetra_element.push_back(atoi(line2.substr(24+offset,32+offset).c_str()));
-			tetra_element.push_back(atoi(line2.substr(32+offset,40+offset).c_str()));
-
-			all_elements.push_back(tetra_element);
-		}
-		else if (nastran_free_format && line1.find("GRID")!= std::string::npos ) //We found a Grid line
-		{
-			char_separator<char> sep(",");
-			tokenizer<char_separator<char> > tokens(line1, sep);
-			token_results.assign(tokens.begin(),tokens.end());
-			if (token_results.size() < 3)
-				continue;//Line does not include Nodal coordinates
-			nodal_id.push_back(atoi(token_results[1].c_str()));
-			current_node.x = atof(token_results[3].c_str());
-			current_node.y = atof(token_results[4].c_str());		
-			current_node.z = atof(token_results[5].c_str());
-			vertices.push_back(current_node);
-		}
-		else if (nastran_free_format && line1.find("CTETRA")!= std::string::npos)
-		{
-			tetra_element.clear();
-			//Lets extract the elements
-			//As each Element Line consists of two subsequent lines as well 
-			//we have to take care of that
-			//At a first step we only extract Quadratic Tetrahedral Elements
-			std::getline(inputfile,line2);
-			char_separator<char> sep(",");
-			tokenizer<char_separator<char> > tokens(line1.append(line2), sep);
-			token_results.assign(tokens.begin(),tokens.end());
-			if (token_results.size() < 11)
-				continue;//Line does not include enough nodal IDs
-			element_id.push_back(atoi(token_results[1].c_str()));
-			tetra_element.push_back(atoi(token_results[3].c_str()));
-			tetra_element.push_back(atoi(token_results[4].c_str()));
-			tetra_element.push_back(atoi(token_results[5].c_str()));
-			tetra_element.push_back(atoi(token_results[6].c_str()));
-			tetra_element.push_back(atoi(token_results[7].c_str()));
-			tetra_element.push_back(atoi(token_results[8].c_str()));
-			tetra_element.push_back(atoi(token_results[10].c_str()));
-			tetra_element.push_back(atoi(token_results[11].c_str()));
-			tetra_element.push_back(atoi(token_results[12].c_str()));
-			tetra_element.push_back(atoi(token_results[13].c_str()));
-
-			all_elements.push_back(tetra_element);
-		}
-
-	}
-	while (inputfile.good());
-	inputfile.close();
-
-    Base::Console().Log("    %f: File read, start building mesh\n",Base::TimeInfo::diffTimeF(Start,Base::TimeInfo()));
+    // read the file directly from memory if it can be mapped
+    QFile file(QString::fromUtf8(Filename.c_str()));
+    if (!file.open(QIODevice::ReadOnly))
+        throw Base::FileException("File to load not existing or not readable", Filename.c_str());
+    QByteArray content;
+    const char* data = 0;
+    qint64 size = file.size();
+    if (size > 0)
+        data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) {
+        content = file.readAll();
+        data = content.constData();
+        size = content.size();
+    }
+    const char* end = data + size;
 
-	//Now fill the SMESH datastructure
-	std::vector<Base::Vector3d>::const_iterator anodeiterator;
 	SMESHDS_Mesh* meshds = this->myMesh->GetMeshDS();
 	meshds->ClearMesh();
-	unsigned int j=0;
-	for(anodeiterator=vertices.begin(); anodeiterator!=vertices.end(); anodeiterator++)
-	{
-		meshds->AddNodeWithID((*anodeiterator).x,(*anodeiterator).y,(*anodeiterator).z,nodal_id[j]);
-		j++;
-	}
 
-	for(unsigned int i=0;i<all_elements.size();i++)
-	{
-		//Die Reihenfolge wie hier die Elemente hinzugefgt werden ist sehr wichtig. 
-		//Ansonsten ist eine konsistente Datenstruktur nicht mglich
-		//meshds->AddVolumeWithID
-		//(
-		//	meshds->FindNode(all_elements[i][0]),
-		//	meshds->FindNode(all_elements[i][2]),
-		//	meshds->FindNode(all_elements[i][1]),
-		//	meshds->FindNode(all_elements[i][3]),
-		//	meshds->FindNode(all_elements[i][6]),
-		//	meshds->FindNode(all_elements[i][5]),
-		//	meshds->FindNode(all_elements[i][4]),
-		//	meshds->FindNode(all_elements[i][9]),
-		//	meshds->FindNode(all_elements[i][7]),
-		//	meshds->FindNode(all_elements[i][8]),
-		//	element_id[i]
-		//);
-		meshds->AddVolumeWithID
-		(
-			meshds->FindNode(all_elements[i][1]),
-			meshds->FindNode(all_elements[i][0]),
-			meshds->FindNode(all_elements[i][2]),
-			meshds->FindNode(all_elements[i][3]),
-			meshds->FindNode(all_elements[i][4]),
-			meshds->FindNode(all_elements[i][6]),
-			meshds->FindNode(all_elements[i][5]),
-			meshds->FindNode(all_elements[i][8]),
-			meshds->FindNode(all_elements[i][7]),
-			meshds->FindNode(all_elements[i][9]),
-			element_id[i]
-		);
-	}
-    Base::Console().Log("    %f: Done \n",Base::TimeInfo::diffTimeF(Start,Base::TimeInfo()));
+    // The file is handled in windows of complete cards. The cards of a window
+    // are parsed in parallel and then added to the mesh. Elements may refer
+    // to nodes of a later window and are kept back until the end.
+    const std::size_t WindowSize = 64 * 1024 * 1024;
+    std::size_t numChunks = 4 * std::max<int>(1, QThread::idealThreadCount());
+    NastranReader reader;
+    NastranChunk deferred;
+    for (const char* window = data; window < end;) {
+        const char* windowEnd = end;
+        if (static_cast<std::size_t>(end - window) > WindowSize)
+            windowEnd = nextCardAfter(window + WindowSize, end);
+
+        std::size_t step = (windowEnd - window) / numChunks + 1;
+        std::vector<NastranChunk> chunks;
+        for (const char* p = window; p < windowEnd;) {
+            NastranChunk chunk;
+            chunk.begin = p;
+            chunk.end = windowEnd;
+            if (static_cast<std::size_t>(windowEnd - p) > step)
+                chunk.end = nextCardAfter(p + step, windowEnd);
+            chunks.push_back(chunk);
+            p = chunk.end;
+        }
+
+        QtConcurrent::blockingMap(chunks, boost::bind(&NastranReader::parse, &reader, _1));
+
+        for (std::vector<NastranChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            for (std::size_t i = 0; i < it->grids.size(); i++) {
+                const Base::Vector3d& v = it->grids[i];
+                meshds->AddNodeWithID(v.x, v.y, v.z, it->gridIds[i]);
+            }
+        }
+        for (std::vector<NastranChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            for (std::vector<NastranElement>::iterator jt = it->elements.begin(); jt != it->elements.end(); ++jt) {
+                const int* ids = &it->nodes[jt->offset];
+                if (!addNastranElement(meshds, *jt, ids)) {
+                    NastranElement element = *jt;
+                    element.offset = deferred.nodes.size();
+                    deferred.nodes.insert(deferred.nodes.end(), ids, ids + jt->numNodes);
+                    deferred.elements.push_back(element);
+                }
+            }
+        }
 
+        window = windowEnd;
+    }
+
+    int missing = 0;
+    for (std::vector<NastranElement>::iterator it = deferred.elements.begin(); it != deferred.elements.end(); ++it) {
+        if (!addNastranElement(meshds, *it, &deferred.nodes[it->offset]))
+            missing++;
+    }
+    if (missing > 0)
+        Base::Console().Warning("FemMesh::readNastran(): %d elements with undefined nodes skipped\n", missing);
+
+    Base::Console().Log("    %f: Done \n",Base::TimeInfo::diffTimeF(Start,Base::TimeInfo()));
 }
 
 
@@ -623,6 +1340,7 @@ void FemMesh::read(const char *FileName)
 {
     Base::FileInfo File(FileName);
     _Mtrx = Base::Matrix4D();
+    invalidateNodeIndex();
   
     // checking on the file
     if (!File.isReadable())
@@ -654,65 +1372,64 @@ void FemMesh::read(const char *FileName)
 
 void FemMesh::writeABAQUS(const std::string &Filename) const
 {
-    std::ofstream anABAQUS_Output;
-    anABAQUS_Output.open(Filename.c_str());
-    anABAQUS_Output << "*Node , NSET=Nall" << std::endl;
+    Base::FileInfo fi(Filename);
+    Base::ofstream anABAQUS_Output(fi, std::ios::out | std::ios::trunc | std::ios::binary);
+    anABAQUS_Output << "*Node , NSET=Nall\n";
 
     //Extract Nodes and Elements of the current SMESH datastructure
-    SMDS_NodeIteratorPtr aNodeIter = myMesh->GetMeshDS()->nodesIterator();
-
-    Base::Vector3d current_node;
-    for (;aNodeIter->more();) {
-        const SMDS_MeshNode* aNode = aNodeIter->next();
-        current_node.Set(aNode->X(),aNode->Y(),aNode->Z());
-        current_node = _Mtrx * current_node;
-        anABAQUS_Output << aNode->GetID() << ","
-            << current_node.x << "," 
-            << current_node.y << ","
-            << current_node.z << std::endl;
+    const SMESHDS_Mesh* meshds = myMesh->GetMeshDS();
+    AbaqusWriter writer(_Mtrx);
+    writer.nodes.reserve(meshds->NbNodes());
+    SMDS_NodeIteratorPtr aNodeIter = meshds->nodesIterator();
+    while (aNodeIter->more())
+        writer.nodes.push_back(aNodeIter->next());
+
+    std::vector<AbaqusChunk> chunks = makeAbaqusChunks(writer.nodes.size());
+    QtConcurrent::blockingMap(chunks, boost::bind(&AbaqusWriter::formatNodes, &writer, _1));
+    writeAbaqusChunks(anABAQUS_Output, chunks);
+
+    // only the elements of the highest dimension are written to the element set
+    std::vector<const SMDS_MeshElement*> elements;
+    if (meshds->NbVolumes() > 0) {
+        SMDS_VolumeIteratorPtr aVolIter = meshds->volumesIterator();
+        while (aVolIter->more())
+            elements.push_back(aVolIter->next());
+    }
+    else if (meshds->NbFaces() > 0) {
+        SMDS_FaceIteratorPtr aFaceIter = meshds->facesIterator();
+        while (aFaceIter->more())
+            elements.push_back(aFaceIter->next());
+    }
+    else {
+        SMDS_EdgeIteratorPtr aEdgeIter = meshds->edgesIterator();
+        while (aEdgeIter->more())
+            elements.push_back(aEdgeIter->next());
+    }
+    std::sort(elements.begin(), elements.end(), ElementIdOrder());
+
+    std::size_t written = 0;
+    for (int i = 0; i < NumAbaqusElements; i++) {
+        const AbaqusElementType& type = AbaqusElements[i];
+        writer.elements.clear();
+        for (std::vector<const SMDS_MeshElement*>::iterator it = elements.begin(); it != elements.end(); ++it) {
+            if ((*it)->GetType() == type.type && (*it)->NbNodes() == type.numNodes)
+                writer.elements.push_back(*it);
+        }
+        if (writer.elements.empty())
+            continue;
+
+        anABAQUS_Output << "*Element, TYPE=" << type.name << ", ELSET=Eall\n";
+        writer.type = &type;
+        chunks = makeAbaqusChunks(writer.elements.size());
+        QtConcurrent::blockingMap(chunks, boost::bind(&AbaqusWriter::formatElements, &writer, _1));
+        writeAbaqusChunks(anABAQUS_Output, chunks);
+        written += writer.elements.size();
     }
 
-	anABAQUS_Output << "*Element, TYPE=C3D10, ELSET=Eall" << std::endl;
-	SMDS_VolumeIteratorPtr aVolIter = myMesh->GetMeshDS()->volumesIterator();
-
-	std::map<int,std::vector<int> > temp_map;
-	std::pair<int,std::vector<int> > apair;
-	temp_map.clear();
-	for (;aVolIter->more();) 
-	{
-		const SMDS_MeshVolume* aVol = aVolIter->next();
-		//Dont ask about the order in which we have to output the SMESH structure
-		//I absolute dont understand the scheme behind it but somehow its working like this
-		apair.first = aVol->GetID();
-		apair.second.clear();
-
-		//Neuer Versuch
-		apair.second.push_back(aVol->GetNode(1)->GetID());
-		apair.second.push_back(aVol->GetNode(0)->GetID());
-		apair.second.push_back(aVol->GetNode(2)->GetID());
-		apair.second.push_back(aVol->GetNode(3)->GetID());
-		apair.second.push_back(aVol->GetNode(4)->GetID());
-		apair.second.push_back(aVol->GetNode(6)->GetID());
-		apair.second.push_back(aVol->GetNode(5)->GetID());
-		apair.second.push_back(aVol->GetNode(8)->GetID());
-		apair.second.push_back(aVol->GetNode(7)->GetID());
-		apair.second.push_back(aVol->GetNode(9)->GetID());
-	
-        temp_map.insert(apair);
-	}
-
-	std::map<int,std::vector<int> >::iterator it_map;
-	std::vector<int>::iterator it_vector;
-	for(it_map = temp_map.begin();it_map!=temp_map.end();it_map++)
-	{
-		anABAQUS_Output << it_map->first << ",";
-		for(it_vector = it_map->second.begin();it_vector!=it_map->second.end();it_vector++)
-		{
-			anABAQUS_Output << *it_vector << ",";
-		}
-		anABAQUS_Output << std::endl;
-	}
-	anABAQUS_Output.close();
+    if (written < elements.size())
+        Base::Console().Warning("FemMesh::writeABAQUS(): %d elements of unsupported type skipped\n",
+            static_cast<int>(elements.size() - written));
+    anABAQUS_Output.close();
 }
 
 void FemMesh::write(const char *FileName) const
@@ -838,6 +1555,7 @@ void FemMesh::RestoreDocFile(Base::Reader &reader)
     file.close();
 
     // read the shape from the temp file
+    invalidateNodeIndex();
     myMesh->UNVToMesh(fi.filePath().c_str());
 
     // delete the temp file
@@ -848,6 +1566,7 @@ void FemMesh::transformGeometry(const Base::Matrix4D& rclTrf)
 {
 	//We perform a translation and rotation of the current active Mesh object
 	Base::Matrix4D clMatrix(rclTrf);
+	invalidateNodeIndex();
 	SMDS_NodeIteratorPtr aNodeIter = myMesh->GetMeshDS()->nodesIterator();
 	Base::Vector3d current_node;
 	for (;aNodeIter->more();) {
@@ -862,6 +1581,7 @@ void FemMesh::setTransform(const Base::Matrix4D& rclTrf)
 {
     // Placement handling, no geometric transformation
     _Mtrx = rclTrf;
+    invalidateNodeIndex();
 }
 
 Base::Matrix4D FemMesh::getTransform(void) const
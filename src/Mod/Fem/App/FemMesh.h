@@ -37,11 +37,14 @@ class SMESH_Mesh;
 class SMESH_Hypothesis;
 class TopoDS_Shape;
 class TopoDS_Face;
+class TopoDS_Edge;
+class TopoDS_Vertex;
 
 namespace Fem
 {
 
 typedef boost::shared_ptr<SMESH_Hypothesis> SMESH_HypothesisPtr;
+class FemNodeIndex;
 
 /** The representation of a FemMesh
  */
@@ -87,6 +90,10 @@ public:
     std::set<long> getSurfaceNodes(long ElemId,short FaceId, float Angle=360)const;
     /// retrivinb by face
     std::set<long> getSurfaceNodes(const TopoDS_Face &face)const;
+    /// retrieving by edge
+    std::set<long> getEdgeNodes(const TopoDS_Edge &edge)const;
+    /// retrieving by vertex
+    std::set<long> getVertexNodes(const TopoDS_Vertex &vertex)const;
     //@}
 
     /** @name Placement control */
@@ -132,6 +139,9 @@ public:
 private:
     void copyMeshData(const FemMesh&);
     void readNastran(const std::string &Filename);
+    /// the node index in absolute space, built on first use
+    const FemNodeIndex& getNodeIndex() const;
+    void invalidateNodeIndex() const;
 
 private:
     /// positioning matrix
@@ -140,6 +150,7 @@ private:
     SMESH_Mesh *myMesh;
 
     std::list<SMESH_HypothesisPtr> hypoth;
+    mutable boost::shared_ptr<FemNodeIndex> nodeIndex;
 };
 
 } //namespace Part
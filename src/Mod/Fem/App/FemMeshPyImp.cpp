@@ -30,6 +30,8 @@
 
 #include <TopoDS_Shape.hxx>
 #include <TopoDS_Face.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Vertex.hxx>
 #include <TopoDS.hxx>
 
 #include <Base/VectorPy.h>
@@ -39,6 +41,8 @@
 
 #include <Mod/Part/App/TopoShapePy.h>
 #include <Mod/Part/App/TopoShapeFacePy.h>
+#include <Mod/Part/App/TopoShapeEdgePy.h>
+#include <Mod/Part/App/TopoShapeVertexPy.h>
 #include <Mod/Part/App/TopoShape.h>
 
 #include "Mod/Fem/App/FemMesh.h"
@@ -531,33 +535,99 @@ PyObject* FemMeshPy::getNodeById(PyObject *args)
     }
 }
 
-PyObject* FemMeshPy::getNodesByFace(PyObject *args)
+namespace Fem {
+// Returns the node IDs of a single shape or a list with the node IDs of each
+// shape for a sequence of shapes.
+static PyObject* getNodesByShapes(const FemMesh* mesh, PyObject* pW, PyTypeObject* type)
 {
-    PyObject *pW;
-    if (!PyArg_ParseTuple(args, "O!", &(Part::TopoShapeFacePy::Type), &pW))
-         return 0;
-
-    try {
-        const TopoDS_Shape& sh = static_cast<Part::TopoShapeFacePy*>(pW)->getTopoShapePtr()->_Shape;
-        const TopoDS_Face& fc = TopoDS::Face(sh);
-        if (sh.IsNull()) {
-            PyErr_SetString(Base::BaseExceptionFreeCADError, "Face is empty");
-            return 0;
+    bool single = PyObject_TypeCheck(pW, type) != 0;
+    if (!single && !PySequence_Check(pW)) {
+        PyErr_Format(PyExc_TypeError, "%s or sequence of %s expected", type->tp_name, type->tp_name);
+        return 0;
+    }
+
+    std::vector<TopoDS_Shape> shapes;
+    if (single) {
+        shapes.push_back(static_cast<Part::TopoShapePy*>(pW)->getTopoShapePtr()->_Shape);
+    }
+    else {
+        Py::Sequence list(pW);
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            PyObject* item = (*it).ptr();
+            if (!PyObject_TypeCheck(item, type)) {
+                PyErr_Format(PyExc_TypeError, "%s expected", type->tp_name);
+                return 0;
+            }
+            shapes.push_back(static_cast<Part::TopoShapePy*>(item)->getTopoShapePtr()->_Shape);
         }
+    }
+
+    try {
         Py::List ret;
-        std::set<long> resultSet = getFemMeshPtr()->getSurfaceNodes(fc);
-        for( std::set<long>::const_iterator it = resultSet.begin();it!=resultSet.end();++it)
-            ret.append(Py::Int(*it));
-        
-        return Py::new_reference_to(ret);
+        for (std::vector<TopoDS_Shape>::iterator it = shapes.begin(); it != shapes.end(); ++it) {
+            if (it->IsNull()) {
+                PyErr_SetString(Base::BaseExceptionFreeCADError, "Shape is empty");
+                return 0;
+            }
+
+            std::set<long> resultSet;
+            switch (it->ShapeType()) {
+            case TopAbs_FACE:
+                resultSet = mesh->getSurfaceNodes(TopoDS::Face(*it));
+                break;
+            case TopAbs_EDGE:
+                resultSet = mesh->getEdgeNodes(TopoDS::Edge(*it));
+                break;
+            case TopAbs_VERTEX:
+                resultSet = mesh->getVertexNodes(TopoDS::Vertex(*it));
+                break;
+            default:
+                break;
+            }
 
+            Py::List nodes;
+            for( std::set<long>::const_iterator jt = resultSet.begin();jt!=resultSet.end();++jt)
+                nodes.append(Py::Int(*jt));
+            if (single)
+                return Py::new_reference_to(nodes);
+            ret.append(nodes);
+        }
+
+        return Py::new_reference_to(ret);
     }
-    catch (Standard_Failure) {
+    catch (Standard_Failure) {
         Handle_Standard_Failure e = Standard_Failure::Caught();
-        PyErr_SetString(Base::BaseExceptionFreeCADError, e->GetMessageString());
+        PyErr_SetString(Base::BaseExceptionFreeCADError, e->GetMessageString());
         return 0;
-    }
-  
+    }
+}
+}
+
+PyObject* FemMeshPy::getNodesByFace(PyObject *args)
+{
+    PyObject *pW;
+    if (!PyArg_ParseTuple(args, "O", &pW))
+         return 0;
+
+    return getNodesByShapes(getFemMeshPtr(), pW, &(Part::TopoShapeFacePy::Type));
+}
+
+PyObject* FemMeshPy::getNodesByEdge(PyObject *args)
+{
+    PyObject *pW;
+    if (!PyArg_ParseTuple(args, "O", &pW))
+         return 0;
+
+    return getNodesByShapes(getFemMeshPtr(), pW, &(Part::TopoShapeEdgePy::Type));
+}
+
+PyObject* FemMeshPy::getNodesByVertex(PyObject *args)
+{
+    PyObject *pW;
+    if (!PyArg_ParseTuple(args, "O", &pW))
+         return 0;
+
+    return getNodesByShapes(getFemMeshPtr(), pW, &(Part::TopoShapeVertexPy::Type));
 }
 
 
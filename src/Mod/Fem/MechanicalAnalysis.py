@@ -375,9 +375,8 @@ class _JobControlTaskPanel:
         # write the fixed node set
         NodeSetName = FixedObject.Name 
         inpfile.write('*NSET,NSET=' + NodeSetName + '\n')
-        for o,f in FixedObject.References:
-            fo = o.Shape.getElement(f)
-            n = MeshObject.FemMesh.getNodesByFace(fo)
+        faces = [o.Shape.getElement(f) for o,f in FixedObject.References]
+        for n in MeshObject.FemMesh.getNodesByFace(faces):
             for i in n:
                 inpfile.write( str(i)+',\n')
         inpfile.write('\n\n')
@@ -386,9 +385,8 @@ class _JobControlTaskPanel:
         NodeSetNameForce = ForceObject.Name 
         inpfile.write('*NSET,NSET=' + NodeSetNameForce + '\n')
         NbrForceNods = 0
-        for o,f in ForceObject.References:
-            fo = o.Shape.getElement(f)
-            n = MeshObject.FemMesh.getNodesByFace(fo)
+        faces = [o.Shape.getElement(f) for o,f in ForceObject.References]
+        for n in MeshObject.FemMesh.getNodesByFace(faces):
             for i in n:
                 inpfile.write( str(i)+',\n')
                 NbrForceNods = NbrForceNods + 1
@@ -0,0 +1,204 @@
+#***************************************************************************
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, os, sys, unittest, math, tempfile, time, Part, Fem
+App = FreeCAD
+
+
+def writeCard(file, name, fields):
+    # a small field card, continued after every eight fields
+    line = "%-8s" % name
+    for i, f in enumerate(fields):
+        if i > 0 and i % 8 == 0:
+            file.write(line + "\n")
+            line = "%-8s" % "+"
+        line += "%8s" % f
+    file.write(line + "\n")
+
+
+def readAbaqus(filename):
+    # returns the nodes and the elements of each element type
+    nodes = {}
+    elements = {}
+    block = None
+    data = []
+    for line in open(filename).read().splitlines() + ["*End"]:
+        if line.startswith("*"):
+            if block == "node":
+                for i in range(0, len(data), 4):
+                    nodes[int(data[i])] = App.Vector(float(data[i+1]), float(data[i+2]), float(data[i+3]))
+            elif block:
+                size = int(block[3:]) + 1
+                elements[block] = [[int(d) for d in data[i:i+size]] for i in range(0, len(data), size)]
+            data = []
+            if line.startswith("*Node"):
+                block = "node"
+            elif line.startswith("*Element"):
+                block = line.split("TYPE=")[1].split(",")[0]
+            else:
+                block = None
+        else:
+            data += [d for d in line.split(",") if d.strip()]
+    return nodes, elements
+
+
+#---------------------------------------------------------------------------
+# define the test cases to test the FreeCAD Fem module
+#---------------------------------------------------------------------------
+
+
+class FemNodesByShapeTestCases(unittest.TestCase):
+    def setUp(self):
+        # a grid of nodes filling a 10x10x10 box and the nodes on and near
+        # the lateral face of a cylinder inside of it
+        self.mesh = Fem.FemMesh()
+        for i in range(21):
+            for j in range(21):
+                for k in range(21):
+                    self.mesh.addNode(0.5*i, 0.5*j, 0.5*k)
+        for i in range(36):
+            a = math.radians(10.0*i)
+            for k in range(21):
+                self.mesh.addNode(5+3.0*math.cos(a), 5+3.0*math.sin(a), 0.5*k)
+                self.mesh.addNode(5+3.2*math.cos(a), 5+3.2*math.sin(a), 0.5*k)
+        self.box = Part.makeBox(10,10,10)
+        self.cylinder = Part.makeCylinder(3,10,App.Vector(5,5,0))
+
+    def bruteForce(self, shape):
+        # the nodes are either on the shape or at least 0.04 away from it
+        bb = shape.BoundBox
+        bb.enlarge(0.1)
+        nodes = []
+        for id, pnt in self.mesh.Nodes.items():
+            if bb.isInside(pnt) and shape.distToShape(Part.Vertex(pnt))[0] < 0.01:
+                nodes.append(id)
+        nodes.sort()
+        return nodes
+
+    def testNodesByFace(self):
+        faces = self.box.Faces + [f for f in self.cylinder.Faces if isinstance(f.Surface, Part.Cylinder)]
+        for face in faces:
+            nodes = self.mesh.getNodesByFace(face)
+            self.failUnless(len(nodes) > 0)
+            self.failUnless(sorted(nodes) == self.bruteForce(face))
+
+    def testNodesByEdge(self):
+        for edge in self.box.Edges + self.cylinder.Edges:
+            nodes = self.mesh.getNodesByEdge(edge)
+            self.failUnless(len(nodes) > 0)
+            self.failUnless(sorted(nodes) == self.bruteForce(edge))
+
+    def testNodesByVertex(self):
+        for vertex in self.box.Vertexes:
+            nodes = self.mesh.getNodesByVertex(vertex)
+            self.failUnless(len(nodes) == 1)
+            self.failUnless((self.mesh.getNodeById(nodes[0]) - vertex.Point).Length < 1e-7)
+
+    def testSequence(self):
+        # a sequence of shapes gives a list with the nodes of each shape
+        faces = self.mesh.getNodesByFace(self.box.Faces)
+        self.failUnless(faces == [self.mesh.getNodesByFace(f) for f in self.box.Faces])
+        edges = self.mesh.getNodesByEdge(tuple(self.box.Edges))
+        self.failUnless(edges == [self.mesh.getNodesByEdge(e) for e in self.box.Edges])
+        vertexes = self.mesh.getNodesByVertex(self.box.Vertexes)
+        self.failUnless(vertexes == [self.mesh.getNodesByVertex(v) for v in self.box.Vertexes])
+        self.failUnless(self.mesh.getNodesByFace([]) == [])
+        self.failUnlessRaises(TypeError, self.mesh.getNodesByFace, self.box.Edges)
+        self.failUnlessRaises(TypeError, self.mesh.getNodesByEdge, self.box)
+
+
+class FemNastranTestCases(unittest.TestCase):
+    def setUp(self):
+        self.bdf = tempfile.mkstemp(suffix=".bdf")
+        self.inp = tempfile.mkstemp(suffix=".inp")
+        os.close(self.bdf[0])
+        os.close(self.inp[0])
+
+    def testQuadraticToAbaqus(self):
+        # a Hexa20 and a Penta15 element with the corner nodes first, then
+        # the mid-side nodes in the order of the Nastran manual
+        hexa = [(0,0,0),(2,0,0),(2,2,0),(0,2,0),(0,0,2),(2,0,2),(2,2,2),(0,2,2),
+                (1,0,0),(2,1,0),(1,2,0),(0,1,0),(0,0,1),(2,0,1),(2,2,1),(0,2,1),
+                (1,0,2),(2,1,2),(1,2,2),(0,1,2)]
+        penta = [(3,0,0),(5,0,0),(3,2,0),(3,0,2),(5,0,2),(3,2,2),
+                 (4,0,0),(4,1,0),(3,1,0),(3,0,1),(5,0,1),(3,2,1),
+                 (4,0,2),(4,1,2),(3,1,2)]
+        file = open(self.bdf[1], "w")
+        file.write("$ card names are case-insensitive\n")
+        file.write("BEGIN BULK\n")
+        for i, p in enumerate(hexa + penta):
+            writeCard(file, ("GRID", "grid", "Grid")[i % 3], [i+1, ""] + ["%.1f" % c for c in p])
+        writeCard(file, "chexa", [1, 1] + list(range(1, 21)))
+        writeCard(file, "Cpenta", [2, 1] + list(range(21, 36)))
+        file.write("ENDDATA\n")
+        file.close()
+
+        mesh = Fem.FemMesh()
+        mesh.read(self.bdf[1])
+        self.failUnless(mesh.NodeCount == 35)
+        self.failUnless(mesh.VolumeCount == 2)
+        self.failUnless(mesh.HexaCount == 1)
+        self.failUnless(mesh.PrismCount == 1)
+
+        mesh.writeABAQUS(self.inp[1])
+        nodes, elements = readAbaqus(self.inp[1])
+        self.failUnless(len(nodes) == 35)
+        for i, p in enumerate(hexa + penta):
+            self.failUnless((nodes[i+1] - App.Vector(p)).Length < 1e-7)
+        # the vertical mid-side nodes follow the top ones in ABAQUS
+        self.failUnless(elements["C3D20"] == [[1] + list(range(1, 13)) + list(range(17, 21)) + list(range(13, 17))])
+        self.failUnless(elements["C3D15"] == [[2] + list(range(21, 30)) + list(range(33, 36)) + list(range(30, 33))])
+
+    def testReadTime(self):
+        # a block of 100000 hexahedrons
+        nx, ny, nz = 50, 50, 40
+        def node(i, j, k):
+            return 1 + i + (nx+1) * (j + (ny+1) * k)
+        file = open(self.bdf[1], "w")
+        file.write("BEGIN BULK\n")
+        for k in range(nz+1):
+            for j in range(ny+1):
+                for i in range(nx+1):
+                    writeCard(file, "GRID", [node(i,j,k), "", "%.1f" % i, "%.1f" % j, "%.1f" % k])
+        id = 1
+        for k in range(nz):
+            for j in range(ny):
+                for i in range(nx):
+                    writeCard(file, "CHEXA", [id, 1,
+                        node(i,j,k), node(i+1,j,k), node(i+1,j+1,k), node(i,j+1,k),
+                        node(i,j,k+1), node(i+1,j,k+1), node(i+1,j+1,k+1), node(i,j+1,k+1)])
+                    id += 1
+        file.write("ENDDATA\n")
+        file.close()
+
+        mesh = Fem.FemMesh()
+        start=time.time()
+        mesh.read(self.bdf[1])
+        FreeCAD.Console.PrintMessage("Reading %d elements: %.3f s\n" % (mesh.VolumeCount, time.time()-start))
+        self.failUnless(mesh.NodeCount == (nx+1) * (ny+1) * (nz+1))
+        self.failUnless(mesh.HexaCount == nx * ny * nz)
+        start=time.time()
+        mesh.writeABAQUS(self.inp[1])
+        FreeCAD.Console.PrintMessage("Writing %d elements: %.3f s\n" % (mesh.VolumeCount, time.time()-start))
+
+    def tearDown(self):
+        os.remove(self.bdf[1])
+        os.remove(self.inp[1])
@@ -150,7 +150,10 @@ static PyObject * importer(PyObject *self, PyObject *args)
         }
 
 #if 1
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+            ("User parameter:BaseApp/Preferences/Mod/Import");
         Import::ImportOCAF ocaf(hDoc, pcDoc, file.fileNamePure());
+        ocaf.setInstancing(hGrp->GetBool("UseInstancing", false));
         ocaf.loadShapes();
 #else
         Import::ImportXCAF xcaf(hDoc, pcDoc, file.fileNamePure());
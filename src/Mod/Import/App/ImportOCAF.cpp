@@ -27,8 +27,14 @@
 #endif
 #ifndef _PreComp_
 # include <climits>
+# include <cmath>
+# include <Standard.hxx>
 # include <Standard_Version.hxx>
+# include <Standard_Failure.hxx>
 # include <BRep_Builder.hxx>
+# include <BRepBndLib.hxx>
+# include <BRepMesh_IncrementalMesh.hxx>
+# include <Bnd_Box.hxx>
 # include <Handle_TDocStd_Document.hxx>
 # include <Handle_XCAFApp_Application.hxx>
 # include <TDocStd_Document.hxx>
@@ -40,6 +46,7 @@
 # include <TDF_Label.hxx>
 # include <TDF_LabelSequence.hxx>
 # include <TDF_ChildIterator.hxx>
+# include <TDF_Tool.hxx>
 # include <TDataStd_Name.hxx>
 # include <Quantity_Color.hxx>
 # include <STEPCAFControl_Reader.hxx>
@@ -64,8 +71,13 @@
 # endif
 #endif
 
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "ImportOCAF.h"
 #include <Base/Console.h>
+#include <Base/Sequencer.h>
+#include <Base/TimeInfo.h>
 #include <App/Application.h>
 #include <App/Document.h>
 #include <App/DocumentObjectPy.h>
@@ -77,9 +89,114 @@
 
 using namespace Import;
 
+namespace {
+
+/// Splits a compound into its solids and free shells, if it has any
+void splitShape(const TopoDS_Shape& aShape, std::vector<TopoDS_Shape>& shapes)
+{
+    if (!aShape.IsNull() && aShape.ShapeType() == TopAbs_COMPOUND) {
+        TopExp_Explorer xp;
+        for (xp.Init(aShape, TopAbs_SOLID); xp.More(); xp.Next())
+            shapes.push_back(xp.Current());
+        for (xp.Init(aShape, TopAbs_SHELL, TopAbs_SOLID); xp.More(); xp.Next())
+            shapes.push_back(xp.Current());
+        if (!shapes.empty())
+            return;
+    }
+
+    shapes.push_back(aShape);
+}
+
+void tessellateShape(TopoDS_Shape& shape, double deviation)
+{
+    try {
+        Bnd_Box bounds;
+        BRepBndLib::Add(shape, bounds);
+        if (bounds.IsVoid())
+            return;
+        bounds.SetGap(0.0);
+        Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+        bounds.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+        // The view provider takes the sum of the box sides of the placed shape. For
+        // any placement this is at least the diameter of the shape, which in turn is
+        // at least the box diagonal divided by sqrt(3). So the mesh is fine enough
+        // for all occurrences and is kept by the view providers.
+        Standard_Real diagonal = sqrt((xMax-xMin)*(xMax-xMin) + (yMax-yMin)*(yMax-yMin) +
+                                      (zMax-zMin)*(zMax-zMin));
+        Standard_Real deflection = diagonal / sqrt(3.0) / 300.0 * deviation;
+        if (deflection <= 0.0)
+            return;
+#if OCC_VERSION_HEX >= 0x060600
+        BRepMesh_IncrementalMesh mesh(shape, deflection, Standard_False, 0.5, Standard_False);
+#else
+        BRepMesh_IncrementalMesh mesh(shape, deflection);
+#endif
+    }
+    catch (Standard_Failure) {
+        // the view provider will try again
+    }
+}
+
+/// Shapes that share faces or edges, meshed one after the other by one thread
+struct TessellationGroup
+{
+    std::vector<TopoDS_Shape> shapes;
+};
+
+void tessellateGroup(TessellationGroup& group, double deviation)
+{
+    for (std::vector<TopoDS_Shape>::iterator it = group.shapes.begin(); it != group.shapes.end(); ++it)
+        tessellateShape(*it, deviation);
+}
+
+std::size_t findGroup(std::vector<std::size_t>& parent, std::size_t index)
+{
+    while (parent[index] != index) {
+        parent[index] = parent[parent[index]];
+        index = parent[index];
+    }
+    return index;
+}
+
+/**
+ * Puts shapes with common faces or edges into the same group. The mesher stores the
+ * triangulation in the faces and the polygons in the edges, so these must not be
+ * meshed by two threads at the same time.
+ */
+void groupSharedShapes(const std::vector<TopoDS_Shape>& shapes, std::vector<TessellationGroup>& groups)
+{
+    const TopAbs_ShapeEnum types[2] = {TopAbs_FACE, TopAbs_EDGE};
+    std::vector<std::size_t> parent(shapes.size());
+    std::map<const TopoDS_TShape*, std::size_t> owner;
+    for (std::size_t i = 0; i < shapes.size(); i++) {
+        parent[i] = i;
+        TopExp_Explorer xp;
+        for (int t = 0; t < 2; t++) {
+            for (xp.Init(shapes[i], types[t]); xp.More(); xp.Next()) {
+                std::pair<std::map<const TopoDS_TShape*, std::size_t>::iterator, bool> it =
+                    owner.insert(std::make_pair(xp.Current().TShape().operator->(), i));
+                if (!it.second)
+                    parent[findGroup(parent, i)] = findGroup(parent, it.first->second);
+            }
+        }
+    }
+
+    std::map<std::size_t, std::size_t> index;
+    for (std::size_t i = 0; i < shapes.size(); i++) {
+        std::size_t root = findGroup(parent, i);
+        std::map<std::size_t, std::size_t>::iterator it = index.find(root);
+        if (it == index.end()) {
+            it = index.insert(std::make_pair(root, groups.size())).first;
+            groups.push_back(TessellationGroup());
+        }
+        groups[it->second].shapes.push_back(shapes[i]);
+    }
+}
+
+}
 
 ImportOCAF::ImportOCAF(Handle_TDocStd_Document h, App::Document* d, const std::string& name)
-    : pDoc(h), doc(d), default_name(name)
+    : pDoc(h), doc(d), default_name(name), instancing(false), deviation(0.0)
 {
     aShapeTool = XCAFDoc_DocumentTool::ShapeTool (pDoc->Main());
     aColorTool = XCAFDoc_DocumentTool::ColorTool(pDoc->Main());
@@ -89,10 +206,40 @@ ImportOCAF::~ImportOCAF()
 {
 }
 
+void ImportOCAF::setInstancing(bool on)
+{
+    instancing = on;
+}
+
+void ImportOCAF::setTessellation(double dev)
+{
+    deviation = dev;
+}
+
 void ImportOCAF::loadShapes()
 {
     myRefShapes.clear();
+    myShapes.clear();
+    myPrototypes.clear();
+    myInstances.clear();
+
+    Base::TimeInfo start;
     loadShapes(pDoc->Main(), TopLoc_Location(), default_name, "", false);
+    if (!instancing)
+        return;
+
+    Base::TimeInfo collected;
+    tessellateShapes();
+    Base::TimeInfo tessellated;
+    createInstances();
+    Base::TimeInfo created;
+
+    Base::Console().Log("Import: %d parts with %d occurrences, collecting: %f s, "
+                        "tessellation: %f s, creating features: %f s\n",
+                        (int)myPrototypes.size(), (int)myInstances.size(),
+                        Base::TimeInfo::diffTimeF(start, collected),
+                        Base::TimeInfo::diffTimeF(collected, tessellated),
+                        Base::TimeInfo::diffTimeF(tessellated, created));
 }
 
 void ImportOCAF::loadShapes(const TDF_Label& label, const TopLoc_Location& loc, const std::string& defaultname, const std::string& assembly, bool isRef)
@@ -185,30 +332,43 @@ void ImportOCAF::loadShapes(const TDF_Label& label, const TopLoc_Location& loc,
 
 void ImportOCAF::createShape(const TDF_Label& label, const TopLoc_Location& loc, const std::string& name)
 {
-    const TopoDS_Shape& aShape = aShapeTool->GetShape(label);
-    if (!aShape.IsNull() && aShape.ShapeType() == TopAbs_COMPOUND) {
-        TopExp_Explorer xp;
-        int ctSolids = 0, ctShells = 0;
-        for (xp.Init(aShape, TopAbs_SOLID); xp.More(); xp.Next(), ctSolids++)
-            createShape(xp.Current(), loc, name);
-        for (xp.Init(aShape, TopAbs_SHELL, TopAbs_SOLID); xp.More(); xp.Next(), ctShells++)
-            createShape(xp.Current(), loc, name);
-        if (ctSolids > 0 || ctShells > 0)
-            return;
+    if (instancing) {
+        addInstance(label, loc, name);
+        return;
     }
 
-    createShape(aShape, loc, name);
+    std::vector<TopoDS_Shape> shapes;
+    splitShape(aShapeTool->GetShape(label), shapes);
+    for (std::vector<TopoDS_Shape>::iterator it = shapes.begin(); it != shapes.end(); ++it)
+        createShape(*it, loc, name);
 }
 
 void ImportOCAF::createShape(const TopoDS_Shape& aShape, const TopLoc_Location& loc, const std::string& name)
+{
+    SharedShape shape;
+    shape.shape = aShape;
+    loadColors(aShape, shape.shapeColor, shape.faceColors);
+    createShape(shape, loc, name);
+}
+
+void ImportOCAF::createShape(const SharedShape& shape, const TopLoc_Location& loc, const std::string& name)
 {
     Part::Feature* part = static_cast<Part::Feature*>(doc->addObject("Part::Feature"));
     if (!loc.IsIdentity())
-        part->Shape.setValue(aShape.Moved(loc));
+        part->Shape.setValue(shape.shape.Moved(loc));
     else
-        part->Shape.setValue(aShape);
+        part->Shape.setValue(shape.shape);
     part->Label.setValue(name);
 
+    if (!shape.shapeColor.empty())
+        applyColors(part, shape.shapeColor);
+    if (!shape.faceColors.empty())
+        applyColors(part, shape.faceColors);
+}
+
+void ImportOCAF::loadColors(const TopoDS_Shape& aShape, std::vector<App::Color>& shapeColor,
+                            std::vector<App::Color>& faceColors) const
+{
     Quantity_Color aColor;
     App::Color color(0.8f,0.8f,0.8f);
     if (aColorTool->GetColor(aShape, XCAFDoc_ColorGen, aColor) ||
@@ -217,18 +377,7 @@ void ImportOCAF::createShape(const TopoDS_Shape& aShape, const TopLoc_Location&
         color.r = (float)aColor.Red();
         color.g = (float)aColor.Green();
         color.b = (float)aColor.Blue();
-        std::vector<App::Color> colors;
-        colors.push_back(color);
-        applyColors(part, colors);
-#if 0//TODO
-        Gui::ViewProvider* vp = Gui::Application::Instance->getViewProvider(part);
-        if (vp && vp->isDerivedFrom(PartGui::ViewProviderPart::getClassTypeId())) {
-            color.r = aColor.Red();
-            color.g = aColor.Green();
-            color.b = aColor.Blue();
-            static_cast<PartGui::ViewProviderPart*>(vp)->ShapeColor.setValue(color);
-        }
-#endif
+        shapeColor.push_back(color);
     }
 
     TopTools_IndexedMapOfShape faces;
@@ -238,7 +387,6 @@ void ImportOCAF::createShape(const TopoDS_Shape& aShape, const TopLoc_Location&
         xp.Next();
     }
     bool found_face_color = false;
-    std::vector<App::Color> faceColors;
     faceColors.resize(faces.Extent(), color);
     xp.Init(aShape,TopAbs_FACE);
     while (xp.More()) {
@@ -255,14 +403,73 @@ void ImportOCAF::createShape(const TopoDS_Shape& aShape, const TopLoc_Location&
         xp.Next();
     }
 
-    if (found_face_color) {
-        applyColors(part, faceColors);
-#if 0//TODO
-        Gui::ViewProvider* vp = Gui::Application::Instance->getViewProvider(part);
-        if (vp && vp->isDerivedFrom(PartGui::ViewProviderPartExt::getClassTypeId())) {
-            static_cast<PartGui::ViewProviderPartExt*>(vp)->DiffuseColor.setValues(faceColors);
+    if (!found_face_color)
+        faceColors.clear();
+}
+
+void ImportOCAF::addInstance(const TDF_Label& label, const TopLoc_Location& loc, const std::string& name)
+{
+    // the label of the part is the same for all its occurrences
+    TCollection_AsciiString entry;
+    TDF_Tool::Entry(label, entry);
+    std::map<std::string, std::pair<std::size_t, std::size_t> >::iterator it;
+    it = myPrototypes.find(entry.ToCString());
+    if (it == myPrototypes.end()) {
+        std::size_t first = myShapes.size();
+        std::vector<TopoDS_Shape> shapes;
+        splitShape(aShapeTool->GetShape(label), shapes);
+        for (std::vector<TopoDS_Shape>::iterator jt = shapes.begin(); jt != shapes.end(); ++jt) {
+            SharedShape shape;
+            shape.shape = *jt;
+            loadColors(*jt, shape.shapeColor, shape.faceColors);
+            myShapes.push_back(shape);
         }
+
+        it = myPrototypes.insert(std::make_pair(std::string(entry.ToCString()),
+            std::make_pair(first, myShapes.size()))).first;
+    }
+
+    Instance instance;
+    instance.first = it->second.first;
+    instance.last = it->second.second;
+    instance.loc = loc;
+    instance.name = name;
+    myInstances.push_back(instance);
+}
+
+void ImportOCAF::tessellateShapes()
+{
+    if (deviation <= 0.0)
+        return;
+
+    // a shape that belongs to several parts is meshed only once
+    std::set<const TopoDS_TShape*> done;
+    std::vector<TopoDS_Shape> shapes;
+    for (std::vector<SharedShape>::iterator it = myShapes.begin(); it != myShapes.end(); ++it) {
+        if (!it->shape.IsNull() && done.insert(it->shape.TShape().operator->()).second)
+            shapes.push_back(it->shape);
+    }
+
+#if OCC_VERSION_HEX >= 0x060600
+    // different parts may still share faces or edges, e.g. when a prototype is a
+    // sub-shape of another one
+    std::vector<TessellationGroup> groups;
+    groupSharedShapes(shapes, groups);
+    Standard::SetReentrant(Standard_True);
+    QtConcurrent::blockingMap(groups, boost::bind(&tessellateGroup, _1, deviation));
+#else
+    for (std::vector<TopoDS_Shape>::iterator it = shapes.begin(); it != shapes.end(); ++it)
+        tessellateShape(*it, deviation);
 #endif
+}
+
+void ImportOCAF::createInstances()
+{
+    Base::SequencerLauncher seq("Creating parts...", myInstances.size());
+    for (std::vector<Instance>::iterator it = myInstances.begin(); it != myInstances.end(); ++it) {
+        for (std::size_t i = it->first; i < it->last; i++)
+            createShape(myShapes[i], it->loc, it->name);
+        seq.next();
     }
 }
 
@@ -28,6 +28,7 @@
 #include <Handle_XCAFDoc_ColorTool.hxx>
 #include <Handle_XCAFDoc_ShapeTool.hxx>
 #include <Quantity_Color.hxx>
+#include <TopLoc_Location.hxx>
 #include <TopoDS_Shape.hxx>
 #include <climits>
 #include <string>
@@ -37,7 +38,6 @@
 #include <App/Material.h>
 
 class TDF_Label;
-class TopLoc_Location;
 
 namespace App {
 class Document;
@@ -55,11 +55,39 @@ public:
     ImportOCAF(Handle_TDocStd_Document h, App::Document* d, const std::string& name);
     virtual ~ImportOCAF();
     void loadShapes();
+    /** In the instancing mode the shapes and colours of a part that occurs several
+     * times in the assembly are collected only once. All its occurrences share these
+     * shapes and only differ in their placement.
+     */
+    void setInstancing(bool on);
+    /** Tessellates the shared shapes in parallel before the features are created,
+     * with the deviation of the Part view providers. Only done in the instancing
+     * mode, 0 turns it off.
+     */
+    void setTessellation(double deviation);
 
 private:
+    /// A shape of a part with its colours
+    struct SharedShape {
+        TopoDS_Shape shape;
+        std::vector<App::Color> shapeColor; // empty or one colour
+        std::vector<App::Color> faceColors; // empty or one colour per face
+    };
+    /// An occurrence of a part, refers to the range [first, last) of myShapes
+    struct Instance {
+        std::size_t first, last;
+        TopLoc_Location loc;
+        std::string name;
+    };
+
     void loadShapes(const TDF_Label& label, const TopLoc_Location&, const std::string& partname, const std::string& assembly, bool isRef);
     void createShape(const TDF_Label& label, const TopLoc_Location&, const std::string&);
     void createShape(const TopoDS_Shape& label, const TopLoc_Location&, const std::string&);
+    void createShape(const SharedShape&, const TopLoc_Location&, const std::string&);
+    void loadColors(const TopoDS_Shape&, std::vector<App::Color>& shapeColor, std::vector<App::Color>& faceColors) const;
+    void addInstance(const TDF_Label& label, const TopLoc_Location&, const std::string&);
+    void tessellateShapes();
+    void createInstances();
     virtual void applyColors(Part::Feature*, const std::vector<App::Color>&){}
 
 private:
@@ -69,6 +97,11 @@ private:
     Handle_XCAFDoc_ColorTool aColorTool;
     std::string default_name;
     std::set<int> myRefShapes;
+    bool instancing;
+    double deviation;
+    std::vector<SharedShape> myShapes;
+    std::map<std::string, std::pair<std::size_t, std::size_t> > myPrototypes;
+    std::vector<Instance> myInstances;
     static const int HashUpper = INT_MAX;
 };
 
@@ -190,7 +190,16 @@ static PyObject * importer(PyObject *self, PyObject *args)
             return 0;
         }
 
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+            ("User parameter:BaseApp/Preferences/Mod/Import");
         ImportOCAFExt ocaf(hDoc, pcDoc, file.fileNamePure());
+        if (hGrp->GetBool("UseInstancing", false)) {
+            // let the view providers find the meshes of the shared shapes
+            ParameterGrp::handle hPart = App::GetApplication().GetParameterGroupByPath
+                ("User parameter:BaseApp/Preferences/Mod/Part");
+            ocaf.setInstancing(true);
+            ocaf.setTessellation(hPart->GetFloat("MeshDeviation",0.2));
+        }
         ocaf.loadShapes();
         pcDoc->recompute();
     }
@@ -0,0 +1,245 @@
+#***************************************************************************
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, os, sys, unittest, tempfile, time, Import
+from FreeCAD import Vector, Rotation, Placement
+
+#---------------------------------------------------------------------------
+# define the test cases to test the FreeCAD Import module
+#---------------------------------------------------------------------------
+
+
+class StepWriter:
+    """ Writes the entities of a STEP file, each one gets the next number """
+    def __init__(self):
+        self.entities = []
+
+    def add(self, text):
+        self.entities.append(text)
+        return "#%d" % len(self.entities)
+
+    def real(self, x):
+        return "%.12E" % x
+
+    def point(self, v):
+        return self.add("CARTESIAN_POINT('',(%s,%s,%s))" % (self.real(v.x), self.real(v.y), self.real(v.z)))
+
+    def direction(self, v):
+        return self.add("DIRECTION('',(%s,%s,%s))" % (self.real(v.x), self.real(v.y), self.real(v.z)))
+
+    def axis(self, pos, z, x):
+        return self.add("AXIS2_PLACEMENT_3D('',%s,%s,%s)" % (self.point(pos), self.direction(z), self.direction(x)))
+
+    def write(self, path):
+        f = open(path, "w")
+        f.write("ISO-10303-21;\nHEADER;\n")
+        f.write("FILE_DESCRIPTION(('FreeCAD Model'),'2;1');\n")
+        f.write("FILE_NAME('%s','2015-01-01T00:00:00',('Author'),(''),'','','');\n" % os.path.basename(path))
+        f.write("FILE_SCHEMA(('AUTOMOTIVE_DESIGN { 1 0 10303 214 1 1 1 1 }'));\n")
+        f.write("ENDSEC;\nDATA;\n")
+        for i in range(len(self.entities)):
+            f.write("#%d = %s;\n" % (i+1, self.entities[i]))
+        f.write("ENDSEC;\nEND-ISO-10303-21;\n")
+        f.close()
+
+
+def writeStepAssembly(path, parts, instances):
+    """ Writes an assembly of boxes. parts is a list of (name, size, colour), instances
+    a list of (part index, placement). Each part is written once and referred to by
+    all of its instances. The first face of the first part has an own colour. """
+    w = StepWriter()
+    app = w.add("APPLICATION_CONTEXT('core data for automotive mechanical design processes')")
+    w.add("APPLICATION_PROTOCOL_DEFINITION('international standard','automotive_design',2000,%s)" % app)
+    length = w.add("( LENGTH_UNIT() NAMED_UNIT(*) SI_UNIT(.MILLI.,.METRE.) )")
+    angle = w.add("( NAMED_UNIT(*) PLANE_ANGLE_UNIT() SI_UNIT($,.RADIAN.) )")
+    solid = w.add("( NAMED_UNIT(*) SI_UNIT($,.STERADIAN.) SOLID_ANGLE_UNIT() )")
+    uncertainty = w.add("UNCERTAINTY_MEASURE_WITH_UNIT(LENGTH_MEASURE(1.E-07),%s,"
+                        "'distance_accuracy_value','confusion accuracy')" % length)
+    context = w.add("( GEOMETRIC_REPRESENTATION_CONTEXT(3) GLOBAL_UNCERTAINTY_ASSIGNED_CONTEXT((%s)) "
+                    "GLOBAL_UNIT_ASSIGNED_CONTEXT((%s,%s,%s)) REPRESENTATION_CONTEXT('Context #1',"
+                    "'3D Context with UNIT and UNCERTAINTY') )" % (uncertainty, length, angle, solid))
+    origin = w.axis(Vector(0,0,0), Vector(0,0,1), Vector(1,0,0))
+
+    def product(name):
+        mechanical = w.add("MECHANICAL_CONTEXT('',%s,'mechanical')" % app)
+        prod = w.add("PRODUCT('%s','%s','',(%s))" % (name, name, mechanical))
+        w.add("PRODUCT_TYPE('part',$,(%s))" % prod)
+        formation = w.add("PRODUCT_DEFINITION_FORMATION('','',%s)" % prod)
+        definition = w.add("PRODUCT_DEFINITION_CONTEXT('part definition',%s,'design')" % app)
+        return w.add("PRODUCT_DEFINITION('design','',%s,%s)" % (formation, definition))
+
+    def colour(item, rgb):
+        c = w.add("COLOUR_RGB('',%s,%s,%s)" % (w.real(rgb[0]), w.real(rgb[1]), w.real(rgb[2])))
+        c = w.add("FILL_AREA_STYLE_COLOUR('',%s)" % c)
+        c = w.add("FILL_AREA_STYLE('',(%s))" % c)
+        c = w.add("SURFACE_STYLE_FILL_AREA(%s)" % c)
+        c = w.add("SURFACE_SIDE_STYLE('',(%s))" % c)
+        c = w.add("SURFACE_STYLE_USAGE(.BOTH.,%s)" % c)
+        c = w.add("PRESENTATION_STYLE_ASSIGNMENT((%s))" % c)
+        return w.add("STYLED_ITEM('color',(%s),%s)" % (c, item))
+
+    # the corners have the index x + 2*y + 4*z, the faces run counter-clockwise
+    # seen from outside
+    faces = [((0,2,3,1), Vector(0,0,-1)), ((4,5,7,6), Vector(0,0,1)),
+             ((0,1,5,4), Vector(0,-1,0)), ((2,6,7,3), Vector(0,1,0)),
+             ((0,4,6,2), Vector(-1,0,0)), ((1,3,7,5), Vector(1,0,0))]
+    styles = []
+    partDefinitions = []
+    partShapes = []
+    for name, size, rgb in parts:
+        corners = [Vector(size.x * (i & 1), size.y * ((i >> 1) & 1), size.z * ((i >> 2) & 1)) for i in range(8)]
+        vertices = [w.add("VERTEX_POINT('',%s)" % w.point(c)) for c in corners]
+        edges = {}
+        advancedFaces = []
+        for loop, normal in faces:
+            oriented = []
+            for i in range(4):
+                a, b = loop[i], loop[(i+1)%4]
+                key = (min(a,b), max(a,b))
+                if key not in edges:
+                    d = corners[key[1]] - corners[key[0]]
+                    vector = w.add("VECTOR('',%s,%s)" % (w.direction(Vector(d).normalize()), w.real(d.Length)))
+                    line = w.add("LINE('',%s,%s)" % (w.point(corners[key[0]]), vector))
+                    edges[key] = w.add("EDGE_CURVE('',%s,%s,%s,.T.)" % (vertices[key[0]], vertices[key[1]], line))
+                oriented.append(w.add("ORIENTED_EDGE('',*,*,%s,%s)" % (edges[key], a < b and ".T." or ".F.")))
+            edgeLoop = w.add("EDGE_LOOP('',(%s))" % ",".join(oriented))
+            bound = w.add("FACE_OUTER_BOUND('',%s,.T.)" % edgeLoop)
+            xdir = abs(normal.x) > 0.5 and Vector(0,0,1) or Vector(1,0,0)
+            plane = w.add("PLANE('',%s)" % w.axis(corners[loop[0]], normal, xdir))
+            advancedFaces.append(w.add("ADVANCED_FACE('',(%s),%s,.T.)" % (bound, plane)))
+        shell = w.add("CLOSED_SHELL('',(%s))" % ",".join(advancedFaces))
+        brep = w.add("MANIFOLD_SOLID_BREP('%s',%s)" % (name, shell))
+        styles.append(colour(brep, rgb))
+        if not partShapes:
+            styles.append(colour(advancedFaces[0], (0.0, 1.0, 0.0)))
+        shape = w.add("ADVANCED_BREP_SHAPE_REPRESENTATION('',(%s,%s),%s)" % (origin, brep, context))
+        definition = product(name)
+        w.add("SHAPE_DEFINITION_REPRESENTATION(%s,%s)" % (w.add("PRODUCT_DEFINITION_SHAPE('','',%s)" % definition), shape))
+        partDefinitions.append(definition)
+        partShapes.append(shape)
+
+    axes = []
+    for part, placement in instances:
+        rot = placement.Rotation
+        axes.append(w.axis(placement.Base, rot.multVec(Vector(0,0,1)), rot.multVec(Vector(1,0,0))))
+    assembly = product("Assembly")
+    shape = w.add("SHAPE_REPRESENTATION('',(%s),%s)" % (",".join([origin] + axes), context))
+    w.add("SHAPE_DEFINITION_REPRESENTATION(%s,%s)" % (w.add("PRODUCT_DEFINITION_SHAPE('','',%s)" % assembly), shape))
+    for i in range(len(instances)):
+        part = instances[i][0]
+        transformation = w.add("ITEM_DEFINED_TRANSFORMATION('','',%s,%s)" % (origin, axes[i]))
+        relation = w.add("( REPRESENTATION_RELATIONSHIP('','',%s,%s) REPRESENTATION_RELATIONSHIP_WITH_TRANSFORMATION(%s) "
+                         "SHAPE_REPRESENTATION_RELATIONSHIP() )" % (partShapes[part], shape, transformation))
+        usage = w.add("NEXT_ASSEMBLY_USAGE_OCCURRENCE('%d','%s','',%s,%s,$)" % (i+1, parts[part][0], assembly, partDefinitions[part]))
+        w.add("CONTEXT_DEPENDENT_SHAPE_REPRESENTATION(%s,%s)" % (relation,
+              w.add("PRODUCT_DEFINITION_SHAPE('Placement','Placement of an item',%s)" % usage)))
+
+    w.add("MECHANICAL_DESIGN_GEOMETRIC_PRESENTATION_REPRESENTATION('',(%s),%s)" % (",".join(styles), context))
+    w.write(path)
+
+
+def makeInstances(count):
+    """ Bolts and nuts in a grid, every other one turned """
+    instances = []
+    for i in range(count):
+        rot = Rotation(Vector(0,0,1), 90 * (i % 2)).multiply(Rotation(Vector(1,0,0), 30 * (i % 3)))
+        instances.append((i % 3 == 2 and 1 or 0, Placement(Vector(20 * (i % 10), 20 * (i // 10), 0), rot)))
+    return instances
+
+
+class StepInstancingTestCases(unittest.TestCase):
+    def setUp(self):
+        self.Parts = [("Bolt", Vector(4,4,12), (1.0,0.0,0.0)), ("Nut", Vector(8,8,4), (0.0,0.0,1.0))]
+        self.Group = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Import")
+        self.Instancing = self.Group.GetBool("UseInstancing", False)
+        self.FileName = os.path.join(tempfile.gettempdir(), "InstancingTest.stp")
+
+    def importFile(self, instancing):
+        """ Imports the file into a new document and returns its features """
+        self.Group.SetBool("UseInstancing", instancing)
+        doc = FreeCAD.newDocument(instancing and "InstancingOn" or "InstancingOff")
+        if FreeCAD.GuiUp:
+            import ImportGui
+            ImportGui.insert(self.FileName, doc.Name)
+        else:
+            Import.insert(self.FileName, doc.Name)
+        return [o for o in doc.Objects if o.isDerivedFrom("Part::Feature")]
+
+    def samePlacement(self, p1, p2):
+        if (p1.Base - p2.Base).Length > 1e-6:
+            return False
+        q1 = p1.Rotation.Q
+        q2 = p2.Rotation.Q
+        # q and -q are the same rotation
+        return (max([abs(q1[i] - q2[i]) for i in range(4)]) < 1e-6 or
+                max([abs(q1[i] + q2[i]) for i in range(4)]) < 1e-6)
+
+    def testInstancing(self):
+        instances = makeInstances(12)
+        writeStepAssembly(self.FileName, self.Parts, instances)
+        features = self.importFile(False)
+        shared = self.importFile(True)
+        self.failUnless(len(features) == len(instances))
+        self.failUnless(len(shared) == len(instances))
+
+        for i in range(len(instances)):
+            # both modes create the features in the same order
+            f = features[i]
+            s = shared[i]
+            self.failUnless(f.Label == s.Label)
+            self.failUnless(self.samePlacement(f.Placement, s.Placement), "placement of feature %d" % i)
+            self.failUnless(abs(f.Shape.Volume - s.Shape.Volume) < 1e-6)
+            if FreeCAD.GuiUp:
+                self.failUnless(f.ViewObject.DiffuseColor == s.ViewObject.DiffuseColor, "colours of feature %d" % i)
+                self.failUnless(f.ViewObject.ShapeColor == s.ViewObject.ShapeColor, "colour of feature %d" % i)
+
+        matched = []
+        for i in range(len(instances)):
+            part, placement = instances[i]
+            found = [s for s in shared if self.samePlacement(s.Placement, placement)]
+            self.failUnless(len(found) == 1, "placement of instance %d" % i)
+            s = found[0]
+            matched.append(s)
+            size = self.Parts[part][1]
+            self.failUnless(abs(s.Shape.Volume - size.x * size.y * size.z) < 1e-6)
+
+        # with instancing all occurrences of a part share its shape
+        for i in range(1, len(instances)):
+            if instances[i][0] == instances[0][0]:
+                self.failUnless(matched[i].Shape.isPartner(matched[0].Shape))
+
+    def testImportTime(self):
+        for count in (100, 1000, 5000):
+            writeStepAssembly(self.FileName, self.Parts, makeInstances(count))
+            for instancing in (False, True):
+                start=time.time()
+                features = self.importFile(instancing)
+                FreeCAD.Console.PrintMessage("STEP import of %d instances, UseInstancing=%s: %.3f s\n" % (count, instancing, time.time()-start))
+                self.failUnless(len(features) == count)
+                FreeCAD.closeDocument(instancing and "InstancingOn" or "InstancingOff")
+
+    def tearDown(self):
+        self.Group.SetBool("UseInstancing", self.Instancing)
+        for name in ("InstancingOn", "InstancingOff"):
+            if name in FreeCAD.listDocuments():
+                FreeCAD.closeDocument(name)
+        if os.path.exists(self.FileName):
+            os.remove(self.FileName)
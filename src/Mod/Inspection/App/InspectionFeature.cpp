@@ -23,9 +23,18 @@
 
 #include "PreCompiled.h"
 #include <gp_Pnt.hxx>
+#include <BRep_Tool.hxx>
 #include <BRepExtrema_DistShapeShape.hxx>
 #include <BRepBuilderAPI_MakeVertex.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Standard_Version.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
 #include <TopoDS_Vertex.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
 
 #include <QEventLoop>
 #include <QFuture>
@@ -45,6 +54,7 @@
 #include <Mod/Mesh/App/Mesh.h>
 #include <Mod/Mesh/App/MeshFeature.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/FacetTree.h>
 #include <Mod/Mesh/App/Core/Grid.h>
 #include <Mod/Mesh/App/Core/Iterator.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
@@ -176,15 +186,21 @@ namespace Inspection {
             assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
         }
 
-        void AddFacet (const MeshCore::MeshGeomFacet &rclFacet, unsigned long ulFacetIndex)
+        void CollectCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const
         {
+            const MeshCore::MeshFacet& rclFacet = _pclMesh->GetFacets()[ulIndex];
+            const MeshCore::MeshPointArray& rclPoints = _pclMesh->GetPoints();
+            MeshCore::MeshGeomFacet clFacet;
+            for (int i=0; i<3; i++)
+                clFacet._aclPoints[i] = _transform * rclPoints[rclFacet._aulPoints[i]];
+
             unsigned long ulX, ulY, ulZ;
             unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
 
             Base::BoundBox3f clBB;
-            clBB &= rclFacet._aclPoints[0];
-            clBB &= rclFacet._aclPoints[1];
-            clBB &= rclFacet._aclPoints[2];
+            clBB &= clFacet._aclPoints[0];
+            clBB &= clFacet._aclPoints[1];
+            clBB &= clFacet._aclPoints[2];
 
             Pos(Base::Vector3f(clBB.MinX,clBB.MinY,clBB.MinZ), ulX1, ulY1, ulZ1);
             Pos(Base::Vector3f(clBB.MaxX,clBB.MaxY,clBB.MaxZ), ulX2, ulY2, ulZ2);
@@ -194,20 +210,18 @@ namespace Inspection {
                 for (ulX = ulX1; ulX <= ulX2; ulX++) {
                     for (ulY = ulY1; ulY <= ulY2; ulY++) {
                         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
-                            if (rclFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
-                                _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+                            if (clFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
+                                raulCells.push_back(CellIndex(ulX, ulY, ulZ));
                         }
                     }
                 }
             }
             else
-                _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+                raulCells.push_back(CellIndex(ulX1, ulY1, ulZ1));
         }
 
         void InitGrid (void)
         {
-            unsigned long i, j;
-
             Base::BoundBox3f clBBMesh = _pclMesh->GetBoundBox().Transformed(_transform);
 
             float fLengthX = clBBMesh.LengthX(); 
@@ -223,26 +237,16 @@ namespace Inspection {
             _fGridLenZ = (1.0f + fLengthZ) / float(_ulCtGridsZ);
             _fMinZ = clBBMesh.MinZ - 0.5f;
 
-            _aulGrid.clear();
-            _aulGrid.resize(_ulCtGridsX);
-            for (i = 0; i < _ulCtGridsX; i++) {
-                _aulGrid[i].resize(_ulCtGridsY);
-                for (j = 0; j < _ulCtGridsY; j++)
-                    _aulGrid[i][j].resize(_ulCtGridsZ);
-            }
+            _aulCellElements.clear();
+            _aulCellOffsets.clear();
+            _aulCellOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
         }
 
         void RebuildGrid (void)
         {
             _ulCtElements = _pclMesh->CountFacets();
             InitGrid();
- 
-            unsigned long i = 0;
-            MeshCore::MeshFacetIterator clFIter(*_pclMesh);
-            clFIter.Transform(_transform);
-            for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
-                AddFacet(*clFIter, i++);
-            }
+            FillGrid();
         }
 
     private:
@@ -250,34 +254,21 @@ namespace Inspection {
     };
 }
 
-InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset) : _iter(rMesh.getKernel())
+InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset)
 {
     const MeshCore::MeshKernel& kernel = rMesh.getKernel();
-    _iter.Transform(rMesh.getTransform());
-
-    // Max. limit of grid elements
-    float fMaxGridElements=8000000.0f;
-    Base::BoundBox3f box = kernel.GetBoundBox().Transformed(rMesh.getTransform());
-
-    // estimate the minimum allowed grid length
-    float fMinGridLen = (float)pow((box.LengthX()*box.LengthY()*box.LengthZ()/fMaxGridElements), 0.3333f);
-    float fGridLen = 5.0f * MeshCore::MeshAlgorithm(kernel).GetAverageEdgeLength();
-
-    // We want to avoid to get too small grid elements otherwise building up the grid structure would take
-    // too much time and memory. 
-    // Having quite a dense grid speeds up more the following algorithms extremely. Due to the issue above it's
-    // always a compromise between speed and memory usage.
-    fGridLen = std::max<float>(fMinGridLen, fGridLen);
 
-    // build up grid structure to speed up algorithms
-    _pGrid = new MeshInspectGrid(kernel, fGridLen, rMesh.getTransform());
-    _box = box;
+    // Unlike a grid the search time of a bounding volume hierarchy doesn't depend on
+    // the size and distribution of the facets and it finds the nearest facet also
+    // for points far away from the mesh.
+    _pTree = new MeshCore::MeshFacetTree(kernel, rMesh.getTransform());
+    _box = kernel.GetBoundBox().Transformed(rMesh.getTransform());
     _box.Enlarge(offset);
 }
 
 InspectNominalMesh::~InspectNominalMesh()
 {
-    delete this->_pGrid;
+    delete this->_pTree;
 }
 
 float InspectNominalMesh::getDistance(const Base::Vector3f& point)
@@ -285,26 +276,13 @@ float InspectNominalMesh::getDistance(const Base::Vector3f& point)
     if (!_box.IsInBox(point))
         return FLT_MAX; // must be inside bbox
 
-    std::vector<unsigned long> indices;
-    //_pGrid->GetElements(point, indices);
-    if (indices.empty()) {
-        std::set<unsigned long> inds;
-        _pGrid->MeshGrid::SearchNearestFromPoint(point, inds);
-        indices.insert(indices.begin(), inds.begin(), inds.end());
-    }
-
-    float fMinDist=FLT_MAX;
-    bool positive = true;
-    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
-        if (fabs(fDist) < fabs(fMinDist)) {
-            fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
-        }
-    }
+    unsigned long facet;
+    float fMinDist;
+    if (!_pTree->NearestFacet(point, FLT_MAX, facet, fMinDist))
+        return FLT_MAX;
 
-    if (!positive)
+    MeshCore::MeshGeomFacet face = _pTree->GetFacet(facet);
+    if (point.DistanceToPlane(face._aclPoints[0], face.GetNormal()) <= 0)
         fMinDist = -fMinDist;
     return fMinDist;
 }
@@ -418,25 +396,130 @@ float InspectNominalPoints::getDistance(const Base::Vector3f& point)
 
 // ----------------------------------------------------------------
 
-InspectNominalShape::InspectNominalShape(const TopoDS_Shape& shape, float radius) : _rShape(shape)
+InspectNominalShape::InspectNominalShape(const TopoDS_Shape& shape, float radius)
+  : _rShape(shape), _radius(radius), _deflection(0.0f), _pFaces(0), _pTessellation(0), _pTree(0)
 {
     distss = new BRepExtrema_DistShapeShape();
     distss->LoadS1(_rShape);
     //distss->SetDeflection(radius);
+
+    // use the same deflection as for an actual shape
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part");
+    float deviation = hGrp->GetFloat("MeshDeviation",0.2);
+
+    Base::BoundBox3d bbox = Part::TopoShape(_rShape).getBoundBox();
+    Standard_Real deflection = (bbox.LengthX() + bbox.LengthY() + bbox.LengthZ())/300.0 * deviation;
+    if (!buildTessellation((float)deflection)) {
+        delete _pFaces;
+        _pFaces = 0;
+        _faceOfFacet.clear();
+    }
 }
 
 InspectNominalShape::~InspectNominalShape()
 {
     delete distss;
+    delete _pTree;
+    delete _pTessellation;
+    delete _pFaces;
+}
+
+/**
+ * Tessellates the faces of the shape and builds up a bounding volume hierarchy of the
+ * triangles. Returns false if the shape cannot be handled this way, i.e. if it has no
+ * faces, a face cannot be meshed or if it has edges or vertices outside of a face.
+ */
+bool InspectNominalShape::buildTessellation(float deflection)
+{
+    TopExp_Explorer xp;
+    xp.Init(_rShape, TopAbs_EDGE, TopAbs_FACE);
+    if (xp.More())
+        return false;
+    xp.Init(_rShape, TopAbs_VERTEX, TopAbs_EDGE);
+    if (xp.More())
+        return false;
+
+    _pFaces = new TopTools_IndexedMapOfShape();
+    TopExp::MapShapes(_rShape, TopAbs_FACE, *_pFaces);
+    if (_pFaces->IsEmpty())
+        return false;
+
+#if OCC_VERSION_HEX >= 0x060700
+    BRepMesh_IncrementalMesh aMesh(_rShape, deflection, Standard_False, 0.5, Standard_True);
+#else
+    BRepMesh_IncrementalMesh aMesh(_rShape, deflection, Standard_False);
+#endif
+
+    MeshCore::MeshPointArray points;
+    MeshCore::MeshFacetArray facets;
+    _deflection = deflection;
+    for (int i = 1; i <= _pFaces->Extent(); i++) {
+        TopLoc_Location loc;
+        Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(TopoDS::Face(_pFaces->FindKey(i)), loc);
+        if (mesh.IsNull())
+            return false;
+
+        // a face may keep a finer triangulation from before
+        _deflection = std::max<float>(_deflection, (float)mesh->Deflection());
+
+        gp_Trsf trsf = loc.Transformation();
+        unsigned long offset = points.size();
+        const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+        for (Standard_Integer j = nodes.Lower(); j <= nodes.Upper(); j++) {
+            gp_Pnt p = nodes(j).Transformed(trsf);
+            points.push_back(MeshCore::MeshPoint(Base::Vector3f((float)p.X(),(float)p.Y(),(float)p.Z())));
+        }
+
+        const Poly_Array1OfTriangle& triangles = mesh->Triangles();
+        for (Standard_Integer j = triangles.Lower(); j <= triangles.Upper(); j++) {
+            Standard_Integer n1, n2, n3;
+            triangles(j).Get(n1, n2, n3);
+            facets.push_back(MeshCore::MeshFacet(offset + n1 - nodes.Lower(),
+                                                 offset + n2 - nodes.Lower(),
+                                                 offset + n3 - nodes.Lower()));
+            _faceOfFacet.push_back(i);
+        }
+    }
+
+    _pTessellation = new MeshCore::MeshKernel();
+    _pTessellation->Adopt(points, facets, false);
+    _pTree = new MeshCore::MeshFacetTree(*_pTessellation);
+    return true;
 }
 
 float InspectNominalShape::getDistance(const Base::Vector3f& point)
 {
     BRepBuilderAPI_MakeVertex mkVert(gp_Pnt(point.x,point.y,point.z));
-    distss->LoadS2(mkVert.Vertex());
     float fMinDist=FLT_MAX;
-    if (distss->Perform() && distss->NbSolution() > 0)
-        fMinDist = (float)distss->Value();
+    if (!_pTree) {
+        distss->LoadS2(mkVert.Vertex());
+        if (distss->Perform() && distss->NbSolution() > 0)
+            fMinDist = (float)distss->Value();
+        return fMinDist;
+    }
+
+    // The tessellation deviates from the faces by at most the deflection. So, the
+    // nearest triangle gives the distance up to the deflection and the nearest face
+    // must have a triangle within the distance plus twice the deflection.
+    unsigned long facet;
+    float fDist;
+    if (!_pTree->NearestFacet(point, FLT_MAX, facet, fDist))
+        return FLT_MAX;
+    if (fDist - _deflection > _radius)
+        return fDist; // outside the search radius, no need to be exact
+
+    std::vector<unsigned long> facets;
+    _pTree->SearchFacets(point, fDist + 2.0f * _deflection, facets);
+    std::set<int> faces;
+    for (std::vector<unsigned long>::iterator it = facets.begin(); it != facets.end(); ++it)
+        faces.insert(_faceOfFacet[*it]);
+
+    for (std::set<int>::iterator it = faces.begin(); it != faces.end(); ++it) {
+        BRepExtrema_DistShapeShape dist(mkVert.Vertex(), _pFaces->FindKey(*it));
+        if (dist.IsDone() && dist.NbSolution() > 0)
+            fMinDist = std::min<float>(fMinDist, (float)dist.Value());
+    }
     return fMinDist;
 }
 
@@ -529,7 +612,7 @@ void PropertyDistanceList::Save (Base::Writer &writer) const
     }
     else {
         writer.Stream() << writer.ind() << "<FloatList file=\"" << 
-        writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -549,9 +632,8 @@ void PropertyDistanceList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
-    for (std::vector<float>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << *it;
-    }
+    if (uCt > 0)
+        str.writeArray(&(_lValueList[0]), uCt);
 }
 
 void PropertyDistanceList::RestoreDocFile(Base::Reader &reader)
@@ -560,9 +642,8 @@ void PropertyDistanceList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<float> values(uCt);
-    for (std::vector<float>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> *it;
-    }
+    if (uCt > 0)
+        str.readArray(&(values[0]), uCt);
     setValues(values);
 }
 
@@ -33,10 +33,12 @@
 
 class TopoDS_Shape;
 class BRepExtrema_DistShapeShape;
+class TopTools_IndexedMapOfShape;
 
 namespace MeshCore {
 class MeshKernel;
 class MeshGrid;
+class MeshFacetTree;
 }
 
 namespace Mesh   { class MeshObject; }
@@ -110,8 +112,7 @@ public:
     virtual float getDistance(const Base::Vector3f&);
 
 private:
-    MeshCore::MeshFacetIterator _iter;
-    MeshCore::MeshGrid* _pGrid;
+    MeshCore::MeshFacetTree* _pTree;
     Base::BoundBox3f _box;
 };
 
@@ -148,9 +149,21 @@ public:
     ~InspectNominalShape();
     virtual float getDistance(const Base::Vector3f&);
 
+private:
+    bool buildTessellation(float deflection);
+
 private:
     BRepExtrema_DistShapeShape* distss;
     const TopoDS_Shape& _rShape;
+    float _radius;
+    float _deflection;
+    /** @name Tessellation of the faces to preselect the faces to check */
+    //@{
+    TopTools_IndexedMapOfShape* _pFaces;
+    MeshCore::MeshKernel* _pTessellation;
+    MeshCore::MeshFacetTree* _pTree;
+    std::vector<int> _faceOfFacet;
+    //@}
 };
 
 class InspectionExport PropertyDistanceList: public App::PropertyLists
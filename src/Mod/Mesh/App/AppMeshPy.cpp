@@ -40,6 +40,7 @@
 #include "Core/MeshIO.h"
 #include "Core/Evaluation.h"
 #include "Core/Iterator.h"
+#include "Core/Registration.h"
 
 #include "MeshPy.h"
 #include "Mesh.h"
@@ -438,6 +439,68 @@ calculateEigenTransform(PyObject *self, PyObject *args)
 }
 
 
+static void
+getPointList(PyObject *input, std::vector<Base::Vector3f>& points)
+{
+    Py::Sequence list(input);
+    points.reserve(list.size());
+    for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+        PyObject* value = (*it).ptr();
+        if (!PyObject_TypeCheck(value, &(Base::VectorPy::Type)))
+            throw Py::TypeError("Input have to be a sequence of Base.Vector()");
+        Base::Vector3d* val = static_cast<Base::VectorPy*>(value)->getVectorPtr();
+        points.push_back(Base::Vector3f(float(val->x),float(val->y),float(val->z)));
+    }
+}
+
+static PyObject *
+registerPoints(PyObject *self, PyObject *args)
+{
+    PyObject *source, *target;
+    int iterations = 50;
+    float tolerance = 1.0e-6f, maxDistance = 0.0f;
+
+    if (!PyArg_ParseTuple(args, "OO|iff",&source,&target,&iterations,&tolerance,&maxDistance))
+        return NULL;
+
+    if (!PySequence_Check(source)) {
+        PyErr_SetString(PyExc_TypeError, "Source have to be a sequence of Base.Vector()");
+        return NULL;
+    }
+    if (!PySequence_Check(target) && !PyObject_TypeCheck(target, &(MeshPy::Type))) {
+        PyErr_SetString(PyExc_TypeError, "Target have to be a mesh or a sequence of Base.Vector()");
+        return NULL;
+    }
+
+    PY_TRY {
+        std::vector<Base::Vector3f> sourcePoints;
+        getPointList(source, sourcePoints);
+
+        std::auto_ptr<MeshCore::PointRegistration> reg;
+        if (PyObject_TypeCheck(target, &(MeshPy::Type))) {
+            const MeshObject* mesh = static_cast<MeshPy*>(target)->getMeshObjectPtr();
+            reg.reset(new MeshCore::PointRegistration(mesh->getKernel()));
+        }
+        else {
+            std::vector<Base::Vector3f> targetPoints;
+            getPointList(target, targetPoints);
+            reg.reset(new MeshCore::PointRegistration(targetPoints));
+        }
+
+        reg->SetMaxIterations(iterations);
+        reg->SetTolerance(tolerance);
+        reg->SetMaxDistance(maxDistance);
+
+        Base::Matrix4D mat;
+        float error = reg->Perform(sourcePoints, mat);
+
+        Py::Tuple tuple(2);
+        tuple.setItem(0, Py::Object(new Base::PlacementPy(new Base::Placement(mat)), true));
+        tuple.setItem(1, Py::Float(error));
+        return Py::new_reference_to(tuple);
+    } PY_CATCH;
+}
+
 PyDoc_STRVAR(open_doc,
 "open(string) -- Create a new document and a Mesh::Import feature to load the file into the document.");
 
@@ -455,6 +518,14 @@ PyDoc_STRVAR(calculateEigenTransform_doc,
 "The local coordinate system is right-handed.\n"
 );
 
+PyDoc_STRVAR(registerPoints_doc,
+"registerPoints(seq(Base.Vector), mesh|seq(Base.Vector), [iterations, tolerance, maxDistance]) -- Registers points.\n"
+"Computes the rigid transformation that moves the source points onto the target mesh\n"
+"or point cloud (Iterative Closest Point) and returns a tuple of the placement and the\n"
+"RMS distance of the matched points. Point pairs farther apart than maxDistance are\n"
+"ignored if it is greater than zero.\n"
+);
+
 /* List of functions defined in the module */
 
 struct PyMethodDef Mesh_Import_methods[] = { 
@@ -471,5 +542,6 @@ struct PyMethodDef Mesh_Import_methods[] = {
     {"createCone",createCone, Py_NEWARGS,   "Create a tessellated cone"},
     {"createTorus",createTorus, Py_NEWARGS,   "Create a tessellated torus"},
     {"calculateEigenTransform",calculateEigenTransform, METH_VARARGS,   calculateEigenTransform_doc},
+    {"registerPoints",registerPoints, METH_VARARGS,   registerPoints_doc},
     {NULL, NULL}  /* sentinel */
 };
@@ -37,6 +37,11 @@
 #include <Base/Console.h>
 #include <Base/Sequencer.h>
 
+#include <QAtomicInt>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 using namespace MeshCore;
 using Base::BoundBox3f;
 using Base::BoundBox2D;
@@ -637,8 +642,8 @@ bool MeshAlgorithm::FillupHole(const std::vector<unsigned long>& boundary,
     unsigned long refPoint0 = *(boundary.begin());
     unsigned long refPoint1 = *(boundary.begin()+1);
     if (pP2FStructure) {
-        const std::set<unsigned long>& ring1 = (*pP2FStructure)[refPoint0];
-        const std::set<unsigned long>& ring2 = (*pP2FStructure)[refPoint1];
+        MeshIndexRange ring1 = (*pP2FStructure)[refPoint0];
+        MeshIndexRange ring2 = (*pP2FStructure)[refPoint1];
         std::vector<unsigned long> f_int;
         std::set_intersection(ring1.begin(), ring1.end(), ring2.begin(), ring2.end(),
             std::back_insert_iterator<std::vector<unsigned long> >(f_int));
@@ -1694,28 +1699,220 @@ float MeshAlgorithm::CalculateMinimumGridLength(float fLength, const Base::Bound
 
 // ----------------------------------------------------
 
-void MeshRefPointToFacets::Rebuild (void)
+namespace {
+
+typedef std::pair<unsigned long, unsigned long> IndexRange;
+
+std::vector<IndexRange> SplitRange (unsigned long count)
 {
-    _map.clear();
+    // for small meshes the thread overhead doesn't pay off
+    unsigned long ranges = 1;
+    if (count >= 100000)
+        ranges = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
 
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    _map.resize(rPoints.size());
+    std::vector<IndexRange> parts;
+    unsigned long step = (count + ranges - 1) / ranges;
+    for (unsigned long i = 0; i < count; i += step)
+        parts.push_back(IndexRange(i, std::min<unsigned long>(i + step, count)));
+    return parts;
+}
 
-    MeshFacetArray::_TConstIterator pFBegin = rFacets.begin();
-    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
-        _map[pFIter->_aulPoints[0]].insert(pFIter - pFBegin);
-        _map[pFIter->_aulPoints[1]].insert(pFIter - pFBegin);
-        _map[pFIter->_aulPoints[2]].insert(pFIter - pFBegin);
+template <class T>
+void RunRanges (T* obj, std::vector<IndexRange>& parts, void (T::*func)(const IndexRange&))
+{
+    if (parts.size() > 1)
+        QtConcurrent::blockingMap(parts, boost::bind(func, obj, _1));
+    else if (!parts.empty())
+        (obj->*func)(parts.front());
+}
+
+class PointToFacetsSource : public MeshIndexTable::Source
+{
+public:
+    PointToFacetsSource (const MeshFacetArray& facets) : facets(facets)
+    { }
+    unsigned long CountElements (void) const
+    { return facets.size(); }
+    void Collect (unsigned long index, std::vector<std::pair<unsigned long, unsigned long> >& entries) const
+    {
+        const MeshFacet& face = facets[index];
+        for (int i = 0; i < 3; i++)
+            entries.push_back(std::make_pair(face._aulPoints[i], index));
     }
+
+private:
+    const MeshFacetArray& facets;
+};
+
+class FacetToFacetsSource : public MeshIndexTable::Source
+{
+public:
+    FacetToFacetsSource (const MeshFacetArray& facets, const MeshRefPointToFacets& vertexFace)
+      : facets(facets), vertexFace(vertexFace)
+    { }
+    unsigned long CountElements (void) const
+    { return facets.size(); }
+    void Collect (unsigned long index, std::vector<std::pair<unsigned long, unsigned long> >& entries) const
+    {
+        const MeshFacet& face = facets[index];
+        for (int i = 0; i < 3; i++) {
+            MeshIndexRange faces = vertexFace[face._aulPoints[i]];
+            for (MeshIndexRange::const_iterator it = faces.begin(); it != faces.end(); ++it)
+                entries.push_back(std::make_pair(index, *it));
+        }
+    }
+
+private:
+    const MeshFacetArray& facets;
+    const MeshRefPointToFacets& vertexFace;
+};
+
+class PointToPointsSource : public MeshIndexTable::Source
+{
+public:
+    PointToPointsSource (const MeshFacetArray& facets) : facets(facets)
+    { }
+    unsigned long CountElements (void) const
+    { return facets.size(); }
+    void Collect (unsigned long index, std::vector<std::pair<unsigned long, unsigned long> >& entries) const
+    {
+        const MeshFacet& face = facets[index];
+        for (int i = 0; i < 3; i++) {
+            entries.push_back(std::make_pair(face._aulPoints[i], face._aulPoints[(i+1)%3]));
+            entries.push_back(std::make_pair(face._aulPoints[i], face._aulPoints[(i+2)%3]));
+        }
+    }
+
+private:
+    const MeshFacetArray& facets;
+};
+
+}
+
+namespace MeshCore {
+
+/**
+ * Builds a MeshIndexTable in two counting passes over the source (count, then fill)
+ * followed by sorting each row. For large meshes all passes run on QtConcurrent.
+ */
+class MeshIndexTableBuilder
+{
+public:
+    MeshIndexTableBuilder (MeshIndexTable& table, unsigned long rows, const MeshIndexTable::Source& source)
+      : _table(table), _source(source), _counts(rows)
+    { }
+
+    void Build (void)
+    {
+        std::vector<unsigned long>& offsets = _table._offsets;
+        std::vector<unsigned long>& indices = _table._indices;
+        unsigned long rows = _counts.size();
+
+        std::vector<IndexRange> elements = SplitRange(_source.CountElements());
+        RunRanges(this, elements, &MeshIndexTableBuilder::CountRows);
+
+        offsets.resize(rows + 1);
+        offsets[0] = 0;
+        for (unsigned long i = 0; i < rows; i++) {
+            offsets[i+1] = offsets[i] + (unsigned long)int(_counts[i]);
+            _counts[i] = 0;
+        }
+
+        indices.resize(offsets[rows]);
+        RunRanges(this, elements, &MeshIndexTableBuilder::FillRows);
+
+        std::vector<IndexRange> parts = SplitRange(rows);
+        RunRanges(this, parts, &MeshIndexTableBuilder::SortRows);
+
+        // close the gaps left by removed duplicates
+        unsigned long pos = 0;
+        for (unsigned long i = 0; i < rows; i++) {
+            unsigned long begin = offsets[i];
+            unsigned long size = (unsigned long)int(_counts[i]);
+            offsets[i] = pos;
+            if (pos != begin)
+                std::copy(indices.begin() + begin, indices.begin() + begin + size, indices.begin() + pos);
+            pos += size;
+        }
+        offsets[rows] = pos;
+
+        if (pos < indices.size())
+            std::vector<unsigned long>(indices.begin(), indices.begin() + pos).swap(indices);
+    }
+
+private:
+    void CountRows (const IndexRange& range)
+    {
+        std::vector<std::pair<unsigned long, unsigned long> > entries;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            entries.clear();
+            _source.Collect(i, entries);
+            for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = entries.begin(); it != entries.end(); ++it)
+                _counts[it->first].fetchAndAddRelaxed(1);
+        }
+    }
+
+    void FillRows (const IndexRange& range)
+    {
+        const std::vector<unsigned long>& offsets = _table._offsets;
+        std::vector<unsigned long>& indices = _table._indices;
+        std::vector<std::pair<unsigned long, unsigned long> > entries;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            entries.clear();
+            _source.Collect(i, entries);
+            for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = entries.begin(); it != entries.end(); ++it)
+                indices[offsets[it->first] + (unsigned long)_counts[it->first].fetchAndAddRelaxed(1)] = it->second;
+        }
+    }
+
+    void SortRows (const IndexRange& range)
+    {
+        const std::vector<unsigned long>& offsets = _table._offsets;
+        std::vector<unsigned long>& indices = _table._indices;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            std::vector<unsigned long>::iterator begin = indices.begin() + offsets[i];
+            std::vector<unsigned long>::iterator end = indices.begin() + offsets[i+1];
+            std::sort(begin, end);
+            _counts[i] = int(std::unique(begin, end) - begin);
+        }
+    }
+
+private:
+    MeshIndexTable& _table;
+    const MeshIndexTable::Source& _source;
+    std::vector<QAtomicInt> _counts;
+};
+
+}
+
+void MeshIndexTable::clear (void)
+{
+    // release the memory, the tables of big meshes are huge
+    std::vector<unsigned long>().swap(_offsets);
+    std::vector<unsigned long>().swap(_indices);
+}
+
+void MeshIndexTable::Build (unsigned long rows, const Source& source)
+{
+    clear();
+    MeshIndexTableBuilder builder(*this, rows, source);
+    builder.Build();
+}
+
+// ----------------------------------------------------
+
+void MeshRefPointToFacets::Rebuild (void)
+{
+    PointToFacetsSource source(_rclMesh.GetFacets());
+    _map.Build(_rclMesh.CountPoints(), source);
 }
 
 Base::Vector3f MeshRefPointToFacets::GetNormal(unsigned long pos) const
 {
-    const std::set<unsigned long>& n = _map[pos];
+    MeshIndexRange n = _map[pos];
     Base::Vector3f normal;
     MeshGeomFacet f;
-    for (std::set<unsigned long>::const_iterator it = n.begin(); it != n.end(); ++it) {
+    for (MeshIndexRange::const_iterator it = n.begin(); it != n.end(); ++it) {
         f = _rclMesh.GetFacet(*it);
         normal += f.Area() * f.GetNormal();
     }
@@ -1733,8 +1930,8 @@ std::set<unsigned long> MeshRefPointToFacets::NeighbourPoints(const std::vector<
     for (int i=0; i < level; i++) {
         std::set<unsigned long> cur;
         for (std::set<unsigned long>::iterator it = lp.begin(); it != lp.end(); ++it) {
-            const std::set<unsigned long>& ft = (*this)[*it];
-            for (std::set<unsigned long>::const_iterator jt = ft.begin(); jt != ft.end(); ++jt) {
+            MeshIndexRange ft = (*this)[*it];
+            for (MeshIndexRange::const_iterator jt = ft.begin(); jt != ft.end(); ++jt) {
                 for (int j = 0; j < 3; j++) {
                     unsigned long index = f_it[*jt]._aulPoints[j];
                     if (cp.find(index) == cp.end() && nb.find(index) == nb.end()) {
@@ -1774,9 +1971,9 @@ void MeshRefPointToFacets::SearchNeighbours(const MeshFacetArray& rFacets, unsig
     visited.insert(index);
     collect.Append(_rclMesh, index);
     for (int i = 0; i < 3; i++) {
-        const std::set<unsigned long> &f = (*this)[face._aulPoints[i]];
+        MeshIndexRange f = (*this)[face._aulPoints[i]];
 
-        for (std::set<unsigned long>::const_iterator j = f.begin(); j != f.end(); ++j) {
+        for (MeshIndexRange::const_iterator j = f.begin(); j != f.end(); ++j) {
             SearchNeighbours(rFacets, *j, rclCenter, fMaxDist2, visited, collect);
         }
     }
@@ -1788,43 +1985,24 @@ MeshRefPointToFacets::GetFacet (unsigned long index) const
     return _rclMesh.GetFacets().begin() + index;
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefPointToFacets::operator[] (unsigned long pos) const
 {
     return _map[pos];
 }
 
-void MeshRefPointToFacets::AddNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].insert(facet);
-}
-
-void MeshRefPointToFacets::RemoveNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].erase(facet);
-}
-
 //----------------------------------------------------------------------------
 
 void MeshRefFacetToFacets::Rebuild (void)
 {
     _map.clear();
 
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    _map.resize(rFacets.size());
-
     MeshRefPointToFacets  vertexFace(_rclMesh);
-    MeshFacetArray::_TConstIterator pFBegin = rFacets.begin();
-    for (MeshFacetArray::_TConstIterator pFIter = pFBegin; pFIter != rFacets.end(); ++pFIter) {
-        for (int i = 0; i < 3; i++) {
-            const std::set<unsigned long>& faces = vertexFace[pFIter->_aulPoints[i]];
-            for (std::set<unsigned long>::const_iterator it = faces.begin(); it != faces.end(); ++it)
-                _map[pFIter - pFBegin].insert(*it);
-        }
-    }
+    FacetToFacetsSource source(_rclMesh.GetFacets(), vertexFace);
+    _map.Build(_rclMesh.CountFacets(), source);
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefFacetToFacets::operator[] (unsigned long pos) const
 {
     return _map[pos];
@@ -1834,24 +2012,8 @@ MeshRefFacetToFacets::operator[] (unsigned long pos) const
 
 void MeshRefPointToPoints::Rebuild (void)
 {
-    _map.clear();
-
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    _map.resize(rPoints.size());
-
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
-        unsigned long ulP0 = pFIter->_aulPoints[0];
-        unsigned long ulP1 = pFIter->_aulPoints[1];
-        unsigned long ulP2 = pFIter->_aulPoints[2];
-
-        _map[ulP0].insert(ulP1);
-        _map[ulP0].insert(ulP2);
-        _map[ulP1].insert(ulP0);
-        _map[ulP1].insert(ulP2);
-        _map[ulP2].insert(ulP0);
-        _map[ulP2].insert(ulP1);
-    }
+    PointToPointsSource source(_rclMesh.GetFacets());
+    _map.Build(_rclMesh.CountPoints(), source);
 }
 
 Base::Vector3f MeshRefPointToPoints::GetNormal(unsigned long pos) const
@@ -1860,8 +2022,8 @@ Base::Vector3f MeshRefPointToPoints::GetNormal(unsigned long pos) const
     MeshCore::PlaneFit pf;
     pf.AddPoint(rPoints[pos]);
     MeshCore::MeshPoint center = rPoints[pos];
-    const std::set<unsigned long>& cv = _map[pos];
-    for (std::set<unsigned long>::const_iterator cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
+    MeshIndexRange cv = _map[pos];
+    for (MeshIndexRange::const_iterator cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
         pf.AddPoint(rPoints[*cv_it]);
         center += rPoints[*cv_it];
     }
@@ -1877,60 +2039,125 @@ float MeshRefPointToPoints::GetAverageEdgeLength(unsigned long index) const
 {
     const MeshPointArray& rPoints = _rclMesh.GetPoints();
     float len=0.0f;
-    const std::set<unsigned long>& n = (*this)[index];
+    MeshIndexRange n = (*this)[index];
     const Base::Vector3f& p = rPoints[index];
-    for (std::set<unsigned long>::const_iterator it = n.begin(); it != n.end(); ++it) {
+    for (MeshIndexRange::const_iterator it = n.begin(); it != n.end(); ++it) {
         len += Base::Distance(p, rPoints[*it]);
     }
     return (len/n.size());
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefPointToPoints::operator[] (unsigned long pos) const
 {
     return _map[pos];
 }
 
-void MeshRefPointToPoints::AddNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].insert(facet);
-}
+//----------------------------------------------------------------------------
 
-void MeshRefPointToPoints::RemoveNeighbour(unsigned long pos, unsigned long facet)
+/**
+ * Collects the edges starting at each point from the facets around the point. The
+ * points are processed in two passes (count, then fill) on QtConcurrent.
+ */
+class MeshRefEdgeToFacets::EdgeFacetsBuilder
 {
-    _map[pos].erase(facet);
-}
+public:
+    EdgeFacetsBuilder (const MeshKernel& mesh, std::vector<unsigned long>& offsets,
+                       std::vector<EdgeFacets>& edges)
+      : _points(mesh.CountPoints()), _facets(mesh.GetFacets()), _vertexFace(mesh)
+      , _offsets(offsets), _edges(edges)
+    { }
 
-//----------------------------------------------------------------------------
+    void Build (void)
+    {
+        unsigned long points = _points;
+        _offsets.resize(points + 1);
+        std::vector<IndexRange> parts = SplitRange(points);
+        RunRanges(this, parts, &EdgeFacetsBuilder::CountEdges);
+
+        // _offsets[i+1] holds the number of edges of point i
+        _offsets[0] = 0;
+        for (unsigned long i = 0; i < points; i++)
+            _offsets[i+1] += _offsets[i];
+
+        _edges.resize(_offsets[points]);
+        RunRanges(this, parts, &EdgeFacetsBuilder::FillEdges);
+    }
 
-void MeshRefEdgeToFacets::Rebuild (void)
-{
-    _map.clear();
+private:
+    void CollectEdges (unsigned long point, std::vector<EdgeFacets>& edges) const
+    {
+        // end point and facet of all edges starting at 'point'
+        std::vector<std::pair<unsigned long, unsigned long> > ends;
+        MeshIndexRange faces = _vertexFace[point];
+        for (MeshIndexRange::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+            const MeshFacet& face = _facets[*it];
+            for (int i = 0; i < 3; i++) {
+                if (face._aulPoints[i] == point)
+                    ends.push_back(std::make_pair(face._aulPoints[(i+1)%3], *it));
+            }
+        }
 
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    unsigned long index = 0;
-    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it, ++index) {
-        for (int i=0; i<3; i++) {
-            MeshEdge e;
-            e.first = it->_aulPoints[i];
-            e.second = it->_aulPoints[(i+1)%3];
-            std::map<MeshEdge, MeshFacetPair, EdgeOrder>::iterator jt =
-                _map.find(e);
-            if (jt == _map.end()) {
-                _map[e].first = index;
-                _map[e].second = ULONG_MAX;
+        // keep the first and the last facet of an edge
+        std::sort(ends.begin(), ends.end());
+        edges.clear();
+        for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = ends.begin(); it != ends.end(); ++it) {
+            if (edges.empty() || edges.back().second != it->first) {
+                EdgeFacets edge;
+                edge.second = it->first;
+                edge.facets.first = it->second;
+                edge.facets.second = ULONG_MAX;
+                edges.push_back(edge);
             }
             else {
-                _map[e].second = index;
+                edges.back().facets.second = it->second;
             }
         }
     }
+
+    void CountEdges (const IndexRange& range)
+    {
+        std::vector<EdgeFacets> edges;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            CollectEdges(i, edges);
+            _offsets[i+1] = edges.size();
+        }
+    }
+
+    void FillEdges (const IndexRange& range)
+    {
+        std::vector<EdgeFacets> edges;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            CollectEdges(i, edges);
+            std::copy(edges.begin(), edges.end(), _edges.begin() + _offsets[i]);
+        }
+    }
+
+private:
+    unsigned long _points;
+    const MeshFacetArray& _facets;
+    MeshRefPointToFacets _vertexFace;
+    std::vector<unsigned long>& _offsets;
+    std::vector<EdgeFacets>& _edges;
+};
+
+void MeshRefEdgeToFacets::Rebuild (void)
+{
+    std::vector<unsigned long>().swap(_offsets);
+    std::vector<EdgeFacets>().swap(_edges);
+
+    EdgeFacetsBuilder builder(_rclMesh, _offsets, _edges);
+    builder.Build();
 }
 
 const std::pair<unsigned long, unsigned long>&
 MeshRefEdgeToFacets::operator[] (const MeshEdge& edge) const
 {
-    return _map.find(edge)->second;
+    std::vector<EdgeFacets>::const_iterator begin = _edges.begin() + _offsets[edge.first];
+    std::vector<EdgeFacets>::const_iterator end = _edges.begin() + _offsets[edge.first+1];
+    std::vector<EdgeFacets>::const_iterator it = std::lower_bound(begin, end, edge.second);
+    assert(it != end && it->second == edge.second);
+    return it->facets;
 }
 
 //----------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #ifndef MESHALGORITHM_H
 #define MESHALGORITHM_H
 
+#include <algorithm>
 #include <set>
 #include <vector>
 #include <map>
@@ -354,6 +355,87 @@ private:
     std::vector<unsigned long>& indices;
 };
 
+/**
+ * The MeshIndexRange gives read-only access to a sorted range of indices without
+ * duplicates. It is what the MeshRef* structures return for a point or facet and
+ * can be used like a constant std::set<unsigned long>.
+ * \note The range refers to the memory of the structure it comes from and becomes
+ * invalid as soon as this structure gets rebuilt or destroyed.
+ */
+class MeshIndexRange
+{
+public:
+    typedef const unsigned long* const_iterator;
+    typedef const_iterator iterator;
+
+    MeshIndexRange (const_iterator begin, const_iterator end) : _begin(begin), _end(end)
+    { }
+
+    const_iterator begin (void) const
+    { return _begin; }
+    const_iterator end (void) const
+    { return _end; }
+    std::size_t size (void) const
+    { return _end - _begin; }
+    bool empty (void) const
+    { return _begin == _end; }
+    /// Returns the position of \a index or end() if it is not part of the range.
+    const_iterator find (unsigned long index) const
+    {
+        const_iterator it = std::lower_bound(_begin, _end, index);
+        return (it != _end && *it == index) ? it : _end;
+    }
+    std::size_t count (unsigned long index) const
+    { return find(index) != _end ? 1 : 0; }
+
+private:
+    const_iterator _begin, _end;
+};
+
+/**
+ * The MeshIndexTable stores for a number of rows a sorted range of indices in
+ * compressed row form, i.e. one array with all indices and one array with the offset
+ * of each row into it. This needs much less memory than a vector of sets and is
+ * built in one go by the MeshRef* structures.
+ */
+class MeshExport MeshIndexTable
+{
+public:
+    MeshIndexTable (void)
+    { }
+
+    /// Returns the indices of row \a pos.
+    MeshIndexRange operator[] (unsigned long pos) const
+    {
+        const unsigned long* data = _indices.empty() ? 0 : &_indices[0];
+        return MeshIndexRange(data + _offsets[pos], data + _offsets[pos+1]);
+    }
+    /// Returns the number of rows.
+    unsigned long size (void) const
+    { return _offsets.empty() ? 0 : (unsigned long)_offsets.size() - 1; }
+    void clear (void);
+
+    /** Source of the entries a table is built from. Collect() appends the (row, index)
+     * pairs contributed by one element of the source, it may be called from several
+     * threads at a time.
+     */
+    class Source
+    {
+    public:
+        virtual ~Source (void) {}
+        virtual unsigned long CountElements (void) const = 0;
+        virtual void Collect (unsigned long element,
+                              std::vector<std::pair<unsigned long, unsigned long> >& entries) const = 0;
+    };
+    /// Fills the table with \a rows rows. Each row gets sorted and duplicates are removed.
+    void Build (unsigned long rows, const Source&);
+
+private:
+    friend class MeshIndexTableBuilder;
+    std::vector<unsigned long> _offsets;
+    std::vector<unsigned long> _indices;
+};
+
 /**
  * The MeshRefPointToFacets builds up a structure to have access to all facets indexing
  * a point.
@@ -372,13 +454,11 @@ public:
 
     /// Rebuilds up data structure
     void Rebuild (void);
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
     MeshFacetArray::_TConstIterator GetFacet (unsigned long) const;
     std::set<unsigned long> NeighbourPoints(const std::vector<unsigned long>& , int level) const;
     void Neighbours (unsigned long ulFacetInd, float fMaxDist, MeshCollector& collect) const;
     Base::Vector3f GetNormal(unsigned long) const;
-    void AddNeighbour(unsigned long, unsigned long);
-    void RemoveNeighbour(unsigned long, unsigned long);
 
 protected:
     void SearchNeighbours(const MeshFacetArray& rFacets, unsigned long index, const Base::Vector3f &rclCenter, 
@@ -386,7 +466,7 @@ protected:
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    MeshIndexTable     _map;
 };
 
 /**
@@ -409,11 +489,11 @@ public:
 
     /// Returns a set of facets sharing one or more points with the facet with
     /// index \a ulFacetIndex.
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    MeshIndexTable     _map;
 };
 
 /**
@@ -434,15 +514,13 @@ public:
 
     /// Rebuilds up data structure
     void Rebuild (void);
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
     Base::Vector3f GetNormal(unsigned long) const;
     float GetAverageEdgeLength(unsigned long) const;
-    void AddNeighbour(unsigned long, unsigned long);
-    void RemoveNeighbour(unsigned long, unsigned long);
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    MeshIndexTable     _map;
 };
 
 /**
@@ -466,23 +544,19 @@ public:
     const std::pair<unsigned long, unsigned long>& operator[] (const MeshEdge&) const;
 
 protected:
-    class EdgeOrder {
-    public:
-        bool operator () (const MeshEdge &e1, const MeshEdge &e2) const
-        {
-            if (e1.first < e2.first)
-                return true;
-            else if (e1.first > e2.first)
-                return false;
-            else if (e1.second < e2.second)
-                return true;
-            else
-                return false;
-        }
-    };
     typedef std::pair<unsigned long, unsigned long> MeshFacetPair;
+    /// End point of an edge and its facets
+    struct EdgeFacets {
+        unsigned long second;
+        MeshFacetPair facets;
+        bool operator < (unsigned long index) const
+        { return second < index; }
+    };
+    class EdgeFacetsBuilder;
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::map<MeshEdge, MeshFacetPair, EdgeOrder> _map;
+    /// Edges grouped by their start point, each group sorted by the end point
+    std::vector<unsigned long> _offsets;
+    std::vector<EdgeFacets> _edges;
 };
 
 /**
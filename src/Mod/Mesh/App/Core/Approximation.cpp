@@ -400,6 +400,119 @@ void PlaneFit::Dimension(float& length, float& width) const
 
 // -------------------------------------------------------------------------------
 
+IncrementalPlaneFit::IncrementalPlaneFit()
+  : _ulPoints(0), _bIsFitted(false)
+{
+    Clear();
+}
+
+IncrementalPlaneFit::~IncrementalPlaneFit()
+{
+}
+
+void IncrementalPlaneFit::AddPoint(const Base::Vector3f &rcVector)
+{
+    if (_ulPoints == 0)
+        _vOrigin = rcVector;
+    // relative coordinates keep the moments small and avoid cancellation
+    double x = rcVector.x - _vOrigin.x;
+    double y = rcVector.y - _vOrigin.y;
+    double z = rcVector.z - _vOrigin.z;
+    _sx += x; _sy += y; _sz += z;
+    _sxx += x * x; _sxy += x * y; _sxz += x * z;
+    _syy += y * y; _syz += y * z; _szz += z * z;
+    _ulPoints++;
+    _bIsFitted = false;
+}
+
+unsigned long IncrementalPlaneFit::CountPoints() const
+{
+    return _ulPoints;
+}
+
+void IncrementalPlaneFit::Clear()
+{
+    _sx = _sy = _sz = 0.0;
+    _sxx = _sxy = _sxz = _syy = _syz = _szz = 0.0;
+    _ulPoints = 0;
+    _bIsFitted = false;
+}
+
+bool IncrementalPlaneFit::Done() const
+{
+    return _bIsFitted;
+}
+
+float IncrementalPlaneFit::Fit()
+{
+    _bIsFitted = true;
+    if (_ulPoints < 3)
+        return FLOAT_MAX;
+
+    double n = (double)_ulPoints;
+    double mx = _sx / n, my = _sy / n, mz = _sz / n;
+    double sxx = _sxx - _sx * mx;
+    double sxy = _sxy - _sx * my;
+    double sxz = _sxz - _sx * mz;
+    double syy = _syy - _sy * my;
+    double syz = _syz - _sy * mz;
+    double szz = _szz - _sz * mz;
+
+    // Covariance matrix, same as in PlaneFit::Fit()
+    Wm4::Matrix3<double> akMat(sxx,sxy,sxz,sxy,syy,syz,sxz,syz,szz);
+    Wm4::Matrix3<double> rkRot, rkDiag;
+    try {
+        akMat.EigenDecomposition(rkRot, rkDiag);
+    }
+    catch (const std::exception&) {
+        return FLOAT_MAX;
+    }
+
+    // points describe a line or even are identical
+    if (rkDiag(1,1) <= 0)
+        return FLOAT_MAX;
+
+    Wm4::Vector3<double> W = rkRot.GetColumn(0);
+    for (int i=0; i<3; i++) {
+        if (boost::math::isnan(W[i]))
+            return FLOAT_MAX;
+    }
+
+    _vDirW.Set((float)W.X(), (float)W.Y(), (float)W.Z());
+    _vBase.Set((float)(_vOrigin.x + mx), (float)(_vOrigin.y + my), (float)(_vOrigin.z + mz));
+
+    double sigma = std::max<double>(W.Dot(akMat * W), 0.0);
+    if (_ulPoints > 3)
+        return (float)sqrt(sigma / (n - 3));
+    return 0.0f;
+}
+
+Base::Vector3f IncrementalPlaneFit::GetBase() const
+{
+    if (_bIsFitted)
+        return _vBase;
+    else
+        return Base::Vector3f();
+}
+
+Base::Vector3f IncrementalPlaneFit::GetNormal() const
+{
+    if (_bIsFitted)
+        return _vDirW;
+    else
+        return Base::Vector3f();
+}
+
+float IncrementalPlaneFit::GetDistanceToPlane(const Base::Vector3f &rcPoint) const
+{
+    float fResult = FLOAT_MAX;
+    if (_bIsFitted)
+        fResult = (rcPoint - _vBase) * _vDirW;
+    return fResult;
+}
+
+// -------------------------------------------------------------------------------
+
 bool QuadraticFit::GetCurvatureInfo(double x, double y, double z,
                                     double &rfCurv0, double &rfCurv1,
                                     Base::Vector3f &rkDir0, Base::Vector3f &rkDir1, double &dDistance)
@@ -239,6 +239,48 @@ protected:
 
 // -------------------------------------------------------------------------------
 
+/**
+ * Approximation of a plane into a growing set of points. Unlike PlaneFit the points
+ * are not kept, only their running moments. So adding a point and refitting the plane
+ * take constant time, independent of the number of points added so far.
+ */
+class MeshExport IncrementalPlaneFit
+{
+public:
+    IncrementalPlaneFit();
+    ~IncrementalPlaneFit();
+    void AddPoint(const Base::Vector3f &rcVector);
+    unsigned long CountPoints() const;
+    void Clear();
+    /**
+     * Determines whether Fit() has been called since the last point was added.
+     */
+    bool Done() const;
+    /**
+     * Fit a plane into the points added so far. If the points are (nearly) collinear
+     * the previous plane is kept and FLOAT_MAX is returned.
+     */
+    float Fit();
+    Base::Vector3f GetBase() const;
+    Base::Vector3f GetNormal() const;
+    /**
+     * Returns the distance from the point \a rcPoint to the fitted plane. If Fit() has not
+     * been called FLOAT_MAX is returned.
+     */
+    float GetDistanceToPlane(const Base::Vector3f &rcPoint) const;
+
+private:
+    Base::Vector3f _vOrigin; /**< First point, the moments are taken relative to it. */
+    double _sx, _sy, _sz;
+    double _sxx, _sxy, _sxz, _syy, _syz, _szz;
+    unsigned long _ulPoints;
+    bool _bIsFitted;
+    Base::Vector3f _vBase;
+    Base::Vector3f _vDirW;
+};
+
+// -------------------------------------------------------------------------------
+
 /**
  * Approximation of a quadratic surface into a given set of points. The implicit form of the surface
  * is defined by F(x,y,z) = a * x^2 + b * y^2 + c * z^2 + 
@@ -0,0 +1,596 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <climits>
+# include <cmath>
+#endif
+
+#include "FacetTree.h"
+#include "MeshKernel.h"
+
+#include <Base/Sequencer.h>
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
+using namespace MeshCore;
+
+// Max. number of facets of a leaf node
+#define MESH_FACETTREE_LEAF 4
+
+namespace {
+
+struct CenterOrder
+{
+    CenterOrder(const std::vector<Base::Vector3f>& centers, unsigned short axis)
+      : centers(centers), axis(axis)
+    {
+    }
+    bool operator () (unsigned long f1, unsigned long f2) const
+    {
+        return centers[f1][axis] < centers[f2][axis];
+    }
+
+    const std::vector<Base::Vector3f>& centers;
+    unsigned short axis;
+};
+
+inline float BoxDistanceP2(const Base::BoundBox3f& box, const Base::Vector3f& pt)
+{
+    float dx = std::max<float>(std::max<float>(box.MinX - pt.x, pt.x - box.MaxX), 0.0f);
+    float dy = std::max<float>(std::max<float>(box.MinY - pt.y, pt.y - box.MaxY), 0.0f);
+    float dz = std::max<float>(std::max<float>(box.MinZ - pt.z, pt.z - box.MaxZ), 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * Checks if the triangle \a u lies completely on one side of the plane of the
+ * triangle \a v. This is the first step of Moeller's triangle test in tritritest.h
+ * with the same arithmetic, so it never rejects a pair that the full test accepts.
+ * Most pairs of facets with overlapping boxes are rejected here.
+ */
+inline bool PlaneSeparates(const Base::Vector3f v[3], const Base::Vector3f u[3])
+{
+    Base::Vector3f e1 = v[1] - v[0];
+    Base::Vector3f e2 = v[2] - v[0];
+    float n[3] = {e1.y * e2.z - e1.z * e2.y,
+                  e1.z * e2.x - e1.x * e2.z,
+                  e1.x * e2.y - e1.y * e2.x};
+    float d = -(n[0] * v[0].x + n[1] * v[0].y + n[2] * v[0].z);
+    float du[3];
+    for (int i = 0; i < 3; i++) {
+        du[i] = (n[0] * u[i].x + n[1] * u[i].y + n[2] * u[i].z) + d;
+        if (fabs(du[i]) < 0.000001)
+            du[i] = 0.0f;
+    }
+    return du[0] * du[1] > 0.0f && du[0] * du[2] > 0.0f;
+}
+
+}
+
+/**
+ * Returns the squared distance of \a rclPt to the triangle. The closest point is
+ * found by checking the Voronoi regions of the corners and edges first, see
+ * C. Ericson, Real-Time Collision Detection, 5.1.5.
+ */
+float MeshFacetTree::Triangle::DistanceP2 (const Base::Vector3f &rclPt) const
+{
+    Base::Vector3f e1 = p1 - p0;
+    Base::Vector3f e2 = p2 - p0;
+    Base::Vector3f ap = rclPt - p0;
+    float d1 = e1 * ap;
+    float d2 = e2 * ap;
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return ap.Sqr(); // corner p0
+
+    Base::Vector3f bp = ap - e1;
+    float d3 = e1 * bp;
+    float d4 = e2 * bp;
+    if (d3 >= 0.0f && d4 <= d3)
+        return bp.Sqr(); // corner p1
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return (ap - e1 * (d1 / (d1 - d3))).Sqr(); // edge p0-p1
+
+    Base::Vector3f cp = ap - e2;
+    float d5 = e1 * cp;
+    float d6 = e2 * cp;
+    if (d6 >= 0.0f && d5 <= d6)
+        return cp.Sqr(); // corner p2
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return (ap - e2 * (d2 / (d2 - d6))).Sqr(); // edge p0-p2
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return (bp - (e2 - e1) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))).Sqr(); // edge p1-p2
+
+    float sum = va + vb + vc;
+    if (sum <= 0.0f) // degenerated triangle
+        return std::min<float>(ap.Sqr(), std::min<float>(bp.Sqr(), cp.Sqr()));
+    return (ap - e1 * (vb / sum) - e2 * (vc / sum)).Sqr(); // inside
+}
+
+// ----------------------------------------------------
+
+MeshFacetTree::MeshFacetTree (const MeshKernel &rclM) : _rclMesh(rclM)
+{
+    Rebuild();
+}
+
+MeshFacetTree::MeshFacetTree (const MeshKernel &rclM, const Base::Matrix4D &rclMat) : _rclMesh(rclM)
+{
+    Rebuild(rclMat);
+}
+
+MeshFacetTree::~MeshFacetTree (void)
+{
+}
+
+void MeshFacetTree::Rebuild (const Base::Matrix4D &rclMat)
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    unsigned long ulCtFacets = rFacets.size();
+
+    std::vector<Base::Vector3f> aclPoints;
+    aclPoints.reserve(rPoints.size());
+    for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it)
+        aclPoints.push_back(rclMat * (*it));
+
+    std::vector<Triangle> aclTriangles(ulCtFacets);
+    std::vector<Base::Vector3f> aclCenters(ulCtFacets);
+    for (unsigned long i = 0; i < ulCtFacets; i++) {
+        const Base::Vector3f& p0 = aclPoints[rFacets[i]._aulPoints[0]];
+        const Base::Vector3f& p1 = aclPoints[rFacets[i]._aulPoints[1]];
+        const Base::Vector3f& p2 = aclPoints[rFacets[i]._aulPoints[2]];
+        aclTriangles[i].p0 = p0;
+        aclTriangles[i].p1 = p1;
+        aclTriangles[i].p2 = p2;
+        aclCenters[i] = (p0 + p1 + p2) / 3.0f;
+    }
+
+    _aulFacets.resize(ulCtFacets);
+    for (unsigned long i = 0; i < ulCtFacets; i++)
+        _aulFacets[i] = i;
+
+    // the tree is built on the facet indices, the triangles are needed for the leaf boxes
+    _aclTriangles.swap(aclTriangles);
+    _aclNodes.clear();
+    if (ulCtFacets > 0) {
+        _aclNodes.reserve(2 * (ulCtFacets / MESH_FACETTREE_LEAF) + 1);
+        _aclNodes.push_back(Node());
+        Build(0, 0, ulCtFacets, aclCenters);
+    }
+
+    // store the triangles in tree order, so a leaf reads one block of memory
+    aclTriangles.resize(ulCtFacets);
+    _aulPositions.resize(ulCtFacets);
+    for (unsigned long i = 0; i < ulCtFacets; i++) {
+        aclTriangles[i] = _aclTriangles[_aulFacets[i]];
+        _aulPositions[_aulFacets[i]] = i;
+    }
+    _aclTriangles.swap(aclTriangles);
+}
+
+void MeshFacetTree::Build (unsigned long ulNode, unsigned long ulBegin, unsigned long ulEnd,
+                           const std::vector<Base::Vector3f> &raclCenters)
+{
+    if (ulEnd - ulBegin <= MESH_FACETTREE_LEAF) {
+        Node& rclLeaf = _aclNodes[ulNode];
+        rclLeaf.first = ulBegin;
+        rclLeaf.count = ulEnd - ulBegin;
+        rclLeaf.box = Base::BoundBox3f();
+        for (unsigned long i = ulBegin; i < ulEnd; i++) {
+            const Triangle& t = _aclTriangles[_aulFacets[i]];
+            rclLeaf.box.Add(t.p0);
+            rclLeaf.box.Add(t.p1);
+            rclLeaf.box.Add(t.p2);
+        }
+        return;
+    }
+
+    // split at the median of the facet centers along the longest axis
+    Base::BoundBox3f clBox;
+    for (unsigned long i = ulBegin; i < ulEnd; i++)
+        clBox.Add(raclCenters[_aulFacets[i]]);
+    unsigned short usAxis = 0;
+    if (clBox.LengthY() > clBox.LengthX())
+        usAxis = 1;
+    if (clBox.LengthZ() > std::max<float>(clBox.LengthX(), clBox.LengthY()))
+        usAxis = 2;
+
+    unsigned long ulMid = ulBegin + (ulEnd - ulBegin) / 2;
+    std::nth_element(_aulFacets.begin() + ulBegin, _aulFacets.begin() + ulMid,
+                     _aulFacets.begin() + ulEnd, CenterOrder(raclCenters, usAxis));
+
+    unsigned long ulLeft = _aclNodes.size();
+    _aclNodes.push_back(Node());
+    Build(ulLeft, ulBegin, ulMid, raclCenters);
+    unsigned long ulRight = _aclNodes.size();
+    _aclNodes.push_back(Node());
+    Build(ulRight, ulMid, ulEnd, raclCenters);
+
+    Node& rclNode = _aclNodes[ulNode];
+    rclNode.first = ulRight;
+    rclNode.count = 0;
+    rclNode.box = _aclNodes[ulLeft].box;
+    rclNode.box.Add(_aclNodes[ulRight].box);
+}
+
+MeshGeomFacet MeshFacetTree::GetFacet (unsigned long ulFacet) const
+{
+    const Triangle& t = _aclTriangles[_aulPositions[ulFacet]];
+    return MeshGeomFacet(t.p0, t.p1, t.p2);
+}
+
+Base::BoundBox3f MeshFacetTree::GetBoundBox (void) const
+{
+    if (_aclNodes.empty())
+        return Base::BoundBox3f();
+    return _aclNodes.front().box;
+}
+
+bool MeshFacetTree::NearestFacet (const Base::Vector3f &rclPt, float fMaxDist,
+                                  unsigned long &rulFacet, float &rfDist) const
+{
+    if (_aclNodes.empty())
+        return false;
+
+    // the depth of the tree is limited by the median split
+    unsigned long aulStack[128];
+    int iTop = 0;
+    aulStack[iTop++] = 0;
+
+    float fMinDist2 = fMaxDist * fMaxDist;
+    unsigned long ulNearest = ULONG_MAX;
+    while (iTop > 0) {
+        unsigned long ulNode = aulStack[--iTop];
+        const Node& rclNode = _aclNodes[ulNode];
+        if (BoxDistanceP2(rclNode.box, rclPt) > fMinDist2)
+            continue;
+
+        if (rclNode.count > 0) {
+            for (unsigned long i = rclNode.first; i < rclNode.first + rclNode.count; i++) {
+                float fDist2 = _aclTriangles[i].DistanceP2(rclPt);
+                if (fDist2 < fMinDist2 || (fDist2 == fMinDist2 && _aulFacets[i] < ulNearest)) {
+                    fMinDist2 = fDist2;
+                    ulNearest = _aulFacets[i];
+                }
+            }
+        }
+        else {
+            // visit the nearer child first
+            unsigned long ulLeft = ulNode + 1;
+            unsigned long ulRight = rclNode.first;
+            if (BoxDistanceP2(_aclNodes[ulLeft].box, rclPt) < BoxDistanceP2(_aclNodes[ulRight].box, rclPt)) {
+                aulStack[iTop++] = ulRight;
+                aulStack[iTop++] = ulLeft;
+            }
+            else {
+                aulStack[iTop++] = ulLeft;
+                aulStack[iTop++] = ulRight;
+            }
+        }
+    }
+
+    if (ulNearest == ULONG_MAX)
+        return false;
+    rulFacet = ulNearest;
+    rfDist = (float)sqrt(fMinDist2);
+    return true;
+}
+
+void MeshFacetTree::SearchFacets (const Base::Vector3f &rclPt, float fMaxDist,
+                                  std::vector<unsigned long> &raulFacets) const
+{
+    raulFacets.clear();
+    if (_aclNodes.empty())
+        return;
+
+    unsigned long aulStack[128];
+    int iTop = 0;
+    aulStack[iTop++] = 0;
+
+    float fMaxDist2 = fMaxDist * fMaxDist;
+    while (iTop > 0) {
+        unsigned long ulNode = aulStack[--iTop];
+        const Node& rclNode = _aclNodes[ulNode];
+        if (BoxDistanceP2(rclNode.box, rclPt) > fMaxDist2)
+            continue;
+
+        if (rclNode.count > 0) {
+            for (unsigned long i = rclNode.first; i < rclNode.first + rclNode.count; i++) {
+                if (_aclTriangles[i].DistanceP2(rclPt) <= fMaxDist2)
+                    raulFacets.push_back(_aulFacets[i]);
+            }
+        }
+        else {
+            aulStack[iTop++] = rclNode.first;
+            aulStack[iTop++] = ulNode + 1;
+        }
+    }
+
+    std::sort(raulFacets.begin(), raulFacets.end());
+}
+
+// ----------------------------------------------------
+
+struct MeshFacetTree::IntersectionState
+{
+    QAtomicInt found;
+    QAtomicInt abort;
+    QMutex mutex;
+    QWaitCondition taskDone;
+    unsigned long done;
+};
+
+struct MeshFacetTree::IntersectionTask
+{
+    const MeshFacetTree* tree;
+    unsigned long node1, node2;
+    bool self;
+    bool firstOnly;
+    IntersectionState* state;
+    std::vector<std::pair<unsigned long, unsigned long> > pairs;
+};
+
+void MeshFacetTree::SearchSelfIntersections (std::vector<std::pair<unsigned long, unsigned long> > &raulPairs,
+                                             bool bFirstOnly) const
+{
+    Intersections(*this, true, bFirstOnly, raulPairs);
+}
+
+void MeshFacetTree::SearchIntersections (const MeshFacetTree &rclTree,
+                                         std::vector<std::pair<unsigned long, unsigned long> > &raulPairs,
+                                         bool bFirstOnly) const
+{
+    Intersections(rclTree, false, bFirstOnly, raulPairs);
+}
+
+void MeshFacetTree::Intersections (const MeshFacetTree &rclTree, bool bSelf, bool bFirstOnly,
+                                   std::vector<std::pair<unsigned long, unsigned long> > &raulPairs) const
+{
+    raulPairs.clear();
+    if (_aclNodes.empty() || rclTree._aclNodes.empty())
+        return;
+
+    IntersectionState state;
+    state.found = 0;
+    state.abort = 0;
+    state.done = 0;
+    IntersectionTask root;
+    root.tree = &rclTree;
+    root.node1 = 0;
+    root.node2 = 0;
+    root.self = bSelf;
+    root.firstOnly = bFirstOnly;
+    root.state = &state;
+
+    // Descend both trees until there are enough independent node pairs to keep
+    // all threads busy. For small meshes the thread overhead doesn't pay off.
+    std::vector<IntersectionTask> aclTasks(1, root);
+    unsigned long ulMaxTasks = 1;
+    if (CountFacets() + rclTree.CountFacets() >= 10000)
+        ulMaxTasks = 16 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+    std::vector<std::pair<unsigned long, unsigned long> > aulNodes;
+    while (aclTasks.size() < ulMaxTasks) {
+        bool bSplit = false;
+        std::vector<IntersectionTask> aclSplit;
+        for (std::vector<IntersectionTask>::iterator it = aclTasks.begin(); it != aclTasks.end(); ++it) {
+            aulNodes.clear();
+            if (SplitNodes(rclTree, it->node1, it->node2, aulNodes)) {
+                bSplit = true;
+                for (std::vector<std::pair<unsigned long, unsigned long> >::iterator jt = aulNodes.begin(); jt != aulNodes.end(); ++jt) {
+                    aclSplit.push_back(root);
+                    aclSplit.back().node1 = jt->first;
+                    aclSplit.back().node2 = jt->second;
+                }
+            }
+            else {
+                aclSplit.push_back(*it);
+            }
+        }
+        aclTasks.swap(aclSplit);
+        if (!bSplit)
+            break;
+    }
+
+    // The sequencer must only be used by this thread, so it waits for the tasks
+    // and advances once per finished task. A complete search can be aborted.
+    Base::SequencerLauncher seq(bSelf ? "Checking for self-intersections..."
+                                      : "Checking for intersections...", aclTasks.size());
+    if (aclTasks.size() > 1) {
+        QFuture<void> future = QtConcurrent::map(aclTasks, boost::bind(&MeshFacetTree::RunTask, this, _1));
+        unsigned long ulDone = 0;
+        try {
+            while (ulDone < aclTasks.size()) {
+                state.mutex.lock();
+                while (state.done == ulDone)
+                    state.taskDone.wait(&state.mutex);
+                unsigned long ulFinished = state.done;
+                state.mutex.unlock();
+                for (; ulDone < ulFinished; ulDone++)
+                    seq.next(!bFirstOnly);
+            }
+        }
+        catch (...) {
+            // let the running tasks stop early and drop the pending ones
+            state.abort = 1;
+            future.cancel();
+            future.waitForFinished();
+            throw;
+        }
+    }
+    else if (!aclTasks.empty()) {
+        RunTask(aclTasks.front());
+        seq.next(!bFirstOnly);
+    }
+
+    for (std::vector<IntersectionTask>::iterator it = aclTasks.begin(); it != aclTasks.end(); ++it)
+        raulPairs.insert(raulPairs.end(), it->pairs.begin(), it->pairs.end());
+    std::sort(raulPairs.begin(), raulPairs.end());
+    if (bFirstOnly && raulPairs.size() > 1)
+        raulPairs.resize(1);
+}
+
+/**
+ * Adds the child pairs of the node \a ulNode1 of this tree and the node \a ulNode2
+ * of \a rclTree whose boxes overlap. A node paired with itself stands for the test
+ * of its facets against each other. Returns false if both nodes are leaves, i.e.
+ * their facets must be tested.
+ */
+bool MeshFacetTree::SplitNodes (const MeshFacetTree &rclTree, unsigned long ulNode1, unsigned long ulNode2,
+                                std::vector<std::pair<unsigned long, unsigned long> > &raulNodes) const
+{
+    const Node& rclNode1 = _aclNodes[ulNode1];
+    const Node& rclNode2 = rclTree._aclNodes[ulNode2];
+    if (&rclTree == this && ulNode1 == ulNode2) {
+        if (rclNode1.count > 0)
+            return false;
+        unsigned long ulLeft = ulNode1 + 1;
+        unsigned long ulRight = rclNode1.first;
+        raulNodes.push_back(std::make_pair(ulLeft, ulLeft));
+        raulNodes.push_back(std::make_pair(ulRight, ulRight));
+        if (_aclNodes[ulLeft].box && _aclNodes[ulRight].box)
+            raulNodes.push_back(std::make_pair(ulLeft, ulRight));
+        return true;
+    }
+
+    if (!(rclNode1.box && rclNode2.box))
+        return true;
+    if (rclNode1.count > 0 && rclNode2.count > 0)
+        return false;
+
+    // split the node with the bigger box
+    if (rclNode2.count > 0 || (rclNode1.count == 0 &&
+        rclNode1.box.CalcDiagonalLength() >= rclNode2.box.CalcDiagonalLength())) {
+        raulNodes.push_back(std::make_pair(ulNode1 + 1, ulNode2));
+        raulNodes.push_back(std::make_pair(rclNode1.first, ulNode2));
+    }
+    else {
+        raulNodes.push_back(std::make_pair(ulNode1, ulNode2 + 1));
+        raulNodes.push_back(std::make_pair(ulNode1, rclNode2.first));
+    }
+    return true;
+}
+
+void MeshFacetTree::RunTask (IntersectionTask &rclTask) const
+{
+    Descend(rclTask);
+
+    IntersectionState& rclState = *rclTask.state;
+    rclState.mutex.lock();
+    rclState.done++;
+    rclState.taskDone.wakeAll();
+    rclState.mutex.unlock();
+}
+
+void MeshFacetTree::Descend (IntersectionTask &rclTask) const
+{
+    const IntersectionState& rclState = *rclTask.state;
+    std::vector<std::pair<unsigned long, unsigned long> > aulStack;
+    aulStack.push_back(std::make_pair(rclTask.node1, rclTask.node2));
+    while (!aulStack.empty()) {
+        if (int(rclState.abort) > 0)
+            return;
+        if (rclTask.firstOnly && int(rclState.found) > 0)
+            return;
+        std::pair<unsigned long, unsigned long> nodes = aulStack.back();
+        aulStack.pop_back();
+        if (!SplitNodes(*rclTask.tree, nodes.first, nodes.second, aulStack))
+            TestLeaves(rclTask, nodes.first, nodes.second);
+    }
+}
+
+void MeshFacetTree::TestLeaves (IntersectionTask &rclTask, unsigned long ulNode1, unsigned long ulNode2) const
+{
+    const MeshFacetTree& rclTree = *rclTask.tree;
+    const Node& rclNode1 = _aclNodes[ulNode1];
+    const Node& rclNode2 = rclTree._aclNodes[ulNode2];
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    bool bSameNode = (&rclTree == this && ulNode1 == ulNode2);
+
+    Base::Vector3f clPt1, clPt2;
+    Base::Vector3f v[3], u[3];
+    for (unsigned long i = rclNode1.first; i < rclNode1.first + rclNode1.count; i++) {
+        const Triangle& t1 = _aclTriangles[i];
+        v[0] = t1.p0;
+        v[1] = t1.p1;
+        v[2] = t1.p2;
+        Base::BoundBox3f clBox1(v, 3);
+        unsigned long ulFacet1 = _aulFacets[i];
+
+        unsigned long j = bSameNode ? i + 1 : rclNode2.first;
+        for (; j < rclNode2.first + rclNode2.count; j++) {
+            const Triangle& t2 = rclTree._aclTriangles[j];
+            unsigned long ulFacet2 = rclTree._aulFacets[j];
+            if (rclTask.self) {
+                // facets sharing a corner point usually do not intersect but the test
+                // below would report false-positives
+                const MeshFacet& rFace1 = rFacets[ulFacet1];
+                const MeshFacet& rFace2 = rFacets[ulFacet2];
+                bool bCommon = false;
+                for (int k = 0; k < 3 && !bCommon; k++) {
+                    bCommon = (rFace1._aulPoints[k] == rFace2._aulPoints[0] ||
+                               rFace1._aulPoints[k] == rFace2._aulPoints[1] ||
+                               rFace1._aulPoints[k] == rFace2._aulPoints[2]);
+                }
+                if (bCommon)
+                    continue;
+            }
+
+            u[0] = t2.p0;
+            u[1] = t2.p1;
+            u[2] = t2.p2;
+            if (!(clBox1 && Base::BoundBox3f(u, 3)))
+                continue;
+            if (PlaneSeparates(v, u) || PlaneSeparates(u, v))
+                continue;
+
+            MeshGeomFacet clFacet1(v[0], v[1], v[2]);
+            MeshGeomFacet clFacet2(u[0], u[1], u[2]);
+            if (clFacet1.IntersectWithFacet(clFacet2, clPt1, clPt2) == 2) {
+                if (rclTask.self && ulFacet2 < ulFacet1)
+                    rclTask.pairs.push_back(std::make_pair(ulFacet2, ulFacet1));
+                else
+                    rclTask.pairs.push_back(std::make_pair(ulFacet1, ulFacet2));
+                if (rclTask.firstOnly) {
+                    rclTask.state->found.fetchAndAddRelaxed(1);
+                    return;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_FACETTREE_H
+#define MESH_FACETTREE_H
+
+#include <vector>
+
+#include "Elements.h"
+#include <Base/BoundBox.h>
+#include <Base/Matrix.h>
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshFacetTree is a bounding volume hierarchy over the facets of a mesh.
+ * Unlike the MeshFacetGrid its search time does not depend on how the facets are
+ * distributed, so it suits meshes with very different facet sizes and points far
+ * away from the mesh.
+ * The facets are copied into the tree in tree order (optionally transformed) so
+ * that a query doesn't touch the mesh kernel. All queries are const and can be
+ * run from several threads at a time.
+ * \note If the underlying mesh kernel gets changed this structure becomes invalid
+ * and must be rebuilt.
+ */
+class MeshExport MeshFacetTree
+{
+public:
+    /// Construction
+    MeshFacetTree (const MeshKernel &rclM);
+    /// Construction with facets transformed by \a rclMat
+    MeshFacetTree (const MeshKernel &rclM, const Base::Matrix4D &rclMat);
+    /// Destruction
+    ~MeshFacetTree (void);
+
+    /// Rebuilds up the tree.
+    void Rebuild (const Base::Matrix4D &rclMat = Base::Matrix4D());
+    /// Returns the number of facets in the tree.
+    unsigned long CountFacets (void) const
+    { return (unsigned long)_aulFacets.size(); }
+    /// Returns the (transformed) geometric facet with index \a ulFacet of the mesh kernel.
+    MeshGeomFacet GetFacet (unsigned long ulFacet) const;
+    /// Returns the bounding box of all (transformed) facets.
+    Base::BoundBox3f GetBoundBox (void) const;
+
+    /**
+     * Searches for the facet nearest to \a rclPt with a distance less than or equal
+     * to \a fMaxDist. Returns false if there is no such facet, otherwise the index
+     * of the facet is returned in \a rulFacet and its distance in \a rfDist. If two
+     * facets have the same distance the one with the lower index is taken.
+     */
+    bool NearestFacet (const Base::Vector3f &rclPt, float fMaxDist,
+                       unsigned long &rulFacet, float &rfDist) const;
+    /**
+     * Returns the indices of all facets with a distance less than or equal to
+     * \a fMaxDist to \a rclPt. The indices are sorted.
+     */
+    void SearchFacets (const Base::Vector3f &rclPt, float fMaxDist,
+                       std::vector<unsigned long> &raulFacets) const;
+    /**
+     * Collects the pairs of facets of the mesh that intersect each other. Facets
+     * sharing a corner point are not tested. The pairs have the lower index first
+     * and are sorted. If \a bFirstOnly is true the search stops after the first
+     * intersection is found, otherwise the user may abort the search and a
+     * Base::AbortException is thrown.
+     */
+    void SearchSelfIntersections (std::vector<std::pair<unsigned long, unsigned long> > &raulPairs,
+                                  bool bFirstOnly = false) const;
+    /**
+     * Collects the pairs of intersecting facets of this mesh and the mesh of \a rclTree,
+     * e.g. to check two parts for collision. The first index of a pair refers to this
+     * mesh. The pairs are sorted. If \a bFirstOnly is true the search stops after the
+     * first intersection is found, otherwise the user may abort the search and a
+     * Base::AbortException is thrown.
+     */
+    void SearchIntersections (const MeshFacetTree &rclTree,
+                              std::vector<std::pair<unsigned long, unsigned long> > &raulPairs,
+                              bool bFirstOnly = false) const;
+
+protected:
+    /// A triangle given by its corner points
+    struct Triangle
+    {
+        Base::Vector3f p0, p1, p2;
+        float DistanceP2 (const Base::Vector3f &rclPt) const;
+    };
+    /// Inner nodes have no facets, their right child is stored in 'first', the
+    /// left child directly follows the node.
+    struct Node
+    {
+        Base::BoundBox3f box;
+        unsigned long first, count;
+    };
+
+    /// A pair of nodes of this and another tree whose facets are tested against each other.
+    struct IntersectionTask;
+    /// The state all tasks of one search share.
+    struct IntersectionState;
+
+    void Build (unsigned long ulNode, unsigned long ulBegin, unsigned long ulEnd,
+                const std::vector<Base::Vector3f> &raclCenters);
+    void Intersections (const MeshFacetTree &rclTree, bool bSelf, bool bFirstOnly,
+                        std::vector<std::pair<unsigned long, unsigned long> > &raulPairs) const;
+    bool SplitNodes (const MeshFacetTree &rclTree, unsigned long ulNode1, unsigned long ulNode2,
+                     std::vector<std::pair<unsigned long, unsigned long> > &raulNodes) const;
+    void RunTask (IntersectionTask &rclTask) const;
+    void Descend (IntersectionTask &rclTask) const;
+    void TestLeaves (IntersectionTask &rclTask, unsigned long ulNode1, unsigned long ulNode2) const;
+
+protected:
+    const MeshKernel &_rclMesh; /**< The mesh kernel. */
+    std::vector<Node> _aclNodes;
+    std::vector<Triangle> _aclTriangles;  /**< The facets in tree order. */
+    std::vector<unsigned long> _aulFacets;  /**< Facet index of each tree position. */
+    std::vector<unsigned long> _aulPositions;  /**< Tree position of each facet. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_FACETTREE_H
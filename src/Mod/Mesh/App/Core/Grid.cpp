@@ -27,6 +27,11 @@
 # include <algorithm>
 #endif
 
+#include <QAtomicInt>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Grid.h"
 #include "Iterator.h"
 
@@ -62,7 +67,8 @@ void MeshGrid::Attach (const MeshKernel &rclM)
 
 void MeshGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulCellOffsets.clear();
+  _aulCellElements.clear();
   _pclMesh = NULL;  
 }
 
@@ -93,8 +99,6 @@ void MeshGrid::InitGrid (void)
 {
   assert(_pclMesh != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsX == 0) || (_ulCtGridsX == 0))
@@ -128,14 +132,9 @@ void MeshGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
-  {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
-  }
+  _aulCellElements.clear();
+  _aulCellOffsets.clear();
+  _aulCellOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
 }
 
 unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulElements,
@@ -155,7 +154,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(raulElements.end(), CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -190,7 +189,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).CalcCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          raulElements.insert(raulElements.end(), CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -221,7 +220,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::set<unsigned
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -451,7 +450,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(CellBegin(nX, i, j), CellEnd(nX, i, j));
           }
           nX++;
         }
@@ -465,7 +464,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(CellBegin(nX, i, j), CellEnd(nX, i, j));
           }
           nX++;
         }
@@ -479,7 +478,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(CellBegin(i, nY, j), CellEnd(i, nY, j));
           }
           nY++;
         }
@@ -493,7 +492,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(CellBegin(i, nY, j), CellEnd(i, nY, j));
           }
           nY--;
         }
@@ -507,7 +506,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(CellBegin(i, j, nZ), CellEnd(i, j, nZ));
           }
           nZ++;
         }
@@ -521,7 +520,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(CellBegin(i, j, nZ), CellEnd(i, j, nZ));
           }
           nZ--;
         }
@@ -587,11 +586,12 @@ void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ,
 unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
                                      std::set<unsigned long> &raclInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
+  const unsigned long* pBegin = CellBegin(ulX, ulY, ulZ);
+  const unsigned long* pEnd = CellEnd(ulX, ulY, ulZ);
+  if (pBegin != pEnd)
   {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
+    raclInd.insert(pBegin, pEnd);
+    return pEnd - pBegin;
   }
 
   return 0;
@@ -603,9 +603,7 @@ unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<
   if (!CheckPosition(rclPoint, ulX, ulY, ulZ))
     return 0;
 
-  aulFacets.resize(_aulGrid[ulX][ulY][ulZ].size());
-
-  std::copy(_aulGrid[ulX][ulY][ulZ].begin(), _aulGrid[ulX][ulY][ulZ].end(), aulFacets.begin());
+  aulFacets.assign(CellBegin(ulX, ulY, ulZ), CellEnd(ulX, ulY, ulZ));
   return aulFacets.size();
 }
 
@@ -613,7 +611,7 @@ unsigned long MeshGrid::GetIndexToPosition(unsigned long ulX, unsigned long ulY,
 {
   if ( !CheckPos(ulX, ulY, ulZ) )
     return ULONG_MAX;
-  return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX;
+  return CellIndex(ulX, ulY, ulZ);
 }
 
 bool MeshGrid::GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned long& ulY, unsigned long& ulZ) const
@@ -633,6 +631,119 @@ bool MeshGrid::GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned
   return true;
 }
 
+namespace MeshCore {
+
+/**
+ * The MeshGridBuilder class fills the compressed grid structure of a MeshGrid.
+ * In a first pass the number of elements per grid element is counted, then the
+ * offsets are computed and in a second pass the element indices are stored.
+ * Both passes work on independent ranges of elements which are handled in parallel
+ * for large meshes. Afterwards each grid element is sorted so that the result
+ * doesn't depend on the thread scheduling.
+ */
+class MeshGridBuilder
+{
+public:
+  typedef std::pair<unsigned long, unsigned long> Range;
+
+  MeshGridBuilder (MeshGrid &rclGrid)
+    : _rclGrid(rclGrid), _aclCounts(rclGrid._aulCellOffsets.size())
+  {
+  }
+
+  void Build (void)
+  {
+    std::vector<unsigned long>& raulOffsets = _rclGrid._aulCellOffsets;
+    std::vector<unsigned long>& raulElements = _rclGrid._aulCellElements;
+    unsigned long ulCtCells = raulOffsets.size() - 1;
+
+    std::vector<Range> aclElements = Split(_rclGrid._ulCtElements);
+    Run(aclElements, &MeshGridBuilder::CountCells);
+
+    raulOffsets[0] = 0;
+    for (unsigned long i = 0; i < ulCtCells; i++)
+    {
+      raulOffsets[i+1] = raulOffsets[i] + (unsigned long)int(_aclCounts[i]);
+      _aclCounts[i] = 0;
+    }
+
+    raulElements.resize(raulOffsets[ulCtCells]);
+    Run(aclElements, &MeshGridBuilder::FillCells);
+
+    std::vector<Range> aclCells = Split(ulCtCells);
+    Run(aclCells, &MeshGridBuilder::SortCells);
+  }
+
+private:
+  std::vector<Range> Split (unsigned long ulCount) const
+  {
+    // for small meshes the thread overhead doesn't pay off
+    unsigned long ulCtRanges = 1;
+    if (ulCount >= 100000)
+      ulCtRanges = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+
+    std::vector<Range> aclRanges;
+    unsigned long ulStep = (ulCount + ulCtRanges - 1) / ulCtRanges;
+    for (unsigned long i = 0; i < ulCount; i += ulStep)
+      aclRanges.push_back(Range(i, std::min<unsigned long>(i + ulStep, ulCount)));
+    return aclRanges;
+  }
+
+  void Run (std::vector<Range> &raclRanges, void (MeshGridBuilder::*pFunc)(const Range&))
+  {
+    if (raclRanges.size() > 1)
+      QtConcurrent::blockingMap(raclRanges, boost::bind(pFunc, this, _1));
+    else if (!raclRanges.empty())
+      (this->*pFunc)(raclRanges.front());
+  }
+
+  void CountCells (const Range &rclRange)
+  {
+    std::vector<unsigned long> aulCells;
+    for (unsigned long i = rclRange.first; i < rclRange.second; i++)
+    {
+      aulCells.clear();
+      _rclGrid.CollectCells(i, aulCells);
+      for (std::vector<unsigned long>::iterator it = aulCells.begin(); it != aulCells.end(); ++it)
+        _aclCounts[*it].fetchAndAddRelaxed(1);
+    }
+  }
+
+  void FillCells (const Range &rclRange)
+  {
+    const std::vector<unsigned long>& raulOffsets = _rclGrid._aulCellOffsets;
+    std::vector<unsigned long>& raulElements = _rclGrid._aulCellElements;
+    std::vector<unsigned long> aulCells;
+    for (unsigned long i = rclRange.first; i < rclRange.second; i++)
+    {
+      aulCells.clear();
+      _rclGrid.CollectCells(i, aulCells);
+      for (std::vector<unsigned long>::iterator it = aulCells.begin(); it != aulCells.end(); ++it)
+        raulElements[raulOffsets[*it] + (unsigned long)_aclCounts[*it].fetchAndAddRelaxed(1)] = i;
+    }
+  }
+
+  void SortCells (const Range &rclRange)
+  {
+    const std::vector<unsigned long>& raulOffsets = _rclGrid._aulCellOffsets;
+    std::vector<unsigned long>& raulElements = _rclGrid._aulCellElements;
+    for (unsigned long i = rclRange.first; i < rclRange.second; i++)
+      std::sort(raulElements.begin() + raulOffsets[i], raulElements.begin() + raulOffsets[i+1]);
+  }
+
+private:
+  MeshGrid& _rclGrid;
+  std::vector<QAtomicInt> _aclCounts;
+};
+
+} // namespace MeshCore
+
+void MeshGrid::FillGrid (void)
+{
+  MeshGridBuilder clBuilder(*this);
+  clBuilder.Build();
+}
+
 // ----------------------------------------------------------------
 
 MeshFacetGrid::MeshFacetGrid (const MeshKernel &rclM)
@@ -710,15 +821,19 @@ void MeshFacetGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
-  MeshFacetIterator clFIter(*_pclMesh);
-
-  unsigned long i = 0;
-  for (clFIter.Init(); clFIter.More(); clFIter.Next())
-  {
-//    AddFacet(*clFIter, i++, 2.0f);
-    AddFacet(*clFIter, i++);
-  }
+  FillGrid();
+}
 
+void MeshFacetGrid::CollectCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const
+{
+  // do not use MeshKernel::GetFacet() as we don't need the normal
+  const MeshFacet& rclFacet = _pclMesh->GetFacets()[ulIndex];
+  const MeshPointArray& rclPoints = _pclMesh->GetPoints();
+  MeshGeomFacet clFacet;
+  clFacet._aclPoints[0] = rclPoints[rclFacet._aulPoints[0]];
+  clFacet._aclPoints[1] = rclPoints[rclFacet._aulPoints[1]];
+  clFacet._aclPoints[2] = rclPoints[rclFacet._aulPoints[2]];
+  AddFacet(clFacet, raulCells);
 }
 
 unsigned long MeshFacetGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
@@ -919,8 +1034,8 @@ void MeshFacetGrid::SearchNearestFacetInGrid(unsigned long ulX, unsigned long ul
                                              const Base::Vector3f &rclPt, float &rfMinDist,
                                              unsigned long &rulFacetInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  for (std::set<unsigned long>::const_iterator pI = rclSet.begin(); pI != rclSet.end(); pI++)
+  const unsigned long* pEnd = CellEnd(ulX, ulY, ulZ);
+  for (const unsigned long* pI = CellBegin(ulX, ulY, ulZ); pI != pEnd; pI++)
   {
     float fDist = _pclMesh->GetFacet(*pI).DistanceToPoint(rclPt);
     if (fDist < rfMinDist)
@@ -965,12 +1080,12 @@ MeshPointGrid::MeshPointGrid (const MeshKernel &rclM, float fGridLen)
           std::max<unsigned long>((unsigned long)(clBBMesh.LengthZ() / fGridLen), 1));
 }
 
-void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, float fEpsilon)
+void MeshPointGrid::CollectCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const
 {
   unsigned long ulX, ulY, ulZ;
-  Pos(Base::Vector3f(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
+  Pos(_pclMesh->GetPoints()[ulIndex], ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    raulCells.push_back(CellIndex(ulX, ulY, ulZ));
 }
 
 void MeshPointGrid::Validate (const MeshKernel &rclMesh)
@@ -1021,14 +1136,7 @@ void MeshPointGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
-
-  MeshPointIterator cPIter(*_pclMesh);
-
-  unsigned long i = 0;
-  for (cPIter.Init(); cPIter.More(); cPIter.Next())
-  {
-    AddPoint(*cPIter, i++);
-  }
+  FillGrid();
 }
 
 void MeshPointGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -1090,7 +1198,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ));
     _bValidRay = true;
   }
   else
@@ -1103,7 +1211,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ));
       _bValidRay = true;
     }
   }
@@ -1154,7 +1262,7 @@ bool MeshGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ)); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
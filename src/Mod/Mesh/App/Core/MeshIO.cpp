@@ -39,11 +39,21 @@
 #include <Base/Placement.h>
 #include <zipios++/gzipoutputstream.h>
 
+#include <algorithm>
 #include <cmath>
+#include <climits>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <QtConcurrentMap>
 
 
 using namespace MeshCore;
@@ -107,6 +117,26 @@ int numDigits(int number)
     return digits;
 }
 
+// Checks the header of a binary STL file in memory, see also MeshInput::LoadSTL()
+static bool isBinarySTL(const char* data, std::size_t size)
+{
+    if (size < 84)
+        return false;
+    uint32_t ulCt;
+    std::memcpy(&ulCt, data + 80, sizeof(ulCt));
+    if (ulCt > (size - 84) / 50)
+        return false;
+
+    char szBuf[101];
+    std::size_t ulBytes = std::min<std::size_t>(ulCt > 1 ? 100 : 50, size - 84);
+    std::memcpy(szBuf, data + 84, ulBytes);
+    szBuf[ulBytes] = 0;
+    upper(szBuf);
+
+    return ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
+            (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL));
+}
+
 /* Usage by CMeshNastran, CMeshCadmouldFE. Added by Sergey Sukhov (26.04.2002)*/
 struct NODE {float x, y, z;};
 struct TRIA {int iV[3];};
@@ -133,7 +163,15 @@ bool MeshInput::LoadAny(const char* FileName)
         // read file
         bool ok = false;
         if (fi.hasExtension("stl") || fi.hasExtension("ast")) {
-            ok = LoadSTL(str);
+            // a binary STL file is read directly from the mapped file
+            QFile file(QString::fromUtf8(FileName));
+            uchar* data = 0;
+            if (file.open(QIODevice::ReadOnly) && file.size() > 0)
+                data = file.map(0, file.size());
+            if (data && isBinarySTL(reinterpret_cast<const char*>(data), file.size()))
+                ok = LoadBinarySTL(reinterpret_cast<const char*>(data), file.size());
+            else
+                ok = LoadSTL(str);
         }
         else if (fi.hasExtension("iv")) {
             ok = LoadInventor( str );
@@ -910,6 +948,338 @@ bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
     return true;
 }
 
+namespace MeshCore {
+
+/**
+ * The BinarySTLReader reads the facets of a binary STL file from memory.
+ * The corners of the facets are distributed to buckets by the hash of the
+ * block of cells they lie in, so that the points can be welded per bucket in
+ * parallel. As with MeshBuilder a corner becomes the same point as the
+ * earliest point whose coordinates differ by less than
+ * MeshDefinitions::_fMinPointDistanceD1. The cells are twice as wide as this
+ * tolerance. So, the points of a cell are compared with each other when they
+ * are welded, and only a point close to a face of its cell needs to be
+ * compared with the points of the neighbour cells afterwards. The points get
+ * their index in the order of their first occurrence in the file as with
+ * MeshBuilder.
+ */
+class BinarySTLReader
+{
+public:
+    BinarySTLReader(const char* data, uint32_t count)
+      : _data(data), _count(count)
+    {
+        _tol = MeshDefinitions::_fMinPointDistanceD1;
+        _cell = 2.0 * _tol;
+    }
+
+    void Read(MeshPointArray& rPoints, MeshFacetArray& rFacets);
+
+private:
+    struct Key
+    {
+        double x, y, z;
+        bool operator == (const Key& k) const
+        { return x == k.x && y == k.y && z == k.z; }
+    };
+    struct KeyHash
+    {
+        // the coordinates are integral, hashing their bits is much faster
+        // than boost::hash<double>, adding zero turns -0 into +0
+        static uint64_t Bits(double v)
+        {
+            uint64_t b;
+            v += 0.0;
+            std::memcpy(&b, &v, sizeof(b));
+            return b;
+        }
+        std::size_t operator () (const Key& k) const
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, Bits(k.x));
+            boost::hash_combine(seed, Bits(k.y));
+            boost::hash_combine(seed, Bits(k.z));
+            return seed;
+        }
+    };
+    typedef boost::unordered_multimap<Key, uint32_t, KeyHash> KeyMap;
+    typedef std::pair<KeyMap::const_iterator, KeyMap::const_iterator> KeyRange;
+
+    static const std::size_t NumBuckets = 256;
+    static const int BlockSize = 64; // cells per block and direction
+
+    const char* FacetData(uint32_t f) const
+    { return _data + 84 + 50 * static_cast<std::size_t>(f); }
+    Base::Vector3f Corner(uint32_t c) const
+    {
+        float v[3];
+        std::memcpy(v, FacetData(c / 3) + 12 * (1 + c % 3), sizeof(v));
+        return Base::Vector3f(v[0], v[1], v[2]);
+    }
+    Key CornerKey(uint32_t c) const
+    {
+        Base::Vector3f p = Corner(c);
+        Key k;
+        k.x = std::floor(p.x / _cell);
+        k.y = std::floor(p.y / _cell);
+        k.z = std::floor(p.z / _cell);
+        return k;
+    }
+    std::size_t Bucket(const Key& k) const
+    {
+        // neighbouring cells mostly share their block and thus their bucket
+        Key b;
+        b.x = std::floor(k.x / BlockSize);
+        b.y = std::floor(k.y / BlockSize);
+        b.z = std::floor(k.z / BlockSize);
+        return KeyHash()(b) % NumBuckets;
+    }
+    bool IsClose(const Base::Vector3f& p, const Base::Vector3f& q) const
+    {
+        // the same criterion as MeshPoint::operator<
+        return fabs(p.x - q.x) < _tol && fabs(p.y - q.y) < _tol && fabs(p.z - q.z) < _tol;
+    }
+
+    void CountBuckets(std::size_t chunk);
+    void SortIntoBuckets(std::size_t chunk);
+    void WeldBucket(std::size_t bucket);
+    void FindNeighbours(std::size_t bucket);
+    void MergeNeighbours();
+
+private:
+    const char* _data;
+    uint32_t _count;
+    float _tol;
+    double _cell;
+    std::vector<std::pair<uint32_t, uint32_t> > _chunks; // ranges of corners
+    std::vector<uint32_t> _counts;  // per chunk and bucket
+    std::vector<uint32_t> _offsets; // start of each bucket in _order
+    std::vector<uint32_t> _order;   // corners sorted by bucket
+    std::vector<uint32_t> _first;   // first corner with the same point
+    std::vector<KeyMap> _points;    // first corners of the points per bucket
+    // per bucket the first corners of two points of neighbour cells that are
+    // within the tolerance, the later one first
+    std::vector<std::vector<std::pair<uint32_t, uint32_t> > > _near;
+};
+
+void BinarySTLReader::CountBuckets(std::size_t chunk)
+{
+    uint32_t* counts = &_counts[chunk * NumBuckets];
+    for (uint32_t c = _chunks[chunk].first; c < _chunks[chunk].second; c++)
+        counts[Bucket(CornerKey(c))]++;
+}
+
+void BinarySTLReader::SortIntoBuckets(std::size_t chunk)
+{
+    // the offsets of this chunk are already set by Read()
+    uint32_t* offsets = &_counts[chunk * NumBuckets];
+    for (uint32_t c = _chunks[chunk].first; c < _chunks[chunk].second; c++)
+        _order[offsets[Bucket(CornerKey(c))]++] = c;
+}
+
+void BinarySTLReader::WeldBucket(std::size_t bucket)
+{
+    // the corners of a bucket are in ascending order
+    KeyMap& points = _points[bucket];
+    points.rehash((_offsets[bucket+1] - _offsets[bucket]) / 4);
+    for (uint32_t i = _offsets[bucket]; i < _offsets[bucket+1]; i++) {
+        uint32_t c = _order[i];
+        Key k = CornerKey(c);
+        Base::Vector3f p = Corner(c);
+        uint32_t first = c;
+        KeyRange range = points.equal_range(k);
+        for (KeyMap::const_iterator it = range.first; it != range.second; ++it) {
+            if (it->second < first && IsClose(p, Corner(it->second)))
+                first = it->second;
+        }
+        if (first == c)
+            points.insert(std::make_pair(k, c));
+        _first[c] = first;
+    }
+}
+
+void BinarySTLReader::FindNeighbours(std::size_t bucket)
+{
+    // Points closer than the tolerance are at most one cell apart and must
+    // both be closer than the tolerance to the common face of their cells.
+    // So, each point only looks into the neighbour cells behind the faces
+    // it is close to. The maps are not modified any more.
+    const KeyMap& points = _points[bucket];
+    for (KeyMap::const_iterator it = points.begin(); it != points.end(); ++it) {
+        uint32_t c = it->second;
+        Base::Vector3f p = Corner(c);
+        const Key& key = it->first;
+        // the directions to check per axis, rounding is taken into account
+        double margin = 0.01 * _tol;
+        double pos[3] = { p.x - key.x * _cell, p.y - key.y * _cell, p.z - key.z * _cell };
+        int lo[3], hi[3];
+        for (int j = 0; j < 3; j++) {
+            lo[j] = pos[j] < _tol + margin ? -1 : 0;
+            hi[j] = pos[j] > _cell - _tol - margin ? 1 : 0;
+        }
+        for (int dx = lo[0]; dx <= hi[0]; dx++) {
+            for (int dy = lo[1]; dy <= hi[1]; dy++) {
+                for (int dz = lo[2]; dz <= hi[2]; dz++) {
+                    if (dx == 0 && dy == 0 && dz == 0)
+                        continue;
+                    Key k = key;
+                    k.x += dx; k.y += dy; k.z += dz;
+                    const KeyMap& other = _points[Bucket(k)];
+                    KeyRange range = other.equal_range(k);
+                    for (KeyMap::const_iterator jt = range.first; jt != range.second; ++jt) {
+                        // the earlier point finds the pair as well
+                        if (jt->second < c && IsClose(p, Corner(jt->second)))
+                            _near[bucket].push_back(std::make_pair(c, jt->second));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BinarySTLReader::MergeNeighbours()
+{
+    std::vector<std::pair<uint32_t, uint32_t> > pairs;
+    for (std::size_t b = 0; b < NumBuckets; b++)
+        pairs.insert(pairs.end(), _near[b].begin(), _near[b].end());
+    if (pairs.empty())
+        return;
+
+    // In the order of the file a point is merged with the earliest point that
+    // still exists, i.e. that is not merged itself.
+    std::sort(pairs.begin(), pairs.end());
+    boost::unordered_map<uint32_t, uint32_t> merged;
+    for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = pairs.begin(); it != pairs.end(); ++it) {
+        if (merged.find(it->first) == merged.end() && merged.find(it->second) == merged.end())
+            merged[it->first] = it->second;
+    }
+
+    for (std::vector<uint32_t>::iterator it = _first.begin(); it != _first.end(); ++it) {
+        boost::unordered_map<uint32_t, uint32_t>::iterator jt = merged.find(*it);
+        if (jt != merged.end())
+            *it = jt->second;
+    }
+}
+
+void BinarySTLReader::Read(MeshPointArray& rPoints, MeshFacetArray& rFacets)
+{
+    uint32_t corners = 3 * _count;
+
+    // split the corners into chunks that are processed in parallel
+    std::size_t numChunks = 1;
+    if (corners >= 300000)
+        numChunks = 4 * std::max<int>(1, QThread::idealThreadCount());
+    uint32_t step = corners / numChunks + 1;
+    std::vector<std::size_t> chunks;
+    for (uint32_t c = 0; c < corners; c += step) {
+        chunks.push_back(_chunks.size());
+        _chunks.push_back(std::make_pair(c, std::min<uint32_t>(c + step, corners)));
+    }
+    std::vector<std::size_t> buckets;
+    for (std::size_t b = 0; b < NumBuckets; b++)
+        buckets.push_back(b);
+
+    // count the corners of each chunk per bucket
+    _counts.resize(_chunks.size() * NumBuckets, 0);
+    QtConcurrent::blockingMap(chunks, boost::bind(&BinarySTLReader::CountBuckets, this, _1));
+
+    // turn the counts into the positions where each chunk writes into a bucket
+    _offsets.resize(NumBuckets + 1);
+    uint32_t sum = 0;
+    for (std::size_t b = 0; b < NumBuckets; b++) {
+        _offsets[b] = sum;
+        for (std::size_t k = 0; k < _chunks.size(); k++) {
+            uint32_t num = _counts[k * NumBuckets + b];
+            _counts[k * NumBuckets + b] = sum;
+            sum += num;
+        }
+    }
+    _offsets[NumBuckets] = sum;
+
+    _order.resize(corners);
+    QtConcurrent::blockingMap(chunks, boost::bind(&BinarySTLReader::SortIntoBuckets, this, _1));
+
+    _first.resize(corners);
+    _points.resize(NumBuckets);
+    QtConcurrent::blockingMap(buckets, boost::bind(&BinarySTLReader::WeldBucket, this, _1));
+    std::vector<uint32_t>().swap(_order);
+
+    _near.resize(NumBuckets);
+    QtConcurrent::blockingMap(buckets, boost::bind(&BinarySTLReader::FindNeighbours, this, _1));
+    std::vector<KeyMap>().swap(_points);
+    MergeNeighbours();
+
+    // Facets with two equal points are skipped. So, only the points used by
+    // the other facets get an index.
+    const uint32_t unused = UINT_MAX;
+    std::vector<uint32_t> index(corners, unused);
+    uint32_t numFacets = 0;
+    for (uint32_t f = 0; f < _count; f++) {
+        uint32_t p0 = _first[3*f], p1 = _first[3*f+1], p2 = _first[3*f+2];
+        if (p0 != p1 && p0 != p2 && p1 != p2) {
+            index[p0] = index[p1] = index[p2] = 0;
+            numFacets++;
+        }
+    }
+
+    uint32_t numPoints = 0;
+    for (uint32_t c = 0; c < corners; c++) {
+        if (index[c] != unused)
+            index[c] = numPoints++;
+    }
+
+    rPoints.resize(numPoints);
+    for (uint32_t c = 0; c < corners; c++) {
+        if (index[c] != unused)
+            rPoints[index[c]] = Corner(c);
+    }
+
+    rFacets.resize(numFacets);
+    MeshFacetArray::_TIterator it = rFacets.begin();
+    for (uint32_t f = 0; f < _count; f++) {
+        uint32_t p0 = _first[3*f], p1 = _first[3*f+1], p2 = _first[3*f+2];
+        if (p0 == p1 || p0 == p2 || p1 == p2)
+            continue;
+
+        it->_aulPoints[0] = index[p0];
+        it->_aulPoints[1] = index[p1];
+        it->_aulPoints[2] = index[p2];
+
+        // adjust circulation direction
+        float n[3];
+        std::memcpy(n, FacetData(f), sizeof(n));
+        const Base::Vector3f& v0 = rPoints[it->_aulPoints[0]];
+        const Base::Vector3f& v1 = rPoints[it->_aulPoints[1]];
+        const Base::Vector3f& v2 = rPoints[it->_aulPoints[2]];
+        if ((((v1 - v0) % (v2 - v0)) * Base::Vector3f(n[0], n[1], n[2])) < 0.0f)
+            std::swap(it->_aulPoints[1], it->_aulPoints[2]);
+        ++it;
+    }
+}
+
+}
+
+bool MeshInput::LoadBinarySTL (const char* data, std::size_t size)
+{
+    if (size < 84)
+        return false;
+
+    uint32_t ulCt;
+    std::memcpy(&ulCt, data + 80, sizeof(ulCt));
+
+    // compare the read value with the file size, the corners must be indexable as well
+    if (ulCt > (size - 84) / 50 || ulCt > UINT_MAX / 3)
+        return false;// not a valid STL file
+
+    MeshPointArray points;
+    MeshFacetArray facets;
+    BinarySTLReader reader(data, ulCt);
+    reader.Read(points, facets);
+
+    this->_rclMesh.Adopt(points, facets, true);
+    return true;
+}
+
 /** Loads the mesh object from an XML file. */
 void MeshInput::LoadXML (Base::XMLReader &reader)
 {
@@ -92,6 +92,11 @@ public:
     bool LoadAsciiSTL (std::istream &rstrIn);
     /** Loads a binary STL file. */
     bool LoadBinarySTL (std::istream &rstrIn);
+    /** Loads a binary STL file from memory, e.g. a memory-mapped file.
+     * The facets are parsed in parallel and the points are welded by hashing
+     * instead of going through MeshBuilder.
+     */
+    bool LoadBinarySTL (const char* data, std::size_t size);
     /** Loads an OBJ Mesh file. */
     bool LoadOBJ (std::istream &rstrIn);
     /** Loads an OFF Mesh file. */
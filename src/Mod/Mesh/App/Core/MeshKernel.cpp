@@ -777,18 +777,37 @@ void MeshKernel::Write (std::ostream &rclOut) const
     // write the number of points and facets
     str << (uint32_t)CountPoints() << (uint32_t)CountFacets();
 
-    // write the data
-    for (MeshPointArray::_TConstIterator it = _aclPointArray.begin(); it != _aclPointArray.end(); ++it) {
-        str << it->x << it->y << it->z;
+    // write the data in blocks of packed values
+    const unsigned long block = 4096;
+    std::vector<float> pointBuf;
+    pointBuf.reserve(3 * block);
+    for (unsigned long i = 0; i < _aclPointArray.size(); i += block) {
+        unsigned long end = std::min<unsigned long>(i + block, _aclPointArray.size());
+        pointBuf.clear();
+        for (unsigned long j = i; j < end; j++) {
+            const MeshPoint& p = _aclPointArray[j];
+            pointBuf.push_back(p.x);
+            pointBuf.push_back(p.y);
+            pointBuf.push_back(p.z);
+        }
+        str.writeArray(&(pointBuf[0]), pointBuf.size());
     }
 
-    for (MeshFacetArray::_TConstIterator it = _aclFacetArray.begin(); it != _aclFacetArray.end(); ++it) {
-        str << (uint32_t)it->_aulPoints[0] 
-            << (uint32_t)it->_aulPoints[1] 
-            << (uint32_t)it->_aulPoints[2];
-        str << (uint32_t)it->_aulNeighbours[0] 
-            << (uint32_t)it->_aulNeighbours[1] 
-            << (uint32_t)it->_aulNeighbours[2];
+    std::vector<uint32_t> facetBuf;
+    facetBuf.reserve(6 * block);
+    for (unsigned long i = 0; i < _aclFacetArray.size(); i += block) {
+        unsigned long end = std::min<unsigned long>(i + block, _aclFacetArray.size());
+        facetBuf.clear();
+        for (unsigned long j = i; j < end; j++) {
+            const MeshFacet& f = _aclFacetArray[j];
+            facetBuf.push_back((uint32_t)f._aulPoints[0]);
+            facetBuf.push_back((uint32_t)f._aulPoints[1]);
+            facetBuf.push_back((uint32_t)f._aulPoints[2]);
+            facetBuf.push_back((uint32_t)f._aulNeighbours[0]);
+            facetBuf.push_back((uint32_t)f._aulNeighbours[1]);
+            facetBuf.push_back((uint32_t)f._aulNeighbours[2]);
+        }
+        str.writeArray(&(facetBuf[0]), facetBuf.size());
     }
 
     str << _clBoundBox.MinX << _clBoundBox.MaxX;
@@ -830,42 +849,45 @@ void MeshKernel::Read (std::istream &rclIn)
         str >> uCtPts >> uCtFts;
 
         try {
-            // read the data
+            // read the data in blocks of packed values
+            const unsigned long block = 4096;
             MeshPointArray pointArray;
             pointArray.resize(uCtPts);
-            for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
-                str >> it->x >> it->y >> it->z;
+            std::vector<float> pointBuf(3 * block);
+            for (unsigned long i = 0; i < uCtPts; i += block) {
+                unsigned long end = std::min<unsigned long>(i + block, uCtPts);
+                str.readArray(&(pointBuf[0]), 3 * (end - i));
+                const float* v = &(pointBuf[0]);
+                for (unsigned long j = i; j < end; j++, v += 3) {
+                    pointArray[j].Set(v[0], v[1], v[2]);
+                }
             }
           
             MeshFacetArray facetArray;
             facetArray.resize(uCtFts);
 
-            uint32_t v1, v2, v3;
-            for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
-                str >> v1 >> v2 >> v3;
-                it->_aulPoints[0] = v1;
-                it->_aulPoints[1] = v2;
-                it->_aulPoints[2] = v3;
-
-                // On systems where an 'unsigned long' is a 64-bit value
-                // the empty neighbour must be explicitly set to 'ULONG_MAX'
-                // because in algorithms this value is always used to check
-                // for open edges.
-                str >> v1 >> v2 >> v3;
-                if (v1 < open_edge)
-                    it->_aulNeighbours[0] = v1;
-                else
-                    it->_aulNeighbours[0] = ULONG_MAX;
-
-                if (v2 < open_edge)
-                    it->_aulNeighbours[1] = v2;
-                else
-                    it->_aulNeighbours[1] = ULONG_MAX;
-
-                if (v3 < open_edge)
-                    it->_aulNeighbours[2] = v3;
-                else
-                    it->_aulNeighbours[2] = ULONG_MAX;
+            std::vector<uint32_t> facetBuf(6 * block);
+            for (unsigned long i = 0; i < uCtFts; i += block) {
+                unsigned long end = std::min<unsigned long>(i + block, uCtFts);
+                str.readArray(&(facetBuf[0]), 6 * (end - i));
+                const uint32_t* v = &(facetBuf[0]);
+                for (unsigned long j = i; j < end; j++, v += 6) {
+                    MeshFacet& f = facetArray[j];
+                    f._aulPoints[0] = v[0];
+                    f._aulPoints[1] = v[1];
+                    f._aulPoints[2] = v[2];
+
+                    // On systems where an 'unsigned long' is a 64-bit value
+                    // the empty neighbour must be explicitly set to 'ULONG_MAX'
+                    // because in algorithms this value is always used to check
+                    // for open edges.
+                    for (int k = 0; k < 3; k++) {
+                        if (v[3+k] < open_edge)
+                            f._aulNeighbours[k] = v[3+k];
+                        else
+                            f._aulNeighbours[k] = ULONG_MAX;
+                    }
+                }
             }
 
             str >> _clBoundBox.MinX >> _clBoundBox.MaxX;
@@ -0,0 +1,442 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cfloat>
+# include <climits>
+# include <cmath>
+#endif
+
+#include "Registration.h"
+#include "MeshKernel.h"
+
+#include <Base/BoundBox.h>
+
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+#include <Eigen/Eigenvalues>
+
+using namespace MeshCore;
+
+// Max. number of points of a leaf node
+#define MESH_POINTTREE_LEAF 8
+
+namespace {
+
+inline float Coordinate(const Base::Vector3f& pt, unsigned short axis)
+{
+    return axis == 0 ? pt.x : (axis == 1 ? pt.y : pt.z);
+}
+
+struct PointOrder
+{
+    PointOrder(const std::vector<Base::Vector3f>& points, unsigned short axis)
+      : points(points), axis(axis)
+    {
+    }
+    bool operator () (unsigned long p1, unsigned long p2) const
+    {
+        return Coordinate(points[p1], axis) < Coordinate(points[p2], axis);
+    }
+
+    const std::vector<Base::Vector3f>& points;
+    unsigned short axis;
+};
+
+std::vector<Base::Vector3f> GetMeshPoints(const MeshKernel& mesh)
+{
+    const MeshPointArray& points = mesh.GetPoints();
+    return std::vector<Base::Vector3f>(points.begin(), points.end());
+}
+
+/**
+ * The weighted sums of the point pairs that are needed for the closed-form
+ * solution. The sums of the chunks are computed in parallel and merged afterwards.
+ */
+struct PointPairMoments
+{
+    PointPairMoments() : count(0), weight(0.0), error(0.0)
+    {
+        for (int i=0; i<3; i++) {
+            p[i] = q[i] = 0.0;
+            for (int j=0; j<3; j++)
+                pq[i][j] = 0.0;
+        }
+    }
+    void Add(const Base::Vector3f& s, const Base::Vector3f& t, double w)
+    {
+        double sw[3] = {w*s.x, w*s.y, w*s.z};
+        double tv[3] = {t.x, t.y, t.z};
+        for (int i=0; i<3; i++) {
+            p[i] += sw[i];
+            q[i] += w*tv[i];
+            for (int j=0; j<3; j++)
+                pq[i][j] += sw[i]*tv[j];
+        }
+        weight += w;
+        error += Base::DistanceP2(s, t);
+        count++;
+    }
+    void Merge(const PointPairMoments& m)
+    {
+        for (int i=0; i<3; i++) {
+            p[i] += m.p[i];
+            q[i] += m.q[i];
+            for (int j=0; j<3; j++)
+                pq[i][j] += m.pq[i][j];
+        }
+        weight += m.weight;
+        error += m.error;
+        count += m.count;
+    }
+    float RMS() const
+    {
+        return count > 0 ? (float)sqrt(error/count) : FLT_MAX;
+    }
+    Base::Matrix4D Solve() const;
+
+    unsigned long count;
+    double weight, error;
+    double p[3], q[3], pq[3][3];
+};
+
+/**
+ * Returns the rotation and translation that moves the source points onto the
+ * target points. The rotation is the unit quaternion of the eigenvector of the
+ * largest eigenvalue of Horn's symmetric 4x4 matrix.
+ */
+Base::Matrix4D PointPairMoments::Solve() const
+{
+    Base::Matrix4D mat;
+    if (count < 3 || weight <= 0.0)
+        return mat;
+
+    double cp[3], cq[3], S[3][3];
+    for (int i=0; i<3; i++) {
+        cp[i] = p[i]/weight;
+        cq[i] = q[i]/weight;
+    }
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++)
+            S[i][j] = pq[i][j] - weight*cp[i]*cq[j];
+    }
+
+    Eigen::Matrix4d N;
+    N(0,0) = S[0][0]+S[1][1]+S[2][2];
+    N(1,1) = S[0][0]-S[1][1]-S[2][2];
+    N(2,2) =-S[0][0]+S[1][1]-S[2][2];
+    N(3,3) =-S[0][0]-S[1][1]+S[2][2];
+    N(0,1) = N(1,0) = S[1][2]-S[2][1];
+    N(0,2) = N(2,0) = S[2][0]-S[0][2];
+    N(0,3) = N(3,0) = S[0][1]-S[1][0];
+    N(1,2) = N(2,1) = S[0][1]+S[1][0];
+    N(1,3) = N(3,1) = S[2][0]+S[0][2];
+    N(2,3) = N(3,2) = S[1][2]+S[2][1];
+
+    // the eigenvalues are sorted in increasing order
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> eig(N);
+    Eigen::Vector4d quat = eig.eigenvectors().col(3);
+    double w = quat(0), x = quat(1), y = quat(2), z = quat(3);
+
+    double R[3][3];
+    R[0][0] = w*w+x*x-y*y-z*z; R[0][1] = 2.0*(x*y-w*z);   R[0][2] = 2.0*(x*z+w*y);
+    R[1][0] = 2.0*(x*y+w*z);   R[1][1] = w*w-x*x+y*y-z*z; R[1][2] = 2.0*(y*z-w*x);
+    R[2][0] = 2.0*(x*z-w*y);   R[2][1] = 2.0*(y*z+w*x);   R[2][2] = w*w-x*x-y*y+z*z;
+
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++)
+            mat[i][j] = R[i][j];
+        mat[i][3] = cq[i] - (R[i][0]*cp[0] + R[i][1]*cp[1] + R[i][2]*cp[2]);
+    }
+
+    return mat;
+}
+
+struct CorrespondenceChunk
+{
+    unsigned long begin, end;
+    PointPairMoments moments;
+};
+
+class CorrespondenceSearch
+{
+public:
+    CorrespondenceSearch(const PointKDTree& tree, const std::vector<Base::Vector3f>& source,
+                         const Base::Matrix4D& mat, float maxDist)
+      : tree(tree), source(source), mat(mat), maxDist(maxDist), weights(0), targets(0)
+    {
+    }
+    void Run(CorrespondenceChunk& chunk) const
+    {
+        for (unsigned long i = chunk.begin; i < chunk.end; i++) {
+            Base::Vector3f pt = mat * source[i];
+            // the match of the previous iteration is a good start for the search
+            unsigned long index = targets ? (*targets)[i] : ULONG_MAX;
+            float dist;
+            if (tree.NearestPoint(pt, maxDist, index, index, dist)) {
+                chunk.moments.Add(pt, tree.GetPoint(index), weights ? (*weights)[i] : 1.0);
+                if (targets)
+                    (*targets)[i] = index;
+            }
+            else if (targets) {
+                (*targets)[i] = ULONG_MAX;
+            }
+        }
+    }
+    PointPairMoments Search(std::vector<CorrespondenceChunk>& chunks) const
+    {
+        if (chunks.size() > 1)
+            QtConcurrent::blockingMap(chunks, boost::bind(&CorrespondenceSearch::Run, this, _1));
+        else if (!chunks.empty())
+            Run(chunks.front());
+
+        PointPairMoments moments;
+        for (std::vector<CorrespondenceChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            moments.Merge(it->moments);
+            it->moments = PointPairMoments();
+        }
+        return moments;
+    }
+
+    const PointKDTree& tree;
+    const std::vector<Base::Vector3f>& source;
+    Base::Matrix4D mat;
+    float maxDist;
+    const std::vector<float>* weights;
+    std::vector<unsigned long>* targets;
+};
+
+std::vector<CorrespondenceChunk> SplitPoints (unsigned long count)
+{
+    // for small point sets the thread overhead doesn't pay off
+    unsigned long chunks = 1;
+    if (count >= 10000)
+        chunks = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+
+    std::vector<CorrespondenceChunk> parts;
+    unsigned long step = (count + chunks - 1) / chunks;
+    for (unsigned long i = 0; i < count; i += step) {
+        CorrespondenceChunk chunk;
+        chunk.begin = i;
+        chunk.end = std::min<unsigned long>(i + step, count);
+        parts.push_back(chunk);
+    }
+    return parts;
+}
+
+}
+
+// ----------------------------------------------------
+
+PointKDTree::PointKDTree (const std::vector<Base::Vector3f> &raclPoints)
+  : _aclPoints(raclPoints)
+{
+    unsigned long ulCount = (unsigned long)raclPoints.size();
+    _afSplits.resize(ulCount, 0.0f);
+    _aucAxes.resize(ulCount, 0);
+    _aulPoints.resize(ulCount);
+    for (unsigned long i = 0; i < ulCount; i++)
+        _aulPoints[i] = i;
+
+    Build(0, ulCount);
+
+    // copy the points into tree order
+    _aulPositions.resize(ulCount);
+    for (unsigned long i = 0; i < ulCount; i++) {
+        _aclPoints[i] = raclPoints[_aulPoints[i]];
+        _aulPositions[_aulPoints[i]] = i;
+    }
+}
+
+PointKDTree::~PointKDTree (void)
+{
+}
+
+/**
+ * Sorts the points of the range so that the median along the axis of the largest
+ * extent is in the middle, all points before it are not greater and all points
+ * after it are not less. The two halves are split in the same way.
+ */
+void PointKDTree::Build (unsigned long ulBegin, unsigned long ulEnd)
+{
+    if (ulEnd - ulBegin <= MESH_POINTTREE_LEAF)
+        return;
+
+    Base::BoundBox3f clBox;
+    for (unsigned long i = ulBegin; i < ulEnd; i++)
+        clBox.Add(_aclPoints[_aulPoints[i]]);
+
+    unsigned short usAxis = 0;
+    if (clBox.LengthY() > clBox.LengthX() && clBox.LengthY() >= clBox.LengthZ())
+        usAxis = 1;
+    else if (clBox.LengthZ() > clBox.LengthX() && clBox.LengthZ() > clBox.LengthY())
+        usAxis = 2;
+
+    unsigned long ulMid = ulBegin + (ulEnd - ulBegin) / 2;
+    std::nth_element(_aulPoints.begin() + ulBegin, _aulPoints.begin() + ulMid,
+                     _aulPoints.begin() + ulEnd, PointOrder(_aclPoints, usAxis));
+    _afSplits[ulMid] = Coordinate(_aclPoints[_aulPoints[ulMid]], usAxis);
+    _aucAxes[ulMid] = (unsigned char)usAxis;
+
+    Build(ulBegin, ulMid);
+    Build(ulMid + 1, ulEnd);
+}
+
+void PointKDTree::Search (unsigned long ulBegin, unsigned long ulEnd, const Base::Vector3f &rclPt,
+                          unsigned long &rulPos, float &rfDist2) const
+{
+    if (ulEnd - ulBegin <= MESH_POINTTREE_LEAF) {
+        for (unsigned long i = ulBegin; i < ulEnd; i++) {
+            float fDist2 = Base::DistanceP2(_aclPoints[i], rclPt);
+            if (fDist2 <= rfDist2) {
+                rfDist2 = fDist2;
+                rulPos = i;
+            }
+        }
+        return;
+    }
+
+    unsigned long ulMid = ulBegin + (ulEnd - ulBegin) / 2;
+    float fDist2 = Base::DistanceP2(_aclPoints[ulMid], rclPt);
+    if (fDist2 <= rfDist2) {
+        rfDist2 = fDist2;
+        rulPos = ulMid;
+    }
+
+    // search the side of the query point first, the other side only if the
+    // splitting plane is closer than the nearest point found so far
+    float fDiff = Coordinate(rclPt, _aucAxes[ulMid]) - _afSplits[ulMid];
+    if (fDiff < 0.0f) {
+        Search(ulBegin, ulMid, rclPt, rulPos, rfDist2);
+        if (fDiff * fDiff <= rfDist2)
+            Search(ulMid + 1, ulEnd, rclPt, rulPos, rfDist2);
+    }
+    else {
+        Search(ulMid + 1, ulEnd, rclPt, rulPos, rfDist2);
+        if (fDiff * fDiff <= rfDist2)
+            Search(ulBegin, ulMid, rclPt, rulPos, rfDist2);
+    }
+}
+
+bool PointKDTree::NearestPoint (const Base::Vector3f &rclPt, float fMaxDist,
+                                unsigned long &rulPoint, float &rfDist) const
+{
+    unsigned long ulPos = ULONG_MAX;
+    float fDist2 = fMaxDist * fMaxDist;
+    Search(0, CountPoints(), rclPt, ulPos, fDist2);
+    if (ulPos == ULONG_MAX)
+        return false;
+
+    rulPoint = _aulPoints[ulPos];
+    rfDist = (float)sqrt(fDist2);
+    return true;
+}
+
+bool PointKDTree::NearestPoint (const Base::Vector3f &rclPt, float fMaxDist, unsigned long ulHint,
+                                unsigned long &rulPoint, float &rfDist) const
+{
+    unsigned long ulPos = ULONG_MAX;
+    float fDist2 = fMaxDist * fMaxDist;
+    if (ulHint < CountPoints()) {
+        float fHint2 = Base::DistanceP2(GetPoint(ulHint), rclPt);
+        if (fHint2 <= fDist2) {
+            fDist2 = fHint2;
+            ulPos = _aulPositions[ulHint];
+        }
+    }
+    Search(0, CountPoints(), rclPt, ulPos, fDist2);
+    if (ulPos == ULONG_MAX)
+        return false;
+
+    rulPoint = _aulPoints[ulPos];
+    rfDist = (float)sqrt(fDist2);
+    return true;
+}
+
+// ----------------------------------------------------
+
+PointRegistration::PointRegistration (const std::vector<Base::Vector3f> &raclTarget)
+  : _clTree(raclTarget), _iMaxIter(50), _iIter(0), _fTolerance(1.0e-6f), _fMaxDist(0.0f)
+{
+}
+
+PointRegistration::PointRegistration (const MeshKernel &rclTarget)
+  : _clTree(GetMeshPoints(rclTarget)), _iMaxIter(50), _iIter(0), _fTolerance(1.0e-6f), _fMaxDist(0.0f)
+{
+}
+
+PointRegistration::~PointRegistration (void)
+{
+}
+
+float PointRegistration::Perform (const std::vector<Base::Vector3f> &raclSource, Base::Matrix4D &rclMat,
+                                  const std::vector<float> *pafWeights)
+{
+    float fMaxDist = _fMaxDist > 0.0f ? _fMaxDist : FLT_MAX;
+    std::vector<CorrespondenceChunk> chunks = SplitPoints((unsigned long)raclSource.size());
+
+    std::vector<unsigned long> targets(raclSource.size(), ULONG_MAX);
+    float fLastError = FLT_MAX;
+    for (_iIter = 0; ; _iIter++) {
+        CorrespondenceSearch search(_clTree, raclSource, rclMat, fMaxDist);
+        search.weights = pafWeights;
+        search.targets = &targets;
+        PointPairMoments moments = search.Search(chunks);
+
+        float fError = moments.RMS();
+        if (_iIter >= _iMaxIter || moments.count < 3 || fLastError - fError < _fTolerance)
+            return fError;
+        fLastError = fError;
+
+        // the pairs were built from the transformed source points
+        rclMat = moments.Solve() * rclMat;
+    }
+}
+
+float PointRegistration::FindCorrespondences (const std::vector<Base::Vector3f> &raclSource,
+                                              const Base::Matrix4D &rclMat,
+                                              std::vector<unsigned long> &raulTarget) const
+{
+    float fMaxDist = _fMaxDist > 0.0f ? _fMaxDist : FLT_MAX;
+    std::vector<CorrespondenceChunk> chunks = SplitPoints((unsigned long)raclSource.size());
+
+    raulTarget.assign(raclSource.size(), ULONG_MAX);
+    CorrespondenceSearch search(_clTree, raclSource, rclMat, fMaxDist);
+    search.targets = &raulTarget;
+    return search.Search(chunks).RMS();
+}
+
+Base::Matrix4D PointRegistration::ComputeTransform (const std::vector<Base::Vector3f> &raclSource,
+                                                    const std::vector<Base::Vector3f> &raclTarget,
+                                                    const std::vector<float> *pafWeights)
+{
+    PointPairMoments moments;
+    std::size_t ulCount = std::min<std::size_t>(raclSource.size(), raclTarget.size());
+    for (std::size_t i = 0; i < ulCount; i++)
+        moments.Add(raclSource[i], raclTarget[i], pafWeights ? (*pafWeights)[i] : 1.0);
+    return moments.Solve();
+}
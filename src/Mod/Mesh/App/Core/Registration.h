@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_REGISTRATION_H
+#define MESH_REGISTRATION_H
+
+#include <vector>
+
+#include <Base/Matrix.h>
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The PointKDTree is a balanced kd-tree over a set of points to find the nearest
+ * point of a query position. The points are copied into the tree in tree order so
+ * that the tree must be built only once for any number of queries. All queries
+ * are const and can be run from several threads at a time.
+ */
+class MeshExport PointKDTree
+{
+public:
+    /// Construction
+    PointKDTree (const std::vector<Base::Vector3f> &raclPoints);
+    /// Destruction
+    ~PointKDTree (void);
+
+    /// Returns the number of points in the tree.
+    unsigned long CountPoints (void) const
+    { return (unsigned long)_aclPoints.size(); }
+    /// Returns the point with index \a ulPoint of the input points.
+    const Base::Vector3f& GetPoint (unsigned long ulPoint) const
+    { return _aclPoints[_aulPositions[ulPoint]]; }
+
+    /**
+     * Searches for the point nearest to \a rclPt with a distance less than or equal
+     * to \a fMaxDist. Returns false if there is no such point, otherwise the index
+     * of the point is returned in \a rulPoint and its distance in \a rfDist.
+     */
+    bool NearestPoint (const Base::Vector3f &rclPt, float fMaxDist,
+                       unsigned long &rulPoint, float &rfDist) const;
+    /**
+     * Does the same as above but starts with the point \a ulHint, e.g. the result of a
+     * previous query close to \a rclPt. A good hint prunes most of the tree.
+     */
+    bool NearestPoint (const Base::Vector3f &rclPt, float fMaxDist, unsigned long ulHint,
+                       unsigned long &rulPoint, float &rfDist) const;
+
+protected:
+    void Build (unsigned long ulBegin, unsigned long ulEnd);
+    void Search (unsigned long ulBegin, unsigned long ulEnd, const Base::Vector3f &rclPt,
+                 unsigned long &rulPos, float &rfDist2) const;
+
+protected:
+    std::vector<Base::Vector3f> _aclPoints;  /**< The points in tree order. */
+    std::vector<float> _afSplits;  /**< Split value of the node with the median at this position. */
+    std::vector<unsigned char> _aucAxes;  /**< Split axis of the node with the median at this position. */
+    std::vector<unsigned long> _aulPoints;  /**< Point index of each tree position. */
+    std::vector<unsigned long> _aulPositions;  /**< Tree position of each point. */
+};
+
+/**
+ * The PointRegistration class computes the rigid transformation that moves a
+ * set of source points onto a target shape given by a point cloud or by the
+ * points of a mesh (Iterative Closest Point).
+ * The search tree over the target is built once in the constructor and is
+ * reused for every source and every iteration. In each iteration the nearest
+ * target point of every source point is searched in parallel and the best
+ * rotation and translation of the point pairs is solved in closed form with
+ * the quaternion method of B.K.P. Horn, Closed-form solution of absolute
+ * orientation using unit quaternions, 1987.
+ */
+class MeshExport PointRegistration
+{
+public:
+    /// Construction with the target point cloud
+    PointRegistration (const std::vector<Base::Vector3f> &raclTarget);
+    /// Construction with the points of the target mesh
+    PointRegistration (const MeshKernel &rclTarget);
+    /// Destruction
+    ~PointRegistration (void);
+
+    /// Sets the maximum number of iterations. The default is 50.
+    void SetMaxIterations (int iIter)
+    { _iMaxIter = iIter; }
+    /// Stops the iteration as soon as the RMS error improves by less than \a fTol. The default is 1.0e-6.
+    void SetTolerance (float fTol)
+    { _fTolerance = fTol; }
+    /// Ignores point pairs with a distance greater than \a fDist. By default (0) all pairs are used.
+    void SetMaxDistance (float fDist)
+    { _fMaxDist = fDist; }
+    /// Returns the number of iterations of the last call of Perform().
+    int GetIterations (void) const
+    { return _iIter; }
+    /// Returns the search tree over the target points.
+    const PointKDTree& GetTree (void) const
+    { return _clTree; }
+
+    /**
+     * Computes the rigid transformation that moves \a raclSource onto the target.
+     * \a rclMat is the start transformation and receives the result. If \a pafWeights
+     * is given it must have a weight for each source point. Returns the RMS distance
+     * of the matched point pairs.
+     */
+    float Perform (const std::vector<Base::Vector3f> &raclSource, Base::Matrix4D &rclMat,
+                   const std::vector<float> *pafWeights = 0);
+    /**
+     * Searches the nearest target point for each of the source points transformed by
+     * \a rclMat. The indices are returned in \a raulTarget, source points without
+     * a target point within the maximum distance get ULONG_MAX. Returns the RMS
+     * distance of the matched point pairs.
+     */
+    float FindCorrespondences (const std::vector<Base::Vector3f> &raclSource, const Base::Matrix4D &rclMat,
+                               std::vector<unsigned long> &raulTarget) const;
+    /**
+     * Returns the rigid transformation that moves the points \a raclSource onto the
+     * points \a raclTarget in the least-squares sense. Both containers must have the
+     * same size, \a pafWeights can be null or has a weight for each point pair.
+     */
+    static Base::Matrix4D ComputeTransform (const std::vector<Base::Vector3f> &raclSource,
+                                            const std::vector<Base::Vector3f> &raclTarget,
+                                            const std::vector<float> *pafWeights = 0);
+
+protected:
+    PointKDTree _clTree;
+    int _iMaxIter;
+    int _iIter;
+    float _fTolerance;
+    float _fMaxDist;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_REGISTRATION_H
@@ -23,12 +23,17 @@
 #include "PreCompiled.h"
 #ifndef _PreComp_
 #include <algorithm>
+#include <climits>
 #endif
 
 #include "Segmentation.h"
 #include "Algorithm.h"
 #include "Approximation.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 using namespace MeshCore;
 
 void MeshSurfaceSegment::Initialize(unsigned long)
@@ -59,7 +64,7 @@ MeshSegment MeshSurfaceSegment::FindSegment(unsigned long index) const
 // --------------------------------------------------------
 
 MeshDistancePlanarSegment::MeshDistancePlanarSegment(const MeshKernel& mesh, unsigned long minFacets, float tol)
-  : MeshDistanceSurfaceSegment(mesh, minFacets, tol), fitter(new PlaneFit)
+  : MeshDistanceSurfaceSegment(mesh, minFacets, tol), fitter(new IncrementalPlaneFit)
 {
 }
 
@@ -187,52 +192,245 @@ bool MeshSurfaceVisitor::Visit (const MeshFacet & face, const MeshFacet &,
 
 // --------------------------------------------------------
 
+namespace {
+
+/**
+ * Finds the connected components of the facets accepted by a stateless surface type
+ * with a union-find. The facets are split into ranges, each thread tests the facets
+ * of its range and joins the accepted neighbours within the range. The neighbours in
+ * other ranges are joined afterwards. The root of a component is its lowest facet index.
+ */
+class FacetComponents
+{
+public:
+    typedef std::pair<unsigned long, unsigned long> IndexPair;
+
+    struct Range
+    {
+        unsigned long begin, end;
+        std::vector<IndexPair> links; // accepted neighbours in other ranges
+    };
+
+    FacetComponents (const MeshFacetArray& facets, const MeshSurfaceSegment& segm)
+      : _facets(facets), _segm(segm)
+    {
+        unsigned long count = facets.size();
+        _accepted.resize(count, 0);
+        _parent.resize(count);
+        for (unsigned long i = 0; i < count; i++)
+            _parent[i] = i;
+        _next.resize(count, ULONG_MAX);
+
+        // for small meshes the thread overhead doesn't pay off
+        unsigned long ranges = 1;
+        if (count >= 10000)
+            ranges = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+        unsigned long step = (count + ranges - 1) / ranges;
+        for (unsigned long i = 0; i < count; i += step) {
+            Range range;
+            range.begin = i;
+            range.end = std::min<unsigned long>(i + step, count);
+            _ranges.push_back(range);
+        }
+    }
+
+    /// Tests all facets not visited yet and joins the accepted neighbours.
+    void Compute ()
+    {
+        Run(&FacetComponents::TestFacets);
+        Run(&FacetComponents::JoinFacets);
+        for (std::vector<Range>::iterator it = _ranges.begin(); it != _ranges.end(); ++it) {
+            for (std::vector<IndexPair>::iterator jt = it->links.begin(); jt != it->links.end(); ++jt)
+                Join(jt->first, jt->second);
+        }
+
+        // link the facets of each component in ascending order
+        std::vector<unsigned long> last(_facets.size());
+        for (unsigned long i = 0; i < _facets.size(); i++) {
+            if (!_accepted[i])
+                continue;
+            unsigned long root = Find(i);
+            _parent[i] = root;
+            if (root != i)
+                _next[last[root]] = i;
+            last[root] = i;
+        }
+    }
+
+    bool IsAccepted (unsigned long index) const
+    {
+        return _accepted[index] != 0;
+    }
+
+    /// Appends the facets of the component of \a index to \a indices and marks them visited.
+    void Collect (unsigned long index, std::vector<unsigned long>& indices) const
+    {
+        for (unsigned long i = _parent[index]; i != ULONG_MAX; i = _next[i]) {
+            indices.push_back(i);
+            _facets[i].SetFlag(MeshFacet::VISIT);
+        }
+    }
+
+private:
+    void Run (void (FacetComponents::*func)(Range&))
+    {
+        if (_ranges.size() > 1)
+            QtConcurrent::blockingMap(_ranges, boost::bind(func, this, _1));
+        else if (!_ranges.empty())
+            (this->*func)(_ranges.front());
+    }
+
+    void TestFacets (Range& range)
+    {
+        for (unsigned long i = range.begin; i < range.end; i++) {
+            const MeshFacet& face = _facets[i];
+            _accepted[i] = (!face.IsFlag(MeshFacet::VISIT) && _segm.TestFacet(face)) ? 1 : 0;
+        }
+    }
+
+    /// Only modifies the entries of the range, so the ranges can be joined in parallel.
+    void JoinFacets (Range& range)
+    {
+        unsigned long count = _facets.size();
+        for (unsigned long i = range.begin; i < range.end; i++) {
+            if (!_accepted[i])
+                continue;
+            for (int k = 0; k < 3; k++) {
+                unsigned long j = _facets[i]._aulNeighbours[k];
+                if (j >= count || !_accepted[j])
+                    continue;
+                if (j >= range.begin && j < range.end)
+                    Join(i, j);
+                else
+                    range.links.push_back(IndexPair(i, j));
+            }
+        }
+    }
+
+    unsigned long Find (unsigned long index)
+    {
+        while (_parent[index] != index) {
+            _parent[index] = _parent[_parent[index]];
+            index = _parent[index];
+        }
+        return index;
+    }
+
+    void Join (unsigned long a, unsigned long b)
+    {
+        a = Find(a);
+        b = Find(b);
+        if (a < b)
+            _parent[b] = a;
+        else if (b < a)
+            _parent[a] = b;
+    }
+
+private:
+    const MeshFacetArray& _facets;
+    const MeshSurfaceSegment& _segm;
+    std::vector<char> _accepted;
+    std::vector<unsigned long> _parent;
+    std::vector<unsigned long> _next;
+    std::vector<Range> _ranges;
+};
+
+}
+
 void MeshSegmentAlgorithm::FindSegments(std::vector<MeshSurfaceSegment*>& segm)
 {
     // reset VISIT flags
-    unsigned long startFacet;
     MeshCore::MeshAlgorithm cAlgo(myKernel);
     cAlgo.ResetFacetFlag(MeshCore::MeshFacet::VISIT);
 
+    std::vector<unsigned long> resetVisited;
+    for (std::vector<MeshSurfaceSegment*>::iterator it = segm.begin(); it != segm.end(); ++it) {
+        cAlgo.ResetFacetsFlag(resetVisited, MeshCore::MeshFacet::VISIT);
+        resetVisited.clear();
+
+        if ((*it)->IsStateless())
+            JoinSegments(**it, resetVisited);
+        else
+            GrowSegments(**it, resetVisited);
+    }
+}
+
+void MeshSegmentAlgorithm::GrowSegments(MeshSurfaceSegment& segm, std::vector<unsigned long>& resetVisited)
+{
+    unsigned long startFacet;
     const MeshCore::MeshFacetArray& rFAry = myKernel.GetFacets();
     MeshCore::MeshFacetArray::_TConstIterator iCur = rFAry.begin();
     MeshCore::MeshFacetArray::_TConstIterator iBeg = rFAry.begin();
     MeshCore::MeshFacetArray::_TConstIterator iEnd = rFAry.end();
 
     // start from the first not visited facet
-    cAlgo.CountFacetFlag(MeshCore::MeshFacet::VISIT);
-    std::vector<unsigned long> resetVisited;
-
-    for (std::vector<MeshSurfaceSegment*>::iterator it = segm.begin(); it != segm.end(); ++it) {
-        cAlgo.ResetFacetsFlag(resetVisited, MeshCore::MeshFacet::VISIT);
-        resetVisited.clear();
+    iCur = std::find_if(iBeg, iEnd, std::bind2nd(MeshCore::MeshIsNotFlag<MeshCore::MeshFacet>(),
+        MeshCore::MeshFacet::VISIT));
+    if (iCur < iEnd)
+        startFacet = iCur - iBeg;
+    else
+        startFacet = ULONG_MAX;
+    while (startFacet != ULONG_MAX) {
+        // collect all facets of the same geometry
+        std::vector<unsigned long> indices;
+        indices.push_back(startFacet);
+        segm.Initialize(startFacet);
+        MeshSurfaceVisitor pv(segm, indices);
+        myKernel.VisitNeighbourFacets(pv, startFacet);
+
+        // add or discard the segment
+        if (indices.size() == 1) {
+            resetVisited.push_back(startFacet);
+        }
+        else {
+            segm.AddSegment(indices);
+        }
 
-        iCur = std::find_if(iBeg, iEnd, std::bind2nd(MeshCore::MeshIsNotFlag<MeshCore::MeshFacet>(),
+        // search for the next start facet
+        iCur = std::find_if(iCur, iEnd, std::bind2nd(MeshCore::MeshIsNotFlag<MeshCore::MeshFacet>(),
             MeshCore::MeshFacet::VISIT));
-        startFacet = iCur - iBeg;
-        while (startFacet != ULONG_MAX) {
-            // collect all facets of the same geometry
-            std::vector<unsigned long> indices;
-            indices.push_back(startFacet);
-            (*it)->Initialize(startFacet);
-            MeshSurfaceVisitor pv(**it, indices);
-            myKernel.VisitNeighbourFacets(pv, startFacet);
-
-            // add or discard the segment
-            if (indices.size() == 1) {
-                resetVisited.push_back(startFacet);
-            }
-            else {
-                (*it)->AddSegment(indices);
+        if (iCur < iEnd)
+            startFacet = iCur - iBeg;
+        else
+            startFacet = ULONG_MAX;
+    }
+}
+
+void MeshSegmentAlgorithm::JoinSegments(MeshSurfaceSegment& segm, std::vector<unsigned long>& resetVisited)
+{
+    const MeshCore::MeshFacetArray& rFAry = myKernel.GetFacets();
+    FacetComponents components(rFAry, segm);
+    components.Compute();
+
+    // Same order as in GrowSegments(): a segment starts at the first facet not visited yet.
+    // An accepted start facet gets its component. A start facet that isn't accepted gets
+    // the components of its neighbours, as it is the only facet not tested.
+    unsigned long count = rFAry.size();
+    std::vector<unsigned long> indices;
+    for (unsigned long i = 0; i < count; i++) {
+        if (rFAry[i].IsFlag(MeshCore::MeshFacet::VISIT))
+            continue;
+
+        indices.clear();
+        if (components.IsAccepted(i)) {
+            components.Collect(i, indices);
+        }
+        else {
+            indices.push_back(i);
+            rFAry[i].SetFlag(MeshCore::MeshFacet::VISIT);
+            for (int k = 0; k < 3; k++) {
+                unsigned long j = rFAry[i]._aulNeighbours[k];
+                if (j < count && components.IsAccepted(j) && !rFAry[j].IsFlag(MeshCore::MeshFacet::VISIT))
+                    components.Collect(j, indices);
             }
+        }
 
-            // search for the next start facet
-            iCur = std::find_if(iCur, iEnd, std::bind2nd(MeshCore::MeshIsNotFlag<MeshCore::MeshFacet>(),
-                MeshCore::MeshFacet::VISIT));
-            if (iCur < iEnd)
-                startFacet = iCur - iBeg;
-            else
-                startFacet = ULONG_MAX;
+        // add or discard the segment
+        if (indices.size() == 1) {
+            resetVisited.push_back(i);
+        }
+        else {
+            segm.AddSegment(indices);
         }
     }
 }
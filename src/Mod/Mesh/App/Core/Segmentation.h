@@ -30,7 +30,7 @@
 
 namespace MeshCore {
 
-class PlaneFit;
+class IncrementalPlaneFit;
 class MeshFacet;
 typedef std::vector<unsigned long> MeshSegment;
 
@@ -42,6 +42,11 @@ public:
     virtual ~MeshSurfaceSegment() {}
     virtual bool TestFacet (const MeshFacet &rclFacet) const = 0;
     virtual const char* GetType() const = 0;
+    /** Returns true if TestFacet() only depends on the facet itself and not on the
+     * facets added to the segment so far. The segments of such a surface type are
+     * the connected components of the accepted facets and can be searched in parallel.
+     */
+    virtual bool IsStateless() const { return false; }
     virtual void Initialize(unsigned long);
     virtual void AddFacet(const MeshFacet& rclFacet);
     void AddSegment(const std::vector<unsigned long>&);
@@ -79,7 +84,7 @@ public:
 protected:
     Base::Vector3f basepoint;
     Base::Vector3f normal;
-    PlaneFit* fitter;
+    IncrementalPlaneFit* fitter;
 };
 
 // --------------------------------------------------------
@@ -89,6 +94,7 @@ class MeshExport MeshCurvatureSurfaceSegment : public MeshSurfaceSegment
 public:
     MeshCurvatureSurfaceSegment(const std::vector<CurvatureInfo>& ci, unsigned long minFacets)
         : MeshSurfaceSegment(minFacets), info(ci) {}
+    bool IsStateless() const { return true; }
 
 protected:
     const std::vector<CurvatureInfo>& info;
@@ -169,8 +175,18 @@ class MeshExport MeshSegmentAlgorithm
 {
 public:
     MeshSegmentAlgorithm(const MeshKernel& kernel) : myKernel(kernel) {}
+    /** Searches the segments of each surface type in the given order. A facet that
+     * belongs to a segment of one type is not considered by the following types.
+     */
     void FindSegments(std::vector<MeshSurfaceSegment*>&);
 
+private:
+    /// Grows the segments facet by facet, starting from each facet not visited yet
+    void GrowSegments(MeshSurfaceSegment&, std::vector<unsigned long>& resetVisited);
+    /// Same result as GrowSegments() for stateless surface types, but the facets are
+    /// tested and joined by several threads
+    void JoinSegments(MeshSurfaceSegment&, std::vector<unsigned long>& resetVisited);
+
 private:
     const MeshKernel& myKernel;
 };
@@ -46,6 +46,12 @@
 #include <Base/Builder3D.h>
 #include <Base/Tools2D.h>
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+
 using namespace Base;
 using namespace MeshCore;
 
@@ -178,6 +184,7 @@ void SetOperations::Cut (std::set<unsigned long>& facetsCuttingEdge0, std::set<u
   unsigned long ctGx1, ctGy1, ctGz1;
   grid1.GetCtGrids(ctGx1, ctGy1, ctGz1);
 
+  std::vector<unsigned long> cells;
   unsigned long gx1;
   for (gx1 = 0; gx1 < ctGx1; gx1++)  
   {
@@ -188,227 +195,175 @@ void SetOperations::Cut (std::set<unsigned long>& facetsCuttingEdge0, std::set<u
       for (gz1 = 0; gz1 < ctGz1; gz1++)
       {
         if (grid1.GetCtElements(gx1, gy1, gz1) > 0)
-        {
-          std::vector<unsigned long> vecFacets2;
-          grid2.Inside(grid1.GetBoundBox(gx1, gy1, gz1), vecFacets2);
-      
-          if (vecFacets2.size() > 0)
-          {
-            std::set<unsigned long> vecFacets1;
-            grid1.GetElements(gx1, gy1, gz1, vecFacets1);
-            
-            std::set<unsigned long>::iterator it1;
-            for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
-            {
-              unsigned long fidx1 = *it1;
-              MeshGeomFacet f1 = _cutMesh0.GetFacet(*it1);
-              
-              std::vector<unsigned long>::iterator it2;
-              for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
-              {
-                unsigned long fidx2 = *it2;
-                MeshGeomFacet f2 = _cutMesh1.GetFacet(fidx2);
-
-                MeshPoint p0, p1;
-
-                int isect = f1.IntersectWithFacet(f2, p0, p1);
-                if (isect > 0)
-                { 
-                   // optimize cut line if distance to nearest point is too small
-                  float minDist1 = _minDistanceToPoint, minDist2 = _minDistanceToPoint;
-                  MeshPoint np0 = p0, np1 = p1;
-                  int i;
-                  for (i = 0; i < 3; i++)
-                  {
-                    float d1 = (f1._aclPoints[i] - p0).Length();
-                    float d2 = (f1._aclPoints[i] - p1).Length();
-                    if (d1 < minDist1)
-                    {
-                      minDist1 = d1;
-                      np0 = f1._aclPoints[i];
-                    }
-                    if (d2 < minDist2)
-                    {
-                      minDist2 = d2;
-                      p1 = f1._aclPoints[i];
-                    }
-                  } // for (int i = 0; i < 3; i++)
-
-                  // optimize cut line if distance to nearest point is too small
-                  for (i = 0; i < 3; i++)
-                  {
-                    float d1 = (f2._aclPoints[i] - p0).Length();
-                    float d2 = (f2._aclPoints[i] - p1).Length();
-                    if (d1 < minDist1)
-                    {
-                      minDist1 = d1;
-                      np0 = f2._aclPoints[i];
-                    }
-                    if (d2 < minDist2)
-                    {
-                      minDist2 = d2;
-                      np1 = f2._aclPoints[i];
-                    }
-                  } // for (int i = 0; i < 3; i++)
-
-                  MeshPoint mp0 = np0;
-                  MeshPoint mp1 = np1;
-
-                  if (mp0 != mp1)
-                  {
-                    facetsCuttingEdge0.insert(fidx1);
-                    facetsCuttingEdge1.insert(fidx2);
-
-                    _cutPoints.insert(mp0);
-                    _cutPoints.insert(mp1);
-
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit0 = _cutPoints.insert(mp0);
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit1 = _cutPoints.insert(mp1);
-
-                    _edges[Edge(mp0, mp1)] = EdgeInfo();
-
-                    _facet2points[0][fidx1].push_back(pit0.first);
-                    _facet2points[0][fidx1].push_back(pit1.first);
-                    _facet2points[1][fidx2].push_back(pit0.first);
-                    _facet2points[1][fidx2].push_back(pit1.first);
-
-                  }
-                  else
-                  {
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit = _cutPoints.insert(mp0);
-
-                    // do not insert a facet when only one corner point cuts the edge
-                    // if (!((mp0 == f1._aclPoints[0]) || (mp0 == f1._aclPoints[1]) || (mp0 == f1._aclPoints[2])))
-                    {
-                      facetsCuttingEdge0.insert(fidx1);
-                      _facet2points[0][fidx1].push_back(pit.first);
-                    }
-
-                    // if (!((mp0 == f2._aclPoints[0]) || (mp0 == f2._aclPoints[1]) || (mp0 == f2._aclPoints[2])))
-                    {
-                      facetsCuttingEdge1.insert(fidx2);
-                      _facet2points[1][fidx2].push_back(pit.first);
-                    }
-                  }
-
-                 } // if (f1.IntersectWithFacet(f2, p0, p1))
-              } // for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
-            } // for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
-          } // if (vecFacets2.size() > 0)
-        } // if (grid1.GetCtElements(gx1, gy1, gz1) > 0)
-      } // for (gz1 = 0; gz1 < ctGz1; gz1++)
-    } // for (gy1 = 0; gy1 < ctGy1; gy1++)
-  } // for (gx1 = 0; gx1 < ctGx1; gx1++)  
-}
-
-void SetOperations::TriangulateMesh (const MeshKernel &cutMesh, int side)
-{
-  // Triangulate Mesh 
-  std::map<unsigned long, std::list<std::set<MeshPoint>::iterator> >::iterator it1;
-  for (it1 = _facet2points[side].begin(); it1 != _facet2points[side].end(); it1++)
-  {
-    std::vector<Vector3f> points;
-    std::set<MeshPoint>   pointsSet;
-
-    unsigned long fidx = it1->first;
-    MeshGeomFacet f = cutMesh.GetFacet(fidx);
+          cells.push_back((gx1 * ctGy1 + gy1) * ctGz1 + gz1);
+      }
+    }
+  }
 
-    //if (side == 1)
-    //    _builder.addSingleTriangle(f._aclPoints[0], f._aclPoints[1], f._aclPoints[2], 3, 0, 1, 1);
+  // intersect the facets of all cells in parallel
+  QFuture<std::vector<CutSegment> > future = QtConcurrent::mapped
+    (cells, boost::bind(&SetOperations::CutCell, this, boost::cref(grid1), boost::cref(grid2), _1));
+  QFutureWatcher<std::vector<CutSegment> > watcher;
+  watcher.setFuture(future);
+  watcher.waitForFinished();
 
-     // facet corner points
-    //const MeshFacet& mf = cutMesh._aclFacetArray[fidx];
-    int i;
-    for (i = 0; i < 3; i++)
-    {
-      pointsSet.insert(f._aclPoints[i]);
-      points.push_back(f._aclPoints[i]);
-    }
-    
-    // triangulated facets
-    std::list<std::set<MeshPoint>::iterator>::iterator it2;
-    for (it2 = it1->second.begin(); it2 != it1->second.end(); it2++)
+  // collect the cut lines in the order of the cells, so the result doesn't depend on the scheduling
+  for (QFuture<std::vector<CutSegment> >::const_iterator it = future.begin(); it != future.end(); ++it)
+  {
+    for (std::vector<CutSegment>::const_iterator jt = it->begin(); jt != it->end(); ++jt)
     {
-      if (pointsSet.find(*(*it2)) == pointsSet.end())
+      unsigned long fidx1 = jt->facet0;
+      unsigned long fidx2 = jt->facet1;
+      const MeshPoint& mp0 = jt->pt0;
+      const MeshPoint& mp1 = jt->pt1;
+
+      if (mp0 != mp1)
       {
-        pointsSet.insert(*(*it2));
-        points.push_back(*(*it2));
-      }
+        facetsCuttingEdge0.insert(fidx1);
+        facetsCuttingEdge1.insert(fidx2);
 
-    }
+        _cutPoints.insert(mp0);
+        _cutPoints.insert(mp1);
 
-    Vector3f normal = f.GetNormal();
-    Vector3f base = points[0];
-    Vector3f dirX = points[1] - points[0];
-    dirX.Normalize();
-    Vector3f dirY = dirX % normal;
+        std::pair<std::set<MeshPoint>::iterator, bool> pit0 = _cutPoints.insert(mp0);
+        std::pair<std::set<MeshPoint>::iterator, bool> pit1 = _cutPoints.insert(mp1);
 
-    // project points to 2D plane
-    std::vector<Vector3f>::iterator it;
-    std::vector<Vector3f> vertices;
-    for (it = points.begin(); it != points.end(); it++)
-    {
-      Vector3f pv = *it;
-      pv.TransformToCoordinateSystem(base, dirX, dirY);
-      vertices.push_back(pv);
-    }
+        _edges[Edge(mp0, mp1)] = EdgeInfo();
 
-    DelaunayTriangulator tria;
-    tria.SetPolygon(vertices);
-    tria.TriangulatePolygon();
+        _facet2points[0][fidx1].push_back(pit0.first);
+        _facet2points[0][fidx1].push_back(pit1.first);
+        _facet2points[1][fidx2].push_back(pit0.first);
+        _facet2points[1][fidx2].push_back(pit1.first);
 
-    std::vector<MeshFacet> facets = tria.GetFacets();
-    for (std::vector<MeshFacet>::iterator it = facets.begin(); it != facets.end(); ++it)
-    {
-      if ((it->_aulPoints[0] == it->_aulPoints[1]) ||
-          (it->_aulPoints[1] == it->_aulPoints[2]) ||
-          (it->_aulPoints[2] == it->_aulPoints[0]))
-      { // two same triangle corner points
-        continue;
       }
-  
-      MeshGeomFacet facet(points[it->_aulPoints[0]],
-                          points[it->_aulPoints[1]],
-                          points[it->_aulPoints[2]]);
-
-      //if (side == 1)
-      // _builder.addSingleTriangle(facet._aclPoints[0], facet._aclPoints[1], facet._aclPoints[2], true, 3, 0, 1, 1);
-
-      //if (facet.Area() < 0.0001f)
-      //{ // too small facet
-      //  continue;
-      //}
-
-      float dist0 = facet._aclPoints[0].DistanceToLine
-          (facet._aclPoints[1],facet._aclPoints[1] - facet._aclPoints[2]);
-      float dist1 = facet._aclPoints[1].DistanceToLine
-          (facet._aclPoints[0],facet._aclPoints[0] - facet._aclPoints[2]);
-      float dist2 = facet._aclPoints[2].DistanceToLine
-          (facet._aclPoints[0],facet._aclPoints[0] - facet._aclPoints[1]);
-
-      if ((dist0 < _minDistanceToPoint) ||
-          (dist1 < _minDistanceToPoint) ||
-          (dist2 < _minDistanceToPoint))
+      else
       {
-        continue;
+        std::pair<std::set<MeshPoint>::iterator, bool> pit = _cutPoints.insert(mp0);
+
+        // do not insert a facet when only one corner point cuts the edge
+        // if (!((mp0 == f1._aclPoints[0]) || (mp0 == f1._aclPoints[1]) || (mp0 == f1._aclPoints[2])))
+        {
+          facetsCuttingEdge0.insert(fidx1);
+          _facet2points[0][fidx1].push_back(pit.first);
+        }
+
+        // if (!((mp0 == f2._aclPoints[0]) || (mp0 == f2._aclPoints[1]) || (mp0 == f2._aclPoints[2])))
+        {
+          facetsCuttingEdge1.insert(fidx2);
+          _facet2points[1][fidx2].push_back(pit.first);
+        }
       }
+    }
+  }
+}
+
+std::vector<SetOperations::CutSegment> SetOperations::CutCell (const MeshFacetGrid& grid1, const MeshFacetGrid& grid2, unsigned long cell) const
+{
+  std::vector<CutSegment> segments;
 
-      //dist0 = (facet._aclPoints[0] - facet._aclPoints[1]).Length();
-      //dist1 = (facet._aclPoints[1] - facet._aclPoints[2]).Length();
-      //dist2 = (facet._aclPoints[2] - facet._aclPoints[3]).Length();
+  unsigned long ctGx1, ctGy1, ctGz1;
+  grid1.GetCtGrids(ctGx1, ctGy1, ctGz1);
+  unsigned long gz1 = cell % ctGz1;
+  unsigned long gy1 = (cell / ctGz1) % ctGy1;
+  unsigned long gx1 = cell / (ctGz1 * ctGy1);
 
-      //if ((dist0 < _minDistanceToPoint) || (dist1 < _minDistanceToPoint) || (dist2 < _minDistanceToPoint))
-      //{
-      //  continue;
-      //}
+  std::vector<unsigned long> vecFacets2;
+  grid2.Inside(grid1.GetBoundBox(gx1, gy1, gz1), vecFacets2);
 
-      facet.CalcNormal();
-      if ((facet.GetNormal() * f.GetNormal()) < 0.0f)
-      { // adjust normal
-         std::swap(facet._aclPoints[0], facet._aclPoints[1]);
-         facet.CalcNormal();
-      }
+  if (vecFacets2.size() > 0)
+  {
+    std::set<unsigned long> vecFacets1;
+    grid1.GetElements(gx1, gy1, gz1, vecFacets1);
+    
+    std::set<unsigned long>::iterator it1;
+    for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
+    {
+      unsigned long fidx1 = *it1;
+      MeshGeomFacet f1 = _cutMesh0.GetFacet(*it1);
+      
+      std::vector<unsigned long>::iterator it2;
+      for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
+      {
+        unsigned long fidx2 = *it2;
+        MeshGeomFacet f2 = _cutMesh1.GetFacet(fidx2);
+
+        MeshPoint p0, p1;
+
+        int isect = f1.IntersectWithFacet(f2, p0, p1);
+        if (isect > 0)
+        { 
+           // optimize cut line if distance to nearest point is too small
+          float minDist1 = _minDistanceToPoint, minDist2 = _minDistanceToPoint;
+          MeshPoint np0 = p0, np1 = p1;
+          int i;
+          for (i = 0; i < 3; i++)
+          {
+            float d1 = (f1._aclPoints[i] - p0).Length();
+            float d2 = (f1._aclPoints[i] - p1).Length();
+            if (d1 < minDist1)
+            {
+              minDist1 = d1;
+              np0 = f1._aclPoints[i];
+            }
+            if (d2 < minDist2)
+            {
+              minDist2 = d2;
+              p1 = f1._aclPoints[i];
+            }
+          } // for (int i = 0; i < 3; i++)
+
+          // optimize cut line if distance to nearest point is too small
+          for (i = 0; i < 3; i++)
+          {
+            float d1 = (f2._aclPoints[i] - p0).Length();
+            float d2 = (f2._aclPoints[i] - p1).Length();
+            if (d1 < minDist1)
+            {
+              minDist1 = d1;
+              np0 = f2._aclPoints[i];
+            }
+            if (d2 < minDist2)
+            {
+              minDist2 = d2;
+              np1 = f2._aclPoints[i];
+            }
+          } // for (int i = 0; i < 3; i++)
+
+          CutSegment segment;
+          segment.facet0 = fidx1;
+          segment.facet1 = fidx2;
+          segment.pt0 = np0;
+          segment.pt1 = np1;
+          segments.push_back(segment);
+        } // if (f1.IntersectWithFacet(f2, p0, p1))
+      } // for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
+    } // for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
+  } // if (vecFacets2.size() > 0)
+
+  return segments;
+}
 
+void SetOperations::TriangulateMesh (const MeshKernel &cutMesh, int side)
+{
+  // Triangulate the cutted facets in parallel
+  std::vector<FacetPoints::const_iterator> cutFacets;
+  for (FacetPoints::const_iterator it1 = _facet2points[side].begin(); it1 != _facet2points[side].end(); it1++)
+    cutFacets.push_back(it1);
+
+  QFuture<std::vector<MeshGeomFacet> > future = QtConcurrent::mapped
+    (cutFacets, boost::bind(&SetOperations::TriangulateFacet, this, boost::cref(cutMesh), _1));
+  QFutureWatcher<std::vector<MeshGeomFacet> > watcher;
+  watcher.setFuture(future);
+  watcher.waitForFinished();
+
+  // assign the new facets to the cut edges in the order of the facet indices
+  std::vector<FacetPoints::const_iterator>::iterator it1 = cutFacets.begin();
+  for (QFuture<std::vector<MeshGeomFacet> >::const_iterator it = future.begin(); it != future.end(); ++it, ++it1)
+  {
+    unsigned long fidx = (*it1)->first;
+    for (std::vector<MeshGeomFacet>::const_iterator jt = it->begin(); jt != it->end(); ++jt)
+    {
+      MeshGeomFacet facet = *jt;
 
       int j;
       for (j = 0; j < 3; j++)
@@ -433,9 +388,119 @@ void SetOperations::TriangulateMesh (const MeshKernel &cutMesh, int side)
       }
 
       _newMeshFacets[side].push_back(facet);
+    }
+  }
+}
+
+std::vector<MeshGeomFacet> SetOperations::TriangulateFacet (const MeshKernel &cutMesh, FacetPoints::const_iterator it) const
+{
+  std::vector<MeshGeomFacet> newFacets;
+  std::vector<Vector3f> points;
+  std::set<MeshPoint>   pointsSet;
+
+  MeshGeomFacet f = cutMesh.GetFacet(it->first);
+
+  //if (side == 1)
+  //    _builder.addSingleTriangle(f._aclPoints[0], f._aclPoints[1], f._aclPoints[2], 3, 0, 1, 1);
+
+   // facet corner points
+  //const MeshFacet& mf = cutMesh._aclFacetArray[fidx];
+  int i;
+  for (i = 0; i < 3; i++)
+  {
+    pointsSet.insert(f._aclPoints[i]);
+    points.push_back(f._aclPoints[i]);
+  }
+  
+  // triangulated facets
+  std::list<std::set<MeshPoint>::iterator>::const_iterator it2;
+  for (it2 = it->second.begin(); it2 != it->second.end(); it2++)
+  {
+    if (pointsSet.find(*(*it2)) == pointsSet.end())
+    {
+      pointsSet.insert(*(*it2));
+      points.push_back(*(*it2));
+    }
+
+  }
+
+  Vector3f normal = f.GetNormal();
+  Vector3f base = points[0];
+  Vector3f dirX = points[1] - points[0];
+  dirX.Normalize();
+  Vector3f dirY = dirX % normal;
+
+  // project points to 2D plane
+  std::vector<Vector3f>::iterator jt;
+  std::vector<Vector3f> vertices;
+  for (jt = points.begin(); jt != points.end(); jt++)
+  {
+    Vector3f pv = *jt;
+    pv.TransformToCoordinateSystem(base, dirX, dirY);
+    vertices.push_back(pv);
+  }
+
+  DelaunayTriangulator tria;
+  tria.SetPolygon(vertices);
+  tria.TriangulatePolygon();
+
+  std::vector<MeshFacet> facets = tria.GetFacets();
+  for (std::vector<MeshFacet>::iterator ft = facets.begin(); ft != facets.end(); ++ft)
+  {
+    if ((ft->_aulPoints[0] == ft->_aulPoints[1]) ||
+        (ft->_aulPoints[1] == ft->_aulPoints[2]) ||
+        (ft->_aulPoints[2] == ft->_aulPoints[0]))
+    { // two same triangle corner points
+      continue;
+    }
+
+    MeshGeomFacet facet(points[ft->_aulPoints[0]],
+                        points[ft->_aulPoints[1]],
+                        points[ft->_aulPoints[2]]);
+
+    //if (side == 1)
+    // _builder.addSingleTriangle(facet._aclPoints[0], facet._aclPoints[1], facet._aclPoints[2], true, 3, 0, 1, 1);
+
+    //if (facet.Area() < 0.0001f)
+    //{ // too small facet
+    //  continue;
+    //}
+
+    float dist0 = facet._aclPoints[0].DistanceToLine
+        (facet._aclPoints[1],facet._aclPoints[1] - facet._aclPoints[2]);
+    float dist1 = facet._aclPoints[1].DistanceToLine
+        (facet._aclPoints[0],facet._aclPoints[0] - facet._aclPoints[2]);
+    float dist2 = facet._aclPoints[2].DistanceToLine
+        (facet._aclPoints[0],facet._aclPoints[0] - facet._aclPoints[1]);
+
+    if ((dist0 < _minDistanceToPoint) ||
+        (dist1 < _minDistanceToPoint) ||
+        (dist2 < _minDistanceToPoint))
+    {
+      continue;
+    }
+
+    //dist0 = (facet._aclPoints[0] - facet._aclPoints[1]).Length();
+    //dist1 = (facet._aclPoints[1] - facet._aclPoints[2]).Length();
+    //dist2 = (facet._aclPoints[2] - facet._aclPoints[3]).Length();
+
+    //if ((dist0 < _minDistanceToPoint) || (dist1 < _minDistanceToPoint) || (dist2 < _minDistanceToPoint))
+    //{
+    //  continue;
+    //}
+
+    facet.CalcNormal();
+    if ((facet.GetNormal() * f.GetNormal()) < 0.0f)
+    { // adjust normal
+       std::swap(facet._aclPoints[0], facet._aclPoints[1]);
+       facet.CalcNormal();
+    }
+
+    newFacets.push_back(facet);
+
+  } // for (i = 0; i < (out->numberoftriangles * 3); i += 3)
 
-    } // for (i = 0; i < (out->numberoftriangles * 3); i += 3)
-  } // for (it1 = _facet2points[side].begin(); it1 != _facet2points[side].end(); it1++)
+  return newFacets;
 }
 
 void SetOperations::CollectFacets (int side, float mult)
@@ -158,12 +158,21 @@ private:
       bool AllowVisit (const MeshFacet& rclFacet, const MeshFacet& rclFrom, unsigned long ulFInd, unsigned long ulLevel, unsigned short neighbourIndex);
   };
 
+  typedef std::map<unsigned long, std::list<std::set<MeshPoint>::iterator> > FacetPoints;
+
+  /** Part of the cut line of two facets, both points are equal if the facets touch in one point only */
+  struct CutSegment
+  {
+    unsigned long     facet0, facet1;        // index of the facet of mesh 1 and mesh 2
+    MeshPoint         pt0, pt1;
+  };
+
   /** all points from cut */
   std::set<MeshPoint>       _cutPoints;
   /** all edges */
   std::map<Edge, EdgeInfo>  _edges;
   /** map from facet index to his cutted points (mesh 1 and mesh 2) Key: Facet-Index  Value: List of iterators of set<MeshPoint> */
-  std::map<unsigned long, std::list<std::set<MeshPoint>::iterator> > _facet2points[2];
+  FacetPoints               _facet2points[2];
   /** Facets collected from region growing */
   std::vector<MeshGeomFacet> _facetsOf[2];
 
@@ -171,8 +180,12 @@ private:
 
   /** Cut mesh 1 with mesh 2 */
   void Cut (std::set<unsigned long>& facetsNotCuttingEdge0, std::set<unsigned long>& facetsCuttingEdge1);
+  /** Cut the facets of mesh 1 in a cell of \a grid1 with the facets of mesh 2. This is called in parallel for all cells. */
+  std::vector<CutSegment> CutCell (const MeshFacetGrid& grid1, const MeshFacetGrid& grid2, unsigned long cell) const;
   /** Trianglute each facets cutted with his cutting points */
   void TriangulateMesh (const MeshKernel &cutMesh, int side);
+  /** Trianglute a facet cutted with his cutting points. This is called in parallel for all cutted facets. */
+  std::vector<MeshGeomFacet> TriangulateFacet (const MeshKernel &cutMesh, FacetPoints::const_iterator it) const;
   /** search facets for adding (with region growing) */
   void CollectFacets (int side, float mult);
   /** close gap in the mesh */
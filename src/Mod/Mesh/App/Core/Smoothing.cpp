@@ -23,6 +23,8 @@
 
 #include "PreCompiled.h"
 #ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
 #endif
 
 #include "Smoothing.h"
@@ -32,56 +34,155 @@
 #include "Iterator.h"
 #include "Approximation.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
 
-using namespace MeshCore;
 
+using namespace MeshCore;
 
-AbstractSmoothing::AbstractSmoothing(MeshKernel& m) : kernel(m)
+namespace MeshCore {
+
+/**
+ * The SmoothingEngine keeps everything a smoothing algorithm needs between two
+ * iterations: the points to be moved together with their neighbours, and the
+ * coordinates of all mesh points as separate x, y and z arrays.
+ * A step computes the new positions of all moved points from the old coordinates
+ * into a second buffer and copies them back afterwards (Jacobi iteration). Thus the
+ * points are independent from each other and can be handled by several threads.
+ * The mesh itself is only modified by WriteBack().
+ */
+class SmoothingEngine
 {
-}
+public:
+    typedef std::pair<unsigned long, unsigned long> IndexRange;
+
+    /** Collects the points to be moved. If \a facets is given border points are
+     * skipped. If \a subset is given only these points are taken into account.
+     */
+    SmoothingEngine (const MeshKernel& kernel, const MeshRefPointToPoints& neighbours,
+                     const MeshRefPointToFacets* facets,
+                     const std::vector<unsigned long>* subset)
+      : _neighbours(neighbours), _stepsize(0.0), _tolerance(0.0f)
+    {
+        const MeshPointArray& points = kernel.GetPoints();
+        unsigned long count = points.size();
+        _x.resize(count);
+        _y.resize(count);
+        _z.resize(count);
+        for (unsigned long i = 0; i < count; i++) {
+            _x[i] = points[i].x;
+            _y[i] = points[i].y;
+            _z[i] = points[i].z;
+        }
 
-AbstractSmoothing::~AbstractSmoothing()
-{
-}
+        if (subset) {
+            _rows = *subset;
+            std::sort(_rows.begin(), _rows.end());
+            _rows.erase(std::unique(_rows.begin(), _rows.end()), _rows.end());
+            _rows.erase(std::lower_bound(_rows.begin(), _rows.end(), count), _rows.end());
+        }
+        else {
+            _rows.resize(count);
+            for (unsigned long i = 0; i < count; i++)
+                _rows[i] = i;
+        }
 
-void AbstractSmoothing::initialize(Component comp, Continuity cont)
-{
-    this->component = comp;
-    this->continuity = cont;
-}
+        // points with less than three neighbours are never moved
+        std::vector<unsigned long>::iterator jt = _rows.begin();
+        for (std::vector<unsigned long>::iterator it = _rows.begin(); it != _rows.end(); ++it) {
+            std::size_t ulNeighbours = _neighbours[*it].size();
+            if (ulNeighbours < 3)
+                continue;
+            // do nothing for border points
+            if (facets && ulNeighbours != (*facets)[*it].size())
+                continue;
+            *jt++ = *it;
+        }
+        _rows.erase(jt, _rows.end());
+
+        _nx.resize(_rows.size());
+        _ny.resize(_rows.size());
+        _nz.resize(_rows.size());
+
+        // for small meshes the thread overhead doesn't pay off
+        unsigned long rows = _rows.size();
+        unsigned long ranges = 1;
+        if (rows >= 10000)
+            ranges = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+        unsigned long step = (rows + ranges - 1) / ranges;
+        for (unsigned long i = 0; i < rows; i += step)
+            _ranges.push_back(IndexRange(i, std::min<unsigned long>(i + step, rows)));
+    }
 
-PlaneFitSmoothing::PlaneFitSmoothing(MeshKernel& m)
-  : AbstractSmoothing(m)
-{
-}
+    /// Moves each point by \a stepsize towards the centre of its neighbours.
+    void UmbrellaStep (double stepsize)
+    {
+        _stepsize = stepsize;
+        Run(&SmoothingEngine::Umbrella);
+        Run(&SmoothingEngine::Commit);
+    }
+    /// Moves each point towards the mean plane of its neighbourhood, by at most \a tolerance.
+    void PlaneFitStep (float tolerance)
+    {
+        _tolerance = tolerance;
+        Run(&SmoothingEngine::PlaneFit);
+        Run(&SmoothingEngine::Commit);
+    }
+    /// Sets the new coordinates of the moved points to \a kernel.
+    void WriteBack (MeshKernel& kernel) const
+    {
+        for (std::vector<unsigned long>::const_iterator it = _rows.begin(); it != _rows.end(); ++it)
+            kernel.SetPoint(*it, _x[*it], _y[*it], _z[*it]);
+    }
 
-PlaneFitSmoothing::~PlaneFitSmoothing()
-{
-}
+private:
+    void Run (void (SmoothingEngine::*func)(const IndexRange&))
+    {
+        if (_ranges.size() > 1)
+            QtConcurrent::blockingMap(_ranges, boost::bind(func, this, _1));
+        else if (!_ranges.empty())
+            (this->*func)(_ranges.front());
+    }
 
-void PlaneFitSmoothing::Smooth(unsigned int iterations)
-{
-    MeshCore::MeshPoint center;
-    MeshCore::MeshPointArray PointArray = kernel.GetPoints();
+    void Umbrella (const IndexRange& range)
+    {
+        const float* x = &_x[0];
+        const float* y = &_y[0];
+        const float* z = &_z[0];
+        for (unsigned long i = range.first; i < range.second; i++) {
+            unsigned long pos = _rows[i];
+            MeshIndexRange cv = _neighbours[pos];
+            double w = 1.0/double(cv.size());
+
+            double delx=0.0,dely=0.0,delz=0.0;
+            for (MeshIndexRange::const_iterator cv_it = cv.begin(); cv_it != cv.end(); ++cv_it) {
+                delx += w*(x[*cv_it]-x[pos]);
+                dely += w*(y[*cv_it]-y[pos]);
+                delz += w*(z[*cv_it]-z[pos]);
+            }
 
-    MeshCore::MeshPointIterator v_it(kernel);
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshPointArray::_TConstIterator v_beg = kernel.GetPoints().begin();
+            _nx[i] = (float)(x[pos]+_stepsize*delx);
+            _ny[i] = (float)(y[pos]+_stepsize*dely);
+            _nz[i] = (float)(z[pos]+_stepsize*delz);
+        }
+    }
 
-    for (unsigned int i=0; i<iterations; i++) {
+    void PlaneFit (const IndexRange& range)
+    {
         Base::Vector3f N, L;
-        for (v_it.Begin(); v_it.More(); v_it.Next()) {
+        for (unsigned long i = range.first; i < range.second; i++) {
+            unsigned long pos = _rows[i];
+            Base::Vector3f point(_x[pos], _y[pos], _z[pos]);
             MeshCore::PlaneFit pf;
-            pf.AddPoint(*v_it);
-            center = *v_it;
-            const std::set<unsigned long>& cv = vv_it[v_it.Position()];
-            if (cv.size() < 3)
-                continue;
-
-            std::set<unsigned long>::const_iterator cv_it;
-            for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-                pf.AddPoint(v_beg[*cv_it]);
-                center += v_beg[*cv_it];
+            pf.AddPoint(point);
+            Base::Vector3f center = point;
+
+            MeshIndexRange cv = _neighbours[pos];
+            for (MeshIndexRange::const_iterator cv_it = cv.begin(); cv_it != cv.end(); ++cv_it) {
+                Base::Vector3f neighbour(_x[*cv_it], _y[*cv_it], _z[*cv_it]);
+                pf.AddPoint(neighbour);
+                center += neighbour;
             }
 
             float scale = 1.0f/((float)cv.size()+1.0f);
@@ -93,77 +194,87 @@ void PlaneFitSmoothing::Smooth(unsigned int iterations)
             N.Normalize();
 
             // look in which direction we should move the vertex
-            L.Set(v_it->x - center.x, v_it->y - center.y, v_it->z - center.z);
+            L = point - center;
             if (N*L < 0.0)
                 N.Scale(-1.0, -1.0, -1.0);
 
             // maximum value to move is distance to mean plane
-            float d = std::min<float>((float)fabs(this->tolerance),(float)fabs(N*L));
+            float d = std::min<float>((float)fabs(_tolerance),(float)fabs(N*L));
             N.Scale(d,d,d);
 
-            PointArray[v_it.Position()].Set(v_it->x - N.x, v_it->y - N.y, v_it->z - N.z);
+            _nx[i] = point.x - N.x;
+            _ny[i] = point.y - N.y;
+            _nz[i] = point.z - N.z;
         }
+    }
 
-        // assign values without affecting iterators
-        unsigned long count = kernel.CountPoints();
-        for (unsigned long idx = 0; idx < count; idx++) {
-            kernel.SetPoint(idx, PointArray[idx]);
+    void Commit (const IndexRange& range)
+    {
+        for (unsigned long i = range.first; i < range.second; i++) {
+            unsigned long pos = _rows[i];
+            _x[pos] = _nx[i];
+            _y[pos] = _ny[i];
+            _z[pos] = _nz[i];
         }
     }
+
+private:
+    const MeshRefPointToPoints& _neighbours;
+    std::vector<float> _x, _y, _z;     ///< coordinates of all mesh points
+    std::vector<float> _nx, _ny, _nz;  ///< new coordinates of the moved points
+    std::vector<unsigned long> _rows;  ///< the moved points
+    std::vector<IndexRange> _ranges;
+    double _stepsize;
+    float _tolerance;
+};
+
 }
 
-void PlaneFitSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
+AbstractSmoothing::AbstractSmoothing(MeshKernel& m) : kernel(m)
 {
-    MeshCore::MeshPoint center;
-    MeshCore::MeshPointArray PointArray = kernel.GetPoints();
+}
 
-    MeshCore::MeshPointIterator v_it(kernel);
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshPointArray::_TConstIterator v_beg = kernel.GetPoints().begin();
+AbstractSmoothing::~AbstractSmoothing()
+{
+}
 
-    for (unsigned int i=0; i<iterations; i++) {
-        Base::Vector3f N, L;
-        for (std::vector<unsigned long>::const_iterator it = point_indices.begin(); it != point_indices.end(); ++it) {
-            v_it.Set(*it);
-            MeshCore::PlaneFit pf;
-            pf.AddPoint(*v_it);
-            center = *v_it;
-            const std::set<unsigned long>& cv = vv_it[v_it.Position()];
-            if (cv.size() < 3)
-                continue;
+void AbstractSmoothing::initialize(Component comp, Continuity cont)
+{
+    this->component = comp;
+    this->continuity = cont;
+}
 
-            std::set<unsigned long>::const_iterator cv_it;
-            for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-                pf.AddPoint(v_beg[*cv_it]);
-                center += v_beg[*cv_it];
-            }
+PlaneFitSmoothing::PlaneFitSmoothing(MeshKernel& m)
+  : AbstractSmoothing(m)
+{
+}
 
-            float scale = 1.0f/((float)cv.size()+1.0f);
-            center.Scale(scale,scale,scale);
+PlaneFitSmoothing::~PlaneFitSmoothing()
+{
+}
 
-            // get the mean plane of the current vertex with the surrounding vertices
-            pf.Fit();
-            N = pf.GetNormal();
-            N.Normalize();
+void PlaneFitSmoothing::Smooth(unsigned int iterations)
+{
+    MeshCore::MeshRefPointToPoints vv_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, 0, 0);
 
-            // look in which direction we should move the vertex
-            L.Set(v_it->x - center.x, v_it->y - center.y, v_it->z - center.z);
-            if (N*L < 0.0)
-                N.Scale(-1.0, -1.0, -1.0);
+    for (unsigned int i=0; i<iterations; i++) {
+        engine.PlaneFitStep(this->tolerance);
+    }
 
-            // maximum value to move is distance to mean plane
-            float d = std::min<float>((float)fabs(this->tolerance),(float)fabs(N*L));
-            N.Scale(d,d,d);
+    engine.WriteBack(kernel);
+}
 
-            PointArray[v_it.Position()].Set(v_it->x - N.x, v_it->y - N.y, v_it->z - N.z);
-        }
+void PlaneFitSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
+{
+    MeshCore::MeshRefPointToPoints vv_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, 0, &point_indices);
 
-        // assign values without affecting iterators
-        unsigned long count = kernel.CountPoints();
-        for (unsigned long idx = 0; idx < count; idx++) {
-            kernel.SetPoint(idx, PointArray[idx]);
-        }
+    for (unsigned int i=0; i<iterations; i++) {
+        engine.PlaneFitStep(this->tolerance);
     }
+
+    engine.WriteBack(kernel);
 }
 
 LaplaceSmoothing::LaplaceSmoothing(MeshKernel& m)
@@ -175,95 +286,35 @@ LaplaceSmoothing::~LaplaceSmoothing()
 {
 }
 
-void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
-                                const MeshRefPointToFacets& vf_it, double stepsize)
-{
-    const MeshCore::MeshPointArray& points = kernel.GetPoints();
-    MeshCore::MeshPointArray::_TConstIterator v_it,
-    v_beg = points.begin(), v_end = points.end();
-
-    unsigned long pos = 0;
-    for (v_it = points.begin(); v_it != v_end; ++v_it,++pos) {
-        const std::set<unsigned long>& cv = vv_it[pos];
-        if (cv.size() < 3)
-            continue;
-        if (cv.size() != vf_it[pos].size()) {
-            // do nothing for border points
-            continue;
-        }
-
-        unsigned int n_count = cv.size();
-        double w;
-        w=1.0/double(n_count);
-
-        double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
-        for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-            delx += w*((v_beg[*cv_it]).x-v_it->x);
-            dely += w*((v_beg[*cv_it]).y-v_it->y);
-            delz += w*((v_beg[*cv_it]).z-v_it->z);
-        }
-
-        float x = (float)(v_it->x+stepsize*delx);
-        float y = (float)(v_it->y+stepsize*dely);
-        float z = (float)(v_it->z+stepsize*delz);
-        kernel.SetPoint(pos,x,y,z);
-    }
-}
-
-void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
-                                const MeshRefPointToFacets& vf_it, double stepsize,
-                                const std::vector<unsigned long>& point_indices)
+void LaplaceSmoothing::Umbrella(SmoothingEngine& engine, double stepsize)
 {
-    const MeshCore::MeshPointArray& points = kernel.GetPoints();
-    MeshCore::MeshPointArray::_TConstIterator v_beg = points.begin();
-
-    for (std::vector<unsigned long>::const_iterator pos = point_indices.begin(); pos != point_indices.end(); ++pos) {
-        const std::set<unsigned long>& cv = vv_it[*pos];
-        if (cv.size() < 3)
-            continue;
-        if (cv.size() != vf_it[*pos].size()) {
-            // do nothing for border points
-            continue;
-        }
-
-        unsigned int n_count = cv.size();
-        double w;
-        w=1.0/double(n_count);
-
-        double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
-        for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-            delx += w*((v_beg[*cv_it]).x-(v_beg[*pos]).x);
-            dely += w*((v_beg[*cv_it]).y-(v_beg[*pos]).y);
-            delz += w*((v_beg[*cv_it]).z-(v_beg[*pos]).z);
-        }
-
-        float x = (float)((v_beg[*pos]).x+stepsize*delx);
-        float y = (float)((v_beg[*pos]).y+stepsize*dely);
-        float z = (float)((v_beg[*pos]).z+stepsize*delz);
-        kernel.SetPoint(*pos,x,y,z);
-    }
+    engine.UmbrellaStep(stepsize);
 }
 
 void LaplaceSmoothing::Smooth(unsigned int iterations)
 {
     MeshCore::MeshRefPointToPoints vv_it(kernel);
     MeshCore::MeshRefPointToFacets vf_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, &vf_it, 0);
 
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda);
+        Umbrella(engine, lambda);
     }
+
+    engine.WriteBack(kernel);
 }
 
 void LaplaceSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
 {
     MeshCore::MeshRefPointToPoints vv_it(kernel);
     MeshCore::MeshRefPointToFacets vf_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, &vf_it, &point_indices);
 
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda, point_indices);
+        Umbrella(engine, lambda);
     }
+
+    engine.WriteBack(kernel);
 }
 
 TaubinSmoothing::TaubinSmoothing(MeshKernel& m)
@@ -277,28 +328,32 @@ TaubinSmoothing::~TaubinSmoothing()
 
 void TaubinSmoothing::Smooth(unsigned int iterations)
 {
-    MeshCore::MeshPointArray::_TConstIterator v_it;
     MeshCore::MeshRefPointToPoints vv_it(kernel);
     MeshCore::MeshRefPointToFacets vf_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, &vf_it, 0);
 
     // Theoretically Taubin does not shrink the surface
     iterations = (iterations+1)/2; // two steps per iteration
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda);
-        Umbrella(vv_it, vf_it, -(lambda+micro));
+        Umbrella(engine, lambda);
+        Umbrella(engine, -(lambda+micro));
     }
+
+    engine.WriteBack(kernel);
 }
 
 void TaubinSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
 {
-    MeshCore::MeshPointArray::_TConstIterator v_it;
     MeshCore::MeshRefPointToPoints vv_it(kernel);
     MeshCore::MeshRefPointToFacets vf_it(kernel);
+    SmoothingEngine engine(kernel, vv_it, &vf_it, &point_indices);
 
     // Theoretically Taubin does not shrink the surface
     iterations = (iterations+1)/2; // two steps per iteration
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda, point_indices);
-        Umbrella(vv_it, vf_it, -(lambda+micro), point_indices);
+        Umbrella(engine, lambda);
+        Umbrella(engine, -(lambda+micro));
     }
+
+    engine.WriteBack(kernel);
 }
@@ -31,6 +31,7 @@ namespace MeshCore
 class MeshKernel;
 class MeshRefPointToPoints;
 class MeshRefPointToFacets;
+class SmoothingEngine;
 
 /** Base class for smoothing algorithms. */
 class MeshExport AbstractSmoothing
@@ -83,11 +84,8 @@ public:
     void SetLambda(double l) { lambda = l;}
 
 protected:
-    void Umbrella(const MeshRefPointToPoints&,
-                  const MeshRefPointToFacets&, double);
-    void Umbrella(const MeshRefPointToPoints&,
-                  const MeshRefPointToFacets&, double,
-                  const std::vector<unsigned long>&);
+    /// Moves the points of \a engine by \a stepsize towards the centre of their neighbours.
+    void Umbrella(SmoothingEngine&, double);
 
 protected:
     double lambda;
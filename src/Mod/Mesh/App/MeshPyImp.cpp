@@ -27,6 +27,7 @@
 #include <Base/Handle.h>
 #include <Base/Builder3D.h>
 #include <Base/GeometryPyCXX.h>
+#include <Base/PyBuffer.h>
 
 #include "Mesh.h"
 #include "MeshPy.h"
@@ -39,6 +40,7 @@
 #include "Core/Iterator.h"
 #include "Core/Degeneration.h"
 #include "Core/Elements.h"
+#include "Core/FacetTree.h"
 #include "Core/Grid.h"
 #include "Core/MeshKernel.h"
 #include "Core/Segmentation.h"
@@ -819,6 +821,31 @@ PyObject*  MeshPy::fixSelfIntersections(PyObject *args)
     Py_Return;
 }
 
+PyObject*  MeshPy::getIntersectingFacets(PyObject *args)
+{
+    PyObject *pcObj;
+    if (!PyArg_ParseTuple(args, "O!", &(MeshPy::Type), &pcObj))
+        return NULL;
+
+    const MeshObject* mesh1 = getMeshObjectPtr();
+    const MeshObject* mesh2 = static_cast<MeshPy*>(pcObj)->getMeshObjectPtr();
+    MeshCore::MeshFacetTree tree1(mesh1->getKernel(), mesh1->getTransform());
+    MeshCore::MeshFacetTree tree2(mesh2->getKernel(), mesh2->getTransform());
+    std::vector<std::pair<unsigned long, unsigned long> > pairs;
+    tree1.SearchIntersections(tree2, pairs);
+
+    Py::List ary(pairs.size());
+    Py::List::size_type pos=0;
+    for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = pairs.begin(); it != pairs.end(); ++it) {
+        Py::Tuple pair(2);
+        pair.setItem(0, Py::Long(it->first));
+        pair.setItem(1, Py::Long(it->second));
+        ary[pos++] = pair;
+    }
+
+    return Py::new_reference_to(ary);
+}
+
 PyObject*  MeshPy::removeFoldsOnSurface(PyObject *args)
 {
     if (!PyArg_ParseTuple(args, ""))
@@ -1537,6 +1564,151 @@ PyObject*  MeshPy::getSegmentsByCurvature(PyObject *args)
     return Py::new_reference_to(list);
 }
 
+PyObject*  MeshPy::getPointBuffer(PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+
+    const MeshObject* mesh = getMeshObjectPtr();
+    const MeshCore::MeshPointArray& points = mesh->getKernel().GetPoints();
+    Base::Matrix4D mat = mesh->getTransform();
+    bool transform = (mat != Base::Matrix4D());
+
+    std::vector<float> coords(3 * points.size());
+    float* data = coords.empty() ? 0 : &coords[0];
+    for (MeshCore::MeshPointArray::_TConstIterator it = points.begin(); it != points.end(); ++it) {
+        Base::Vector3f pnt = *it;
+        if (transform)
+            pnt = mat * pnt;
+        *data++ = pnt.x;
+        *data++ = pnt.y;
+        *data++ = pnt.z;
+    }
+
+    return Base::PyBuffer::toByteArray(coords.empty() ? 0 : &coords[0], coords.size() * sizeof(float));
+}
+
+PyObject*  MeshPy::getFacetBuffer(PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+
+    const MeshCore::MeshFacetArray& facets = getMeshObjectPtr()->getKernel().GetFacets();
+    std::vector<uint32_t> indices(3 * facets.size());
+    uint32_t* data = indices.empty() ? 0 : &indices[0];
+    for (MeshCore::MeshFacetArray::_TConstIterator it = facets.begin(); it != facets.end(); ++it) {
+        *data++ = (uint32_t)it->_aulPoints[0];
+        *data++ = (uint32_t)it->_aulPoints[1];
+        *data++ = (uint32_t)it->_aulPoints[2];
+    }
+
+    return Base::PyBuffer::toByteArray(indices.empty() ? 0 : &indices[0], indices.size() * sizeof(uint32_t));
+}
+
+PyObject*  MeshPy::getNormalBuffer(PyObject *args)
+{
+    PyObject* points = Py_False;
+    if (!PyArg_ParseTuple(args, "|O!", &PyBool_Type, &points))
+        return NULL;
+
+    const MeshObject* mesh = getMeshObjectPtr();
+    const MeshCore::MeshKernel& kernel = mesh->getKernel();
+    std::vector<Base::Vector3f> normals;
+    if (PyObject_IsTrue(points)) {
+        normals = kernel.CalcVertexNormals();
+    }
+    else {
+        unsigned long ctFacets = kernel.CountFacets();
+        normals.reserve(ctFacets);
+        for (unsigned long i = 0; i < ctFacets; i++)
+            normals.push_back(kernel.GetFacet(i).GetNormal());
+    }
+
+    // only the rotation part of the placement applies to normals
+    Base::Matrix4D mat = mesh->getTransform();
+    mat[0][3] = 0.0;
+    mat[1][3] = 0.0;
+    mat[2][3] = 0.0;
+    bool transform = (mat != Base::Matrix4D());
+
+    std::vector<float> coords(3 * normals.size());
+    float* data = coords.empty() ? 0 : &coords[0];
+    for (std::vector<Base::Vector3f>::iterator it = normals.begin(); it != normals.end(); ++it) {
+        if (transform) {
+            *it = mat * (*it);
+            it->Normalize();
+        }
+        *data++ = it->x;
+        *data++ = it->y;
+        *data++ = it->z;
+    }
+
+    return Base::PyBuffer::toByteArray(coords.empty() ? 0 : &coords[0], coords.size() * sizeof(float));
+}
+
+PyObject*  MeshPy::setFromBuffers(PyObject *args)
+{
+    PyObject *pts, *fts;
+    if (!PyArg_ParseTuple(args, "OO", &pts, &fts))
+        return NULL;
+
+    try {
+        Base::PyBuffer pointBuffer(pts, "fd");
+        Base::PyBuffer facetBuffer(fts, "I");
+        if (pointBuffer.count() % 3 != 0 || facetBuffer.count() % 3 != 0) {
+            PyErr_SetString(PyExc_ValueError, "Number of coordinates and indices must be a multiple of three");
+            return NULL;
+        }
+
+        unsigned long ctPoints = pointBuffer.count() / 3;
+        MeshCore::MeshPointArray points(ctPoints);
+        if (pointBuffer.format() == 'f') {
+            const float* data = static_cast<const float*>(pointBuffer.data());
+            for (unsigned long i = 0; i < ctPoints; i++, data += 3)
+                points[i].Set(data[0], data[1], data[2]);
+        }
+        else {
+            const double* data = static_cast<const double*>(pointBuffer.data());
+            for (unsigned long i = 0; i < ctPoints; i++, data += 3)
+                points[i].Set((float)data[0], (float)data[1], (float)data[2]);
+        }
+
+        unsigned long ctFacets = facetBuffer.count() / 3;
+        MeshCore::MeshFacetArray facets(ctFacets);
+        const uint32_t* data = static_cast<const uint32_t*>(facetBuffer.data());
+        for (unsigned long i = 0; i < ctFacets; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (*data >= ctPoints) {
+                    PyErr_SetString(PyExc_IndexError, "Point index out of range");
+                    return NULL;
+                }
+                facets[i]._aulPoints[j] = *data++;
+            }
+        }
+
+        // the points are given in global coordinates
+        MeshObject* mesh = getMeshObjectPtr();
+        Base::Matrix4D mat = mesh->getTransform();
+        if (mat != Base::Matrix4D()) {
+            mat.inverseGauss();
+            for (MeshCore::MeshPointArray::_TIterator it = points.begin(); it != points.end(); ++it) {
+                Base::Vector3f pnt = mat * (*it);
+                it->Set(pnt.x, pnt.y, pnt.z);
+            }
+        }
+
+        MeshCore::MeshKernel kernel;
+        kernel.Adopt(points, facets, true);
+        mesh->swap(kernel);
+    }
+    catch (const Base::Exception& e) {
+        PyErr_SetString(PyExc_TypeError, e.what());
+        return NULL;
+    }
+
+    Py_Return;
+}
+
 Py::Int MeshPy::getCountPoints(void) const
 {
     return Py::Int((long)getMeshObjectPtr()->countPoints());
@@ -1,7 +1,7 @@
 #   (c) Juergen Riegel (juergen.riegel@web.de) 2007      LGPL
 
 import FreeCAD, os, sys, unittest, Mesh
-import thread, time, tempfile
+import thread, time, tempfile, struct, math
 
 
 #---------------------------------------------------------------------------
@@ -161,3 +161,333 @@ class LoadMeshInThreadsCases(unittest.TestCase):
 
     def tearDown(self):
         pass
+
+
+class MeshSmoothingTestCases(unittest.TestCase):
+    # The sphere has enough points to let the smoothing run in parallel ranges.
+    # testSmoothingTime prints the time of a fixed run, so the numbers of two
+    # builds can be compared on the same machine.
+    def setUp(self):
+        self.mesh = Mesh.createSphere(10.0, 200)
+
+    def testSmoothingShrinksSphere(self):
+        count = self.mesh.CountPoints
+        self.mesh.smooth(5)
+        self.failUnless(self.mesh.CountPoints == count)
+        radius = [p.Vector.Length for p in self.mesh.Points]
+        self.failUnless(max(radius) < 10.0)
+        self.failUnless(min(radius) > 9.0)
+
+    def testSmoothingIsReproducible(self):
+        # The points are computed from the previous iteration only, so the
+        # result must not depend on how the points are split into ranges.
+        # A small sphere is smoothed in a single range. Together with seven
+        # translated copies it has enough points for parallel ranges, and
+        # its points must come out the same.
+        single = Mesh.createSphere(10.0, 50)
+        self.failUnless(single.CountPoints < 10000)
+        ranges = single.copy()
+        for i in range(7):
+            other = single.copy()
+            other.translate(30.0 * (i + 1), 0.0, 0.0)
+            ranges.addMesh(other)
+        self.failUnless(ranges.CountPoints >= 10000)
+        single.smooth(5)
+        ranges.smooth(5)
+        points = ranges.Points
+        for p in single.Points:
+            self.failUnless(p.Vector == points[p.Index].Vector)
+
+    def testSmoothingTime(self):
+        iterations = 20
+        start = time.time()
+        self.mesh.smooth(iterations)
+        seconds = time.time() - start
+        FreeCAD.Console.PrintMessage("Laplace smoothing of %d points, %d iterations: %.3f s\n"
+                                     % (self.mesh.CountPoints, iterations, seconds))
+
+    def tearDown(self):
+        pass
+
+
+class MeshBufferTestCases(unittest.TestCase):
+    def setUp(self):
+        self.mesh = Mesh.createBox(1.0, 2.0, 3.0)
+
+    def testRoundTrip(self):
+        other = Mesh.Mesh()
+        other.setFromBuffers(self.mesh.getPointBuffer(), self.mesh.getFacetBuffer())
+        self.failUnless(other.CountPoints == self.mesh.CountPoints)
+        self.failUnless(other.CountFacets == self.mesh.CountFacets)
+        self.failUnless(abs(other.Volume - 6.0) < 1e-5)
+
+    def testPointIndex(self):
+        points = bytearray(struct.pack('9f', 0, 0, 0, 1, 0, 0, 0, 1, 0))
+        # index 3 refers to a fourth point that doesn't exist
+        facets = bytearray(struct.pack('3I', 0, 1, 3))
+        other = Mesh.Mesh()
+        self.failUnlessRaises(IndexError, other.setFromBuffers, points, facets)
+        self.failUnless(other.CountFacets == 0)
+
+    def testIndexCount(self):
+        points = bytearray(struct.pack('9f', 0, 0, 0, 1, 0, 0, 0, 1, 0))
+        facets = bytearray(struct.pack('2I', 0, 1))
+        self.failUnlessRaises(ValueError, Mesh.Mesh().setFromBuffers, points, facets)
+
+    def testItemSize(self):
+        # ten bytes are no whole number of float32 values
+        facets = bytearray(struct.pack('3I', 0, 1, 2))
+        self.failUnlessRaises(TypeError, Mesh.Mesh().setFromBuffers, bytearray(10), facets)
+
+    def tearDown(self):
+        pass
+
+
+class MeshGridTestCases(unittest.TestCase):
+    # crossSections() builds a facet grid of the whole mesh and looks up the
+    # facets of each plane in it, so it covers building and querying the grid
+    def setUp(self):
+        self.mesh = Mesh.createSphere(10.0, 200)
+
+    def testCrossSections(self):
+        planes = [((0, 0, z), (0, 0, 1)) for z in range(-9, 10)]
+        sections = self.mesh.crossSections(planes, 1e-2, True)
+        self.failUnless(len(sections) == len(planes))
+        for plane, section in zip(planes, sections):
+            self.failUnless(len(section) > 0)
+            z = plane[0][2]
+            for polyline in section:
+                for v in polyline:
+                    self.failUnless(abs(v.z - z) < 1e-4)
+                    self.failUnless(abs(v.Length - 10.0) < 1e-2)
+
+    def testGridTime(self):
+        planes = [((0, 0, 0.1 * i), (0, 0, 1)) for i in range(-90, 91)]
+        start = time.time()
+        self.mesh.crossSections(planes)
+        seconds = time.time() - start
+        FreeCAD.Console.PrintMessage("Grid build and %d plane queries on %d facets: %.3f s\n"
+                                     % (len(planes), self.mesh.CountFacets, seconds))
+
+    def tearDown(self):
+        pass
+
+
+class MeshSTLTestCases(unittest.TestCase):
+    # binary STL files are read by a parallel reader, ASCII files go through
+    # MeshBuilder, both must weld the corners the same way
+    def setUp(self):
+        self.fileName = os.path.join(tempfile.gettempdir(), "MeshSTLTest")
+
+    def writeBinary(self, facets):
+        data = struct.pack("80sI", b"", len(facets))
+        for f in facets:
+            data += struct.pack("12fH", 0, 0, 1, *(f + (0,)))
+        open(self.fileName + ".stl", "wb").write(data)
+        return self.fileName + ".stl"
+
+    def writeAscii(self, facets):
+        text = "solid test\n"
+        for f in facets:
+            text += "facet normal 0 0 1\nouter loop\n"
+            for i in range(0, 9, 3):
+                text += "vertex %r %r %r\n" % f[i:i+3]
+            text += "endloop\nendfacet\n"
+        text += "endsolid test\n"
+        open(self.fileName + ".ast", "w").write(text)
+        return self.fileName + ".ast"
+
+    def testRoundTrip(self):
+        mesh = Mesh.createSphere(10.0, 100)
+        mesh.write(self.fileName + ".stl")
+        other = Mesh.Mesh(self.fileName + ".stl")
+        self.failUnless(other.CountPoints == mesh.CountPoints)
+        self.failUnless(other.CountFacets == mesh.CountFacets)
+        self.failUnless(abs(other.Volume - mesh.Volume) < 1e-3)
+
+    def testWeldAcrossCells(self):
+        # the copies of the shared edge differ by less than the tolerance but
+        # lie on both sides of the coordinate planes
+        eps = 1e-7
+        facets = [(0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0),
+                  (1.0, -eps, 0.0, 1.0, 1.0, 0.0, -eps, 1.0, 0.0)]
+        binary = Mesh.Mesh(self.writeBinary(facets))
+        ascii = Mesh.Mesh(self.writeAscii(facets))
+        self.failUnless(binary.CountFacets == 2)
+        self.failUnless(binary.CountPoints == 4)
+        self.failUnless(binary.CountPoints == ascii.CountPoints)
+        self.failUnless([p.Vector for p in binary.Points] == [p.Vector for p in ascii.Points])
+
+    def testReadTime(self):
+        mesh = Mesh.createSphere(10.0, 500)
+        mesh.write(self.fileName + ".stl")
+        start = time.time()
+        other = Mesh.Mesh(self.fileName + ".stl")
+        seconds = time.time() - start
+        FreeCAD.Console.PrintMessage("Reading binary STL with %d facets: %.3f s\n"
+                                     % (other.CountFacets, seconds))
+
+    def tearDown(self):
+        for ext in (".stl", ".ast"):
+            if os.path.exists(self.fileName + ext):
+                os.remove(self.fileName + ext)
+
+
+class MeshSetOperationsTestCases(unittest.TestCase):
+    # two spheres of radius 10 whose centers are 10 apart
+    def setUp(self):
+        self.mesh1 = Mesh.createSphere(10.0, 100)
+        self.mesh2 = Mesh.createSphere(10.0, 100)
+        self.mesh2.translate(10.0, 0.0, 0.0)
+
+    def testVolumes(self):
+        union = self.mesh1.unite(self.mesh2)
+        inter = self.mesh1.intersect(self.mesh2)
+        diff = self.mesh1.difference(self.mesh2)
+        volume1 = self.mesh1.Volume
+        volume2 = self.mesh2.Volume
+        # the volume of the lens of two spheres with radius r and distance d
+        # is pi*(4r+d)*(2r-d)^2/12
+        lens = math.pi * 50.0 * 100.0 / 12.0
+        self.failUnless(abs(inter.Volume - lens) < 0.01 * lens)
+        self.failUnless(abs(union.Volume + inter.Volume - volume1 - volume2) < 0.01 * volume1)
+        self.failUnless(abs(diff.Volume + inter.Volume - volume1) < 0.01 * volume1)
+
+    def testSetOperationsTime(self):
+        mesh1 = Mesh.createSphere(10.0, 300)
+        mesh2 = Mesh.createSphere(10.0, 300)
+        mesh2.translate(10.0, 0.0, 0.0)
+        for name in ("unite", "intersect", "difference"):
+            start = time.time()
+            getattr(mesh1, name)(mesh2)
+            seconds = time.time() - start
+            FreeCAD.Console.PrintMessage("Mesh %s of two spheres with %d facets: %.3f s\n"
+                                         % (name, mesh1.CountFacets, seconds))
+
+    def tearDown(self):
+        pass
+
+
+class MeshRegistrationTestCases(unittest.TestCase):
+    # The source points are the points of a sphere moved by a known placement.
+    # The sampled points break the symmetry of the sphere, so the rotation can
+    # be recovered as long as it moves the points by less than their distance.
+    def setUp(self):
+        self.mesh = Mesh.createSphere(10.0, 30)
+        self.target = [p.Vector for p in self.mesh.Points]
+        self.placement = FreeCAD.Placement(FreeCAD.Vector(0.2, -0.1, 0.15),
+                                           FreeCAD.Rotation(FreeCAD.Vector(1, 2, 3), 3.0))
+
+    def checkPlacement(self, source, target, placement):
+        # the placement moves the source points onto the target points
+        for s, t in zip(source, target):
+            self.failUnless((placement.multVec(s) - t).Length < 1e-4)
+
+    def testPointsTarget(self):
+        source = [self.placement.multVec(v) for v in self.target]
+        placement, error = Mesh.registerPoints(source, self.target)
+        self.failUnless(error < 1e-4)
+        self.checkPlacement(source, self.target, placement)
+
+    def testMeshTarget(self):
+        source = [self.placement.multVec(v) for v in self.target]
+        placement, error = Mesh.registerPoints(source, self.mesh)
+        self.failUnless(error < 1e-4)
+        self.checkPlacement(source, self.target, placement)
+        # it is the inverse of the placement that moved the points
+        inverse = self.placement.inverse()
+        self.failUnless((placement.Base - inverse.Base).Length < 1e-4)
+        for axis in (FreeCAD.Vector(1, 0, 0), FreeCAD.Vector(0, 1, 0), FreeCAD.Vector(0, 0, 1)):
+            self.failUnless((placement.Rotation.multVec(self.placement.Rotation.multVec(axis)) - axis).Length < 1e-4)
+
+    def testRegistrationTime(self):
+        mesh = Mesh.createSphere(10.0, 500)
+        target = [p.Vector for p in mesh.Points]
+        placement = FreeCAD.Placement(FreeCAD.Vector(0.02, -0.01, 0.015),
+                                      FreeCAD.Rotation(FreeCAD.Vector(1, 2, 3), 0.1))
+        source = [placement.multVec(v) for v in target]
+        start = time.time()
+        result, error = Mesh.registerPoints(source, mesh)
+        seconds = time.time() - start
+        FreeCAD.Console.PrintMessage("Registration of %d points: %.3f s\n" % (len(source), seconds))
+        self.checkPlacement(source, target, result)
+
+    def tearDown(self):
+        pass
+
+
+class MeshIntersectionTestCases(unittest.TestCase):
+    def setUp(self):
+        self.mesh1 = Mesh.createSphere(10.0, 16)
+        self.mesh2 = Mesh.createSphere(10.0, 16)
+        self.mesh2.translate(7.3, 1.1, 0.7)
+
+    def bruteForce(self):
+        # tests all pairs of facets whose bounding boxes overlap
+        def bounds(facet):
+            return [(min(p[i] for p in facet.Points), max(p[i] for p in facet.Points)) for i in range(3)]
+        facets1 = [(f, bounds(f)) for f in self.mesh1.Facets]
+        facets2 = [(f, bounds(f)) for f in self.mesh2.Facets]
+        pairs = []
+        for f1, b1 in facets1:
+            for f2, b2 in facets2:
+                if all(b1[i][0] <= b2[i][1] and b2[i][0] <= b1[i][1] for i in range(3)):
+                    if len(f1.intersect(f2)) == 2:
+                        pairs.append((f1.Index, f2.Index))
+        return sorted(pairs)
+
+    def testIntersectingFacets(self):
+        pairs = sorted(self.mesh1.getIntersectingFacets(self.mesh2))
+        self.failUnless(len(pairs) > 0)
+        self.failUnless(pairs == self.bruteForce())
+
+    def testNoIntersection(self):
+        self.mesh2.translate(20.0, 0.0, 0.0)
+        self.failUnless(self.mesh1.getIntersectingFacets(self.mesh2) == [])
+
+    def tearDown(self):
+        pass
+
+
+class MeshSegmentationTestCases(unittest.TestCase):
+    # On a torus the curvature along the tube is constant, the one around the
+    # axis changes sign from the outer to the inner side.
+    def setUp(self):
+        self.types = [(0.33, 0.07, 0.05, 0.02, 10), (0.33, -0.07, 0.05, 0.02, 10),
+                      (0.33, 0.0, 0.05, 0.02, 10)]
+
+    def testSegmentsAreReproducible(self):
+        # The curvature segments don't depend on the growth order, so splitting
+        # the facets into ranges must not change them. A small torus is
+        # segmented in a single range. Together with seven translated copies it
+        # has enough facets for parallel ranges, and the segments of its facets
+        # must come out the same.
+        single = Mesh.createTorus(10.0, 3.0, 60)
+        count = single.CountFacets
+        self.failUnless(count < 10000)
+        ranges = single.copy()
+        for i in range(7):
+            other = single.copy()
+            other.translate(30.0 * (i + 1), 0.0, 0.0)
+            ranges.addMesh(other)
+        self.failUnless(ranges.CountFacets >= 10000)
+
+        segments = single.getSegmentsByCurvature(self.types)
+        self.failUnless(len(segments) > 0)
+        parallel = ranges.getSegmentsByCurvature(self.types)
+        self.failUnless([s for s in parallel if s[0] < count] == segments)
+
+        # no facet is in two segments
+        facets = [f for s in parallel for f in s]
+        self.failUnless(len(facets) == len(set(facets)))
+
+    def testSegmentationTime(self):
+        mesh = Mesh.createTorus(10.0, 3.0, 500)
+        start = time.time()
+        segments = mesh.getSegmentsByCurvature(self.types)
+        seconds = time.time() - start
+        FreeCAD.Console.PrintMessage("Curvature segmentation of %d facets into %d segments: %.3f s\n"
+                                     % (mesh.CountFacets, len(segments), seconds))
+
+    def tearDown(self):
+        pass
@@ -47,6 +47,10 @@ public:
     /// recalculate the Feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderBox";
@@ -39,6 +39,7 @@
 # include <gp_Pln.hxx> // for Precision::Confusion()
 # include <Bnd_Box.hxx>
 # include <BRepBndLib.hxx>
+# include <Standard.hxx>
 #endif
 
 
@@ -95,6 +96,11 @@ App::DocumentObjectExecReturn *Feature::execute(void)
     return App::DocumentObject::StdReturn;
 }
 
+void Feature::onBeforeExecuteThreaded()
+{
+    Standard::SetReentrant(Standard_True);
+}
+
 PyObject *Feature::getPyObject(void)
 {
     if (PythonObject.is(Py::_None())){
@@ -76,6 +76,8 @@ public:
 
 protected:
     void onChanged(const App::Property* prop);
+    /// OCC must be reentrant before shapes are built in worker threads
+    void onBeforeExecuteThreaded();
     TopLoc_Location getLocation() const;
     /**
      * Build a history of changes
@@ -117,6 +117,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderPlaneParametric";
@@ -141,6 +145,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderSphereParametric";
@@ -167,6 +175,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     //@}
     virtual const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderEllipsoid";
@@ -189,6 +201,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderCylinderParametric";
@@ -212,6 +228,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderPrism";
@@ -262,6 +282,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderConeParametric";
@@ -287,6 +311,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderTorusParametric";
@@ -313,6 +341,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderHelixParametric";
@@ -343,6 +375,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderSpiralParametric";
@@ -376,6 +412,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    /// built from its own properties only, so it may run in a worker thread
+    bool isExecuteThreadSafe(void) const {
+        return true;
+    }
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderWedge";
@@ -28,6 +28,7 @@
 # include <BRepAdaptor_Curve.hxx>
 # include <BRepAdaptor_Surface.hxx>
 # include <BRepBndLib.hxx>
+# include <BRep_Builder.hxx>
 # include <BRepBuilderAPI_GTransform.hxx>
 # include <Bnd_Box.hxx>
 # include <BRepTools.hxx>
@@ -44,13 +45,10 @@
 #endif
 
 
-#include <strstream>
 #include <Base/Console.h>
 #include <Base/Writer.h>
 #include <Base/Reader.h>
 #include <Base/Exception.h>
-#include <Base/FileInfo.h>
-#include <Base/Stream.h>
 #include <App/DocumentObject.h>
 
 #include "PropertyTopoShape.h"
@@ -255,97 +253,77 @@ void PropertyPartShape::SaveDocFile (Base::Writer &writer) const
     // can be checked when reading in the data.
     if (_Shape._Shape.IsNull())
         return;
+
     // NOTE: Cleaning the triangulation may cause problems on some algorithms like BOP
-    // Before writing to the project we clean all triangulation data to save memory
-    BRepBuilderAPI_Copy copy(_Shape._Shape);
-    const TopoDS_Shape& myShape = copy.Shape();
-    BRepTools::Clean(myShape); // remove triangulation
-
-    // create a temporary file and copy the content to the zip stream
-    // once the tmp. filename is known use always the same because otherwise
-    // we may run into some problems on the Linux platform
-    static Base::FileInfo fi(Base::FileInfo::getTempFileName());
-
-    if (!BRepTools::Write(myShape,(const Standard_CString)fi.filePath().c_str())) {
-        // Note: Do NOT throw an exception here because if the tmp. file could
-        // not be created we should not abort.
+    // Instead of cleaning the triangulation of a copy of the shape we write the
+    // shape without triangulation data directly to the zip stream. This is what
+    // BRepTools::Write() does, except for the triangulation.
+    try {
+#if OCC_VERSION_HEX >= 0x060900
+        const TopoDS_Shape& myShape = _Shape._Shape;
+        BRepTools_ShapeSet set(Standard_False);
+#else
+        // older versions always write the triangulation, so clean a copy
+        BRepBuilderAPI_Copy copy(_Shape._Shape);
+        const TopoDS_Shape& myShape = copy.Shape();
+        BRepTools::Clean(myShape); // remove triangulation
+        BRepTools_ShapeSet set;
+#endif
+        set.Add(myShape);
+        writer.Stream() << "DBRep_DrawableShape" << std::endl; // for compatibility with DRAW
+        set.Write(writer.Stream());
+        set.Write(myShape, writer.Stream());
+    }
+    catch (Standard_Failure) {
+        // Note: Do NOT throw an exception here because if the shape could not be
+        // written we should not abort.
         // We only print an error message but continue writing the next files to the
         // stream...
+        Handle_Standard_Failure e = Standard_Failure::Caught();
         App::PropertyContainer* father = this->getContainer();
         if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
             App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-            Base::Console().Error("Shape of '%s' cannot be written to BRep file '%s'\n", 
-                obj->Label.getValue(),fi.filePath().c_str());
+            Base::Console().Error("Shape of '%s' cannot be written to BRep file: %s\n", 
+                obj->Label.getValue(),e->GetMessageString());
         }
         else {
-            Base::Console().Error("Cannot save BRep file '%s'\n", fi.filePath().c_str());
+            Base::Console().Error("Cannot save BRep file: %s\n", e->GetMessageString());
         }
     }
-
-    Base::ifstream file(fi, std::ios::in | std::ios::binary);
-    if (file){
-        unsigned long ulSize = 0; 
-        std::streambuf* buf = file.rdbuf();
-        if (buf) {
-            unsigned long ulCurr;
-            ulCurr = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-            ulSize = buf->pubseekoff(0, std::ios::end, std::ios::in);
-            buf->pubseekoff(ulCurr, std::ios::beg, std::ios::in);
-        }
-
-        // read in the ASCII file and write back to the stream
-        std::strstreambuf sbuf(ulSize);
-        file >> &sbuf;
-        writer.Stream() << &sbuf;
-    }
-
-    file.close();
-    // remove temp file
-    fi.deleteFile();
 }
 
 void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
 {
-    BRep_Builder builder;
-
-    // create a temporary file and copy the content from the zip stream
-    Base::FileInfo fi(Base::FileInfo::getTempFileName());
-
-    // read in the ASCII file and write back to the file stream
-    Base::ofstream file(fi, std::ios::out | std::ios::binary);
-    unsigned long ulSize = 0; 
-    if (reader) {
-        std::streambuf* buf = file.rdbuf();
-        reader >> buf;
-        file.flush();
-        ulSize = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-    }
-    file.close();
-
-    // Read the shape from the temp file, if the file is empty the stored shape was already empty.
-    // If it's still empty after reading the (non-empty) file there must occurred an error.
+    // Read the shape directly from the zip stream, if the file is empty the stored
+    // shape was already empty. If it's still empty after reading the (non-empty)
+    // file there must occurred an error.
     TopoDS_Shape shape;
-    if (ulSize > 0) {
-        if (!BRepTools::Read(shape, (const Standard_CString)fi.filePath().c_str(), builder)) {
-            // Note: Do NOT throw an exception here because if the tmp. created file could
-            // not be read it's NOT an indication for an invalid input stream 'reader'.
+    if (reader && reader.peek() != EOF) {
+        try {
+            BRep_Builder builder;
+            BRepTools::Read(shape, reader, builder);
+        }
+        catch (Standard_Failure) {
+            shape.Nullify();
+        }
+
+        if (shape.IsNull()) {
+            // Note: Do NOT throw an exception here because if the file could not be read
+            // we want to go on with the next files of the stream.
             // We only print an error message but continue reading the next files from the
             // stream...
             App::PropertyContainer* father = this->getContainer();
             if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
                 App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-                Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n", 
-                    fi.filePath().c_str(),obj->Label.getValue());
+                Base::Console().Error("BRep file with shape of '%s' seems to be empty\n", 
+                    obj->Label.getValue());
             }
             else {
-                Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.filePath().c_str());
+                Base::Console().Warning("Loaded BRep file seems to be empty\n");
             }
         }
     }
 
-    // delete the temp file
-    fi.deleteFile();
-
     setValue(shape);
 }
 
@@ -153,6 +153,8 @@
 # include <Transfer_FinderProcess.hxx>
 # include <APIHeaderSection_MakeHeader.hxx>
 
+#include <boost/unordered_map.hpp>
+
 #include <Base/Builder3D.h>
 #include <Base/FileInfo.h>
 #include <Base/Exception.h>
@@ -2269,78 +2271,103 @@ struct MeshVertex
         return false; // points are considered to be equal
     }
 
+    // As MESH_MIN_PT_DIST is gp::Resolution() the shared vertices of two
+    // adjacent faces have exactly the same coordinates. So, they can be
+    // welded by hashing.
+    bool operator == (const MeshVertex &rclPt) const
+    {
+        return this->x == rclPt.x && this->y == rclPt.y && this->z == rclPt.z;
+    }
+
 private:
     // use the same value as used inside the Mesh module
     static const double MESH_MIN_PT_DIST;
 };
+
+struct MeshVertexHash
+{
+    std::size_t operator () (const MeshVertex& v) const
+    {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, v.x);
+        boost::hash_combine(seed, v.y);
+        boost::hash_combine(seed, v.z);
+        return seed;
+    }
+};
 }
 
 //const double Vertex::MESH_MIN_PT_DIST = 1.0e-6;
 const double MeshVertex::MESH_MIN_PT_DIST = gp::Resolution();
 
-#include <StlTransfer.hxx>
-#include <StlMesh_Mesh.hxx>
-#include <StlMesh_MeshExplorer.hxx>
-
 void TopoShape::getFaces(std::vector<Base::Vector3d> &aPoints,
                          std::vector<Facet> &aTopo,
                          float accuracy, uint16_t flags) const
 {
     if (this->_Shape.IsNull())
         return;
-    std::set<MeshVertex> vertices;
-    Standard_Real x1, y1, z1;
-    Standard_Real x2, y2, z2;
-    Standard_Real x3, y3, z3;
 
-    Handle_StlMesh_Mesh aMesh = new StlMesh_Mesh();
-    StlTransfer::BuildIncrementalMesh(this->_Shape, accuracy,
-#if OCC_VERSION_HEX >= 0x060503
-        Standard_True,
+    // The triangulation is kept in the faces of the shape. So, for a repeated
+    // call with the same (or a coarser) deflection BRepMesh doesn't re-mesh
+    // the faces. As StlTransfer did before, the accuracy is an absolute
+    // deflection. With OCC 6.7 or higher the faces are meshed in parallel.
+#if OCC_VERSION_HEX >= 0x060700
+    BRepMesh_IncrementalMesh aMesh(this->_Shape, accuracy, Standard_False, 0.5, Standard_True);
+#else
+    BRepMesh_IncrementalMesh aMesh(this->_Shape, accuracy, Standard_False);
 #endif
-        aMesh);
-    StlMesh_MeshExplorer xp(aMesh);
-    for (Standard_Integer nbd=1;nbd<=aMesh->NbDomains();nbd++) {
-        for (xp.InitTriangle (nbd); xp.MoreTriangle (); xp.NextTriangle ()) {
-            xp.TriangleVertices (x1,y1,z1,x2,y2,z2,x3,y3,z3);
-            Data::ComplexGeoData::Facet face;
-            std::set<MeshVertex>::iterator it;
-
-            // 1st vertex
-            MeshVertex v1(x1,y1,z1);
-            it = vertices.find(v1);
-            if (it == vertices.end()) {
-                v1.i = vertices.size();
-                face.I1 = v1.i;
-                vertices.insert(v1);
-            }
-            else {
-                face.I1 = it->i;
-            }
 
-            // 2nd vertex
-            MeshVertex v2(x2,y2,z2);
-            it = vertices.find(v2);
-            if (it == vertices.end()) {
-                v2.i = vertices.size();
-                face.I2 = v2.i;
-                vertices.insert(v2);
-            }
-            else {
-                face.I2 = it->i;
-            }
+    // weld the vertices of all faces, the vertices shared by adjacent faces
+    // are added only once
+    typedef boost::unordered_map<MeshVertex, Standard_Integer, MeshVertexHash> VertexMap;
+    VertexMap vertices;
+    std::vector<gp_Pnt> points;
+    std::vector<Standard_Integer> index;
 
-            // 3rd vertex
-            MeshVertex v3(x3,y3,z3);
-            it = vertices.find(v3);
-            if (it == vertices.end()) {
-                v3.i = vertices.size();
-                face.I3 = v3.i;
-                vertices.insert(v3);
-            }
-            else {
-                face.I3 = it->i;
-            }
+    for (TopExp_Explorer xp(this->_Shape, TopAbs_FACE); xp.More(); xp.Next()) {
+        const TopoDS_Face& aFace = TopoDS::Face(xp.Current());
+        TopLoc_Location aLoc;
+        Handle(Poly_Triangulation) aPoly = BRep_Tool::Triangulation(aFace,aLoc);
+        if (aPoly.IsNull())
+            continue;
+
+        // geting the transformation of the shape/face
+        gp_Trsf myTransf;
+        Standard_Boolean identity = true;
+        if (!aLoc.IsIdentity()) {
+            identity = false;
+            myTransf = aLoc.Transformation();
+        }
+
+        // map the nodes of the face to the welded vertices
+        const TColgp_Array1OfPnt& Nodes = aPoly->Nodes();
+        index.resize(Nodes.Length());
+        for (Standard_Integer i = Nodes.Lower(); i <= Nodes.Upper(); i++) {
+            gp_Pnt p = Nodes(i);
+            if (!identity)
+                p.Transform(myTransf);
+            std::pair<VertexMap::iterator, bool> it = vertices.insert
+                (std::make_pair(MeshVertex(p), static_cast<Standard_Integer>(points.size())));
+            if (it.second)
+                points.push_back(p);
+            index[i - Nodes.Lower()] = it.first->second;
+        }
+
+        // check orientation
+        TopAbs_Orientation orient = aFace.Orientation();
+        const Poly_Array1OfTriangle& Triangles = aPoly->Triangles();
+        for (Standard_Integer i = Triangles.Lower(); i <= Triangles.Upper(); i++) {
+            Standard_Integer N1,N2,N3;
+            Triangles(i).Get(N1,N2,N3);
+
+            // change orientation of the triangles
+            if (orient != TopAbs_FORWARD)
+                std::swap(N1, N2);
+
+            Data::ComplexGeoData::Facet face;
+            face.I1 = index[N1 - Nodes.Lower()];
+            face.I2 = index[N2 - Nodes.Lower()];
+            face.I3 = index[N3 - Nodes.Lower()];
 
             // make sure that we don't insert invalid facets
             if (face.I1 != face.I2 &&
@@ -2350,10 +2377,7 @@ void TopoShape::getFaces(std::vector<Base::Vector3d> &aPoints,
         }
     }
 
-    std::vector<gp_Pnt> points;
-    points.resize(vertices.size());
-    for (std::set<MeshVertex>::iterator it = vertices.begin(); it != vertices.end(); ++it)
-        points[it->i] = it->toPoint();
+    aPoints.reserve(aPoints.size() + points.size());
     for (std::vector<gp_Pnt>::iterator it = points.begin(); it != points.end(); ++it)
         aPoints.push_back(Base::Vector3d(it->X(),it->Y(),it->Z()));
 }
@@ -60,6 +60,7 @@
 #include <Base/Matrix.h>
 #include <Base/Rotation.h>
 #include <Base/MatrixPy.h>
+#include <Base/PyBuffer.h>
 #include <Base/Vector3D.h>
 #include <Base/VectorPy.h>
 #include <CXX/Extensions.hxx>
@@ -1377,6 +1378,50 @@ PyObject* TopoShapePy::tessellate(PyObject *args)
     }
 }
 
+PyObject* TopoShapePy::tessellateToBuffers(PyObject *args)
+{
+    try {
+        float tolerance;
+        PyObject* ok = Py_False;
+        if (!PyArg_ParseTuple(args, "f|O!",&tolerance,&PyBool_Type,&ok))
+            return 0;
+        std::vector<Base::Vector3d> Points;
+        std::vector<Data::ComplexGeoData::Facet> Facets;
+        if (PyObject_IsTrue(ok))
+            BRepTools::Clean(getTopoShapePtr()->_Shape);
+        getTopoShapePtr()->getFaces(Points, Facets,tolerance);
+
+        std::vector<double> coords;
+        coords.reserve(3 * Points.size());
+        for (std::vector<Base::Vector3d>::const_iterator it = Points.begin();
+            it != Points.end(); ++it) {
+            coords.push_back(it->x);
+            coords.push_back(it->y);
+            coords.push_back(it->z);
+        }
+        std::vector<uint32_t> indices;
+        indices.reserve(3 * Facets.size());
+        for (std::vector<Data::ComplexGeoData::Facet>::const_iterator
+            it = Facets.begin(); it != Facets.end(); ++it) {
+            indices.push_back(it->I1);
+            indices.push_back(it->I2);
+            indices.push_back(it->I3);
+        }
+
+        Py::Tuple tuple(2);
+        tuple.setItem(0, Py::asObject(Base::PyBuffer::toByteArray(
+            coords.empty() ? 0 : &coords[0], coords.size() * sizeof(double))));
+        tuple.setItem(1, Py::asObject(Base::PyBuffer::toByteArray(
+            indices.empty() ? 0 : &indices[0], indices.size() * sizeof(uint32_t))));
+        return Py::new_reference_to(tuple);
+    }
+    catch (Standard_Failure) {
+        Handle_Standard_Failure e = Standard_Failure::Caught();
+        PyErr_SetString(PartExceptionOCCError, e->GetMessageString());
+        return NULL;
+    }
+}
+
 PyObject* TopoShapePy::project(PyObject *args)
 {
     PyObject *obj;
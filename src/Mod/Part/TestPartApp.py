@@ -19,7 +19,7 @@
 #   USA                                                                   *
 #**************************************************************************
 
-import FreeCAD, os, sys, unittest, Part
+import FreeCAD, os, sys, unittest, Part, tempfile
 App = FreeCAD
 
 #---------------------------------------------------------------------------
@@ -35,8 +35,31 @@ class PartTestCases(unittest.TestCase):
 		self.Box = App.ActiveDocument.addObject("Part::Box","Box")
 		self.Doc.recompute()
 		self.failUnless(len(self.Box.Shape.Faces)==6)
-		
+
+	def testSaveRestoreShape(self):
+		box = self.Doc.addObject("Part::Box","Box")
+		cyl = self.Doc.addObject("Part::Cylinder","Cylinder")
+		cut = self.Doc.addObject("Part::Cut","Cut")
+		cut.Base = box
+		cut.Tool = cyl
+		self.Doc.recompute()
+		# the triangulation is not saved, the geometry must be unchanged
+		cut.Shape.tessellate(0.1)
+		volume = cut.Shape.Volume
+		points = [v.Point for v in cut.Shape.Vertexes]
+		faces = len(cut.Shape.Faces)
+		fileName = os.path.join(tempfile.gettempdir(), "PartShapeTest.FCStd")
+		self.Doc.saveAs(fileName)
+		FreeCAD.closeDocument(self.Doc.Name)
+		self.Doc = FreeCAD.openDocument(fileName)
+		shape = self.Doc.getObject("Cut").Shape
+		self.failUnless(shape.isValid())
+		self.failUnless(len(shape.Faces) == faces)
+		self.failUnless([v.Point for v in shape.Vertexes] == points)
+		self.failUnless(abs(shape.Volume - volume) < 1e-7)
+		os.remove(fileName)
+
 	def tearDown(self):
 		#closing doc
-		FreeCAD.closeDocument("PartTest")
+		FreeCAD.closeDocument(self.Doc.Name)
 		#print ("omit clos document for debuging")
@@ -31,9 +31,19 @@
 # include <TopExp_Explorer.hxx>
 # include <TopTools_IndexedMapOfShape.hxx>
 # include <Precision.hxx>
+# include <Standard.hxx>
 # include <BRepBuilderAPI_Copy.hxx>
+# include <BRepBndLib.hxx>
+# include <Bnd_Box.hxx>
+# include <Standard_Failure.hxx>
+# include <Standard_Version.hxx>
+# include <TopTools_ListOfShape.hxx>
 #endif
 
+#include <algorithm>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 
 #include "FeatureTransformed.h"
 #include "FeatureMultiTransform.h"
@@ -51,6 +61,138 @@
 
 using namespace PartDesign;
 
+namespace {
+
+/// A transformed copy of an original, made by makeInstance()
+struct TransformedInstance
+{
+    enum Status { Done, CopyFailed, TransformFailed, Exception };
+
+    std::vector<gp_Trsf>::const_iterator trsf;
+    TopoDS_Shape shape;
+    Bnd_Box box;
+    Status status;
+    std::string error;
+};
+
+void makeInstance(const TopoDS_Shape& original, TransformedInstance& instance)
+{
+    instance.status = TransformedInstance::Done;
+    try {
+        // Make an explicit copy of the shape because the "true" parameter to BRepBuilderAPI_Transform
+        // seems to be pretty broken
+        BRepBuilderAPI_Copy copy(original);
+        TopoDS_Shape shape = copy.Shape();
+        if (shape.IsNull()) {
+            instance.status = TransformedInstance::CopyFailed;
+            return;
+        }
+
+        BRepBuilderAPI_Transform mkTrf(shape, *instance.trsf, false); // No need to copy, now
+        if (!mkTrf.IsDone()) {
+            instance.status = TransformedInstance::TransformFailed;
+            return;
+        }
+
+        instance.shape = mkTrf.Shape();
+        BRepBndLib::Add(instance.shape, instance.box);
+        instance.box.SetGap(0);
+    }
+    catch (Standard_Failure& e) {
+        instance.status = TransformedInstance::Exception;
+        instance.error = e.GetMessageString();
+    }
+}
+
+/// A pair of shapes whose bounding boxes overlap
+struct OverlapCheck
+{
+    std::size_t first, second;
+    const TopoDS_Shape* shape1;
+    const TopoDS_Shape* shape2;
+    bool overlaps;
+    std::string error;
+};
+
+void checkOverlap(OverlapCheck& check)
+{
+    check.overlaps = false;
+    try {
+        check.overlaps = Part::checkIntersection(*check.shape1, *check.shape2, false, false);
+    }
+    catch (Standard_Failure& e) {
+        check.error = e.GetMessageString();
+    }
+}
+
+struct BoxMinXOrder
+{
+    BoxMinXOrder(const std::vector<Bnd_Box>& boxes) : boxes(boxes) {}
+    bool operator () (std::size_t i, std::size_t j) const
+    {
+        Standard_Real xmin1, ymin1, zmin1, xmax1, ymax1, zmax1;
+        Standard_Real xmin2, ymin2, zmin2, xmax2, ymax2, zmax2;
+        boxes[i].Get(xmin1, ymin1, zmin1, xmax1, ymax1, zmax1);
+        boxes[j].Get(xmin2, ymin2, zmin2, xmax2, ymax2, zmax2);
+        return xmin1 < xmin2;
+    }
+    const std::vector<Bnd_Box>& boxes;
+};
+
+/** Collects all pairs of shapes with overlapping bounding boxes. The boxes are
+ * sorted along the x axis so that each box is only compared with the boxes
+ * starting before it ends.
+ */
+void findOverlappingBoxes(const std::vector<const TopoDS_Shape*>& shapes,
+                          const std::vector<Bnd_Box>& boxes,
+                          std::vector<OverlapCheck>& checks)
+{
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+        if (!boxes[i].IsVoid())
+            order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), BoxMinXOrder(boxes));
+
+    Standard_Real xmin1, ymin1, zmin1, xmax1, ymax1, zmax1;
+    Standard_Real xmin2, ymin2, zmin2, xmax2, ymax2, zmax2;
+    for (std::vector<std::size_t>::iterator it = order.begin(); it != order.end(); ++it) {
+        boxes[*it].Get(xmin1, ymin1, zmin1, xmax1, ymax1, zmax1);
+        for (std::vector<std::size_t>::iterator jt = it + 1; jt != order.end(); ++jt) {
+            boxes[*jt].Get(xmin2, ymin2, zmin2, xmax2, ymax2, zmax2);
+            if (xmin2 > xmax1)
+                break;
+            if (boxes[*it].IsOut(boxes[*jt]))
+                continue;
+
+            OverlapCheck check;
+            check.first = std::min<std::size_t>(*it, *jt);
+            check.second = std::max<std::size_t>(*it, *jt);
+            check.shape1 = shapes[check.first];
+            check.shape2 = shapes[check.second];
+            checks.push_back(check);
+        }
+    }
+}
+
+#if OCC_VERSION_HEX >= 0x060900
+/// Runs a boolean operation of the support with all \a tools at once
+void runBoolean(BRepAlgoAPI_BooleanOperation& mkBool, const TopoDS_Shape& support,
+                const std::vector<TopoDS_Shape>& tools)
+{
+    TopTools_ListOfShape arguments, toolList;
+    arguments.Append(support);
+    for (std::vector<TopoDS_Shape>::const_iterator it = tools.begin(); it != tools.end(); ++it)
+        toolList.Append(*it);
+    mkBool.SetArguments(arguments);
+    mkBool.SetTools(toolList);
+    mkBool.SetRunParallel(Standard_True);
+    mkBool.Build();
+}
+#endif
+
+}
+
 namespace PartDesign {
 
 PROPERTY_SOURCE(PartDesign::Transformed, PartDesign::Feature)
@@ -149,6 +291,11 @@ App::DocumentObjectExecReturn *Transformed::execute(void)
     std::set<std::vector<gp_Trsf>::const_iterator> nointersect_trsfms;
     std::set<std::vector<gp_Trsf>::const_iterator> overlapping_trsfms;
 
+    // The bounding box of the support is needed for every transformed shape
+    Bnd_Box supportBox;
+    BRepBndLib::Add(support, supportBox);
+    supportBox.SetGap(0);
+
     // NOTE: It would be possible to build a compound from all original addShapes/subShapes and then
     // transform the compounds as a whole. But we choose to apply the transformations to each
     // Original separately. This way it is easier to discover what feature causes a fuse/cut
@@ -176,36 +323,49 @@ App::DocumentObjectExecReturn *Transformed::execute(void)
             return new App::DocumentObjectExecReturn("Only additive and subtractive features can be transformed");
         }
 
-        // Transform the add/subshape and collect the resulting shapes for overlap testing
-        std::vector<std::vector<gp_Trsf>::const_iterator> v_transformations;
-        std::vector<TopoDS_Shape> v_transformedShapes;
-
+        // Transform the add/subshape in parallel. Each transformation gets its own copy of the shape
+        std::vector<TransformedInstance> instances;
         std::vector<gp_Trsf>::const_iterator t = transformations.begin();
         t++; // Skip first transformation, which is always the identity transformation
         for (; t != transformations.end(); t++) {
-            // Make an explicit copy of the shape because the "true" parameter to BRepBuilderAPI_Transform
-            // seems to be pretty broken
-            BRepBuilderAPI_Copy copy(shape);
-            shape = copy.Shape();
-            if (shape.IsNull())
-                throw Base::Exception("Transformed: Linked shape object is empty");
+            TransformedInstance instance;
+            instance.trsf = t;
+            instances.push_back(instance);
+        }
+        Standard::SetReentrant(Standard_True);
+        QtConcurrent::blockingMap(instances, boost::bind(&makeInstance, boost::cref(shape), _1));
 
-            BRepBuilderAPI_Transform mkTrf(shape, *t, false); // No need to copy, now
-            if (!mkTrf.IsDone())
-                return new App::DocumentObjectExecReturn("Transformation failed", (*o));
+        // Collect the resulting shapes for overlap testing. The exact checks run one after
+        // the other because all of them work on the same support shape
+        std::vector<std::vector<gp_Trsf>::const_iterator> v_transformations;
+        std::vector<TopoDS_Shape> v_transformedShapes;
+        std::vector<Bnd_Box> v_boxes;
 
-            // Check for intersection with support
-            if (!Part::checkIntersection(support, mkTrf.Shape(), false, true)) {
+        for (std::vector<TransformedInstance>::const_iterator it = instances.begin(); it != instances.end(); ++it) {
+            if (it->status == TransformedInstance::CopyFailed)
+                throw Base::Exception("Transformed: Linked shape object is empty");
+            if (it->status == TransformedInstance::TransformFailed)
+                return new App::DocumentObjectExecReturn("Transformation failed", (*o));
+            if (it->status == TransformedInstance::Exception)
+                throw Base::Exception(it->error);
+
+            // Check for intersection with support. Disjoint bounding boxes are the common case
+            // and don't need the boolean check
+            bool intersects = !supportBox.IsOut(it->box) &&
+                Part::checkIntersection(support, it->shape, false, true);
+            if (!intersects) {
 #ifdef FC_DEBUG // do not write this in release mode because a message appears already in the task view
                 Base::Console().Warning("Transformed shape does not intersect support %s: Removed\n", (*o)->getNameInDocument());
 #endif
-                nointersect_trsfms.insert(t);
+                nointersect_trsfms.insert(it->trsf);
             } else {
-                v_transformations.push_back(t);
-                v_transformedShapes.push_back(mkTrf.Shape());
+                v_transformations.push_back(it->trsf);
+                v_transformedShapes.push_back(it->shape);
+                v_boxes.push_back(it->box);
                 // Note: Transformations that do not intersect the support are ignored in the overlap tests
             }
         }
+        instances.clear();
 
         if (v_transformedShapes.empty())
             break; // Skip the overlap check and go on to next original
@@ -223,62 +383,65 @@ App::DocumentObjectExecReturn *Transformed::execute(void)
         } else {
             // For MultiTransform, just checking the first transformed shape is not sufficient - any two
             // features might overlap, even if the original and the first shape don't overlap!
-
-            std::set<std::vector<TopoDS_Shape>::iterator> rejected_iterators;
-
-            std::vector<TopoDS_Shape>::iterator s1 = v_transformedShapes.begin();
-            std::vector<TopoDS_Shape>::iterator s2 = s1;
-            s2++;
-            std::vector<std::vector<gp_Trsf>::const_iterator>::const_iterator t1 = v_transformations.begin();
-            std::vector<std::vector<gp_Trsf>::const_iterator>::const_iterator t2 = t1;
-            t2++;
-            for (; s2 != v_transformedShapes.end();) {
-                // Check intersection with the original
-                if (Part::checkIntersection(shape, *s1, false, false)) {
-                    rejected_iterators.insert(s1);
-                    overlapping_trsfms.insert(*t1);
-                }
-                // Check intersection with other transformations
-                for (; s2 != v_transformedShapes.end(); s2++, t2++)
-                    if (Part::checkIntersection(*s1, *s2, false, false)) {
-                        rejected_iterators.insert(s1);
-                        rejected_iterators.insert(s2);
-                        overlapping_trsfms.insert(*t1);
-                        overlapping_trsfms.insert(*t2);
-                    }
-                s1++;
-                s2 = s1;
-                s2++;
-                t1++;
-                t2 = t1;
-                t2++;
+            // Only the pairs with overlapping bounding boxes need the exact (and expensive) check.
+            // A shape takes part in several checks, so they run one after the other.
+            // The original gets the index 0, the transformed shapes start at index 1.
+            std::vector<const TopoDS_Shape*> shapes;
+            std::vector<Bnd_Box> boxes;
+            shapes.push_back(&shape);
+            boxes.push_back(Bnd_Box());
+            BRepBndLib::Add(shape, boxes.back());
+            boxes.back().SetGap(0);
+            for (std::size_t i = 0; i < v_transformedShapes.size(); i++) {
+                shapes.push_back(&v_transformedShapes[i]);
+                boxes.push_back(v_boxes[i]);
             }
-            // Check intersection of last transformation with the original
-            if (Part::checkIntersection(shape, *s1, false, false)) {
-                rejected_iterators.insert(s1);
-                overlapping_trsfms.insert(*t1);
+
+            std::vector<OverlapCheck> checks;
+            findOverlappingBoxes(shapes, boxes, checks);
+            std::for_each(checks.begin(), checks.end(), &checkOverlap);
+
+            std::set<std::size_t> rejected_indices;
+            for (std::vector<OverlapCheck>::const_iterator it = checks.begin(); it != checks.end(); ++it) {
+                if (!it->error.empty())
+                    throw Base::Exception(it->error);
+                if (!it->overlaps)
+                    continue;
+                // an overlap with the original only rejects the transformed shape
+                if (it->first > 0)
+                    rejected_indices.insert(it->first - 1);
+                rejected_indices.insert(it->second - 1);
             }
 
-            for (std::set<std::vector<TopoDS_Shape>::iterator>::reverse_iterator it = rejected_iterators.rbegin();
-                 it != rejected_iterators.rend(); it++)
-                v_transformedShapes.erase(*it);
+            for (std::set<std::size_t>::reverse_iterator it = rejected_indices.rbegin();
+                 it != rejected_indices.rend(); it++) {
+                overlapping_trsfms.insert(v_transformations[*it]);
+                v_transformedShapes.erase(v_transformedShapes.begin() + *it);
+            }
         }
 
         if (v_transformedShapes.empty())
             break; // Skip the boolean operation and go on to next original
 
+        // Fuse/Cut the transformed shapes with the support
+        TopoDS_Shape result;
+
+#if OCC_VERSION_HEX < 0x060900
         // Build a compound from all the valid transformations
         BRep_Builder builder;
         TopoDS_Compound transformedShapes;
         builder.MakeCompound(transformedShapes);
         for (std::vector<TopoDS_Shape>::const_iterator s = v_transformedShapes.begin(); s != v_transformedShapes.end(); s++)
             builder.Add(transformedShapes, *s);
-
-        // Fuse/Cut the compounded transformed shapes with the support
-        TopoDS_Shape result;
+#endif
 
         if (fuse) {
+#if OCC_VERSION_HEX >= 0x060900
+            BRepAlgoAPI_Fuse mkFuse;
+            runBoolean(mkFuse, support, v_transformedShapes);
+#else
             BRepAlgoAPI_Fuse mkFuse(support, transformedShapes);
+#endif
             if (!mkFuse.IsDone())
                 return new App::DocumentObjectExecReturn("Fusion with support failed", *o);
             // we have to get the solids (fuse sometimes creates compounds)
@@ -288,7 +451,12 @@ App::DocumentObjectExecReturn *Transformed::execute(void)
                 return new App::DocumentObjectExecReturn("Resulting shape is not a solid", *o);
             result = refineShapeIfActive(result);
         } else {
+#if OCC_VERSION_HEX >= 0x060900
+            BRepAlgoAPI_Cut mkCut;
+            runBoolean(mkCut, support, v_transformedShapes);
+#else
             BRepAlgoAPI_Cut mkCut(support, transformedShapes);
+#endif
             if (!mkCut.IsDone())
                 return new App::DocumentObjectExecReturn("Cut out of support failed", *o);
             result = mkCut.Shape();
@@ -296,6 +464,9 @@ App::DocumentObjectExecReturn *Transformed::execute(void)
         }
 
         support = result; // Use result of this operation for fuse/cut of next original
+        supportBox.SetVoid();
+        BRepBndLib::Add(support, supportBox);
+        supportBox.SetGap(0);
     }
 
     if (!overlapping_trsfms.empty())
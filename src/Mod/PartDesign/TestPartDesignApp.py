@@ -19,7 +19,7 @@
 #   USA                                                                   *
 #**************************************************************************
 
-import FreeCAD, os, sys, unittest, Sketcher, PartDesign, TestSketcherApp
+import FreeCAD, os, sys, unittest, time, Part, Sketcher, PartDesign, TestSketcherApp
 App = FreeCAD
 
 #---------------------------------------------------------------------------
@@ -44,3 +44,60 @@ class PartDesignPadTestCases(unittest.TestCase):
 		#closing doc
 		FreeCAD.closeDocument("PartDesignTest")
 		#print ("omit clos document for debuging")
+
+class PartDesignPatternTestCases(unittest.TestCase):
+	def setUp(self):
+		self.Doc = FreeCAD.newDocument("PartDesignPatternTest")
+
+	def makePlate(self, length):
+		# a plate along the x axis with a through hole at the origin
+		sketch = self.Doc.addObject('Sketcher::SketchObject','SketchPlate')
+		p = [App.Vector(-10,-10,0),App.Vector(length,-10,0),App.Vector(length,10,0),App.Vector(-10,10,0)]
+		for i in range(4):
+			sketch.addGeometry(Part.Line(p[i],p[(i+1)%4]))
+		pad = self.Doc.addObject("PartDesign::Pad","Pad")
+		pad.Sketch = sketch
+		pad.Length = 10
+		self.Doc.recompute()
+		top = [i for i,f in enumerate(pad.Shape.Faces) if f.BoundBox.ZMin > 9.999][0]
+		hole = self.Doc.addObject('Sketcher::SketchObject','SketchHole')
+		hole.Support = (pad, ['Face%d' % (top+1)])
+		hole.addGeometry(Part.Circle(App.Vector(0,0,0),App.Vector(0,0,1),2))
+		pocket = self.Doc.addObject("PartDesign::Pocket","Pocket")
+		pocket.Sketch = hole
+		pocket.Length = 20
+		self.Doc.recompute()
+		return (pad, hole, pocket)
+
+	def makePattern(self, pocket, hole, occurrences):
+		pattern = self.Doc.addObject("PartDesign::LinearPattern","LinearPattern")
+		pattern.Originals = [pocket]
+		pattern.Direction = (hole, ["H_Axis"])
+		pattern.Length = 8 * (occurrences - 1)
+		pattern.Occurrences = occurrences
+		return pattern
+
+	def countHoles(self, shape):
+		return len([f for f in shape.Faces if isinstance(f.Surface, Part.Cylinder)])
+
+	def testLinearPattern(self):
+		pad, hole, pocket = self.makePlate(100)
+		pattern = self.makePattern(pocket, hole, 10)
+		self.Doc.recompute()
+		self.failUnless(pattern.Shape.isValid())
+		self.failUnless(self.countHoles(pattern.Shape) == 10)
+		volume = pad.Shape.Volume - 10 * 3.14159265358979 * 4 * 10
+		self.failUnless(abs(pattern.Shape.Volume - volume) < 1e-3 * volume)
+
+	def testPatternTime(self):
+		for occurrences in (10, 50, 100, 200):
+			pad, hole, pocket = self.makePlate(8 * occurrences)
+			pattern = self.makePattern(pocket, hole, occurrences)
+			start=time.time()
+			self.Doc.recompute()
+			FreeCAD.Console.PrintMessage("LinearPattern with %d occurrences: %.3f s\n" % (occurrences, time.time()-start))
+			self.failUnless(self.countHoles(pattern.Shape) == occurrences)
+
+	def tearDown(self):
+		#closing doc
+		FreeCAD.closeDocument("PartDesignPatternTest")
@@ -28,11 +28,14 @@
 #include <Base/Console.h>
 #include <Base/Interpreter.h>
 #include <Base/FileInfo.h>
+#include <Base/BoundBoxPy.h>
+#include <Base/VectorPy.h>
 
 #include <App/Application.h>
 #include <App/Document.h>
 #include <App/DocumentObject.h>
 #include <App/Property.h>
+#include <App/PropertyStandard.h>
 
 // PCL test
 #ifdef HAVE_PCL_IO
@@ -44,10 +47,47 @@
 #include "Points.h"
 #include "PointsPy.h"
 #include "PointsAlgos.h"
+#include "PointsFeature.h"
+#include "PointStore.h"
+#include "Properties.h"
 #include "FeaturePointsImportAscii.h"
 
 using namespace Points;
 
+// Adds a feature with the points of an ASCII file to the document. If the
+// file has intensities, colors or normals they are added as properties.
+static void importAscii(App::Document* pcDoc, const std::string& FileName)
+{
+    Base::FileInfo file(FileName.c_str());
+    Points::PointKernel pkTemp;
+    Points::PointsAlgos::Attributes attr;
+    Points::PointsAlgos::LoadAscii(pkTemp, attr, FileName.c_str());
+
+    bool extra = !attr.intensity.empty() || !attr.colors.empty() || !attr.normals.empty();
+    Points::Feature *pcFeature = (Points::Feature *)pcDoc->addObject(extra ?
+        "Points::FeaturePython" : "Points::Feature", file.fileNamePure().c_str());
+    pcFeature->Points.setValue( pkTemp );
+
+    if (!attr.intensity.empty()) {
+        Points::PropertyGreyValueList* prop = static_cast<Points::PropertyGreyValueList*>
+            (pcFeature->addDynamicProperty("Points::PropertyGreyValueList", "Intensity"));
+        if (prop)
+            prop->setValues(attr.intensity);
+    }
+    if (!attr.colors.empty()) {
+        App::PropertyColorList* prop = static_cast<App::PropertyColorList*>
+            (pcFeature->addDynamicProperty("App::PropertyColorList", "Color"));
+        if (prop)
+            prop->setValues(attr.colors);
+    }
+    if (!attr.normals.empty()) {
+        Points::PropertyNormalList* prop = static_cast<Points::PropertyNormalList*>
+            (pcFeature->addDynamicProperty("Points::PropertyNormalList", "Normal"));
+        if (prop)
+            prop->setValues(attr.normals);
+    }
+}
+
 /* module functions */
 static PyObject *
 open(PyObject *self, PyObject *args)
@@ -69,11 +109,7 @@ open(PyObject *self, PyObject *args)
         if (file.hasExtension("asc")) {
             // create new document and add Import feature
             App::Document *pcDoc = App::GetApplication().newDocument("Unnamed");
-            Points::Feature *pcFeature = (Points::Feature *)pcDoc->addObject("Points::Feature", file.fileNamePure().c_str());
-            Points::PointKernel pkTemp;
-            pkTemp.load(EncodedName.c_str());
-            pcFeature->Points.setValue( pkTemp );
-
+            importAscii(pcDoc, EncodedName);
         }
 #ifdef HAVE_PCL_IO
         else if (file.hasExtension("ply")) {
@@ -124,10 +160,7 @@ insert(PyObject *self, PyObject *args)
                 pcDoc = App::GetApplication().newDocument(DocName);
             }
 
-            Points::Feature *pcFeature = (Points::Feature *)pcDoc->addObject("Points::Feature", file.fileNamePure().c_str());
-            Points::PointKernel pkTemp;
-            pkTemp.load(EncodedName.c_str());
-            pcFeature->Points.setValue( pkTemp );
+            importAscii(pcDoc, EncodedName);
         }
 #ifdef HAVE_PCL_IO
         else if (file.hasExtension("ply")) {
@@ -178,10 +211,82 @@ show(PyObject *self, PyObject *args)
     Py_Return;
 }
 
+static PyObject *
+buildStore(PyObject *self, PyObject *args)
+{
+    char* Name;
+    char* StoreName;
+    unsigned long leafSize = 4096;
+    if (!PyArg_ParseTuple(args, "etet|k","utf-8",&Name,"utf-8",&StoreName,&leafSize))
+        return NULL;
+    std::string EncodedName = std::string(Name);
+    PyMem_Free(Name);
+    std::string EncodedStoreName = std::string(StoreName);
+    PyMem_Free(StoreName);
+
+    PY_TRY {
+        Points::PointStoreBuilder builder(EncodedStoreName.c_str(), leafSize);
+        Points::PointsAlgos::LoadAscii(builder, EncodedName.c_str());
+        builder.finish();
+    } PY_CATCH;
+
+    Py_Return;
+}
+
+static PyObject *
+readStore(PyObject *self, PyObject *args)
+{
+    char* StoreName;
+    PyObject *pcObj=0;
+    double radius=0.0;
+    if (!PyArg_ParseTuple(args, "et|Od","utf-8",&StoreName,&pcObj,&radius))
+        return NULL;
+    std::string EncodedStoreName = std::string(StoreName);
+    PyMem_Free(StoreName);
+
+    std::vector<Points::PointKernel::value_type> points;
+    PY_TRY {
+        Points::PointStore store;
+        if (!store.open(EncodedStoreName.c_str()))
+            Py_Error(Base::BaseExceptionFreeCADError,"not a point store");
+
+        if (!pcObj) {
+            points.assign(store.getPoints(), store.getPoints() + store.size());
+        }
+        else {
+            std::vector<uint64_t> indices;
+            if (PyObject_TypeCheck(pcObj, &(Base::BoundBoxPy::Type))) {
+                Base::BoundBox3d bb = *static_cast<Base::BoundBoxPy*>(pcObj)->getBoundBoxPtr();
+                store.searchPoints(Base::BoundBox3f((float)bb.MinX, (float)bb.MinY, (float)bb.MinZ,
+                                                    (float)bb.MaxX, (float)bb.MaxY, (float)bb.MaxZ), indices);
+            }
+            else if (PyObject_TypeCheck(pcObj, &(Base::VectorPy::Type))) {
+                Base::Vector3d c = static_cast<Base::VectorPy*>(pcObj)->value();
+                store.searchPoints(Base::Vector3f((float)c.x, (float)c.y, (float)c.z), (float)radius, indices);
+            }
+            else {
+                Py_Error(PyExc_TypeError,"expected a bounding box or a center and a radius");
+            }
+            points.reserve(indices.size());
+            for (std::vector<uint64_t>::iterator it = indices.begin(); it != indices.end(); ++it)
+                points.push_back(store[*it]);
+        }
+    } PY_CATCH;
+
+    Points::PointKernel* kernel = new Points::PointKernel();
+    kernel->setBasicPoints(points);
+    return new Points::PointsPy(kernel);
+}
+
 // registration table  
 struct PyMethodDef Points_Import_methods[] = {
     {"open",  open,   1},       /* method name, C func ptr, always-tuple */
     {"insert",insert, 1},
     {"show",show, 1},
+    {"buildStore",buildStore, 1,
+     "buildStore(ascFile, storeFile, [leafSize]) -- Streams an ASCII point cloud into a point store file"},
+    {"readStore",readStore, 1,
+     "readStore(storeFile, [BoundBox | Vector, radius]) -- Reads all points of a point store\n"
+     "or the ones inside a bounding box or within a radius around a center"},
     {NULL, NULL}                /* end of table marker */
 };
@@ -0,0 +1,562 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <ostream>
+#endif
+
+#include <QFile>
+#include <QString>
+
+#include <Base/Exception.h>
+
+#include "PointStore.h"
+#include "Points.h"
+
+using namespace Points;
+
+namespace {
+
+// The file starts with the header, followed by the points and the nodes.
+struct StoreHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t leafSize;
+    uint64_t numPoints;
+    uint64_t numNodes;
+    uint64_t nodeOffset;
+    float bbox[6];
+};
+
+const char StoreMagic[8] = {'F','C','P','S','T','O','R','E'};
+const uint32_t StoreVersion = 1;
+const qint64 PointOffset = 64;
+const int MaxDepth = 21;
+const std::size_t BufferSize = 1 << 20;
+
+inline Base::BoundBox3f NodeBox(const PointStore::Node& node)
+{
+    return Base::BoundBox3f(node.minX, node.minY, node.minZ,
+                            node.maxX, node.maxY, node.maxZ);
+}
+
+// Unlike the tests of BoundBox3f these include the upper bounds, since
+// the node boxes are tight and may also be flat.
+inline bool Overlaps(const PointStore::Node& node, const Base::BoundBox3f& box)
+{
+    return node.minX <= box.MaxX && node.maxX >= box.MinX &&
+           node.minY <= box.MaxY && node.maxY >= box.MinY &&
+           node.minZ <= box.MaxZ && node.maxZ >= box.MinZ;
+}
+
+inline bool Contains(const Base::BoundBox3f& box, const PointStore::Node& node)
+{
+    return node.minX >= box.MinX && node.maxX <= box.MaxX &&
+           node.minY >= box.MinY && node.maxY <= box.MaxY &&
+           node.minZ >= box.MinZ && node.maxZ <= box.MaxZ;
+}
+
+inline bool Contains(const Base::BoundBox3f& box, const Base::Vector3f& p)
+{
+    return p.x >= box.MinX && p.x <= box.MaxX &&
+           p.y >= box.MinY && p.y <= box.MaxY &&
+           p.z >= box.MinZ && p.z <= box.MaxZ;
+}
+
+// squared distance of the point to the nearest and farthest point of the box
+inline void BoxDistance(const PointStore::Node& node, const Base::Vector3f& p,
+                        float& nearest, float& farthest)
+{
+    const float lo[3] = {node.minX, node.minY, node.minZ};
+    const float hi[3] = {node.maxX, node.maxY, node.maxZ};
+    const float pt[3] = {p.x, p.y, p.z};
+    nearest = farthest = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        float d0 = lo[i] - pt[i];
+        float d1 = pt[i] - hi[i];
+        float d = std::max<float>(0.0f, std::max<float>(d0, d1));
+        nearest += d * d;
+        float f = std::max<float>(std::fabs(d0), std::fabs(d1));
+        farthest += f * f;
+    }
+}
+
+}
+
+// ----------------------------------------------------------------------------
+
+PointStore::PointStore()
+  : _file(0), _points(0), _nodes(0), _numPoints(0), _numNodes(0)
+{
+}
+
+PointStore::~PointStore()
+{
+    close();
+}
+
+bool PointStore::open(const char* FileName)
+{
+    close();
+
+    _file = new QFile(QString::fromUtf8(FileName));
+    if (!_file->open(QIODevice::ReadOnly) || _file->size() < PointOffset) {
+        close();
+        return false;
+    }
+
+    qint64 size = _file->size();
+    uchar* data = _file->map(0, size);
+    if (!data) {
+        close();
+        return false;
+    }
+
+    StoreHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, StoreMagic, sizeof(StoreMagic)) != 0 ||
+        header.version != StoreVersion ||
+        header.numNodes == 0 ||
+        static_cast<uint64_t>(PointOffset) + header.numPoints * sizeof(Base::Vector3f) > header.nodeOffset ||
+        header.nodeOffset + header.numNodes * sizeof(Node) > static_cast<uint64_t>(size)) {
+        close();
+        return false;
+    }
+
+    _points = reinterpret_cast<const Base::Vector3f*>(data + PointOffset);
+    _nodes = reinterpret_cast<const Node*>(data + header.nodeOffset);
+    _numPoints = header.numPoints;
+    _numNodes = header.numNodes;
+    return true;
+}
+
+void PointStore::close()
+{
+    // deleting the file also removes the mapping
+    delete _file;
+    _file = 0;
+    _points = 0;
+    _nodes = 0;
+    _numPoints = 0;
+    _numNodes = 0;
+}
+
+bool PointStore::isOpen() const
+{
+    return _file != 0;
+}
+
+uint64_t PointStore::size() const
+{
+    return _numPoints;
+}
+
+uint64_t PointStore::countNodes() const
+{
+    return _numNodes;
+}
+
+Base::BoundBox3f PointStore::getBoundBox() const
+{
+    if (_numNodes == 0)
+        return Base::BoundBox3f();
+    return NodeBox(_nodes[0]);
+}
+
+void PointStore::visitPoints(PointStoreVisitor& visitor) const
+{
+    // the leaves cover the points without gaps, so just pass them in blocks
+    const uint64_t block = 65536;
+    for (uint64_t i = 0; i < _numPoints; i += block) {
+        if (!visitor.Visit(_points + i, std::min<uint64_t>(block, _numPoints - i), i))
+            break;
+    }
+}
+
+void PointStore::visitPoints(const Base::BoundBox3f& box, PointStoreVisitor& visitor) const
+{
+    if (_numNodes == 0)
+        return;
+    std::vector<int32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node, box))
+            continue;
+        if (node.child < 0) {
+            if (!visitor.Visit(_points + node.first, node.count, node.first))
+                break;
+        }
+        else {
+            // push in reverse order to visit the points in ascending order
+            for (int32_t i = node.numChildren - 1; i >= 0; i--)
+                stack.push_back(node.child + i);
+        }
+    }
+}
+
+void PointStore::searchPoints(const Base::BoundBox3f& box, std::vector<uint64_t>& indices) const
+{
+    if (_numNodes == 0)
+        return;
+    std::vector<int32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node, box))
+            continue;
+        if (Contains(box, node)) {
+            for (uint64_t i = node.first; i < node.first + node.count; i++)
+                indices.push_back(i);
+        }
+        else if (node.child < 0) {
+            for (uint64_t i = node.first; i < node.first + node.count; i++) {
+                if (Contains(box, _points[i]))
+                    indices.push_back(i);
+            }
+        }
+        else {
+            for (int32_t i = node.numChildren - 1; i >= 0; i--)
+                stack.push_back(node.child + i);
+        }
+    }
+}
+
+void PointStore::searchPoints(const Base::Vector3f& center, float radius, std::vector<uint64_t>& indices) const
+{
+    if (_numNodes == 0)
+        return;
+    float radius2 = radius * radius;
+    std::vector<int32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+        float nearest, farthest;
+        BoxDistance(node, center, nearest, farthest);
+        if (nearest > radius2)
+            continue;
+        if (farthest <= radius2) {
+            for (uint64_t i = node.first; i < node.first + node.count; i++)
+                indices.push_back(i);
+        }
+        else if (node.child < 0) {
+            for (uint64_t i = node.first; i < node.first + node.count; i++) {
+                if (Base::DistanceP2(center, _points[i]) <= radius2)
+                    indices.push_back(i);
+            }
+        }
+        else {
+            for (int32_t i = node.numChildren - 1; i >= 0; i--)
+                stack.push_back(node.child + i);
+        }
+    }
+}
+
+void PointStore::getSubsample(double fraction, PointKernel& kernel) const
+{
+    if (_numNodes == 0)
+        return;
+    getSubsample(getBoundBox(), fraction, kernel);
+}
+
+void PointStore::getSubsample(const Base::BoundBox3f& box, double fraction, PointKernel& kernel) const
+{
+    if (_numNodes == 0)
+        return;
+    fraction = std::max<double>(0.0, std::min<double>(1.0, fraction));
+
+    // Take the first part of each leaf. The remainders are carried over to
+    // the next leaf, so that small leaves contribute as well.
+    double carry = 0.0;
+    std::vector<int32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node, box))
+            continue;
+        if (node.child < 0) {
+            double num = node.count * fraction + carry;
+            uint64_t take = static_cast<uint64_t>(num);
+            carry = num - take;
+            bool inside = Contains(box, node);
+            for (uint64_t i = node.first; i < node.first + take; i++) {
+                if (inside || Contains(box, _points[i]))
+                    kernel.push_back(Base::Vector3d(_points[i].x, _points[i].y, _points[i].z));
+            }
+        }
+        else {
+            for (int32_t i = node.numChildren - 1; i >= 0; i--)
+                stack.push_back(node.child + i);
+        }
+    }
+}
+
+namespace {
+class AsciiWriter : public PointStoreVisitor
+{
+public:
+    AsciiWriter(std::ostream& out) : out(out) {}
+    bool Visit(const Base::Vector3f* points, uint64_t count, uint64_t)
+    {
+        for (uint64_t i = 0; i < count; i++)
+            out << points[i].x << " " << points[i].y << " " << points[i].z << std::endl;
+        return out.good();
+    }
+
+private:
+    std::ostream& out;
+};
+}
+
+void PointStore::saveAscii(std::ostream& out) const
+{
+    AsciiWriter writer(out);
+    visitPoints(writer);
+}
+
+// ----------------------------------------------------------------------------
+
+PointStoreBuilder::PointStoreBuilder(const char* FileName, unsigned long leafSize)
+  : _file(0), _leafSize(std::max<unsigned long>(1, leafSize)), _numPoints(0)
+{
+    _file = new QFile(QString::fromUtf8(FileName));
+    if (!_file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        delete _file;
+        _file = 0;
+        throw Base::FileException("Cannot create point store", FileName);
+    }
+
+    // the header is written by finish()
+    char header[PointOffset];
+    std::memset(header, 0, sizeof(header));
+    _file->write(header, sizeof(header));
+    _buffer.reserve(BufferSize);
+}
+
+PointStoreBuilder::~PointStoreBuilder()
+{
+    // an unfinished store has no valid header
+    delete _file;
+}
+
+void PointStoreBuilder::add(const Base::Vector3f& point)
+{
+    _buffer.push_back(point);
+    _bbox.Add(point);
+    _numPoints++;
+    if (_buffer.size() >= BufferSize)
+        flush();
+}
+
+void PointStoreBuilder::add(const Base::Vector3f* points, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+        add(points[i]);
+}
+
+void PointStoreBuilder::add(const PointKernel& kernel)
+{
+    for (PointKernel::const_point_iterator it = kernel.begin(); it != kernel.end(); ++it)
+        add(Base::Vector3f((float)it->x, (float)it->y, (float)it->z));
+}
+
+void PointStoreBuilder::flush()
+{
+    if (_buffer.empty() || !_file)
+        return;
+    qint64 bytes = _buffer.size() * sizeof(Base::Vector3f);
+    if (_file->write(reinterpret_cast<const char*>(&(_buffer[0])), bytes) != bytes)
+        throw Base::FileException("Writing point store failed",
+            (const char*)_file->fileName().toUtf8());
+    _buffer.clear();
+}
+
+void PointStoreBuilder::finish()
+{
+    if (!_file)
+        return;
+    flush();
+    _file->flush();
+
+    std::string name = (const char*)_file->fileName().toUtf8();
+    qint64 pointBytes = _numPoints * sizeof(Base::Vector3f);
+    _nodes.clear();
+    if (_numPoints > 0) {
+        // sort the points directly in the file
+        uchar* data = _file->map(PointOffset, pointBytes);
+        if (!data)
+            throw Base::FileException("Cannot map point store", name.c_str());
+        build(reinterpret_cast<Base::Vector3f*>(data));
+        _file->unmap(data);
+    }
+    else {
+        PointStore::Node root;
+        std::memset(&root, 0, sizeof(root));
+        root.child = -1;
+        _nodes.push_back(root);
+    }
+
+    // the nodes follow the points aligned to eight bytes
+    qint64 nodeOffset = (PointOffset + pointBytes + 7) & ~qint64(7);
+    char padding[8] = {0};
+    _file->seek(PointOffset + pointBytes);
+    _file->write(padding, nodeOffset - PointOffset - pointBytes);
+    qint64 nodeBytes = _nodes.size() * sizeof(PointStore::Node);
+    bool ok = (_file->write(reinterpret_cast<const char*>(&(_nodes[0])), nodeBytes) == nodeBytes);
+
+    StoreHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, StoreMagic, sizeof(StoreMagic));
+    header.version = StoreVersion;
+    header.leafSize = _leafSize;
+    header.numPoints = _numPoints;
+    header.numNodes = _nodes.size();
+    header.nodeOffset = nodeOffset;
+    header.bbox[0] = _bbox.MinX; header.bbox[1] = _bbox.MinY; header.bbox[2] = _bbox.MinZ;
+    header.bbox[3] = _bbox.MaxX; header.bbox[4] = _bbox.MaxY; header.bbox[5] = _bbox.MaxZ;
+    _file->seek(0);
+    ok = ok && (_file->write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header));
+
+    _file->close();
+    delete _file;
+    _file = 0;
+    std::vector<PointStore::Node>().swap(_nodes);
+    if (!ok)
+        throw Base::FileException("Writing point store failed", name.c_str());
+}
+
+namespace {
+// an octree node still to be split together with its cell
+struct BuildTask
+{
+    int32_t node;
+    Base::Vector3f cellMin, cellMax;
+    int depth;
+};
+}
+
+void PointStoreBuilder::build(Base::Vector3f* points)
+{
+    PointStore::Node root;
+    root.minX = _bbox.MinX; root.minY = _bbox.MinY; root.minZ = _bbox.MinZ;
+    root.maxX = _bbox.MaxX; root.maxY = _bbox.MaxY; root.maxZ = _bbox.MaxZ;
+    root.first = 0;
+    root.count = _numPoints;
+    root.child = -1;
+    root.numChildren = 0;
+    _nodes.push_back(root);
+
+    BuildTask task;
+    task.node = 0;
+    task.cellMin.Set(_bbox.MinX, _bbox.MinY, _bbox.MinZ);
+    task.cellMax.Set(_bbox.MaxX, _bbox.MaxY, _bbox.MaxZ);
+    task.depth = 0;
+    std::vector<BuildTask> stack(1, task);
+
+    while (!stack.empty()) {
+        task = stack.back();
+        stack.pop_back();
+        uint64_t first = _nodes[task.node].first;
+        uint64_t count = _nodes[task.node].count;
+        Base::Vector3f* begin = points + first;
+
+        if (count <= _leafSize || task.depth >= MaxDepth) {
+            // shuffle the leaf, so that each of its prefixes is a subsample
+            uint32_t seed = static_cast<uint32_t>(first) * 2654435761u + 1u;
+            for (uint64_t i = count; i > 1; i--) {
+                seed = seed * 1664525u + 1013904223u;
+                std::swap(begin[i - 1], begin[seed % i]);
+            }
+            continue;
+        }
+
+        // count the points per octant of the cell and get their bounding boxes
+        Base::Vector3f center = (task.cellMin + task.cellMax) / 2.0f;
+        uint64_t octCount[8] = {0};
+        Base::BoundBox3f octBox[8];
+        for (uint64_t i = 0; i < count; i++) {
+            const Base::Vector3f& p = begin[i];
+            int oct = (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+            octCount[oct]++;
+            octBox[oct].Add(p);
+        }
+
+        // move the points in place into their octants
+        uint64_t next[8], end[8];
+        uint64_t sum = 0;
+        for (int o = 0; o < 8; o++) {
+            next[o] = sum;
+            sum += octCount[o];
+            end[o] = sum;
+        }
+        for (int o = 0; o < 8; o++) {
+            while (next[o] < end[o]) {
+                Base::Vector3f p = begin[next[o]];
+                int oct = (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+                while (oct != o) {
+                    std::swap(p, begin[next[oct]++]);
+                    oct = (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+                }
+                begin[next[o]++] = p;
+            }
+        }
+
+        // the children of a node are contiguous
+        int32_t child = static_cast<int32_t>(_nodes.size());
+        int32_t numChildren = 0;
+        uint64_t offset = first;
+        for (int o = 0; o < 8; o++) {
+            if (octCount[o] == 0)
+                continue;
+            PointStore::Node node;
+            node.minX = octBox[o].MinX; node.minY = octBox[o].MinY; node.minZ = octBox[o].MinZ;
+            node.maxX = octBox[o].MaxX; node.maxY = octBox[o].MaxY; node.maxZ = octBox[o].MaxZ;
+            node.first = offset;
+            node.count = octCount[o];
+            node.child = -1;
+            node.numChildren = 0;
+            _nodes.push_back(node);
+
+            BuildTask sub;
+            sub.node = child + numChildren;
+            sub.cellMin.Set((o & 1) ? center.x : task.cellMin.x,
+                            (o & 2) ? center.y : task.cellMin.y,
+                            (o & 4) ? center.z : task.cellMin.z);
+            sub.cellMax.Set((o & 1) ? task.cellMax.x : center.x,
+                            (o & 2) ? task.cellMax.y : center.y,
+                            (o & 4) ? task.cellMax.z : center.z);
+            sub.depth = task.depth + 1;
+            stack.push_back(sub);
+
+            offset += octCount[o];
+            numChildren++;
+        }
+        _nodes[task.node].child = child;
+        _nodes[task.node].numChildren = numChildren;
+    }
+}
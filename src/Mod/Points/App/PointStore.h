@@ -0,0 +1,181 @@
+/***************************************************************************
+ *   Copyright (c) 2014 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef POINTS_POINTSTORE_H
+#define POINTS_POINTSTORE_H
+
+#include <Base/BoundBox.h>
+#include <Base/Vector3D.h>
+#include <vector>
+#include <iosfwd>
+
+#ifdef __GNUC__
+# include <stdint.h>
+#endif
+
+class QFile;
+
+namespace Points
+{
+class PointKernel;
+
+/**
+ * The PointStoreVisitor gets the points of a PointStore block by block.
+ */
+class PointsExport PointStoreVisitor
+{
+public:
+    virtual ~PointStoreVisitor() {}
+    /** Gets \a count consecutive points of the store, \a index is the index of
+     * the first one. If false is returned the iteration stops.
+     */
+    virtual bool Visit(const Base::Vector3f* points, uint64_t count, uint64_t index) = 0;
+};
+
+/**
+ * The PointStore keeps a point cloud in a file that is mapped into memory.
+ * The points are sorted by the nodes of an octree, so the points of each node
+ * are contiguous and only the pages of the nodes that are visited are read
+ * from disk. Hence clouds larger than the physical memory can be queried.
+ *
+ * Inside a leaf the points are in random order. So the first part of every
+ * leaf is a uniform subsample of the leaf, which is used for the level of
+ * detail methods.
+ *
+ * A store is created with a PointStoreBuilder.
+ */
+class PointsExport PointStore
+{
+public:
+    /// A node of the octree as it is stored in the file
+    struct Node
+    {
+        float minX, minY, minZ; /**< bounding box of the points */
+        float maxX, maxY, maxZ;
+        uint64_t first;         /**< index of the first point */
+        uint64_t count;         /**< number of points including the children */
+        int32_t child;          /**< index of the first child, -1 for a leaf */
+        int32_t numChildren;    /**< the children are contiguous */
+    };
+
+    PointStore();
+    ~PointStore();
+
+    /** Maps the store file. Returns false if the file cannot be opened or
+     * is not a point store.
+     */
+    bool open(const char* FileName);
+    void close();
+    bool isOpen() const;
+
+    /// number of points
+    uint64_t size() const;
+    Base::BoundBox3f getBoundBox() const;
+    /// the points in the order of the octree
+    const Base::Vector3f* getPoints() const
+    { return _points; }
+    const Base::Vector3f& operator[] (uint64_t index) const
+    { return _points[index]; }
+    uint64_t countNodes() const;
+    const Node& getNode(uint64_t index) const
+    { return _nodes[index]; }
+
+    /** @name Iteration */
+    //@{
+    /// passes the points of all leaves in the order of the store
+    void visitPoints(PointStoreVisitor&) const;
+    /// passes the points of all leaves whose bounding box intersects \a box
+    void visitPoints(const Base::BoundBox3f& box, PointStoreVisitor&) const;
+    //@}
+
+    /** @name Queries */
+    //@{
+    /// indices of all points inside \a box
+    void searchPoints(const Base::BoundBox3f& box, std::vector<uint64_t>& indices) const;
+    /// indices of all points within \a radius around \a center
+    void searchPoints(const Base::Vector3f& center, float radius, std::vector<uint64_t>& indices) const;
+    //@}
+
+    /** @name Level of detail */
+    //@{
+    /** Adds about \a fraction of all points to \a kernel. The points are
+     * taken from every leaf, so they cover the whole cloud evenly.
+     */
+    void getSubsample(double fraction, PointKernel& kernel) const;
+    /// Adds about \a fraction of the points inside \a box to \a kernel.
+    void getSubsample(const Base::BoundBox3f& box, double fraction, PointKernel& kernel) const;
+    //@}
+
+    /// writes the points as ASCII without loading them all at once
+    void saveAscii(std::ostream&) const;
+
+private:
+    PointStore(const PointStore&);
+    PointStore& operator = (const PointStore&);
+
+private:
+    QFile* _file;
+    const Base::Vector3f* _points;
+    const Node* _nodes;
+    uint64_t _numPoints;
+    uint64_t _numNodes;
+};
+
+/**
+ * The PointStoreBuilder writes a point store file. The points are appended
+ * to the file while they are added, so they do not need to fit into memory.
+ * finish() sorts them in place into the octree on the mapped file.
+ */
+class PointsExport PointStoreBuilder
+{
+public:
+    /** Creates the file \a FileName. A node is split while it has more than
+     * \a leafSize points.
+     */
+    PointStoreBuilder(const char* FileName, unsigned long leafSize = 4096);
+    ~PointStoreBuilder();
+
+    void add(const Base::Vector3f& point);
+    void add(const Base::Vector3f* points, std::size_t count);
+    /// adds the transformed points of \a kernel
+    void add(const PointKernel& kernel);
+    /// sorts the points into the octree and completes the file
+    void finish();
+
+private:
+    void flush();
+    void build(Base::Vector3f* points);
+
+private:
+    QFile* _file;
+    unsigned long _leafSize;
+    uint64_t _numPoints;
+    Base::BoundBox3f _bbox;
+    std::vector<Base::Vector3f> _buffer;
+    std::vector<PointStore::Node> _nodes;
+};
+
+} // namespace Points
+
+
+#endif // POINTS_POINTSTORE_H
@@ -101,7 +101,7 @@ void PointKernel::Save (Base::Writer &writer) const
 {
     if (!writer.isForceXML()) {
         writer.Stream() << writer.ind()
-            << "<Points file=\"" << writer.addFile(writer.ObjectName.c_str(), this) << "\" " 
+            << "<Points file=\"" << writer.addFile(writer.ObjectName.c_str(), this, Base::Writer::FastCompression) << "\" " 
             << "mtrx=\"" << _Mtrx.toString() << "\"/>" << std::endl;
     }
 }
@@ -112,9 +112,8 @@ void PointKernel::SaveDocFile (Base::Writer &writer) const
     uint32_t uCt = (uint32_t)size();
     str << uCt;
     // store the data without transforming it
-    for (std::vector<value_type>::const_iterator it = _Points.begin(); it != _Points.end(); ++it) {
-        str << it->x << it->y << it->z;
-    }
+    if (uCt > 0)
+        str.writeArray(&(_Points[0].x), 3 * uCt);
 }
 
 void PointKernel::Restore(Base::XMLReader &reader)
@@ -140,11 +139,8 @@ void PointKernel::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt = 0;
     str >> uCt;
     _Points.resize(uCt);
-    for (unsigned long i=0; i < uCt; i++) {
-        float x, y, z;
-        str >> x >> y >> z;
-        _Points[i].Set(x,y,z);
-    }
+    if (uCt > 0)
+        str.readArray(&(_Points[0].x), 3 * uCt);
 }
 
 void PointKernel::save(const char* file) const
@@ -26,20 +26,30 @@
 #ifdef FC_OS_LINUX
 # include <unistd.h>
 #endif
+# include <algorithm>
+# include <cmath>
 # include <sstream>
 #endif
 
 
 #include "PointsAlgos.h"
 #include "Points.h"
+#include "PointStore.h"
 
 #include <Base/Exception.h>
 #include <Base/FileInfo.h>
 #include <Base/Console.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/TimeInfo.h>
 
-#include <boost/regex.hpp>
+#include <boost/bind.hpp>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <QtConcurrentMap>
 
 using namespace Points;
 
@@ -57,57 +67,416 @@ void PointsAlgos::Load(PointKernel &points, const char *FileName)
         throw Base::Exception("Unknown ending");
 }
 
-void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
+namespace Points {
+
+/**
+ * The AsciiReader parses an ASCII point cloud in memory without any regular
+ * expressions. The text is split into chunks at line ends that are parsed in
+ * parallel. Each chunk writes its points directly into the point array of the
+ * kernel, starting at the number of lines in front of it. Afterwards the ranges
+ * of the chunks are moved together to drop the lines that were skipped.
+ */
+class AsciiReader
 {
-    boost::regex rx("^\\s*([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    //boost::regex rx("(\\b[0-9]+\\.([0-9]+\\b)?|\\.[0-9]+\\b)");
-    //boost::regex rx("^\\s*(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s*$");
-    boost::cmatch what;
+public:
+    AsciiReader(const char* data, std::size_t size)
+      : _data(data), _size(size), _columns(0), _intensity(-1), _color(-1), _normal(-1)
+      , _points(0), _attributes(0), _transform(false)
+    {
+    }
 
-    Base::Vector3d pt;
-    int LineCnt=0;
-    std::string line;
-    Base::FileInfo fi(FileName);
+    /** Reads the points of the text. The layout of the columns is detected
+     * from the text of the first call only.
+     */
+    void Read(PointKernel& points, PointsAlgos::Attributes* attr);
+    /// continues with another text of the same layout
+    void SetData(const char* data, std::size_t size)
+    {
+        _data = data;
+        _size = size;
+    }
 
-    Base::ifstream tmp_str(fi, std::ios::in);
+private:
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+        unsigned long first; // index of the first point of the chunk
+        unsigned long count; // number of points read
+    };
 
-    // estimating size
-    while (std::getline(tmp_str,line))
-        LineCnt++;
+    enum { MaxColumns = 10 };
 
-    // resize the PointKernel
-    points.resize(LineCnt);
+    void DetectColumns();
+    void CountLines(Chunk& chunk);
+    void ParseChunk(Chunk& chunk);
+    static int ParseLine(const char* p, const char* end, double* values);
+    static const char* ParseNumber(const char* p, const char* end, double& value);
 
-    Base::SequencerLauncher seq( "Loading points...", LineCnt );
+    template <class T>
+    static void Compact(std::vector<T>& values, const std::vector<Chunk>& chunks, unsigned long total)
+    {
+        if (values.empty())
+            return;
+        unsigned long pos = 0;
+        for (std::vector<Chunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            if (it->first != pos) {
+                std::copy(values.begin() + it->first,
+                          values.begin() + it->first + it->count,
+                          values.begin() + pos);
+            }
+            pos += it->count;
+        }
+        values.resize(total);
+    }
 
-    // again to the beginning
-    Base::ifstream file(fi, std::ios::in);
-    LineCnt = 0;
+private:
+    const char* _data;
+    std::size_t _size;
+    int _columns;   // values per line
+    int _intensity; // column of the intensity or -1
+    int _color;     // first column of the color or -1
+    int _normal;    // first column of the normal or -1
+    PointKernel* _points;
+    PointsAlgos::Attributes* _attributes;
+    Base::Matrix4D _toInside; // inverse transformation of the kernel
+    bool _transform;          // false if the kernel isn't transformed
+};
 
-    try {
-        // read file
-        while (std::getline(file, line)) {
-            if (boost::regex_match(line.c_str(), what, rx)) {
-                pt.x = std::atof(what[1].first);
-                pt.y = std::atof(what[4].first);
-                pt.z = std::atof(what[7].first);
-
-                points.setPoint(LineCnt,pt);
-                seq.next();
-                LineCnt++;
+const char* AsciiReader::ParseNumber(const char* p, const char* end, double& value)
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    // collect up to 18 significant digits, the others only shift the exponent
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        digits = true;
+        if (mantissa < 100000000000000000ULL)
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            exponent++;
+    }
+    if (p != end && *p == '.') {
+        for (++p; p != end && *p >= '0' && *p <= '9'; ++p) {
+            digits = true;
+            if (mantissa < 100000000000000000ULL) {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!digits)
+        return 0;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negexp = false;
+        if (q != end && (*q == '-' || *q == '+')) {
+            negexp = (*q == '-');
+            ++q;
+        }
+        int e = 0;
+        bool expdigits = false;
+        for (; q != end && *q >= '0' && *q <= '9'; ++q) {
+            expdigits = true;
+            if (e < 10000)
+                e = e * 10 + (*q - '0');
+        }
+        if (!expdigits)
+            return 0;
+        exponent += negexp ? -e : e;
+        p = q;
+    }
+
+    double v = static_cast<double>(mantissa);
+    if (exponent < 0)
+        v = exponent >= -22 ? v / pow10[-exponent] : v * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        v = exponent <= 22 ? v * pow10[exponent] : v * std::pow(10.0, exponent);
+    value = negative ? -v : v;
+    return p;
+}
+
+int AsciiReader::ParseLine(const char* p, const char* end, double* values)
+{
+    // returns the number of values or -1 if the line has something else
+    int count = 0;
+    while (p != end) {
+        char c = *p;
+        if (c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r') {
+            ++p;
+            continue;
+        }
+        double v;
+        const char* q = ParseNumber(p, end, v);
+        if (!q)
+            return -1;
+        if (q != end && *q != ' ' && *q != '\t' && *q != ',' && *q != ';' && *q != '\r')
+            return -1;
+        if (count < MaxColumns)
+            values[count] = v;
+        count++;
+        p = q;
+    }
+    return count;
+}
+
+void AsciiReader::DetectColumns()
+{
+    // the first point defines the number of values per line
+    double values[MaxColumns];
+    int numLines = 0;
+    bool unitVectors = true;
+    const char* end = _data + _size;
+    for (const char* p = _data; p < end && numLines < 100;) {
+        const char* eol = std::find(p, end, '\n');
+        int num = ParseLine(p, eol, values);
+        if (num >= 3 && (_columns == 0 || num == _columns)) {
+            _columns = num;
+            numLines++;
+            if (num == 6) {
+                Base::Vector3d n(values[3], values[4], values[5]);
+                if (std::fabs(n.Length() - 1.0) > 0.01)
+                    unitVectors = false;
             }
         }
+        p = (eol == end) ? end : eol + 1;
+    }
+
+    switch (_columns) {
+    case 4:
+        _intensity = 3;
+        break;
+    case 6:
+        if (unitVectors)
+            _normal = 3;
+        else
+            _color = 3;
+        break;
+    case 7:
+        _intensity = 3;
+        _color = 4;
+        break;
+    case 9:
+        _color = 3;
+        _normal = 6;
+        break;
+    case 10:
+        _intensity = 3;
+        _color = 4;
+        _normal = 7;
+        break;
+    default:
+        break;
+    }
+}
+
+void AsciiReader::CountLines(Chunk& chunk)
+{
+    chunk.count = std::count(chunk.begin, chunk.end, '\n');
+    if (chunk.begin != chunk.end && *(chunk.end - 1) != '\n')
+        chunk.count++;
+}
+
+void AsciiReader::ParseChunk(Chunk& chunk)
+{
+    double values[MaxColumns];
+    std::vector<float>* intensity = 0;
+    std::vector<App::Color>* colors = 0;
+    std::vector<Base::Vector3f>* normals = 0;
+    std::vector<PointKernel::value_type>& kernel = _points->getBasicPoints();
+    if (_attributes) {
+        if (_intensity >= 0)
+            intensity = &_attributes->intensity;
+        if (_color >= 0)
+            colors = &_attributes->colors;
+        if (_normal >= 0)
+            normals = &_attributes->normals;
+    }
+
+    unsigned long index = chunk.first;
+    for (const char* p = chunk.begin; p < chunk.end;) {
+        const char* eol = std::find(p, chunk.end, '\n');
+        if (ParseLine(p, eol, values) == _columns) {
+            // PointKernel::setPoint() would invert the transformation for each point
+            if (_transform) {
+                Base::Vector3d pnt = _toInside * Base::Vector3d(values[0], values[1], values[2]);
+                kernel[index].Set(static_cast<float>(pnt.x), static_cast<float>(pnt.y), static_cast<float>(pnt.z));
+            }
+            else {
+                kernel[index].Set(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+            }
+            if (intensity)
+                (*intensity)[index] = static_cast<float>(values[_intensity]);
+            if (colors) {
+                App::Color& c = (*colors)[index];
+                c.r = static_cast<float>(std::min<double>(std::max<double>(values[_color  ], 0.0), 255.0) / 255.0);
+                c.g = static_cast<float>(std::min<double>(std::max<double>(values[_color+1], 0.0), 255.0) / 255.0);
+                c.b = static_cast<float>(std::min<double>(std::max<double>(values[_color+2], 0.0), 255.0) / 255.0);
+            }
+            if (normals) {
+                (*normals)[index].Set(static_cast<float>(values[_normal  ]),
+                                      static_cast<float>(values[_normal+1]),
+                                      static_cast<float>(values[_normal+2]));
+            }
+            index++;
+        }
+        p = (eol == chunk.end) ? chunk.end : eol + 1;
+    }
+
+    chunk.count = index - chunk.first;
+}
+
+void AsciiReader::Read(PointKernel& points, PointsAlgos::Attributes* attr)
+{
+    if (_columns == 0)
+        DetectColumns();
+    if (_columns == 0) {
+        points.clear();
+        return;
+    }
+
+    // split the text at line ends, big files are read in parallel
+    std::size_t numChunks = 1;
+    if (_size >= 4000000)
+        numChunks = 4 * std::max<int>(1, QThread::idealThreadCount());
+    std::size_t step = _size / numChunks + 1;
+    const char* end = _data + _size;
+    std::vector<Chunk> chunks;
+    for (const char* p = _data; p < end;) {
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = std::find(std::min<const char*>(p + step, end), end, '\n');
+        if (chunk.end != end)
+            ++chunk.end;
+        chunk.first = 0;
+        chunk.count = 0;
+        chunks.push_back(chunk);
+        p = chunk.end;
+    }
+
+    // every line may be a point, so reserve space for all of them
+    QtConcurrent::blockingMap(chunks, boost::bind(&AsciiReader::CountLines, this, _1));
+    unsigned long numLines = 0;
+    for (std::vector<Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        it->first = numLines;
+        numLines += it->count;
+    }
+
+    _points = &points;
+    _attributes = attr;
+    _toInside = points.getTransform();
+    _transform = (_toInside != Base::Matrix4D());
+    if (_transform)
+        _toInside.inverse();
+    points.resize(numLines);
+    if (attr) {
+        attr->intensity.clear();
+        attr->colors.clear();
+        attr->normals.clear();
+        if (_intensity >= 0)
+            attr->intensity.resize(numLines);
+        if (_color >= 0)
+            attr->colors.resize(numLines);
+        if (_normal >= 0)
+            attr->normals.resize(numLines);
+    }
+
+    QtConcurrent::blockingMap(chunks, boost::bind(&AsciiReader::ParseChunk, this, _1));
+
+    // move the points of all chunks together
+    unsigned long numPoints = 0;
+    for (std::vector<Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+        numPoints += it->count;
+    Compact(points.getBasicPoints(), chunks, numPoints);
+    if (attr) {
+        Compact(attr->intensity, chunks, numPoints);
+        Compact(attr->colors, chunks, numPoints);
+        Compact(attr->normals, chunks, numPoints);
+    }
+}
+
+}
+
+void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
+{
+    Attributes attr;
+    LoadAscii(points, attr, FileName);
+}
+
+void PointsAlgos::LoadAscii(PointKernel &points, Attributes &attr, const char *FileName)
+{
+    Base::TimeInfo start;
+
+    // read the file directly from memory if it can be mapped
+    QFile file(QString::fromUtf8(FileName));
+    if (!file.open(QIODevice::ReadOnly))
+        throw Base::FileException("File to load not existing or not readable", FileName);
+    qint64 size = file.size();
+    uchar* data = 0;
+    if (size > 0)
+        data = file.map(0, size);
+
+    try {
+        if (data) {
+            LoadAscii(points, &attr, reinterpret_cast<const char*>(data), size);
+        }
+        else {
+            QByteArray content = file.readAll();
+            LoadAscii(points, &attr, content.constData(), content.size());
+        }
     }
     catch (...) {
         points.clear();
         throw Base::Exception("Reading in points failed.");
     }
 
-    // now remove the last points from the kernel
-    // Note: first we allocate memory corresponding to the number of lines (points and comments)
-    //       and read in the file twice. But then the size of the kernel is too high
-    if (LineCnt < (int)points.size())
-        points.erase(LineCnt, points.size());
+    float seconds = Base::TimeInfo::diffTimeF(start, Base::TimeInfo());
+    if (seconds > 0.0f) {
+        Base::Console().Log("Read %lu points from %s with %.1f MB/s\n",
+            static_cast<unsigned long>(points.size()), FileName,
+            static_cast<double>(size) / (1024.0 * 1024.0 * seconds));
+    }
+}
+
+void PointsAlgos::LoadAscii(PointKernel &points, Attributes* attr, const char* data, std::size_t size)
+{
+    AsciiReader reader(data, size);
+    reader.Read(points, attr);
+}
+
+void PointsAlgos::LoadAscii(PointStoreBuilder &store, const char *FileName)
+{
+    QFile file(QString::fromUtf8(FileName));
+    if (!file.open(QIODevice::ReadOnly))
+        throw Base::FileException("File to load not existing or not readable", FileName);
+
+    // Parse the file in blocks of whole lines, so that only one block
+    // at a time is in memory. The layout of the columns is detected from
+    // the first block and kept for the others.
+    const qint64 blockSize = 64 * 1024 * 1024;
+    QByteArray block;
+    AsciiReader reader(0, 0);
+    while (!file.atEnd()) {
+        block.append(file.read(blockSize));
+        int end = file.atEnd() ? block.size() : block.lastIndexOf('\n') + 1;
+        if (end <= 0)
+            continue;
+        PointKernel points;
+        reader.SetData(block.constData(), end);
+        reader.Read(points, 0);
+        store.add(points);
+        block.remove(0, end);
+    }
 }
@@ -25,22 +25,56 @@
 #define _PointsAlgos_h_
 
 #include "Points.h"
+#include <App/Material.h>
+#include <vector>
 
 namespace Points
 {
+class PointStoreBuilder;
 
 /** The Points algorithms container class
  */
 class PointsExport PointsAlgos
 {
 public:
+  /** The values of the optional columns of an ASCII point cloud. An array
+   * is empty if the file has no such columns, otherwise it has one entry
+   * per point.
+   */
+  struct Attributes
+  {
+    std::vector<float> intensity;
+    std::vector<App::Color> colors;
+    std::vector<Base::Vector3f> normals;
+  };
+
   /** Load a point cloud
    */
   static void Load(PointKernel&, const char *FileName);
   /** Load a point cloud
    */
   static void LoadAscii(PointKernel&, const char *FileName);
-
+  /** Load a point cloud together with the values of the columns following
+   * the coordinates. The number of values per line determines their meaning:
+   * \li 3: x y z
+   * \li 4: x y z intensity
+   * \li 6: x y z r g b, or x y z nx ny nz if the values are unit vectors
+   * \li 7: x y z intensity r g b
+   * \li 9: x y z r g b nx ny nz
+   * \li 10: x y z intensity r g b nx ny nz
+   * Colors are expected in the range 0 to 255. With any other number of
+   * values only the coordinates are read.
+   */
+  static void LoadAscii(PointKernel&, Attributes&, const char *FileName);
+  /** Parses an ASCII point cloud in memory, e.g. a memory-mapped file.
+   * Lines that do not consist of numbers only, or whose number of values
+   * differs from the first point, are skipped.
+   */
+  static void LoadAscii(PointKernel&, Attributes*, const char* data, std::size_t size);
+  /** Adds the points of an ASCII point cloud to a point store. The file
+   * is read in blocks, so it may be larger than the available memory.
+   */
+  static void LoadAscii(PointStoreBuilder&, const char *FileName);
 };
 
 } // namespace Points
@@ -27,6 +27,7 @@
 #include <Base/Builder3D.h>
 #include <Base/VectorPy.h>
 #include <Base/GeometryPyCXX.h>
+#include <Base/PyBuffer.h>
 
 // inclusion of the generated files (generated out of PointsPy.xml)
 #include "PointsPy.h"
@@ -168,6 +169,70 @@ PyObject* PointsPy::addPoints(PyObject * args)
     Py_Return;
 }
 
+PyObject* PointsPy::getPointBuffer(PyObject * args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return 0;
+
+    const PointKernel* kernel = getPointKernelPtr();
+    std::vector<float> coords;
+    coords.reserve(3 * kernel->size());
+    for (PointKernel::const_point_iterator it = kernel->begin(); it != kernel->end(); ++it) {
+        coords.push_back((float)it->x);
+        coords.push_back((float)it->y);
+        coords.push_back((float)it->z);
+    }
+
+    return Base::PyBuffer::toByteArray(coords.empty() ? 0 : &coords[0], coords.size() * sizeof(float));
+}
+
+PyObject* PointsPy::setFromBuffer(PyObject * args)
+{
+    PyObject *obj;
+    if (!PyArg_ParseTuple(args, "O", &obj))
+        return 0;
+
+    try {
+        Base::PyBuffer buffer(obj, "fd");
+        if (buffer.count() % 3 != 0) {
+            PyErr_SetString(PyExc_ValueError, "Number of coordinates must be a multiple of three");
+            return 0;
+        }
+
+        // the points are given in global coordinates
+        Base::Matrix4D mat = getPointKernelPtr()->getTransform();
+        bool transform = (mat != Base::Matrix4D());
+        if (transform)
+            mat.inverseGauss();
+
+        std::size_t count = buffer.count() / 3;
+        std::vector<PointKernel::value_type> points(count);
+        if (buffer.format() == 'f') {
+            const float* data = static_cast<const float*>(buffer.data());
+            for (std::size_t i = 0; i < count; i++, data += 3)
+                points[i].Set(data[0], data[1], data[2]);
+        }
+        else {
+            const double* data = static_cast<const double*>(buffer.data());
+            for (std::size_t i = 0; i < count; i++, data += 3)
+                points[i].Set((float)data[0], (float)data[1], (float)data[2]);
+        }
+
+        if (transform) {
+            for (std::vector<PointKernel::value_type>::iterator it = points.begin(); it != points.end(); ++it)
+                *it = mat * (*it);
+        }
+
+        getPointKernelPtr()->setBasicPoints(points);
+    }
+    catch (const Base::Exception& e) {
+        PyErr_SetString(PyExc_TypeError, e.what());
+        return 0;
+    }
+
+    Py_Return;
+}
+
 Py::Int PointsPy::getCountPoints(void) const
 {
     return Py::Int((long)getPointKernelPtr()->size());
@@ -0,0 +1,189 @@
+#   (c) 2014 FreeCAD Developers      LGPL
+
+import FreeCAD, os, unittest, tempfile, random, struct, time, Points
+
+
+#---------------------------------------------------------------------------
+# define the functions to test the FreeCAD points module
+#---------------------------------------------------------------------------
+
+
+class PointStoreTestCases(unittest.TestCase):
+    def setUp(self):
+        # the coordinates are multiples of 1/8, so they are exact as float and
+        # the bounds of the queries below don't coincide with any point
+        random.seed(1)
+        self.points = []
+        for i in range(5000):
+            self.points.append((random.randint(0,80)/8.0, random.randint(0,40)/8.0, random.randint(0,8)/8.0))
+        self.ascFile = tempfile.gettempdir() + os.sep + "PointStoreTest.asc"
+        self.storeFile = tempfile.gettempdir() + os.sep + "PointStoreTest.fps"
+        f = open(self.ascFile, "w")
+        for p in self.points:
+            # the intensity column must be skipped by the store
+            f.write("%s %s %s 0.5\n" % p)
+        f.close()
+        # a small leaf size gives an octree of several levels
+        Points.buildStore(self.ascFile, self.storeFile, 64)
+
+    def sortedPoints(self, pts):
+        return sorted([(v.x, v.y, v.z) for v in pts.Points])
+
+    def testReadAll(self):
+        pts = Points.readStore(self.storeFile)
+        self.failUnless(pts.CountPoints == len(self.points))
+        self.failUnless(self.sortedPoints(pts) == sorted(self.points))
+
+    def testSearchBox(self):
+        box = FreeCAD.BoundBox(2.0625, 1.0625, 0.1875, 5.0625, 3.0625, 0.6875)
+        pts = Points.readStore(self.storeFile, box)
+        inside = [p for p in self.points if box.isInside(FreeCAD.Vector(p[0], p[1], p[2]))]
+        self.failUnless(len(inside) > 0)
+        self.failUnless(self.sortedPoints(pts) == sorted(inside))
+
+    def testSearchRadius(self):
+        center = FreeCAD.Vector(5, 2.5, 0.5)
+        pts = Points.readStore(self.storeFile, center, 1.3)
+        inside = [p for p in self.points if (FreeCAD.Vector(p[0], p[1], p[2]) - center).Length < 1.3]
+        self.failUnless(len(inside) > 0)
+        self.failUnless(self.sortedPoints(pts) == sorted(inside))
+
+    def testNoStore(self):
+        self.failUnlessRaises(Exception, Points.readStore, self.ascFile)
+
+    def tearDown(self):
+        os.remove(self.ascFile)
+        os.remove(self.storeFile)
+
+
+class PointsBufferTestCases(unittest.TestCase):
+    def setUp(self):
+        self.coords = [0.0, 0.0, 0.0, 1.5, 0.0, 0.0, 0.0, 2.5, 0.0, 0.0, 0.0, 3.5]
+
+    def testRoundTrip(self):
+        pts = Points.Points()
+        pts.setFromBuffer(bytearray(struct.pack('12f', *self.coords)))
+        self.failUnless(pts.CountPoints == 4)
+        data = pts.getPointBuffer()
+        self.failUnless(list(struct.unpack('12f', bytes(data))) == self.coords)
+
+    def testCoordinateCount(self):
+        pts = Points.Points()
+        self.failUnlessRaises(ValueError, pts.setFromBuffer, bytearray(struct.pack('4f', 1, 2, 3, 4)))
+
+    def testItemSize(self):
+        # ten bytes are no whole number of float32 values
+        pts = Points.Points()
+        self.failUnlessRaises(TypeError, pts.setFromBuffer, bytearray(10))
+
+    def testProperties(self):
+        doc = FreeCAD.newDocument("PointsBufferTest")
+        try:
+            feature = doc.addObject("Points::Feature", "Points")
+            feature.addProperty("Points::PropertyGreyValueList", "Intensity")
+            feature.addProperty("Points::PropertyNormalList", "Normal")
+            feature.Intensity = bytearray(struct.pack('3f', 0.25, 0.5, 0.75))
+            self.failUnless(feature.Intensity == [0.25, 0.5, 0.75])
+            feature.Normal = bytearray(struct.pack('6f', 1, 0, 0, 0, 0, 1))
+            self.failUnless(len(feature.Normal) == 2)
+            self.failUnless(feature.Normal[1] == FreeCAD.Vector(0, 0, 1))
+            self.failUnlessRaises(ValueError, setattr, feature, "Normal", bytearray(struct.pack('4f', 1, 0, 0, 0)))
+        finally:
+            FreeCAD.closeDocument("PointsBufferTest")
+
+
+class PointsAsciiTestCases(unittest.TestCase):
+    # the number of values per line decides which attributes an ASCII file has
+    def setUp(self):
+        self.doc = FreeCAD.newDocument("PointsAsciiTest")
+        self.ascFile = os.path.join(tempfile.gettempdir(), "PointsAsciiTest.asc")
+
+    def load(self, lines):
+        f = open(self.ascFile, "w")
+        for line in lines:
+            f.write(" ".join([str(v) for v in line]) + "\n")
+        f.close()
+        Points.insert(self.ascFile, self.doc.Name)
+        return self.doc.Objects[-1]
+
+    def checkPoints(self, feature):
+        self.failUnless(feature.Points.CountPoints == 2)
+        self.failUnless(feature.Points.Points[1] == FreeCAD.Vector(4, 5, 6))
+
+    def checkColors(self, feature):
+        self.failUnless(len(feature.Color) == 2)
+        for value, expected in zip(feature.Color[1][:3], (0.0, 1.0, 0.2)):
+            self.failUnless(abs(value - expected) < 1e-6)
+
+    def checkNormals(self, feature):
+        self.failUnless(feature.Normal == [FreeCAD.Vector(1, 0, 0), FreeCAD.Vector(0, 0, 1)])
+
+    def testThreeColumns(self):
+        feature = self.load([(1, 2, 3), (4, 5, 6)])
+        self.checkPoints(feature)
+        self.failIf(hasattr(feature, "Intensity"))
+        self.failIf(hasattr(feature, "Color"))
+        self.failIf(hasattr(feature, "Normal"))
+
+    def testFourColumns(self):
+        feature = self.load([(1, 2, 3, 0.25), (4, 5, 6, 0.75)])
+        self.checkPoints(feature)
+        self.failUnless(feature.Intensity == [0.25, 0.75])
+        self.failIf(hasattr(feature, "Color"))
+
+    def testSixColumnsColors(self):
+        feature = self.load([(1, 2, 3, 255, 255, 255), (4, 5, 6, 0, 255, 51)])
+        self.checkPoints(feature)
+        self.checkColors(feature)
+        self.failIf(hasattr(feature, "Normal"))
+
+    def testSixColumnsNormals(self):
+        feature = self.load([(1, 2, 3, 1, 0, 0), (4, 5, 6, 0, 0, 1)])
+        self.checkPoints(feature)
+        self.checkNormals(feature)
+        self.failIf(hasattr(feature, "Color"))
+
+    def testSevenColumns(self):
+        feature = self.load([(1, 2, 3, 0.25, 255, 255, 255), (4, 5, 6, 0.75, 0, 255, 51)])
+        self.checkPoints(feature)
+        self.failUnless(feature.Intensity == [0.25, 0.75])
+        self.checkColors(feature)
+        self.failIf(hasattr(feature, "Normal"))
+
+    def testNineColumns(self):
+        feature = self.load([(1, 2, 3, 255, 255, 255, 1, 0, 0), (4, 5, 6, 0, 255, 51, 0, 0, 1)])
+        self.checkPoints(feature)
+        self.checkColors(feature)
+        self.checkNormals(feature)
+        self.failIf(hasattr(feature, "Intensity"))
+
+    def testTenColumns(self):
+        feature = self.load([(1, 2, 3, 0.25, 255, 255, 255, 1, 0, 0), (4, 5, 6, 0.75, 0, 255, 51, 0, 0, 1)])
+        self.checkPoints(feature)
+        self.failUnless(feature.Intensity == [0.25, 0.75])
+        self.checkColors(feature)
+        self.checkNormals(feature)
+
+    def testSkipOtherLines(self):
+        # a header and lines with another number of values are skipped
+        feature = self.load([("x", "y", "z", "i"), (1, 2, 3, 0.25), (7, 8, 9), (4, 5, 6, 0.75)])
+        self.checkPoints(feature)
+        self.failUnless(feature.Intensity == [0.25, 0.75])
+
+    def testReadTime(self):
+        count = 500000
+        f = open(self.ascFile, "w")
+        for i in range(count):
+            f.write("%f %f %f %f %d %d %d %f %f %f\n" % (random.random(), random.random(), random.random(),
+                    random.random(), i % 256, (i * 7) % 256, (i * 13) % 256, 0.0, 0.0, 1.0))
+        f.close()
+        start = time.time()
+        Points.insert(self.ascFile, self.doc.Name)
+        seconds = time.time() - start
+        self.failUnless(self.doc.Objects[-1].Points.CountPoints == count)
+        FreeCAD.Console.PrintMessage("Reading %d points with 10 columns: %.3f s\n" % (count, seconds))
+
+    def tearDown(self):
+        FreeCAD.closeDocument(self.doc.Name)
+        if os.path.exists(self.ascFile):
+            os.remove(self.ascFile)
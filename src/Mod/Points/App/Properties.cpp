@@ -31,6 +31,7 @@
 #include <Base/Exception.h>
 #include <Base/Matrix.h>
 #include <Base/Persistence.h>
+#include <Base/PyBuffer.h>
 #include <Base/Stream.h>
 #include <Base/Writer.h>
 #include <Base/VectorPy.h>
@@ -113,8 +114,29 @@ void PropertyGreyValueList::setPyObject(PyObject *value)
     else if (PyFloat_Check(value)) {
         setValue((float)PyFloat_AsDouble(value));
     } 
+    else if (PyObject_CheckBuffer(value)) {
+        // flat float32 or float64 array, e.g. from numpy
+        std::vector<float> values;
+        try {
+            Base::PyBuffer buffer(value, "fd");
+            values.resize(buffer.count());
+            if (buffer.format() == 'f') {
+                const float* data = static_cast<const float*>(buffer.data());
+                std::copy(data, data + buffer.count(), values.begin());
+            }
+            else {
+                const double* data = static_cast<const double*>(buffer.data());
+                for (std::size_t i = 0; i < buffer.count(); i++)
+                    values[i] = (float)data[i];
+            }
+        }
+        catch (const Base::Exception& e) {
+            throw Py::TypeError(e.what());
+        }
+        setValues(values);
+    }
     else {
-        std::string error = std::string("type must be float or list of float, not ");
+        std::string error = std::string("type must be float, list of float or buffer, not ");
         error += value->ob_type->tp_name;
         throw Py::TypeError(error);
     }
@@ -132,7 +154,7 @@ void PropertyGreyValueList::Save (Base::Writer &writer) const
     }
     else {
         writer.Stream() << writer.ind() << "<FloatList file=\"" << 
-        writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -152,9 +174,8 @@ void PropertyGreyValueList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
-    for (std::vector<float>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << *it;
-    }
+    if (uCt > 0)
+        str.writeArray(&(_lValueList[0]), uCt);
 }
 
 void PropertyGreyValueList::RestoreDocFile(Base::Reader &reader)
@@ -163,9 +184,8 @@ void PropertyGreyValueList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<float> values(uCt);
-    for (std::vector<float>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> *it;
-    }
+    if (uCt > 0)
+        str.readArray(&(values[0]), uCt);
     setValues(values);
 }
 
@@ -298,8 +318,33 @@ void PropertyNormalList::setPyObject(PyObject *value)
         val.setPyObject( value );
         setValue(Base::convertTo<Base::Vector3f>(val.getValue()));
     }
+    else if (PyObject_CheckBuffer(value)) {
+        // flat float32 or float64 array (x0,y0,z0,x1,...), e.g. from numpy
+        std::vector<Base::Vector3f> values;
+        try {
+            Base::PyBuffer buffer(value, "fd");
+            if (buffer.count() % 3 != 0)
+                throw Py::ValueError("Number of coordinates must be a multiple of three");
+            std::size_t count = buffer.count() / 3;
+            values.resize(count);
+            if (buffer.format() == 'f') {
+                const float* data = static_cast<const float*>(buffer.data());
+                for (std::size_t i = 0; i < count; i++, data += 3)
+                    values[i].Set(data[0], data[1], data[2]);
+            }
+            else {
+                const double* data = static_cast<const double*>(buffer.data());
+                for (std::size_t i = 0; i < count; i++, data += 3)
+                    values[i].Set((float)data[0], (float)data[1], (float)data[2]);
+            }
+        }
+        catch (const Base::Exception& e) {
+            throw Py::TypeError(e.what());
+        }
+        setValues(values);
+    }
     else {
-        std::string error = std::string("type must be 'Vector' or list of 'Vector', not ");
+        std::string error = std::string("type must be 'Vector', list of 'Vector' or buffer, not ");
         error += value->ob_type->tp_name;
         throw Py::TypeError(error);
     }
@@ -308,7 +353,7 @@ void PropertyNormalList::setPyObject(PyObject *value)
 void PropertyNormalList::Save (Base::Writer &writer) const
 {
     if (!writer.isForceXML()) {
-        writer.Stream() << writer.ind() << "<VectorList file=\"" << writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.Stream() << writer.ind() << "<VectorList file=\"" << writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -328,9 +373,8 @@ void PropertyNormalList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
-    for (std::vector<Base::Vector3f>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << it->x << it->y << it->z;
-    }
+    if (uCt > 0)
+        str.writeArray(&(_lValueList[0].x), 3 * uCt);
 }
 
 void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
@@ -339,9 +383,8 @@ void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<Base::Vector3f> values(uCt);
-    for (std::vector<Base::Vector3f>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> it->x >> it->y >> it->z;
-    }
+    if (uCt > 0)
+        str.readArray(&(values[0].x), 3 * uCt);
     setValues(values);
 }
 
@@ -550,7 +593,7 @@ void PropertyCurvatureList::removeIndices( const std::vector<unsigned long>& uIn
 void PropertyCurvatureList::Save (Base::Writer &writer) const
 {
     if (!writer.isForceXML()) {
-        writer.Stream() << writer.ind() << "<CurvatureList file=\"" << writer.addFile(getName(), this) << "\"/>" << std::endl;
+        writer.Stream() << writer.ind() << "<CurvatureList file=\"" << writer.addFile(getName(), this, Base::Writer::FastCompression) << "\"/>" << std::endl;
     }
 }
 
@@ -570,12 +613,9 @@ void PropertyCurvatureList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
+    // CurvatureInfo consists of eight floats in the order of the file format
     if (uCt > 0)
-    for (std::vector<CurvatureInfo>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << it->fMaxCurvature << it->fMinCurvature;
-        str << it->cMaxCurvDir.x << it->cMaxCurvDir.y << it->cMaxCurvDir.z;
-        str << it->cMinCurvDir.x << it->cMinCurvDir.y << it->cMinCurvDir.z;
-    }
+        str.writeArray(&(_lValueList[0].fMaxCurvature), 8 * uCt);
 }
 
 void PropertyCurvatureList::RestoreDocFile(Base::Reader &reader)
@@ -584,11 +624,8 @@ void PropertyCurvatureList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<CurvatureInfo> values(uCt);
-    for (std::vector<CurvatureInfo>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> it->fMaxCurvature >> it->fMinCurvature;
-        str >> it->cMaxCurvDir.x >> it->cMaxCurvDir.y >> it->cMaxCurvDir.z;
-        str >> it->cMinCurvDir.x >> it->cMinCurvDir.y >> it->cMinCurvDir.z;
-    }
+    if (uCt > 0)
+        str.readArray(&(values[0].fMaxCurvature), 8 * uCt);
 
     setValues(values);
 }
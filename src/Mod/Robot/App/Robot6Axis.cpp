@@ -42,6 +42,10 @@
 #include "Robot6Axis.h"
 #include "RobotAlgos.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #ifndef M_PI
     #define M_PI    3.14159265358979323846 /* pi */
 #endif
@@ -67,6 +71,307 @@ AxisDefinition KukaIR500[6] = {
 };
 
 
+namespace Robot {
+
+/** The KinematicSolver keeps the solvers of a kinematic chain alive between the calls.
+ * For robots with a spherical wrist (the axes 4 to 6 intersect in one point) and a
+ * planar arm, like most industrial 6-axis robots, the axes are calculated in closed
+ * form. All other robots and the placements where the closed form fails are handled
+ * by the numerical solver, starting from the given axes.
+ * \note A solver must not be used by several threads at a time.
+ */
+class KinematicSolver
+{
+public:
+    KinematicSolver(const Chain& chain, const JntArray& min, const JntArray& max)
+      : chain(chain), min(min), max(max)
+      , fksolver(this->chain)
+      , iksolverv(this->chain)
+      , iksolver(this->chain, this->min, this->max, fksolver, iksolverv, 100, 1e-6)
+    {
+        spherical = initClosedForm();
+    }
+
+    bool hasClosedForm() const
+    {
+        return spherical;
+    }
+
+    /** Calculates the axes for \a dest, the solution closest to \a seed is taken.
+     * Returns -1 if the placement can't be reached, otherwise a bit mask of the
+     * axes that are outside their limits.
+     */
+    int solve(const Frame& dest, const JntArray& seed, JntArray& result)
+    {
+        if (spherical) {
+            int mask = solveClosedForm(dest, seed, result);
+            if (mask == 0)
+                return 0;
+            // the numerical solver may still find a solution within the limits
+            JntArray numeric(6);
+            if (iksolver.CartToJnt(seed, dest, numeric) >= 0 && checkLimits(numeric) == 0) {
+                result = numeric;
+                return 0;
+            }
+            return mask;
+        }
+
+        if (iksolver.CartToJnt(seed, dest, result) < 0)
+            return -1;
+        return checkLimits(result);
+    }
+
+    int checkLimits(const JntArray& q) const
+    {
+        int mask = 0;
+        for (int i=0; i<6; i++) {
+            if (q(i) < min(i) || q(i) > max(i))
+                mask |= 1 << i;
+        }
+        return mask;
+    }
+
+private:
+    /// Gets the Denavit-Hartenberg parameters of \a frame, see Frame::DH()
+    static bool toDH(const Frame& frame, double& a, double& alpha, double& d, double& theta)
+    {
+        const double eps = 1e-9;
+        Vector x = frame.M.UnitX();
+        if (fabs(x.z()) > eps)
+            return false;
+        theta = atan2(x.y(), x.x());
+        alpha = atan2(frame.M(2,1), frame.M(2,2));
+        a = dot(frame.p, x);
+        d = frame.p.z();
+        Vector p(a * cos(theta), a * sin(theta), d);
+        return Equal(p, frame.p, eps * std::max<double>(1.0, frame.p.Norm()));
+    }
+
+    bool initClosedForm()
+    {
+        if (chain.getNrOfSegments() != 6 || chain.getNrOfJoints() != 6)
+            return false;
+        for (int i=0; i<6; i++) {
+            const Segment& segment = chain.getSegment(i);
+            if (segment.getJoint().getType() != Joint::RotZ)
+                return false;
+            if (!toDH(segment.getFrameToTip(), a[i], alpha[i], d[i], theta[i]))
+                return false;
+        }
+
+        // planar arm: the axes 2 and 3 are parallel and perpendicular to axis 1
+        // spherical wrist: the axes 4 to 6 intersect in one point
+        const double eps = 1e-9;
+        double length = 1.0;
+        for (int i=0; i<6; i++)
+            length = std::max<double>(length, std::max<double>(fabs(a[i]), fabs(d[i])));
+        if (fabs(cos(alpha[0])) > eps || fabs(sin(alpha[1])) > eps || cos(alpha[1]) < 0 ||
+            fabs(cos(alpha[2])) > eps || fabs(cos(alpha[3])) > eps ||
+            fabs(cos(alpha[4])) > eps || fabs(sin(alpha[5])) > eps)
+            return false;
+        if (fabs(d[1]) > eps * length || fabs(d[2]) > eps * length || fabs(d[4]) > eps * length ||
+            fabs(a[3]) > eps * length || fabs(a[4]) > eps * length || fabs(a[5]) > eps * length)
+            return false;
+        if (fabs(a[1]) < eps * length || (fabs(a[2]) < eps * length && fabs(d[3]) < eps * length))
+            return false;
+        return true;
+    }
+
+    /// Chooses the angle of \a phi + k*2pi within the limits of \a axis that is closest to \a seed
+    bool fitToLimits(int axis, double phi, double seed, double& q) const
+    {
+        // closest to the seed
+        q = phi + 2 * M_PI * floor((seed - phi) / (2 * M_PI) + 0.5);
+        if (q >= min(axis) && q <= max(axis))
+            return true;
+        double lower = phi + 2 * M_PI * ceil((min(axis) - phi) / (2 * M_PI));
+        if (lower > max(axis))
+            return false;
+        double upper = phi + 2 * M_PI * floor((max(axis) - phi) / (2 * M_PI));
+        q = (fabs(lower - seed) < fabs(upper - seed)) ? lower : upper;
+        return true;
+    }
+
+    int solveClosedForm(const Frame& dest, const JntArray& seed, JntArray& result)
+    {
+        // wrist centre
+        Vector z6 = dest.M.UnitZ();
+        Vector wc = dest.p - z6 * (d[5] * cos(alpha[5]));
+
+        // the two shoulder solutions
+        double phi1[2];
+        if (fabs(wc.x()) + fabs(wc.y()) < 1e-12)
+            phi1[0] = seed(0) + theta[0]; // singular: keep axis 1
+        else
+            phi1[0] = atan2(wc.y(), wc.x());
+        phi1[1] = phi1[0] + M_PI;
+
+        // the link from axis 3 to the wrist centre
+        double b = -d[3] * sin(alpha[2]);
+        double l3 = sqrt(a[2]*a[2] + b*b);
+        double beta = atan2(b, a[2]);
+
+        double bestDistance = 0;
+        int bestMask = -1;
+        JntArray q(6);
+        for (int i=0; i<2; i++) {
+            Frame f1 = chain.getSegment(0).pose(phi1[i] - theta[0]);
+            Vector w = f1.Inverse(wc);
+            double r2 = w.x()*w.x() + w.y()*w.y();
+            double c = (r2 - a[1]*a[1] - l3*l3) / (2 * a[1] * l3);
+            if (c > 1.0 + 1e-9 || c < -1.0 - 1e-9)
+                continue;
+            c = std::max<double>(-1.0, std::min<double>(1.0, c));
+            for (int j=0; j<2; j++) {
+                double gamma = (j == 0 ? acos(c) : -acos(c));
+                double phi2 = atan2(w.y(), w.x()) - atan2(l3 * sin(gamma), a[1] + l3 * cos(gamma));
+                double phi3 = gamma - beta;
+
+                Frame f3 = f1 * chain.getSegment(1).pose(phi2 - theta[1])
+                              * chain.getSegment(2).pose(phi3 - theta[2]);
+                // R36 = Rz(phi4)Rx(alpha4)Rz(phi5)Rx(alpha5)Rz(phi6)Rx(alpha6), with the rotations
+                // about x of +-90 degrees for the axes 4 and 5 this turns into z-y-z Euler angles
+                int s4 = sin(alpha[3]) > 0 ? 1 : -1;
+                int s5 = sin(alpha[4]) > 0 ? 1 : -1;
+                int e = (s4 == s5) ? -1 : 1;
+                KDL::Rotation n = f3.M.Inverse() * dest.M * KDL::Rotation::RotX(-alpha[5]);
+                if (s4 == s5)
+                    n = n * KDL::Rotation::RotX(-s4 * M_PI);
+
+                double sb = sqrt(n(0,2)*n(0,2) + n(1,2)*n(1,2));
+                for (int k=0; k<2; k++) {
+                    double A, B, C;
+                    if (sb < 1e-9) {
+                        // singular wrist: keep axis 4
+                        A = seed(3) + theta[3];
+                        B = n(2,2) > 0 ? 0 : M_PI;
+                        double sum = atan2(-n(0,1), n(1,1));
+                        C = n(2,2) > 0 ? sum - A : A - sum;
+                        if (k > 0)
+                            break;
+                    }
+                    else {
+                        B = atan2(sb, n(2,2));
+                        A = atan2(n(1,2), n(0,2));
+                        C = atan2(n(2,1), -n(2,0));
+                        if (k > 0) {
+                            B = -B;
+                            A += M_PI;
+                            C += M_PI;
+                        }
+                    }
+
+                    double phi[6] = { phi1[i], phi2, phi3, A, -s4 * B, e * C };
+                    int mask = 0;
+                    double distance = 0;
+                    for (int m=0; m<6; m++) {
+                        if (!fitToLimits(m, phi[m] - theta[m], seed(m), q(m))) {
+                            mask |= 1 << m;
+                            double p = phi[m] - theta[m];
+                            q(m) = p + 2 * M_PI * floor((seed(m) - p) / (2 * M_PI) + 0.5);
+                        }
+                        distance += fabs(q(m) - seed(m));
+                    }
+
+                    // prefer solutions within the limits, then the closest one
+                    bool better = bestMask < 0 ||
+                        (mask == 0 && bestMask != 0) ||
+                        ((mask == 0) == (bestMask == 0) && distance < bestDistance);
+                    if (better) {
+                        bestMask = mask;
+                        bestDistance = distance;
+                        result = q;
+                    }
+                }
+            }
+        }
+
+        if (bestMask < 0)
+            return -1;
+
+        // make sure that the placement is really reached
+        Frame check;
+        fksolver.JntToCart(result, check);
+        if (!Equal(check, dest, 1e-6 * std::max<double>(1.0, dest.p.Norm())))
+            return -1;
+        return bestMask;
+    }
+
+private:
+    Chain chain;
+    JntArray min;
+    JntArray max;
+    ChainFkSolverPos_recursive fksolver;
+    ChainIkSolverVel_pinv iksolverv;
+    ChainIkSolverPos_NR_JL iksolver;
+
+    bool spherical;
+    double a[6], alpha[6], d[6], theta[6];
+};
+
+}
+
+namespace {
+
+/// A part of the placements handled by one thread
+struct TrajectoryChunk
+{
+    unsigned long begin, end;
+    JntArray seed;
+    /// axes after the first and the last placement
+    JntArray first, last;
+    unsigned long reached;
+};
+
+class TrajectorySolver
+{
+public:
+    TrajectorySolver(const Chain& chain, const JntArray& min, const JntArray& max, const double* rotDir,
+                     const std::vector<Frame>& frames, std::vector<double>& axes, std::vector<int>& status)
+      : chain(chain), min(min), max(max), rotDir(rotDir), frames(frames), axes(axes), status(status)
+    {
+    }
+
+    void solveChunk(TrajectoryChunk& chunk)
+    {
+        KinematicSolver solver(chain, min, max);
+        solveRange(solver, chunk);
+    }
+
+    /// Each placement starts from the axes of the previous one
+    void solveRange(KinematicSolver& solver, TrajectoryChunk& chunk)
+    {
+        JntArray q = chunk.seed;
+        JntArray result(6);
+        chunk.reached = 0;
+        for (unsigned long i = chunk.begin; i < chunk.end; i++) {
+            int mask = solver.solve(frames[i], q, result);
+            status[i] = mask;
+            if (mask >= 0)
+                q = result;
+            if (mask == 0)
+                chunk.reached++;
+            if (i == chunk.begin)
+                chunk.first = q;
+            // an unreachable placement gets the axes of the previous one
+            for (int j=0; j<6; j++)
+                axes[6*i+j] = rotDir[j] * (q(j)/(M_PI/180));
+        }
+        chunk.last = q;
+    }
+
+private:
+    const Chain& chain;
+    const JntArray& min;
+    const JntArray& max;
+    const double* rotDir;
+    const std::vector<Frame>& frames;
+    std::vector<double>& axes;
+    std::vector<int>& status;
+};
+
+}
+
 TYPESYSTEM_SOURCE(Robot::Robot6Axis , Base::Persistence);
 
 Robot6Axis::Robot6Axis()
@@ -102,6 +407,7 @@ void Robot6Axis::setKinematic(const AxisDefinition KinDef[6])
 
 	// for now and testing
     Kinematic = temp;
+    Solver.reset();
 
 	// get the actuall TCP out of tha axis
 	calcTcp();
@@ -212,12 +518,12 @@ void Robot6Axis::Restore(XMLReader &reader)
 
 
         if(reader.hasAttribute("rotDir"))
-            Velocity[i] = reader.getAttributeAsFloat("rotDir");
+            RotDir[i] = reader.getAttributeAsFloat("rotDir");
         else
-            Velocity[i] = 1.0;
+            RotDir[i] = 1.0;
         // read the axis constraints
-        Min(i)  = reader.getAttributeAsFloat("maxAngle")* (M_PI/180);
-        Max(i)  = reader.getAttributeAsFloat("minAngle")* (M_PI/180);
+        Max(i)  = reader.getAttributeAsFloat("maxAngle")* (M_PI/180);
+        Min(i)  = reader.getAttributeAsFloat("minAngle")* (M_PI/180);
         if(reader.hasAttribute("AxisVelocity"))
             Velocity[i] = reader.getAttributeAsFloat("AxisVelocity");
         else
@@ -225,6 +531,7 @@ void Robot6Axis::Restore(XMLReader &reader)
         Actuall(i) = reader.getAttributeAsFloat("Pos");
     }
     Kinematic = Temp;
+    Solver.reset();
 
     calcTcp();
 
@@ -234,19 +541,14 @@ void Robot6Axis::Restore(XMLReader &reader)
 
 bool Robot6Axis::setTo(const Placement &To)
 {
-	//Creation of the solvers:
-	ChainFkSolverPos_recursive fksolver1(Kinematic);//Forward position solver
-	ChainIkSolverVel_pinv iksolver1v(Kinematic);//Inverse velocity solver
-	ChainIkSolverPos_NR_JL iksolver1(Kinematic,Min,Max,fksolver1,iksolver1v,100,1e-6);//Maximum 100 iterations, stop at accuracy 1e-6
-	 
 	//Creation of jntarrays:
 	JntArray result(Kinematic.getNrOfJoints());
 	 
 	//Set destination frame
 	Frame F_dest = Frame(KDL::Rotation::Quaternion(To.getRotation()[0],To.getRotation()[1],To.getRotation()[2],To.getRotation()[3]),KDL::Vector(To.getPosition()[0],To.getPosition()[1],To.getPosition()[2]));
 	 
-	// solve
-	if(iksolver1.CartToJnt(Actuall,F_dest,result) < 0)
+	// solve, only solutions within the axis limits are accepted
+	if(getSolver().solve(F_dest,Actuall,result) != 0)
 		return false;
 	else{
 		Actuall = result;
@@ -255,6 +557,77 @@ bool Robot6Axis::setTo(const Placement &To)
 	}
 }
 
+KinematicSolver& Robot6Axis::getSolver(void) const
+{
+    if (!Solver)
+        Solver.reset(new KinematicSolver(Kinematic, Min, Max));
+    return *Solver;
+}
+
+bool Robot6Axis::hasClosedForm(void) const
+{
+    return getSolver().hasClosedForm();
+}
+
+unsigned long Robot6Axis::solve(const std::vector<Base::Placement>& To,
+                                std::vector<double>& axes, std::vector<int>& status) const
+{
+    std::vector<Frame> frames;
+    frames.reserve(To.size());
+    for (std::vector<Base::Placement>::const_iterator it = To.begin(); it != To.end(); ++it)
+        frames.push_back(toFrame(*it));
+
+    unsigned long count = frames.size();
+    axes.resize(6 * count);
+    status.resize(count);
+
+    // Long trajectories are split into chunks that are calculated in parallel. As the
+    // axes at the end of the previous chunk aren't known yet, each chunk starts from
+    // the solution of its first placement for the start of the previous chunk.
+    unsigned long numChunks = 1;
+    if (count >= 1000)
+        numChunks = 4 * (unsigned long)std::max<int>(QThread::idealThreadCount(), 1);
+    unsigned long step = (count + numChunks - 1) / std::max<unsigned long>(numChunks, 1);
+
+    KinematicSolver& solver = getSolver();
+    std::vector<TrajectoryChunk> chunks;
+    JntArray seed = Actuall;
+    JntArray result(6);
+    for (unsigned long i = 0; i < count; i += step) {
+        TrajectoryChunk chunk;
+        chunk.begin = i;
+        chunk.end = std::min<unsigned long>(i + step, count);
+        if (i > 0 && solver.solve(frames[i], seed, result) >= 0)
+            seed = result;
+        chunk.seed = seed;
+        chunks.push_back(chunk);
+    }
+
+    TrajectorySolver trajectory(Kinematic, Min, Max, RotDir, frames, axes, status);
+    if (chunks.size() > 1)
+        QtConcurrent::blockingMap(chunks, boost::bind(&TrajectorySolver::solveChunk, &trajectory, _1));
+    else if (!chunks.empty())
+        trajectory.solveRange(solver, chunks.front());
+
+    // Afterwards each chunk is checked against the end of the previous one. Where a
+    // serial run would have continued on a different solution, e.g. with another
+    // wrist configuration, the chunk is calculated again from there.
+    for (std::size_t i = 1; i < chunks.size(); i++) {
+        const JntArray& q = chunks[i-1].last;
+        TrajectoryChunk& chunk = chunks[i];
+        int mask = solver.solve(frames[chunk.begin], q, result);
+        if (mask != status[chunk.begin] || !Equal(mask >= 0 ? result : q, chunk.first, 1e-9)) {
+            chunk.seed = q;
+            trajectory.solveRange(solver, chunk);
+        }
+    }
+
+    unsigned long reached = 0;
+    for (std::vector<TrajectoryChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+        reached += it->reached;
+    return reached;
+}
+
 Base::Placement Robot6Axis::getTcp(void)
 {
 	double x,y,z,w;
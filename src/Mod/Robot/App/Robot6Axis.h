@@ -30,8 +30,12 @@
 #include <Base/Persistence.h>
 #include <Base/Placement.h>
 
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
 namespace Robot
 {
+class KinematicSolver;
 
 /// Definition of the Axis properties
 struct AxisDefinition {
@@ -69,6 +73,18 @@ public:
     
     /// set the robot to that position, calculates the Axis
 	bool setTo(const Base::Placement &To);
+    /** Calculates the axes for a sequence of TCP placements, e.g. the waypoints of a trajectory.
+     * Each placement starts from the axes of the previous one, the first one from the current
+     * axes. Long sequences are split into chunks which are calculated in parallel.
+     * \a axes gets six values per placement in degrees (see getAxis()), \a status one value
+     * per placement: -1 if it can't be reached, otherwise a bit mask of the axes that are
+     * outside their limits. The robot itself is not moved.
+     * Returns the number of placements reached within the limits.
+     */
+    unsigned long solve(const std::vector<Base::Placement> &To,
+                        std::vector<double> &axes, std::vector<int> &status) const;
+    /// Whether the axes are calculated in closed form (robots with a spherical wrist)
+    bool hasClosedForm(void) const;
 	bool setAxis(int Axis,double Value);
 	double getAxis(int Axis);
     double getMaxAngle(int Axis);
@@ -90,6 +106,10 @@ protected:
 	double Velocity[6];
 	double RotDir  [6];
 
+private:
+    KinematicSolver& getSolver(void) const;
+    mutable boost::shared_ptr<KinematicSolver> Solver;
+
 };
 
 } //namespace Part
@@ -27,6 +27,7 @@
 #include <Base/PlacementPy.h>
 #include <Base/MatrixPy.h>
 #include <Base/Exception.h>
+#include <Base/PyBuffer.h>
 #include <sstream>
 
 // inclusion of the generated files (generated out of Robot6AxisPy.xml)
@@ -76,6 +77,35 @@ PyObject* Robot6AxisPy::check(PyObject * /*args*/)
     return 0;
 }
 
+PyObject* Robot6AxisPy::solve(PyObject * args)
+{
+    PyObject *list;
+    if (!PyArg_ParseTuple(args, "O!", &(PyList_Type), &list))
+        return 0;
+
+    std::vector<Base::Placement> placements;
+    Py::List items(list);
+    placements.reserve(items.size());
+    for (Py::List::iterator it = items.begin(); it != items.end(); ++it) {
+        if (!PyObject_TypeCheck((*it).ptr(), &(Base::PlacementPy::Type))) {
+            std::string error = std::string("type must be 'Placement', not ");
+            error += (*it).ptr()->ob_type->tp_name;
+            PyErr_SetString(PyExc_TypeError, error.c_str());
+            return 0;
+        }
+        placements.push_back(*static_cast<Base::PlacementPy*>((*it).ptr())->getPlacementPtr());
+    }
+
+    std::vector<double> axes;
+    std::vector<int> status;
+    getRobot6AxisPtr()->solve(placements, axes, status);
+
+    Py::Tuple tuple(2);
+    tuple.setItem(0, Py::asObject(Base::PyBuffer::toByteArray(axes.empty() ? 0 : &axes[0], axes.size() * sizeof(double))));
+    tuple.setItem(1, Py::asObject(Base::PyBuffer::toByteArray(status.empty() ? 0 : &status[0], status.size() * sizeof(int))));
+    return Py::new_reference_to(tuple);
+}
+
 
 
 Py::Float Robot6AxisPy::getAxis1(void) const
@@ -119,3 +119,18 @@ void Simulation::reset(void)
     Axis[5] = Rob.getAxis(5);
 
 }
+
+unsigned long Simulation::sample(double tick, std::vector<double> &axes, std::vector<int> &status)
+{
+    assert(tick > 0.0);
+
+    std::vector<Base::Placement> positions;
+    double duration = Trac.getDuration();
+    unsigned long count = (unsigned long)(duration / tick) + 1;
+    positions.reserve(count);
+    Base::Placement inverseTool = Tool.inverse();
+    for (unsigned long i=0; i<count; i++)
+        positions.push_back(Trac.getPosition(std::min<double>(i * tick, duration)) * inverseTool);
+
+    return Rob.solve(positions, axes, status);
+}
@@ -29,6 +29,7 @@
 #include <Base/Vector3D.h>
 #include <Base/Placement.h>
 #include <string>
+#include <vector>
 
 #include "Trajectory.h"
 #include "Robot6Axis.h"
@@ -57,6 +58,11 @@ public:
     void setToTime(float t);
     // apply the start axis angles and set to time 0. Restors the exact start position
     void reset(void);
+    /** Calculates the axes for the whole trajectory in steps of \a tick seconds without
+     * moving the robot, see Robot6Axis::solve() for the content of \a axes and \a status.
+     * Returns the number of reached samples.
+     */
+    unsigned long sample(double tick, std::vector<double> &axes, std::vector<int> &status);
 
 	double Pos;
 	double Axis[6];
@@ -0,0 +1,107 @@
+#***************************************************************************
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, os, sys, unittest, math, time, array, Robot
+from FreeCAD import Vector, Rotation, Placement
+
+#---------------------------------------------------------------------------
+# define the test cases to test the FreeCAD Robot module
+#---------------------------------------------------------------------------
+
+
+def makeTrajectory(tcp, count):
+    """ A circle around the Tcp with a turning tool. Every 997th placement can't be reached """
+    placements = []
+    for i in range(count):
+        t = 2 * math.pi * i / 1000.0
+        pos = tcp.Base + Vector(100 * math.cos(t), 100 * math.sin(t), 20 * math.sin(3 * t))
+        if i % 997 == 500:
+            pos = pos + Vector(1e5, 0, 0)
+        rot = Rotation(Vector(0,0,1), 20 * math.sin(t)).multiply(tcp.Rotation)
+        placements.append(Placement(pos, rot))
+    return placements
+
+
+class RobotSolveTestCases(unittest.TestCase):
+    def setUp(self):
+        self.Robot = Robot.Robot6Axis()
+        self.Robot.Axis1 = 10
+        self.Robot.Axis2 = -20
+        self.Robot.Axis3 = 30
+        self.Robot.Axis4 = 10
+        self.Robot.Axis5 = 40
+        self.Robot.Axis6 = 10
+        self.Start = [self.Robot.Axis1, self.Robot.Axis2, self.Robot.Axis3,
+                      self.Robot.Axis4, self.Robot.Axis5, self.Robot.Axis6]
+
+    def setAxes(self, axes):
+        self.Robot.Axis1 = axes[0]
+        self.Robot.Axis2 = axes[1]
+        self.Robot.Axis3 = axes[2]
+        self.Robot.Axis4 = axes[3]
+        self.Robot.Axis5 = axes[4]
+        self.Robot.Axis6 = axes[5]
+
+    def solve(self, placements):
+        axes, status = self.Robot.solve(placements)
+        return (array.array('d', bytes(axes)), array.array('i', bytes(status)))
+
+    def testSolveInChunks(self):
+        # long lists are calculated in chunks, the result must be the same as
+        # solving one placement after the other
+        placements = makeTrajectory(self.Robot.Tcp, 4000)
+        axes, status = self.solve(placements)
+        self.failUnless(len(axes) == 6 * len(placements))
+        self.failUnless(len(status) == len(placements))
+        self.failUnless(status[500] == -1)
+
+        for i in range(len(placements)):
+            a, s = self.solve([placements[i]])
+            self.failUnless(s[0] == status[i], "status of placement %d differs" % i)
+            for j in range(6):
+                self.failUnless(abs(a[j] - axes[6*i+j]) < 1e-4, "axis %d of placement %d differs" % (j+1, i))
+            if s[0] >= 0:
+                self.setAxes(a)
+
+    def testSolveDoesNotMove(self):
+        placements = makeTrajectory(self.Robot.Tcp, 1500)
+        self.solve(placements)
+        axes = [self.Robot.Axis1, self.Robot.Axis2, self.Robot.Axis3,
+                self.Robot.Axis4, self.Robot.Axis5, self.Robot.Axis6]
+        self.failUnless(axes == self.Start)
+
+    def testSolveTime(self):
+        tcp = self.Robot.Tcp
+        for count in (1000, 10000, 100000):
+            placements = makeTrajectory(tcp, count)
+            start=time.time()
+            axes, status = self.solve(placements)
+            FreeCAD.Console.PrintMessage("Robot6Axis.solve of %d placements: %.3f s\n" % (count, time.time()-start))
+            self.failUnless(len(status) == count)
+
+        placements = makeTrajectory(tcp, 10000)
+        start=time.time()
+        for p in placements:
+            try:
+                self.Robot.Tcp = p
+            except Exception:
+                pass
+        FreeCAD.Console.PrintMessage("Setting the Tcp of %d placements: %.3f s\n" % (len(placements), time.time()-start))
@@ -26,9 +26,15 @@
 #include "GCS.h"
 #include "qp_eq.h"
 #include <Eigen/QR>
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+#include <Eigen/Sparse>
+#endif
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
+#include <boost/bind.hpp>
+
+#include <QtConcurrentMap>
 
 // http://forum.freecadweb.org/viewtopic.php?f=3&t=4651&start=40
 namespace Eigen {
@@ -134,6 +140,15 @@ namespace GCS
 
 typedef boost::adjacency_list <boost::vecS, boost::vecS, boost::undirectedS> Graph;
 
+// A decoupled component of the system that is solved on its own
+struct ComponentTask
+{
+    int cid;
+    SubSystem *subsys;
+    SubSystem *subsysAux;
+    int result;
+};
+
 ///////////////////////////////////////
 // Solver
 ///////////////////////////////////////
@@ -814,6 +829,7 @@ void System::initSolution()
 
         subSystems.push_back(NULL);
         subSystemsAux.push_back(NULL);
+        solvedLevels.push_back(0);
         if (clist0.size() > 0)
             subSystems[cid] = new SubSystem(clist0, plists[cid], reductionmaps[cid]);
         if (clist1.size() > 0)
@@ -825,6 +841,8 @@ void System::initSolution()
 
 void System::setReference()
 {
+    // the solutions of the components refer to the former reference
+    std::fill(solvedLevels.begin(), solvedLevels.end(), 0);
     reference.clear();
     reference.reserve(plist.size());
     for (VEC_pD::const_iterator param=plist.begin();
@@ -854,21 +872,38 @@ int System::solve(bool isFine, Algorithm alg)
     if (!isInit)
         return Failed;
 
-    bool isReset = false;
+    // The components are independent of each other, so they are solved in
+    // parallel. A component without moving constraints keeps the solution of
+    // a previous call, because neither its reference nor its constraints have
+    // changed since initSolution().
+    int level = isFine ? 2 : 1;
+    std::vector<ComponentTask> tasks;
+    for (int cid=0; cid < int(subSystems.size()); cid++) {
+        if ((subSystems[cid] || subSystemsAux[cid]) &&
+            (subSystemsAux[cid] || solvedLevels[cid] < level)) {
+            ComponentTask task;
+            task.cid = cid;
+            task.subsys = subSystems[cid];
+            task.subsysAux = subSystemsAux[cid];
+            task.result = Success;
+            tasks.push_back(task);
+        }
+    }
+
     // return success by default in order to permit coincidence constraints to be applied
     // even if no other system has to be solved
     int res = Success;
-    for (int cid=0; cid < int(subSystems.size()); cid++) {
-        if ((subSystems[cid] || subSystemsAux[cid]) && !isReset) {
-             resetToReference();
-             isReset = true;
-        }
-        if (subSystems[cid] && subSystemsAux[cid])
-            res = std::max(res, solve(subSystems[cid], subSystemsAux[cid], isFine));
-        else if (subSystems[cid])
-            res = std::max(res, solve(subSystems[cid], isFine, alg));
-        else if (subSystemsAux[cid])
-            res = std::max(res, solve(subSystemsAux[cid], isFine, alg));
+    if (!tasks.empty()) {
+        resetToReference();
+        if (tasks.size() == 1)
+            solveComponent(tasks.front(), isFine, alg);
+        else
+            QtConcurrent::blockingMap(tasks, boost::bind(&System::solveComponent, this, _1, isFine, alg));
+    }
+    for (std::vector<ComponentTask>::const_iterator it=tasks.begin(); it != tasks.end(); ++it) {
+        res = std::max(res, it->result);
+        if (!it->subsysAux)
+            solvedLevels[it->cid] = (it->result == Success) ? level : 0;
     }
     if (res == Success) {
         for (std::set<Constraint *>::const_iterator constr=redundant.begin();
@@ -881,6 +916,16 @@ int System::solve(bool isFine, Algorithm alg)
     return res;
 }
 
+void System::solveComponent(ComponentTask &task, bool isFine, Algorithm alg)
+{
+    if (task.subsys && task.subsysAux)
+        task.result = solve(task.subsys, task.subsysAux, isFine);
+    else if (task.subsys)
+        task.result = solve(task.subsys, isFine, alg);
+    else if (task.subsysAux)
+        task.result = solve(task.subsysAux, isFine, alg);
+}
+
 int System::solve(SubSystem *subsys, bool isFine, Algorithm alg)
 {
     if (alg == BFGS)
@@ -977,8 +1022,17 @@ int System::solve_LM(SubSystem* subsys)
         return Success;
 
     Eigen::VectorXd e(csize), e_new(csize); // vector of all function errors (every constraint is one function)
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+    // Each constraint depends on a few parameters only, so the Jacobian and
+    // the normal equations are kept sparse
+    Eigen::SparseMatrix<double> J(csize, xsize); // Jacobi of the subsystem
+    Eigen::SparseMatrix<double> JtJ(xsize, xsize), A(xsize, xsize), I(xsize, xsize);
+    Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > ldlt;
+    I.setIdentity();
+#else
     Eigen::MatrixXd J(csize, xsize);        // Jacobi of the subsystem
-    Eigen::MatrixXd A(xsize, xsize);
+    Eigen::MatrixXd JtJ(xsize, xsize), A(xsize, xsize);
+#endif
     Eigen::VectorXd x(xsize), h(xsize), x_new(xsize), g(xsize), diag_A(xsize);
 
     subsys->redirectParams();
@@ -1010,12 +1064,12 @@ int System::solve_LM(SubSystem* subsys)
         // J^T J, J^T e
         subsys->calcJacobi(J);;
 
-        A = J.transpose()*J;
+        JtJ = J.transpose()*J;
         g = J.transpose()*e;
 
         // Compute ||J^T e||_inf
         double g_inf = g.lpNorm<Eigen::Infinity>();
-        diag_A = A.diagonal(); // save diagonal entries so that augmentation can be later canceled
+        diag_A = JtJ.diagonal();
 
         // check for convergence
         if (g_inf <= eps1) {
@@ -1027,16 +1081,33 @@ int System::solve_LM(SubSystem* subsys)
         if (iter == 0)
             mu = tau * diag_A.lpNorm<Eigen::Infinity>();
 
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+        // the pattern of the augmented matrix is the same for every damping factor
+        A = JtJ + I;
+        ldlt.analyzePattern(A);
+#endif
+
         // determine increment using adaptive damping
         int k=0;
         while (k < 50) {
             // augment normal equations A = A+uI
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+            A = JtJ + mu*I;
+
+            //solve augmented functions A*h=-g
+            ldlt.factorize(A);
+            if (ldlt.info() == Eigen::Success)
+                h = ldlt.solve(g);
+            double rel_error = ldlt.info() == Eigen::Success ? (A*h - g).norm() / g.norm() : 1.;
+#else
+            A = JtJ;
             for (int i=0; i < xsize; ++i)
                 A(i,i) += mu;
 
             //solve augmented functions A*h=-g
             h = A.fullPivLu().solve(g);
             double rel_error = (A*h - g).norm() / g.norm();
+#endif
 
             // check if solving works
             if (rel_error < 1e-5) {
@@ -1083,8 +1154,6 @@ int System::solve_LM(SubSystem* subsys)
 
             mu*=nu;
             nu*=2.0;
-            for (int i=0; i < xsize; ++i) // restore diagonal J^T J entries
-                A(i,i) = diag_A(i);
 
             k++;
         }
@@ -1115,7 +1184,11 @@ int System::solve_DL(SubSystem* subsys)
 
     Eigen::VectorXd x(xsize), x_new(xsize);
     Eigen::VectorXd fx(csize), fx_new(csize);
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+    Eigen::SparseMatrix<double> Jx(csize, xsize), Jx_new(csize, xsize);
+#else
     Eigen::MatrixXd Jx(csize, xsize), Jx_new(csize, xsize);
+#endif
     Eigen::VectorXd g(xsize), h_sd(xsize), h_gn(xsize), h_dl(xsize);
 
     subsys->redirectParams();
@@ -1125,6 +1198,16 @@ int System::solve_DL(SubSystem* subsys)
     subsys->calcResidual(fx, err);
     subsys->calcJacobi(Jx);
 
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+    // If the Jacobian has full column rank the Gauss-Newton step is unique and
+    // the sparse QR decomposition finds the same step as the dense LU
+    // decomposition. Otherwise, the system is underconstrained and the dense
+    // LU decomposition is used to get the same step as before. The pattern of
+    // the Jacobian doesn't change, so the ordering is computed once.
+    Eigen::SparseQR< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > qr;
+    qr.analyzePattern(Jx);
+#endif
+
     g = Jx.transpose()*(-fx);
 
     // get the infinity norm fx_inf and g_inf
@@ -1158,7 +1241,16 @@ int System::solve_DL(SubSystem* subsys)
             h_sd  = alpha*g;
 
             // get the gauss-newton step
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+            if (csize >= xsize)
+                qr.factorize(Jx);
+            if (csize >= xsize && qr.info() == Eigen::Success && qr.rank() == xsize)
+                h_gn = qr.solve(-fx);
+            else
+                h_gn = Eigen::MatrixXd(Jx).fullPivLu().solve(-fx);
+#else
             h_gn = Jx.fullPivLu().solve(-fx);
+#endif
             double rel_error = (Jx*h_gn + fx).norm() / fx.norm();
             if (rel_error > 1e15)
                 break;
@@ -1431,6 +1523,8 @@ void System::applySolution()
 void System::undoSolution()
 {
     resetToReference();
+    // the solution was rejected, so a following solve() must not reuse it
+    std::fill(solvedLevels.begin(), solvedLevels.end(), 0);
 }
 
 int System::diagnose()
@@ -1454,6 +1548,59 @@ int System::diagnose()
     redundant.clear();
     conflictingTags.clear();
     redundantTags.clear();
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+    // The transposed Jacobian of the constraints is assembled from the
+    // parameters each constraint depends on. Its sparse QR decomposition
+    // moves the columns of dependent constraints behind the rank.
+    std::vector<Constraint *> clistJ;
+    std::vector< Eigen::Triplet<double> > entries;
+    for (std::vector<Constraint *>::iterator constr=clist.begin();
+         constr != clist.end(); ++constr) {
+        (*constr)->revertParams();
+        if ((*constr)->getTag() >= 0) {
+            int col = int(clistJ.size());
+            clistJ.push_back(*constr);
+            SET_pD cparams(c2p[*constr].begin(), c2p[*constr].end());
+            for (SET_pD::const_iterator param=cparams.begin();
+                 param != cparams.end(); ++param) {
+                MAP_pD_I::const_iterator it = pIndex.find(*param);
+                if (it != pIndex.end())
+                    entries.push_back(Eigen::Triplet<double>(it->second, col, (*constr)->grad(*param)));
+            }
+        }
+    }
+
+    if (clistJ.size() > 0) {
+        Eigen::SparseMatrix<double> JT(plist.size(), clistJ.size());
+        JT.setFromTriplets(entries.begin(), entries.end());
+        Eigen::SparseQR< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > qrJT(JT);
+        int paramsNum = qrJT.rows();
+        int constrNum = qrJT.cols();
+        int rank = qrJT.rank();
+
+        if (constrNum > rank) { // conflicting or redundant constraints
+            // Express the dependent columns of R by the independent ones.
+            // Scaled by the pivots this gives the entries that eliminating
+            // the non zeros above the pivots would leave in R.
+            // (the transposed copy has sorted indices, unlike R itself)
+            Eigen::SparseMatrix<double> RT = qrJT.matrixR().transpose();
+            Eigen::SparseMatrix<double> R11T = RT.topLeftCorner(rank, rank);
+            Eigen::MatrixXd R12 = Eigen::MatrixXd(RT.block(rank, 0, constrNum-rank, rank)).transpose();
+            Eigen::MatrixXd X = R11T.transpose().triangularView<Eigen::Upper>().solve(R12);
+            Eigen::VectorXd pivots = R11T.diagonal();
+
+            std::vector< std::vector<Constraint *> > conflictGroups(constrNum-rank);
+            for (int j=rank; j < constrNum; j++) {
+                for (int row=0; row < rank; row++) {
+                    if (fabs(pivots[row] * X(row,j-rank)) > 1e-10) {
+                        int origCol = qrJT.colsPermutation().indices()[row];
+                        conflictGroups[j-rank].push_back(clistJ[origCol]);
+                    }
+                }
+                int origCol = qrJT.colsPermutation().indices()[j];
+                conflictGroups[j-rank].push_back(clistJ[origCol]);
+            }
+#else
     Eigen::MatrixXd J(clist.size(), plist.size());
     int count=0;
     for (std::vector<Constraint *>::iterator constr=clist.begin();
@@ -1503,6 +1650,7 @@ int System::diagnose()
                 int origCol = qrJT.colsPermutation().indices()[j];
                 conflictGroups[j-rank].push_back(clist[origCol]);
             }
+#endif
 
             // try to remove the conflicting constraints and solve the
             // system in order to check if the removed constraints were
@@ -1628,6 +1776,7 @@ void System::clearSubSystems()
     free(subSystemsAux);
     subSystems.clear();
     subSystemsAux.clear();
+    solvedLevels.clear();
 }
 
 double lineSearch(SubSystem *subsys, Eigen::VectorXd &xdir)
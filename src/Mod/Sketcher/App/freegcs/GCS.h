@@ -27,6 +27,7 @@
 
 namespace GCS
 {
+    struct ComponentTask;
 
     ///////////////////////////////////////
     // Solver
@@ -57,6 +58,7 @@ namespace GCS
         std::map<double *,std::vector<Constraint *> > p2c; // parameter to constraint adjacency list
 
         std::vector<SubSystem *> subSystems, subSystemsAux;
+        VEC_I solvedLevels; // per component 0: unsolved, 1: solved roughly, 2: solved finely
         void clearSubSystems();
 
         VEC_D reference;
@@ -78,6 +80,7 @@ namespace GCS
         int solve_BFGS(SubSystem *subsys, bool isFine);
         int solve_LM(SubSystem *subsys);
         int solve_DL(SubSystem *subsys);
+        void solveComponent(ComponentTask &task, bool isFine, Algorithm alg);
     public:
         System();
         System(std::vector<Constraint *> clist_);
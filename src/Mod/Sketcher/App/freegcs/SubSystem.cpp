@@ -270,6 +270,27 @@ void SubSystem::calcJacobi(Eigen::MatrixXd &jacobi)
     calcJacobi(plist, jacobi);
 }
 
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+void SubSystem::calcJacobi(Eigen::SparseMatrix<double> &jacobi)
+{
+    // only the parameters a constraint depends on give non-zero entries
+    std::vector< Eigen::Triplet<double> > entries;
+    entries.reserve(4*csize);
+    for (int i=0; i < csize; i++) {
+        std::map<Constraint *,VEC_pD >::const_iterator it = c2p.find(clist[i]);
+        if (it == c2p.end())
+            continue;
+        for (VEC_pD::const_iterator p=it->second.begin();
+             p != it->second.end(); ++p) {
+            int j = int(*p - &pvals[0]);
+            entries.push_back(Eigen::Triplet<double>(i, j, clist[i]->grad(*p)));
+        }
+    }
+    jacobi.resize(csize, psize);
+    jacobi.setFromTriplets(entries.begin(), entries.end());
+}
+#endif
+
 void SubSystem::calcGrad(VEC_pD &params, Eigen::VectorXd &grad)
 {
     assert(grad.size() == int(params.size()));
@@ -27,6 +27,9 @@
 #undef max
 
 #include <Eigen/Core>
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+#include <Eigen/SparseCore>
+#endif
 #include "Constraints.h"
 
 namespace GCS
@@ -69,6 +72,9 @@ namespace GCS
         void calcResidual(Eigen::VectorXd &r, double &err);
         void calcJacobi(VEC_pD &params, Eigen::MatrixXd &jacobi);
         void calcJacobi(Eigen::MatrixXd &jacobi);
+#if EIGEN_VERSION_AT_LEAST(3,2,0)
+        void calcJacobi(Eigen::SparseMatrix<double> &jacobi);
+#endif
         void calcGrad(VEC_pD &params, Eigen::VectorXd &grad);
         void calcGrad(Eigen::VectorXd &grad);
 
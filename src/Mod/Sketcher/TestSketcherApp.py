@@ -20,7 +20,7 @@
 #**************************************************************************
 
 
-import FreeCAD, os, sys, unittest, Part, Sketcher
+import FreeCAD, os, sys, time, unittest, Part, Sketcher
 App = FreeCAD
 
 def CreateBoxSketchSet(SketchFeature):
@@ -82,6 +82,24 @@ def CreateSlotPlateInnerSet(SketchFeature):
 	SketchFeature.addConstraint(Sketcher.Constraint('Coincident',7,2,8,1)) 
 	SketchFeature.addConstraint(Sketcher.Constraint('Coincident',8,2,5,1))
 	
+def CreateStairsSketchSet(SketchFeature, Steps):
+	# a chain of alternating horizontal and vertical lines with three constraints
+	# per line, i.e. Steps=3 gives about 10 and Steps=3300 about 10000 constraints
+	for i in range(Steps):
+		p1 = App.Vector(10.0*((i+1)//2)+0.3*(i%3), 10.0*(i//2), 0)
+		if i % 2 == 0:
+			p2 = App.Vector(p1.x+10.0, p1.y+0.5, 0)
+		else:
+			p2 = App.Vector(p1.x-0.5, p1.y+10.0, 0)
+		SketchFeature.addGeometry(Part.Line(p1,p2))
+		if i > 0:
+			SketchFeature.addConstraint(Sketcher.Constraint('Coincident',i-1,2,i,1))
+		if i % 2 == 0:
+			SketchFeature.addConstraint(Sketcher.Constraint('Horizontal',i))
+		else:
+			SketchFeature.addConstraint(Sketcher.Constraint('Vertical',i))
+		SketchFeature.addConstraint(Sketcher.Constraint('Distance',i,10.0))
+	
 
 
 #---------------------------------------------------------------------------
@@ -114,7 +132,56 @@ class SketcherSolverTestCases(unittest.TestCase):
 		self.Doc.recompute()
 		self.failUnless(len(self.Slot.Shape.Edges) == 9)
 	
-	
+	def testStairsCase(self):
+		self.Stairs = self.Doc.addObject('Sketcher::SketchObject','SketchStairs')
+		CreateStairsSketchSet(self.Stairs, 200)
+		self.Doc.recompute()
+		self.failUnless(len(self.Stairs.Shape.Edges) == 200)
+		# moving a point of the sketch
+		self.Stairs.movePoint(100,2,App.Vector(520.0,520.0,0))
+		self.Doc.recompute()
+		self.failUnless(len(self.Stairs.Shape.Edges) == 200)
+
+	def testStairsScaling(self):
+		# fixing the start point makes the stairs fully constrained, so the
+		# Gauss-Newton step is unique and the sparse factorization is used
+		for steps in (3, 33, 330, 3300):
+			stairs = self.Doc.addObject('Sketcher::SketchObject','SketchStairs%d' % steps)
+			CreateStairsSketchSet(stairs, steps)
+			stairs.addConstraint(Sketcher.Constraint('DistanceX',0,1,0.0))
+			stairs.addConstraint(Sketcher.Constraint('DistanceY',0,1,0.0))
+			start=time.time()
+			self.Doc.recompute()
+			FreeCAD.Console.PrintMessage("Solving %d constraints: %.3f s\n" % (len(stairs.Constraints), time.time()-start))
+			self.failUnless(len(stairs.Shape.Edges) == steps)
+			geo = stairs.Geometry
+			self.failUnless(geo[0].StartPoint.Length < 1e-7)
+			for i in range(steps):
+				self.failUnless(abs((geo[i].EndPoint - geo[i].StartPoint).Length - 10.0) < 1e-7)
+				if i > 0:
+					self.failUnless((geo[i].StartPoint - geo[i-1].EndPoint).Length < 1e-7)
+
+	def testUndoSolutionFallback(self):
+		# Two decoupled components: a horizontal line of length 10 and an arc
+		# whose end points are forced together. Solving the arc collapses it,
+		# the geometry can't be built from the solution and Sketch::solve()
+		# undoes it before it tries the next solver. The fallback solvers must
+		# solve all components again instead of reusing the rejected solution.
+		self.Fallback = self.Doc.addObject('Sketcher::SketchObject','SketchFallback')
+		self.Fallback.addGeometry(Part.Line(App.Vector(0,0,0),App.Vector(8,3,0)))
+		self.Fallback.addGeometry(Part.ArcOfCircle(Part.Circle(App.Vector(30,0,0),App.Vector(0,0,1),5),0.0,3.0))
+		self.Fallback.addConstraint(Sketcher.Constraint('Horizontal',0))
+		self.Fallback.addConstraint(Sketcher.Constraint('Distance',0,10.0))
+		self.Fallback.addConstraint(Sketcher.Constraint('Coincident',1,1,1,2))
+		self.Doc.recompute()
+		line = self.Fallback.Geometry[0]
+		self.failUnless(abs(line.StartPoint.y - line.EndPoint.y) < 1e-7)
+		self.failUnless(abs((line.EndPoint - line.StartPoint).Length - 10.0) < 1e-7)
+		# solving again starts from the solution of the first run
+		self.Fallback.solve()
+		line = self.Fallback.Geometry[0]
+		self.failUnless(abs((line.EndPoint - line.StartPoint).Length - 10.0) < 1e-7)
+
 	def tearDown(self):
 		#closing doc
 		FreeCAD.closeDocument("SketchSolverTest")
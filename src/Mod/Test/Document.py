@@ -245,10 +245,89 @@ class DocumentRecomputeCases(unittest.TestCase):
     self.L2.Link = self.L3
 
 
+  def testInList(self):
+    self.L1.Link = self.L3
+    self.L2.LinkList = [self.L3]
+    self.failUnless(sorted([o.Name for o in self.L3.InList]) == ["Label_1", "Label_2"])
+    self.failUnless(self.L1.InList == [])
+    # relinking and unlinking must update the back links
+    self.L1.Link = self.L2
+    self.failUnless([o.Name for o in self.L3.InList] == ["Label_2"])
+    self.failUnless([o.Name for o in self.L2.InList] == ["Label_1"])
+    self.L2.LinkList = []
+    self.failUnless(self.L3.InList == [])
+    self.Doc.removeObject("Label_1")
+    self.failUnless(self.L2.InList == [])
+
+  def testIncrementalRecompute(self):
+    self.L1.Link = self.L2
+    self.L2.Link = self.L3
+    self.Doc.recompute()
+    self.failUnless([self.L1.ExecCount, self.L2.ExecCount, self.L3.ExecCount] == [1, 1, 1])
+    # nothing touched, nothing to do
+    self.Doc.recompute()
+    self.failUnless([self.L1.ExecCount, self.L2.ExecCount, self.L3.ExecCount] == [1, 1, 1])
+    # nothing depends on L1
+    self.L1.Integer = 1
+    self.Doc.recompute()
+    self.failUnless([self.L1.ExecCount, self.L2.ExecCount, self.L3.ExecCount] == [2, 1, 1])
+    # L2 and L1 depend on L3
+    self.L3.Integer = 1
+    self.Doc.recompute()
+    self.failUnless([self.L1.ExecCount, self.L2.ExecCount, self.L3.ExecCount] == [3, 2, 2])
+    self.L2.touch()
+    self.Doc.recompute()
+    self.failUnless([self.L1.ExecCount, self.L2.ExecCount, self.L3.ExecCount] == [4, 3, 2])
+
   def tearDown(self):
     #closing doc
     FreeCAD.closeDocument("RecomputeTests")
 
+class DocumentParallelRecomputeCases(unittest.TestCase):
+  def setUp(self):
+    import Part
+    self.Param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    self.Parallel = self.Param.GetBool("ParallelRecompute", False)
+    self.Doc = FreeCAD.newDocument("ParallelRecomputeTests")
+    # independent primitives, which are recomputed in threads, and booleans
+    # depending on them, which are recomputed in the main thread
+    for i in range(20):
+      box = self.Doc.addObject("Part::Box","Box")
+      box.Length = 10 + i
+      cyl = self.Doc.addObject("Part::Cylinder","Cylinder")
+      cyl.Radius = 2 + 0.25 * i
+      cyl.Height = 30
+      cut = self.Doc.addObject("Part::Cut","Cut")
+      cut.Base = box
+      cut.Tool = cyl
+      test = self.Doc.addObject("App::FeatureTest","Test")
+      test.Link = cut
+
+  def shapes(self):
+    result = []
+    for obj in self.Doc.Objects:
+      if hasattr(obj, "Shape"):
+        result.append((obj.Name, obj.Shape.Volume, [v.Point for v in obj.Shape.Vertexes]))
+    return result
+
+  def testParallelEqualsSerial(self):
+    self.Param.SetBool("ParallelRecompute", False)
+    self.Doc.recompute()
+    serial = self.shapes()
+    counts = [o.ExecCount for o in self.Doc.Objects if o.TypeId == "App::FeatureTest"]
+    for obj in self.Doc.Objects:
+      obj.touch()
+    self.Param.SetBool("ParallelRecompute", True)
+    self.Doc.recompute()
+    self.failUnless(self.shapes() == serial)
+    self.failUnless([o.ExecCount for o in self.Doc.Objects if o.TypeId == "App::FeatureTest"] == [c + 1 for c in counts])
+    for obj in self.Doc.Objects:
+      self.failUnless(obj.State == ["Up-to-date"])
+
+  def tearDown(self):
+    self.Param.SetBool("ParallelRecompute", self.Parallel)
+    FreeCAD.closeDocument("ParallelRecomputeTests")
+
 class UndoRedoCases(unittest.TestCase):
   def setUp(self):
     self.Doc = FreeCAD.newDocument("UndoTest")
@@ -43,9 +43,14 @@ def All():
         suite.addTest(unittest.defaultTestLoader.loadTestsFromName("Menu") )
     # add the module tests
     suite.addTest(unittest.defaultTestLoader.loadTestsFromName("MeshTestsApp") )
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromName("PointsTestsApp") )
     suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestSketcherApp") )
     suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestPartApp") )
     suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestPartDesignApp") )
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestFemApp") )
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestDrawingApp") )
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestRobotApp") )
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestImportApp") )
     # gui tests of modules
     if ( FreeCAD.GuiUp == 1):
         suite.addTest(unittest.defaultTestLoader.loadTestsFromName("TestSketcherGui") )
@@ -18,9 +18,9 @@ using std::endl ;
 InflateInputStreambuf::InflateInputStreambuf( streambuf *inbuf, int s_pos, bool del_inbuf ) 
   : FilterInputStreambuf( inbuf, del_inbuf ),
     _zs_initialized ( false            ),
-    _invecsize      ( 1000             ),
+    _invecsize      ( 65536            ),
     _invec          ( _invecsize       ),
-    _outvecsize     ( 1000             ),
+    _outvecsize     ( 65536            ),
     _outvec         ( _outvecsize      )
 {
   // NOTICE: It is important that this constructor and the methods it
@@ -103,6 +103,24 @@ int ZipInputStreambuf::underflow() {
 }
 
 
+std::streamsize ZipInputStreambuf::xsgetn( char *s, std::streamsize n ) {
+  if ( ! _open_entry || _curr_entry.getMethod() != STORED || n < _outvecsize )
+    return InflateInputStreambuf::xsgetn( s, n ) ;
+
+  // A large block of a STORED entry: hand out what is left in the get
+  // area and read the rest directly into the caller's buffer.
+  std::streamsize num = min< std::streamsize >( egptr() - gptr(), n ) ;
+  std::copy( gptr(), gptr() + num, s ) ;
+  gbump( static_cast< int >( num ) ) ;
+  if ( num < n && _remain > 0 ) {
+    int g = _inbuf->sgetn( s + num, min< std::streamsize >( n - num, _remain ) ) ;
+    _remain -= g ;
+    num += g ;
+  }
+  return num ;
+}
+
+
 // FIXME: We need to check somew
 //  
 //    // gp_bitfield bit 3 is one, if the length of the zip entry
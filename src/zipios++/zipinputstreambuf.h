@@ -43,6 +43,7 @@ public:
   virtual ~ZipInputStreambuf() ;
 protected:
   virtual int underflow() ;
+  virtual std::streamsize xsgetn( char *s, std::streamsize n ) ;
 private:
   bool _open_entry ;
   ZipLocalEntry _curr_entry ;
@@ -23,6 +23,7 @@ ZipOutputStreambuf::ZipOutputStreambuf( streambuf *outbuf, bool del_outbuf )
     _open_entry( false    ),
     _open      ( true     ),
     _method    ( DEFLATED ),
+    _entry_method( DEFLATED ),
     _level     ( 6        )
 {
 }
@@ -32,7 +33,10 @@ void ZipOutputStreambuf::closeEntry() {
   if ( ! _open_entry )
     return ;
 
-  closeStream() ;
+  if ( _entry_method == STORED )
+    flushStored() ;
+  else
+    closeStream() ;
 
   updateEntryHeaderInfo() ;
   setEntryClosedState( ) ;
@@ -63,7 +67,14 @@ void ZipOutputStreambuf::putNextEntry( const ZipCDirEntry &entry ) {
   if ( _open_entry )
     closeEntry() ;
 
-  if ( ! init( _level ) )
+  _entry_method = _method ;
+  if ( _entry_method == STORED ) {
+    // the data is not passed through zlib, only the crc and the size
+    // are computed while writing
+    setp( &( _invec[ 0 ] ), &( _invec[ 0 ] ) + _invecsize ) ;
+    _crc32 = crc32( 0, Z_NULL, 0 ) ;
+    _overflown_bytes = 0 ;
+  } else if ( ! init( _level ) )
     cerr << "ZipOutputStreambuf::putNextEntry(): init() failed!\n" ;
 
   _entries.push_back( entry ) ;
@@ -107,6 +118,15 @@ void ZipOutputStreambuf::setMethod( StorageMethod method ) {
 //
 
 int ZipOutputStreambuf::overflow( int c ) {
+  if ( _entry_method == STORED ) {
+    if ( ! flushStored() )
+      return EOF ;
+    if ( c != EOF ) {
+      *pptr() = c ;
+      pbump( 1 ) ;
+    }
+    return 0 ;
+  }
   return DeflateOutputStreambuf::overflow( c ) ;
 //    // FIXME: implement
   
@@ -124,6 +144,34 @@ int ZipOutputStreambuf::sync() {
 }
 
 
+std::streamsize ZipOutputStreambuf::xsputn( const char *s, std::streamsize n ) {
+  // Large blocks of a STORED entry are handed over directly instead
+  // of being copied piecewise through the put area.
+  if ( _entry_method != STORED || n < _invecsize )
+    return DeflateOutputStreambuf::xsputn( s, n ) ;
+
+  if ( ! flushStored() )
+    return 0 ;
+  _crc32 = crc32( _crc32, reinterpret_cast< const unsigned char * >( s ), 
+		  static_cast< uInt >( n ) ) ;
+  _overflown_bytes += static_cast< uint32 >( n ) ;
+  return _outbuf->sputn( s, n ) ;
+}
+
+
+bool ZipOutputStreambuf::flushStored() {
+  int len = pptr() - pbase() ;
+  int bc = len ;
+  if ( len > 0 ) {
+    _crc32 = crc32( _crc32, reinterpret_cast< unsigned char * >( pbase() ), len ) ;
+    _overflown_bytes += len ;
+    bc = _outbuf->sputn( pbase(), len ) ;
+  }
+  setp( &( _invec[ 0 ] ), &( _invec[ 0 ] ) + _invecsize ) ;
+  return bc == len ;
+}
+
+
 
 void ZipOutputStreambuf::setEntryClosedState() {
   _open_entry = false ;
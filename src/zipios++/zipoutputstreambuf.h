@@ -65,6 +65,11 @@ public:
 protected:
   virtual int overflow( int c = EOF ) ;
   virtual int sync() ;
+  virtual std::streamsize xsputn( const char *s, std::streamsize n ) ;
+
+  /** Passes the buffered data of a STORED entry unchanged to the
+      output streambuf. */
+  bool flushStored() ;
 
   void setEntryClosedState() ;
   void updateEntryHeaderInfo() ;
@@ -82,6 +87,7 @@ private:
   bool _open_entry ;
   bool _open ;
   StorageMethod _method ;
+  StorageMethod _entry_method ; // method of the currently open entry
   int _level ;
 };
 